@@ -0,0 +1,123 @@
+#include "pch.h"
+#include "common.h"
+#include "benchmark.h"
+#include "common/gfxwrapper_opengl.h"
+
+namespace {
+std::string JsonString(const std::string& value) {
+    std::string quoted = "\"";
+    for (const char c : value) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+}  // namespace
+
+void BenchmarkRunner::Report(const std::string& name, uint64_t iterations, std::vector<double>& samples, std::map<std::string, double> counters) {
+    std::sort(samples.begin(), samples.end());
+    const auto percentile = [&samples](uint32_t p) { return samples[(samples.size() - 1) * p / 100]; };
+
+    Result result;
+    result.name = name;
+    result.iterations = iterations;
+    result.minNs = samples.front();
+    result.p50Ns = percentile(50);
+    result.p95Ns = percentile(95);
+    result.meanNs = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    result.counters = std::move(counters);
+
+    Log::Write(Log::Level::Info, Fmt("%-40s p50 %12.1f ns  p95 %12.1f ns  min %12.1f ns  (%llu iterations)", name.c_str(), result.p50Ns,
+                                     result.p95Ns, result.minNs, static_cast<unsigned long long>(iterations)));
+    m_results.push_back(std::move(result));
+}
+
+bool BenchmarkRunner::WriteResults() const {
+    if (m_options.output.empty()) {
+        return true;
+    }
+    FILE* file = fopen(m_options.output.c_str(), "w");
+    if (file == nullptr) {
+        Log::Write(Log::Level::Error, Fmt("Cannot write benchmark results to %s", m_options.output.c_str()));
+        return false;
+    }
+
+    // The build the results belong to, so that runs of different revisions can be told apart.
+    const time_t now = time(nullptr);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    fprintf(file, "{\n  \"revision\": %s,\n  \"buildType\": %s,\n  \"compiler\": %s,\n  \"date\": \"%s\",\n", JsonString(BENCHMARK_REVISION).c_str(),
+            JsonString(BENCHMARK_BUILD_TYPE).c_str(), JsonString(__VERSION__).c_str(), date);
+    fprintf(file, "  \"samples\": %u,\n  \"benchmarks\": [", m_options.samples);
+    for (size_t i = 0; i < m_results.size(); i++) {
+        const Result& result = m_results[i];
+        fprintf(file, "%s\n    {\"name\": %s, \"iterations\": %llu, \"minNs\": %.1f, \"p50Ns\": %.1f, \"p95Ns\": %.1f, \"meanNs\": %.1f", i > 0 ? "," : "",
+                JsonString(result.name).c_str(), static_cast<unsigned long long>(result.iterations), result.minNs, result.p50Ns, result.p95Ns,
+                result.meanNs);
+        for (const auto& counter : result.counters) {
+            fprintf(file, ", %s: %.17g", JsonString(counter.first).c_str(), counter.second);
+        }
+        fprintf(file, "}");
+    }
+    fprintf(file, "\n  ]\n}\n");
+    const bool written = ferror(file) == 0;
+    fclose(file);
+    return written;
+}
+
+HostGlContext::~HostGlContext() {
+    if (m_display == EGL_NO_DISPLAY) {
+        return;
+    }
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (m_surface != EGL_NO_SURFACE) {
+        eglDestroySurface(m_display, m_surface);
+    }
+    if (m_context != EGL_NO_CONTEXT) {
+        eglDestroyContext(m_display, m_context);
+    }
+    eglTerminate(m_display);
+}
+
+bool HostGlContext::Create() {
+    const auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (getPlatformDisplay != nullptr && clientExtensions != nullptr && strstr(clientExtensions, "EGL_MESA_platform_surfaceless") != nullptr) {
+        m_display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    } else {
+        m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (m_display == EGL_NO_DISPLAY || !eglInitialize(m_display, nullptr, nullptr)) {
+        Log::Write(Log::Level::Error, Fmt("No EGL display: 0x%x", eglGetError()));
+        m_display = EGL_NO_DISPLAY;
+        return false;
+    }
+    eglBindAPI(EGL_OPENGL_ES_API);
+
+    const EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR, EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_NONE};
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(m_display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+        Log::Write(Log::Level::Error, "No EGL config for a GL ES 3 context");
+        return false;
+    }
+    const EGLint contextAttributes[] = {EGL_CONTEXT_MAJOR_VERSION_KHR, 3, EGL_CONTEXT_MINOR_VERSION_KHR, 2, EGL_NONE};
+    m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (m_context == EGL_NO_CONTEXT) {
+        Log::Write(Log::Level::Error, Fmt("Unable to create a GL ES 3.2 context: 0x%x", eglGetError()));
+        return false;
+    }
+    if (strstr(eglQueryString(m_display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context") == nullptr) {
+        const EGLint pbufferAttributes[] = {EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE};
+        m_surface = eglCreatePbufferSurface(m_display, config, pbufferAttributes);
+    }
+    if (!eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
+        Log::Write(Log::Level::Error, Fmt("Unable to make the GL context current: 0x%x", eglGetError()));
+        return false;
+    }
+    GlInitExtensions();
+    Log::Write(Log::Level::Info, Fmt("Benchmark GL context: %s", glGetString(GL_RENDERER)));
+    return true;
+}
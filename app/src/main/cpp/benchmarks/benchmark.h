@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include <EGL/egl.h>
+
+// A minimal timing harness for the host benchmarks, results are written as JSON to track them across builds.
+//
+// Every benchmark is timed over Samples samples of a fixed number of iterations, calibrated once so that a sample takes
+// about MinSeconds / Samples. The per iteration time of each sample feeds the reported min, p50, p95 and mean, so a
+// sample disturbed by the host shows up in p95 instead of shifting the median. Counters are reported as given, they
+// describe the work of one iteration (vertices generated, bytes written).
+class BenchmarkRunner {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        double minSeconds = 0.5;  // per benchmark
+        uint32_t samples = 50;
+        std::string filter;  // only benchmarks whose name contains it
+        std::string output;  // JSON results, none when empty
+    };
+
+    struct Result {
+        std::string name;
+        uint64_t iterations;
+        double minNs;
+        double p50Ns;
+        double p95Ns;
+        double meanNs;
+        std::map<std::string, double> counters;
+    };
+
+    explicit BenchmarkRunner(const Options& options) : m_options(options) {}
+
+    bool Enabled(const std::string& name) const { return name.find(m_options.filter) != std::string::npos; }
+
+    // Times body, which does one iteration of the work and is called as often as the options ask for.
+    template <typename Body>
+    void Run(const std::string& name, Body&& body, std::map<std::string, double> counters = {}) {
+        if (!Enabled(name)) {
+            return;
+        }
+        body();  // warm up caches and lazily initialized state
+
+        const double sampleSeconds = m_options.minSeconds / m_options.samples;
+        uint64_t batch = 1;
+        for (;;) {
+            const Clock::time_point start = Clock::now();
+            for (uint64_t i = 0; i < batch; i++) {
+                body();
+            }
+            if (std::chrono::duration<double>(Clock::now() - start).count() >= sampleSeconds || batch >= (1u << 30)) {
+                break;
+            }
+            batch *= 2;
+        }
+
+        std::vector<double> samples(m_options.samples);
+        for (double& sample : samples) {
+            const Clock::time_point start = Clock::now();
+            for (uint64_t i = 0; i < batch; i++) {
+                body();
+            }
+            sample = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / batch;
+        }
+        Report(name, batch * samples.size(), samples, std::move(counters));
+    }
+
+    // Adds the result of samples the caller timed itself, one per iteration, for loops that cannot be rerun at will.
+    void Report(const std::string& name, uint64_t iterations, std::vector<double>& samples, std::map<std::string, double> counters);
+
+    // Writes the results to the output of the options, if any.
+    bool WriteResults() const;
+
+   private:
+
+    Options m_options;
+    std::vector<Result> m_results;
+};
+
+// Keeps the compiler from discarding a result the benchmark computes only to be timed.
+template <typename T>
+inline void KeepResult(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// A GL ES 3.2 context on the host's EGL for the benchmarks that create GL objects, current on the thread that created
+// it. Prefers Mesa's surfaceless platform, so no display server is needed.
+class HostGlContext {
+   public:
+    HostGlContext() = default;
+    HostGlContext(const HostGlContext&) = delete;
+    HostGlContext& operator=(const HostGlContext&) = delete;
+    ~HostGlContext();
+
+    bool Create();
+
+   private:
+    EGLDisplay m_display{EGL_NO_DISPLAY};
+    EGLContext m_context{EGL_NO_CONTEXT};
+    EGLSurface m_surface{EGL_NO_SURFACE};
+};
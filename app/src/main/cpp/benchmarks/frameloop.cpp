@@ -0,0 +1,166 @@
+#include "pch.h"
+#include "common.h"
+#include "options.h"
+#include "platformdata.h"
+#include "platformplugin.h"
+#include "graphicsplugin.h"
+#include "openxr_program.h"
+#include "startuptasks.h"
+#include "benchmark.h"
+#include "standin_runtime/standin_runtime.h"
+#include "demos/utils.h"
+#include "demos/programCache.h"
+#include <filesystem>
+
+// OpenXrProgram against the stand-in runtime on the headless plugin, started and looped the way android_main does:
+// PollEvents, PollActions and RenderFrame with its xrWaitFrame, layers and xrEndFrame, until the runtime ends the
+// session after a number of frames. Reported is the time from one RenderFrame to the next, which the runtime paces to
+// its refresh rate, and the frame statistics of the runtime. A run fails unless every frame reached xrEndFrame.
+//
+//   frameloop_benchmarks [--frames n] [--out results.json] [--quick] [--assets directory] [--record recording]
+//
+// --record writes what the runtime fed the application to a recording session_replay plays back.
+//
+// The views and the refresh rate come from the XR_STANDIN_* variables (standin_runtime.h), the views default to
+// 640x360 here so that a software rasterizer keeps up with 60Hz.
+
+namespace {
+constexpr uint32_t DefaultFrames = 300;
+constexpr uint32_t QuickFrames = 60;
+
+// Mirrors the startup graph of android_main, without the Android loader initialization.
+bool Start(const std::shared_ptr<IOpenXrProgram>& program, StartupTasks& startup, const std::string& cacheDir) {
+    startup.Start();
+    ProgramCache::instance().setDirectory(cacheDir + "/programs");
+    const auto markerImages = startup.Add("marker images", StartupTasks::Thread::Worker, [program, cacheDir] {
+        program->LoadMarkerImages(cacheDir);
+        return true;
+    });
+    const auto session = startup.Add("xr session", StartupTasks::Thread::Render, [program] {
+        program->CreateInstance();
+        program->InitializeSystem();
+        program->InitializeSession();
+        program->CreateSwapchains();
+        return true;
+    });
+    const auto application = startup.Add("application", StartupTasks::Thread::Render, [program, &startup] {
+        program->InitializeApplication(startup);
+        return true;
+    }, {session});
+    const auto marker = startup.Add("marker tracker", StartupTasks::Thread::Render, [program] {
+        program->InitializeMarker();
+        return true;
+    }, {session});
+    const auto markerAdd = startup.Add("marker images add", StartupTasks::Thread::Render, [program] {
+        program->AddMarkerImages();
+        return true;
+    }, {marker, markerImages});
+    const auto planes = startup.Add("plane tracker", StartupTasks::Thread::Render, [program] {
+        program->InitializePlaneTracking();
+        return true;
+    }, {session});
+    startup.Add("tracking", StartupTasks::Thread::Render, [program] {
+        program->StartTracking();
+        return true;
+    }, {markerAdd, planes});
+    return startup.Wait(application);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    BenchmarkRunner::Options benchmarkOptions;
+    std::string assets = BENCHMARK_ASSET_DIR;
+    uint32_t frames = DefaultFrames;
+    std::string recording;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) {
+            benchmarkOptions.output = argv[++i];
+        } else if (arg == "--frames" && i + 1 < argc) {
+            frames = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--assets" && i + 1 < argc) {
+            assets = argv[++i];
+        } else if (arg == "--record" && i + 1 < argc) {
+            recording = argv[++i];
+        } else if (arg == "--quick") {
+            frames = QuickFrames;
+        } else {
+            Log::Write(Log::Level::Error, Fmt("Unknown argument %s", arg.c_str()));
+            return 2;
+        }
+    }
+    if (frames == 0) {
+        Log::Write(Log::Level::Error, "--frames needs at least one frame");
+        return 2;
+    }
+    Log::SetLevel(Log::Level::Info);
+    setAssetDirectory(assets);
+    setenv("XR_STANDIN_FRAMES", std::to_string(frames).c_str(), 1);
+    setenv("XR_STANDIN_VIEW_WIDTH", "640", 0);
+    setenv("XR_STANDIN_VIEW_HEIGHT", "360", 0);
+
+    // The video layer needs an Android surface, the rest is the application as configured on the glasses.
+    auto options = std::make_shared<Options>();
+    options->GraphicsPlugin = "Headless";
+    options->VideoSurfaceLayer = false;
+    options->RecordSession = recording;
+    const std::string cacheDir = (std::filesystem::temp_directory_path() / "frameloop_benchmarks").string();
+    std::filesystem::create_directories(cacheDir);
+
+    std::vector<double> frameNs;
+    frameNs.reserve(frames);
+    try {
+        std::shared_ptr<IPlatformPlugin> platformPlugin = CreatePlatformPlugin(options, std::make_shared<PlatformData>());
+        std::shared_ptr<IGraphicsPlugin> graphicsPlugin = CreateGraphicsPlugin(options, platformPlugin);
+        std::shared_ptr<IOpenXrProgram> program = CreateOpenXrProgram(options, platformPlugin, graphicsPlugin);
+
+        StartupTasks startup;
+        CHECK_MSG(Start(program, startup, cacheDir), "Startup failed");
+
+        constexpr std::chrono::milliseconds startupTaskBudget{2};
+        bool exitRenderLoop = false;
+        bool requestRestart = false;
+        BenchmarkRunner::Clock::time_point lastFrame{};
+        while (!exitRenderLoop) {
+            program->PollEvents(&exitRenderLoop, &requestRestart);
+            startup.RunRenderTasks(startupTaskBudget);
+            if (exitRenderLoop) {
+                break;
+            }
+            if (!program->IsSessionRunning()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+
+            program->PollActions();
+            program->RenderFrame();
+
+            const BenchmarkRunner::Clock::time_point now = BenchmarkRunner::Clock::now();
+            if (lastFrame != BenchmarkRunner::Clock::time_point{}) {
+                frameNs.push_back(std::chrono::duration<double, std::nano>(now - lastFrame).count());
+            }
+            lastFrame = now;
+        }
+    } catch (const std::exception& ex) {
+        Log::Write(Log::Level::Error, ex.what());
+        return 1;
+    }
+
+    StandinFrameStats stats;
+    StandinGetFrameStats(&stats);
+    Log::Write(Log::Level::Info, Fmt("%u frames, %u late, %u refreshes skipped, %.2fms per frame in xrWaitFrame", stats.frames,
+                                     stats.lateFrames, stats.skippedVsyncs, stats.frames > 0 ? stats.waitNs * 1e-6 / stats.frames : 0.0));
+    if (stats.frames != frames || frameNs.empty()) {
+        Log::Write(Log::Level::Error, Fmt("%u of %u frames were ended", stats.frames, frames));
+        return 1;
+    }
+
+    BenchmarkRunner runner(benchmarkOptions);
+    const uint64_t intervals = frameNs.size();
+    runner.Report("frameloop/app", intervals, frameNs,
+                  {{"frames", stats.frames},
+                   {"lateFrames", stats.lateFrames},
+                   {"skippedVsyncs", stats.skippedVsyncs},
+                   {"waitNsPerFrame", static_cast<double>(stats.waitNs) / stats.frames}});
+    return runner.WriteResults() ? 0 : 1;
+}
@@ -0,0 +1,289 @@
+#include "pch.h"
+#include "common.h"
+#include <dlfcn.h>
+#include "glcounters.h"
+#include "common/gfxwrapper_opengl.h"
+
+// The GL ES entry points of the app, defined here so that the calls the executable makes bind to these instead of
+// to the driver's. Each one counts itself and forwards to the next definition of the same name, the driver's, which
+// it looks up on first use. Only calls from the executable are counted, the driver's internal ones never come here.
+
+namespace {
+// GL is only called from the render thread, the counts are not synchronized.
+GlCallCounts s_total;
+std::map<std::string, GlCallCounts> s_renderers;
+std::map<GLuint, std::string> s_labels;  // of the programs
+GlCallCounts* s_current = &s_renderers["none"];
+
+void* NextGlFunction(const char* name) {
+    void* function = dlsym(RTLD_NEXT, name);
+    if (function == nullptr) {
+        Log::Write(Log::Level::Error, Fmt("GL call counters: no %s in the libraries after the executable", name));
+        abort();
+    }
+    return function;
+}
+
+void Count(GlCallCounts::Kind kind) {
+    s_total.calls[kind]++;
+    s_current->calls[kind]++;
+}
+
+GlCallCounts& Renderer(GLuint program) {
+    if (program == 0) {
+        return s_renderers["none"];
+    }
+    const auto label = s_labels.find(program);
+    return s_renderers[label != s_labels.end() ? label->second : Fmt("program %u", program)];
+}
+}  // namespace
+
+const char* GlCallCounts::Name(Kind kind) {
+    switch (kind) {
+        case Draw:
+            return "draws";
+        case Uniform:
+            return "uniforms";
+        case BufferUpload:
+            return "bufferUploads";
+        case TextureUpload:
+            return "textureUploads";
+        case Bind:
+            return "binds";
+        case State:
+            return "state";
+        case Get:
+            return "gets";
+        case GetError:
+            return "getErrors";
+        case Other:
+            return "other";
+        default:
+            return "?";
+    }
+}
+
+uint64_t GlCallCounts::Total() const {
+    uint64_t total = 0;
+    for (const uint64_t count : calls) {
+        total += count;
+    }
+    return total;
+}
+
+GlCallCounts& GlCallCounts::operator+=(const GlCallCounts& other) {
+    for (uint32_t kind = 0; kind < KindCount; kind++) {
+        calls[kind] += other.calls[kind];
+    }
+    return *this;
+}
+
+GlCallCounts GlCallCounts::operator-(const GlCallCounts& other) const {
+    GlCallCounts difference;
+    for (uint32_t kind = 0; kind < KindCount; kind++) {
+        difference.calls[kind] = calls[kind] - other.calls[kind];
+    }
+    return difference;
+}
+
+GlCallSnapshot GlCallSnapshot::Take() {
+    GlCallSnapshot snapshot;
+    snapshot.total = s_total;
+    snapshot.renderers = s_renderers;
+    return snapshot;
+}
+
+GlCallSnapshot& GlCallSnapshot::operator+=(const GlCallSnapshot& other) {
+    total += other.total;
+    for (const auto& renderer : other.renderers) {
+        renderers[renderer.first] += renderer.second;
+    }
+    return *this;
+}
+
+GlCallSnapshot GlCallSnapshot::operator-(const GlCallSnapshot& other) const {
+    // Renderers only ever appear, every one of other is also in this snapshot. The ones without calls in between are
+    // left out.
+    GlCallSnapshot difference;
+    difference.total = total - other.total;
+    for (const auto& renderer : renderers) {
+        const auto earlier = other.renderers.find(renderer.first);
+        const GlCallCounts calls = earlier != other.renderers.end() ? renderer.second - earlier->second : renderer.second;
+        if (calls.Total() > 0) {
+            difference.renderers[renderer.first] = calls;
+        }
+    }
+    return difference;
+}
+
+// Defines the entry point name, which counts as kind.
+#define GL_COUNTED(kind, returnType, name, parameters, arguments)                                                     \
+    extern "C" GL_APICALL returnType GL_APIENTRY name parameters {                                                    \
+        static const auto next = reinterpret_cast<returnType(GL_APIENTRY*) parameters>(NextGlFunction(#name));        \
+        Count(GlCallCounts::kind);                                                                                    \
+        return next arguments;                                                                                        \
+    }
+
+GL_COUNTED(Draw, void, glDrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count))
+GL_COUNTED(Draw, void, glDrawElements, (GLenum mode, GLsizei count, GLenum type, const void* indices), (mode, count, type, indices))
+GL_COUNTED(Draw, void, glDrawArraysInstanced, (GLenum mode, GLint first, GLsizei count, GLsizei instances), (mode, first, count, instances))
+GL_COUNTED(Draw, void, glDrawElementsInstanced, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances),
+           (mode, count, type, indices, instances))
+GL_COUNTED(Draw, void, glDrawRangeElements, (GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const void* indices),
+           (mode, start, end, count, type, indices))
+
+GL_COUNTED(Uniform, void, glUniform1i, (GLint location, GLint v0), (location, v0))
+GL_COUNTED(Uniform, void, glUniform1f, (GLint location, GLfloat v0), (location, v0))
+GL_COUNTED(Uniform, void, glUniform2f, (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1))
+GL_COUNTED(Uniform, void, glUniform3f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2), (location, v0, v1, v2))
+GL_COUNTED(Uniform, void, glUniform4f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (location, v0, v1, v2, v3))
+GL_COUNTED(Uniform, void, glUniform1iv, (GLint location, GLsizei count, const GLint* value), (location, count, value))
+GL_COUNTED(Uniform, void, glUniform1fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value))
+GL_COUNTED(Uniform, void, glUniform2fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value))
+GL_COUNTED(Uniform, void, glUniform3fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value))
+GL_COUNTED(Uniform, void, glUniform4fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value))
+GL_COUNTED(Uniform, void, glUniformMatrix2fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),
+           (location, count, transpose, value))
+GL_COUNTED(Uniform, void, glUniformMatrix3fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),
+           (location, count, transpose, value))
+GL_COUNTED(Uniform, void, glUniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),
+           (location, count, transpose, value))
+
+GL_COUNTED(BufferUpload, void, glBufferData, (GLenum target, GLsizeiptr size, const void* data, GLenum usage), (target, size, data, usage))
+GL_COUNTED(BufferUpload, void, glBufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void* data), (target, offset, size, data))
+
+GL_COUNTED(TextureUpload, void, glTexImage2D,
+           (GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type,
+            const void* pixels),
+           (target, level, internalFormat, width, height, border, format, type, pixels))
+GL_COUNTED(TextureUpload, void, glTexSubImage2D,
+           (GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels),
+           (target, level, x, y, width, height, format, type, pixels))
+GL_COUNTED(TextureUpload, void, glTexSubImage3D,
+           (GLenum target, GLint level, GLint x, GLint y, GLint z, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type,
+            const void* pixels),
+           (target, level, x, y, z, width, height, depth, format, type, pixels))
+GL_COUNTED(TextureUpload, void, glTexStorage2D, (GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height),
+           (target, levels, internalFormat, width, height))
+GL_COUNTED(TextureUpload, void, glTexStorage3D,
+           (GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height, GLsizei depth),
+           (target, levels, internalFormat, width, height, depth))
+
+GL_COUNTED(Bind, void, glBindBuffer, (GLenum target, GLuint buffer), (target, buffer))
+GL_COUNTED(Bind, void, glBindBufferBase, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer))
+GL_COUNTED(Bind, void, glBindBufferRange, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size),
+           (target, index, buffer, offset, size))
+GL_COUNTED(Bind, void, glBindTexture, (GLenum target, GLuint texture), (target, texture))
+GL_COUNTED(Bind, void, glBindVertexArray, (GLuint array), (array))
+GL_COUNTED(Bind, void, glBindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer))
+GL_COUNTED(Bind, void, glBindRenderbuffer, (GLenum target, GLuint renderbuffer), (target, renderbuffer))
+GL_COUNTED(Bind, void, glActiveTexture, (GLenum texture), (texture))
+
+GL_COUNTED(State, void, glEnable, (GLenum capability), (capability))
+GL_COUNTED(State, void, glDisable, (GLenum capability), (capability))
+GL_COUNTED(State, void, glBlendFunc, (GLenum source, GLenum destination), (source, destination))
+GL_COUNTED(State, void, glBlendFuncSeparate, (GLenum sourceRgb, GLenum destinationRgb, GLenum sourceAlpha, GLenum destinationAlpha),
+           (sourceRgb, destinationRgb, sourceAlpha, destinationAlpha))
+GL_COUNTED(State, void, glBlendEquation, (GLenum mode), (mode))
+GL_COUNTED(State, void, glCullFace, (GLenum mode), (mode))
+GL_COUNTED(State, void, glFrontFace, (GLenum mode), (mode))
+GL_COUNTED(State, void, glDepthMask, (GLboolean flag), (flag))
+GL_COUNTED(State, void, glDepthFunc, (GLenum function), (function))
+GL_COUNTED(State, void, glColorMask, (GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha), (red, green, blue, alpha))
+GL_COUNTED(State, void, glViewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height))
+GL_COUNTED(State, void, glScissor, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height))
+GL_COUNTED(State, void, glClearColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha))
+GL_COUNTED(State, void, glClearDepthf, (GLfloat depth), (depth))
+GL_COUNTED(State, void, glTexParameteri, (GLenum target, GLenum name, GLint value), (target, name, value))
+GL_COUNTED(State, void, glTexParameterf, (GLenum target, GLenum name, GLfloat value), (target, name, value))
+GL_COUNTED(State, void, glPixelStorei, (GLenum name, GLint value), (name, value))
+GL_COUNTED(State, void, glVertexAttribPointer,
+           (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer),
+           (index, size, type, normalized, stride, pointer))
+GL_COUNTED(State, void, glVertexAttribIPointer, (GLuint index, GLint size, GLenum type, GLsizei stride, const void* pointer),
+           (index, size, type, stride, pointer))
+GL_COUNTED(State, void, glEnableVertexAttribArray, (GLuint index), (index))
+GL_COUNTED(State, void, glDisableVertexAttribArray, (GLuint index), (index))
+
+GL_COUNTED(Get, void, glGetIntegerv, (GLenum name, GLint* data), (name, data))
+GL_COUNTED(Get, void, glGetFloatv, (GLenum name, GLfloat* data), (name, data))
+GL_COUNTED(Get, void, glGetBooleanv, (GLenum name, GLboolean* data), (name, data))
+GL_COUNTED(Get, const GLubyte*, glGetString, (GLenum name), (name))
+GL_COUNTED(Get, const GLubyte*, glGetStringi, (GLenum name, GLuint index), (name, index))
+GL_COUNTED(Get, GLint, glGetUniformLocation, (GLuint program, const GLchar* name), (program, name))
+GL_COUNTED(Get, GLint, glGetAttribLocation, (GLuint program, const GLchar* name), (program, name))
+GL_COUNTED(Get, GLuint, glGetUniformBlockIndex, (GLuint program, const GLchar* name), (program, name))
+GL_COUNTED(Get, void, glGetProgramiv, (GLuint program, GLenum name, GLint* value), (program, name, value))
+GL_COUNTED(Get, void, glGetShaderiv, (GLuint shader, GLenum name, GLint* value), (shader, name, value))
+GL_COUNTED(Get, void, glGetProgramInfoLog, (GLuint program, GLsizei size, GLsizei* length, GLchar* log), (program, size, length, log))
+GL_COUNTED(Get, void, glGetShaderInfoLog, (GLuint shader, GLsizei size, GLsizei* length, GLchar* log), (shader, size, length, log))
+GL_COUNTED(Get, void, glGetProgramBinary, (GLuint program, GLsizei size, GLsizei* length, GLenum* format, void* binary),
+           (program, size, length, format, binary))
+GL_COUNTED(Get, void, glGetQueryObjectuiv, (GLuint query, GLenum name, GLuint* value), (query, name, value))
+GL_COUNTED(Get, void, glGetSynciv, (GLsync sync, GLenum name, GLsizei size, GLsizei* length, GLint* values), (sync, name, size, length, values))
+GL_COUNTED(Get, GLenum, glCheckFramebufferStatus, (GLenum target), (target))
+
+GL_COUNTED(GetError, GLenum, glGetError, (void), ())
+
+GL_COUNTED(Other, void, glClear, (GLbitfield mask), (mask))
+GL_COUNTED(Other, void, glInvalidateFramebuffer, (GLenum target, GLsizei count, const GLenum* attachments), (target, count, attachments))
+GL_COUNTED(Other, void, glFlush, (void), ())
+GL_COUNTED(Other, void, glFinish, (void), ())
+GL_COUNTED(Other, GLsync, glFenceSync, (GLenum condition, GLbitfield flags), (condition, flags))
+GL_COUNTED(Other, GLenum, glClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout), (sync, flags, timeout))
+GL_COUNTED(Other, void, glDeleteSync, (GLsync sync), (sync))
+GL_COUNTED(Other, void, glGenBuffers, (GLsizei count, GLuint* buffers), (count, buffers))
+GL_COUNTED(Other, void, glDeleteBuffers, (GLsizei count, const GLuint* buffers), (count, buffers))
+GL_COUNTED(Other, void, glGenTextures, (GLsizei count, GLuint* textures), (count, textures))
+GL_COUNTED(Other, void, glDeleteTextures, (GLsizei count, const GLuint* textures), (count, textures))
+GL_COUNTED(Other, void, glGenVertexArrays, (GLsizei count, GLuint* arrays), (count, arrays))
+GL_COUNTED(Other, void, glDeleteVertexArrays, (GLsizei count, const GLuint* arrays), (count, arrays))
+GL_COUNTED(Other, void, glGenFramebuffers, (GLsizei count, GLuint* framebuffers), (count, framebuffers))
+GL_COUNTED(Other, void, glDeleteFramebuffers, (GLsizei count, const GLuint* framebuffers), (count, framebuffers))
+GL_COUNTED(Other, void, glGenRenderbuffers, (GLsizei count, GLuint* renderbuffers), (count, renderbuffers))
+GL_COUNTED(Other, void, glDeleteRenderbuffers, (GLsizei count, const GLuint* renderbuffers), (count, renderbuffers))
+GL_COUNTED(Other, void, glGenQueries, (GLsizei count, GLuint* queries), (count, queries))
+GL_COUNTED(Other, void, glDeleteQueries, (GLsizei count, const GLuint* queries), (count, queries))
+GL_COUNTED(Other, void, glFramebufferTexture2D, (GLenum target, GLenum attachment, GLenum textureTarget, GLuint texture, GLint level),
+           (target, attachment, textureTarget, texture, level))
+GL_COUNTED(Other, void, glFramebufferTextureLayer, (GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer),
+           (target, attachment, texture, level, layer))
+GL_COUNTED(Other, void, glGenerateMipmap, (GLenum target), (target))
+GL_COUNTED(Other, void, glReadPixels, (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels),
+           (x, y, width, height, format, type, pixels))
+GL_COUNTED(Other, GLuint, glCreateShader, (GLenum type), (type))
+GL_COUNTED(Other, void, glShaderSource, (GLuint shader, GLsizei count, const GLchar* const* source, const GLint* length),
+           (shader, count, source, length))
+GL_COUNTED(Other, void, glCompileShader, (GLuint shader), (shader))
+GL_COUNTED(Other, void, glDeleteShader, (GLuint shader), (shader))
+GL_COUNTED(Other, GLuint, glCreateProgram, (void), ())
+GL_COUNTED(Other, void, glAttachShader, (GLuint program, GLuint shader), (program, shader))
+GL_COUNTED(Other, void, glLinkProgram, (GLuint program), (program))
+GL_COUNTED(Other, void, glProgramParameteri, (GLuint program, GLenum name, GLint value), (program, name, value))
+GL_COUNTED(Other, void, glProgramBinary, (GLuint program, GLenum format, const void* binary, GLsizei length), (program, format, binary, length))
+
+// The program in use decides the renderer the following calls are counted for, its own call included.
+extern "C" GL_APICALL void GL_APIENTRY glUseProgram(GLuint program) {
+    static const auto next = reinterpret_cast<void(GL_APIENTRY*)(GLuint)>(NextGlFunction("glUseProgram"));
+    s_current = &Renderer(program);
+    Count(GlCallCounts::Bind);
+    next(program);
+}
+
+// Program labels are the renderer names.
+extern "C" GL_APICALL void GL_APIENTRY glObjectLabel(GLenum identifier, GLuint name, GLsizei length, const GLchar* label) {
+    static const auto next = reinterpret_cast<void(GL_APIENTRY*)(GLenum, GLuint, GLsizei, const GLchar*)>(NextGlFunction("glObjectLabel"));
+    Count(GlCallCounts::Other);
+    if (identifier == GL_PROGRAM && label != nullptr) {
+        s_labels[name] = length < 0 ? std::string(label) : std::string(label, length);
+    }
+    next(identifier, name, length, label);
+}
+
+// Program names are reused, a deleted program loses its label.
+extern "C" GL_APICALL void GL_APIENTRY glDeleteProgram(GLuint program) {
+    static const auto next = reinterpret_cast<void(GL_APIENTRY*)(GLuint)>(NextGlFunction("glDeleteProgram"));
+    Count(GlCallCounts::Other);
+    s_labels.erase(program);
+    next(program);
+}
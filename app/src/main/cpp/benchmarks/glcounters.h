@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <map>
+#include <string>
+
+// Counts of the GL calls the app makes, by kind. The counts come from glcounters.cpp, which defines the GL ES entry
+// points the app uses in the executable it is linked into: each one counts itself and calls the driver's. Functions
+// the app loads through eglGetProcAddress are not counted.
+struct GlCallCounts {
+    enum Kind {
+        Draw,           // glDraw*
+        Uniform,        // glUniform*
+        BufferUpload,   // glBufferData, glBufferSubData
+        TextureUpload,  // glTexImage*, glTexSubImage*, glTexStorage*
+        Bind,           // glBind*, glUseProgram, glActiveTexture
+        State,          // raster, blend, depth, texture and vertex attribute state
+        Get,            // glGet* other than glGetError, glCheckFramebufferStatus
+        GetError,
+        Other,          // object creation and deletion, clears, syncs, shader compilation
+        KindCount
+    };
+
+    uint64_t calls[KindCount] = {};
+
+    static const char* Name(Kind kind);
+
+    uint64_t Total() const;
+    GlCallCounts& operator+=(const GlCallCounts& other);
+    GlCallCounts operator-(const GlCallCounts& other) const;
+};
+
+// What has been counted since the process started: in total and by renderer, i.e. by the label of the program in use
+// when the call was made (see Shader::loadShader). Calls with no program in use go to "none", calls while an unlabeled
+// one is in use to "program <id>". Differences of two snapshots give the calls in between.
+struct GlCallSnapshot {
+    GlCallCounts total;
+    std::map<std::string, GlCallCounts> renderers;
+
+    static GlCallSnapshot Take();
+
+    GlCallSnapshot& operator+=(const GlCallSnapshot& other);
+    GlCallSnapshot operator-(const GlCallSnapshot& other) const;
+};
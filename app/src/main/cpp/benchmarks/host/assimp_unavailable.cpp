@@ -0,0 +1,28 @@
+#include "assimp/Importer.hpp"
+#include "assimp/material.h"
+
+// Stands in for assimp on hosts without one, so that the models the application loads (controller, hands) link. It
+// imports nothing: Model::parseModel fails and the models are simply not drawn, as with a missing asset.
+
+namespace Assimp {
+Importer::Importer() : pimpl(nullptr) {}
+
+Importer::~Importer() {}
+
+const aiScene* Importer::ReadFileFromMemory(const void*, size_t, unsigned int, const char*) {
+    return nullptr;
+}
+
+const char* Importer::GetErrorString() const {
+    return "built without assimp";
+}
+}  // namespace Assimp
+
+extern "C" unsigned int aiGetMaterialTextureCount(const C_STRUCT aiMaterial*, C_ENUM aiTextureType) {
+    return 0;
+}
+
+extern "C" aiReturn aiGetMaterialTexture(const C_STRUCT aiMaterial*, aiTextureType, unsigned int, aiString*, aiTextureMapping*, unsigned int*,
+                                         ai_real*, aiTextureOp*, aiTextureMapMode*, unsigned int*) {
+    return aiReturn_FAILURE;
+}
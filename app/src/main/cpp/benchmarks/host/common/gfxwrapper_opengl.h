@@ -0,0 +1,62 @@
+#pragma once
+
+// Stands in for openxr_loader/include/common/gfxwrapper_opengl.h in host builds: on Linux that header picks desktop
+// GL and GLX, the demos are written against the GL ES 3.2 headers and extensions it sets up on Android. Only that part
+// is provided, and the ksGpu* window only so far that the windowed plugin compiles: the host runs the headless one.
+// The extension functions are loaded by GlInitExtensions, see host/gfxwrapper_opengl.cpp.
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <GLES3/gl3.h>
+#include <GLES3/gl32.h>
+#include <GLES3/gl3ext.h>
+
+#define OPENGL_VERSION_MAJOR 3
+#define OPENGL_VERSION_MINOR 2
+#define GLSL_VERSION "320 es"
+#define GRAPHICS_API_OPENGL_ES 1
+
+// GL_EXT_disjoint_timer_query without _EXT
+#if !defined(GL_TIMESTAMP)
+#define GL_QUERY_COUNTER_BITS GL_QUERY_COUNTER_BITS_EXT
+#define GL_TIME_ELAPSED GL_TIME_ELAPSED_EXT
+#define GL_TIMESTAMP GL_TIMESTAMP_EXT
+#define GL_GPU_DISJOINT GL_GPU_DISJOINT_EXT
+#endif
+
+// GL_EXT_disjoint_timer_query
+extern PFNGLQUERYCOUNTEREXTPROC glQueryCounter;
+extern PFNGLGETQUERYOBJECTI64VEXTPROC glGetQueryObjecti64v;
+extern PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64v;
+
+// GL_OVR_multiview
+extern PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC glFramebufferTextureMultiviewOVR;
+
+// GL_EXT_multisampled_render_to_texture
+extern PFNGLRENDERBUFFERSTORAGEMULTISAMPLEEXTPROC glRenderbufferStorageMultisampleEXT;
+extern PFNGLFRAMEBUFFERTEXTURE2DMULTISAMPLEEXTPROC glFramebufferTexture2DMultisampleEXT;
+
+// Loads the extension functions above, with a context current.
+void GlInitExtensions();
+
+// The ksGpuWindow of the windowed OpenGLES plugin, it cannot be created on the host.
+typedef struct {
+} ksDriverInstance;
+typedef struct {
+} ksGpuQueueInfo;
+typedef enum { KS_GPU_SURFACE_COLOR_FORMAT_B8G8R8A8 } ksGpuSurfaceColorFormat;
+typedef enum { KS_GPU_SURFACE_DEPTH_FORMAT_D24 } ksGpuSurfaceDepthFormat;
+typedef enum { KS_GPU_SAMPLE_COUNT_1 = 1 } ksGpuSampleCount;
+typedef struct {
+    EGLContext context;
+} ksGpuContext;
+typedef struct {
+    EGLDisplay display;
+    ksGpuContext context;
+} ksGpuWindow;
+
+inline bool ksGpuWindow_Create(ksGpuWindow*, ksDriverInstance*, const ksGpuQueueInfo*, int, ksGpuSurfaceColorFormat, ksGpuSurfaceDepthFormat,
+                               ksGpuSampleCount, int, int, bool) {
+    return false;
+}
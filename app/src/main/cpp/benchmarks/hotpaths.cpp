@@ -0,0 +1,189 @@
+#include "pch.h"
+#include "common.h"
+#include "benchmark.h"
+#include "demos/utils.h"
+#include "demos/playerGeometry.h"
+#include "demos/cube.h"
+#include "demos/gui.h"
+#include "demos/text.h"
+#include "demos/glResource.h"
+#include "glm/gtc/matrix_transform.hpp"
+#ifdef BENCHMARK_ASSIMP
+#include "demos/model.h"
+#endif
+
+// The CPU work the demos do per frame and at load, timed on the host. See benchmark.h for what is reported.
+//
+//   hotpath_benchmarks [--out results.json] [--filter substring] [--quick] [--assets directory]
+//
+// --quick runs every benchmark briefly, to check that they all work. --assets defaults to app/src/main/assets.
+
+namespace {
+void BenchmarkPlayerGeometry(BenchmarkRunner& runner) {
+    const std::pair<PlayModel, const char*> models[] = {
+        {playModel_2D, "2D"}, {playModel_2D_360, "2D_360"}, {playModel_3D_SBS, "3D_SBS"}, {playModel_3D_OU, "3D_OU"}};
+    for (const auto& model : models) {
+        // The player keeps its vectors, so from the second call on this is the cost of a play model switch.
+        std::vector<SampleVertex2D> vertices2D;
+        std::vector<SampleVertex3D> vertices3D;
+        std::vector<GLuint> indices;
+        createPlayerGeometry(model.first, vertices2D, vertices3D, indices);
+        const double vertices = static_cast<double>(vertices2D.size() + vertices3D.size());
+        const double indexCount = static_cast<double>(indices.size());
+        runner.Run(Fmt("player/geometry/%s", model.second),
+                   [&] {
+                       createPlayerGeometry(model.first, vertices2D, vertices3D, indices);
+                       KeepResult(indices.data());
+                   },
+                   {{"vertices", vertices}, {"indices", indexCount}});
+    }
+}
+
+void BenchmarkModels(BenchmarkRunner& runner) {
+#ifdef BENCHMARK_ASSIMP
+    const std::pair<const char*, const char*> hands[] = {{"Hand_L", "l_handMesh"}, {"Hand_R", "r_handMesh"}};
+    for (const auto& hand : hands) {
+        // What Hand::load does on the startup worker: import, processMesh/processMeshBone of every node, texture decode.
+        runner.Run(Fmt("model/parse/%s", hand.first), [&] {
+            Model model(hand.first, true);
+            model.bindMeshTexture(hand.second, "hand/0.png");
+            KeepResult(model.parseModel(Fmt("hand/%s.fbx", hand.first)));
+        });
+    }
+#else
+    (void)runner;
+#endif
+}
+
+void BenchmarkGuiIntersection(BenchmarkRunner& runner) {
+    Gui panel("benchmark");
+    if (!panel.initialize(600, 800)) {
+        Log::Write(Log::Level::Error, "Gui initialization failed, skipping the gui benchmarks");
+        return;
+    }
+    panel.setModel(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -2.0f)));
+
+    // The controller ray of updateDashboard, once on the panel and once past it. A hit also queues the mouse position,
+    // the same position every time so that ImGui coalesces the events.
+    const glm::vec3 origin(0.0f, 0.0f, 0.0f);
+    const glm::vec3 onPanel = glm::normalize(glm::vec3(0.1f, 0.2f, -1.0f));
+    const glm::vec3 pastPanel = glm::normalize(glm::vec3(3.0f, 0.0f, -1.0f));
+    runner.Run("gui/intersect/hit", [&] { KeepResult(panel.isIntersectWithLine(origin, onPanel)); });
+    runner.Run("gui/intersect/miss", [&] { KeepResult(panel.isIntersectWithLine(origin, pastPanel)); });
+}
+
+void BenchmarkHandJoints(BenchmarkRunner& runner) {
+    // Both hands fully tracked, the most updateHandTracking ever converts in a frame.
+    XrHandJointLocationEXT joints[HAND_COUNT][XR_HAND_JOINT_COUNT_EXT];
+    for (int hand = 0; hand < HAND_COUNT; hand++) {
+        for (int i = 0; i < XR_HAND_JOINT_COUNT_EXT; i++) {
+            const float angle = 0.1f * i;
+            joints[hand][i].locationFlags = XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_POSITION_TRACKED_BIT |
+                                            XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT;
+            joints[hand][i].pose.position = {hand == HAND_LEFT ? -0.2f : 0.2f, -0.1f + 0.01f * i, -0.4f};
+            joints[hand][i].pose.orientation = {0.0f, sinf(angle / 2), 0.0f, cosf(angle / 2)};
+            joints[hand][i].radius = 0.01f;
+        }
+    }
+
+    std::vector<CubeRender::Cube> cubes;
+    runner.Run("hand/joints_to_cubes",
+               [&] {
+                   cubes.clear();
+                   for (int hand = 0; hand < HAND_COUNT; hand++) {
+                       CubeRender::appendJoints(joints[hand], XR_HAND_JOINT_COUNT_EXT, 0.01f, cubes);
+                   }
+                   KeepResult(cubes.data());
+               },
+               {{"joints", HAND_COUNT * XR_HAND_JOINT_COUNT_EXT}});
+}
+
+// Swallows what Log::Write prints, the benchmark is about formatting it, not about the terminal.
+class NullBuffer : public std::streambuf {
+   protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+void BenchmarkLog(BenchmarkRunner& runner) {
+    const std::string message = Fmt("frame %d: %u draws, %.2fms", 1234, 56u, 7.89f);
+    Log::SetLevel(Log::Level::Info);
+    runner.Run("log/write/filtered", [&] { Log::Write(Log::Level::Verbose, message); });
+
+    // Only around the call, the results of the runner are logged too.
+    NullBuffer null;
+    runner.Run("log/write", [&] {
+        std::streambuf* out = std::cout.rdbuf(&null);
+        Log::Write(Log::Level::Info, message);
+        std::cout.rdbuf(out);
+    });
+    runner.Run("log/write/location", [&] {
+        std::streambuf* out = std::cout.rdbuf(&null);
+        Log::Write(Log::Level::Info, __FILE__, __LINE__, message);
+        std::cout.rdbuf(out);
+    });
+}
+
+void BenchmarkText(BenchmarkRunner& runner, const std::string& assets) {
+    // The font is not checked in, it has to be copied into the assets first.
+    if (FILE* font = fopen((assets + "/" + Text::FontAsset).c_str(), "rb")) {
+        fclose(font);
+    } else {
+        Log::Write(Log::Level::Warning, Fmt("No %s under %s, skipping the text benchmarks", Text::FontAsset, assets.c_str()));
+        return;
+    }
+
+    // Text::load rasterizes the digits on the startup worker, initialize uploads them on the GL thread.
+    runner.Run("text/load", [] {
+        Text text;
+        KeepResult(text.load());
+    });
+    runner.Run("text/load_upload", [] {
+        {
+            Text text;
+            text.load();
+            KeepResult(text.initialize());
+        }
+        GlDeletionQueue::instance().endFrame();
+    });
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    BenchmarkRunner::Options options;
+    std::string assets = BENCHMARK_ASSET_DIR;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) {
+            options.output = argv[++i];
+        } else if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "--assets" && i + 1 < argc) {
+            assets = argv[++i];
+        } else if (arg == "--quick") {
+            options.minSeconds = 0.02;
+            options.samples = 5;
+        } else {
+            Log::Write(Log::Level::Error, Fmt("Unknown argument %s", arg.c_str()));
+            return 2;
+        }
+    }
+    Log::SetLevel(Log::Level::Info);
+    setAssetDirectory(assets);
+
+    HostGlContext context;
+    if (!context.Create()) {
+        return 1;
+    }
+
+    BenchmarkRunner runner(options);
+    BenchmarkPlayerGeometry(runner);
+    BenchmarkModels(runner);
+    BenchmarkGuiIntersection(runner);
+    BenchmarkHandJoints(runner);
+    BenchmarkLog(runner);
+    BenchmarkText(runner, assets);
+
+    GlDeletionQueue::instance().shutdown();
+    return runner.WriteResults() ? 0 : 1;
+}
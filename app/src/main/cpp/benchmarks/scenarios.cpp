@@ -0,0 +1,455 @@
+#include "pch.h"
+#include "common.h"
+#include "options.h"
+#include "graphicsplugin.h"
+#include "offscreenviews.h"
+#include "startuptasks.h"
+#include "benchmark.h"
+#include "glcounters.h"
+#include "demos/application.h"
+#include "demos/utils.h"
+#include "demos/drawList.h"
+#include "demos/mesh.h"
+#include "demos/text.h"
+#include "demos/glState.h"
+#include "demos/gpuMemory.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+// The application rendered frame by frame on the headless plugin, counting the GL calls every eye and every frame
+// makes. Each scenario has budgets for them, a run fails when one is exceeded: a change that draws the same with more
+// calls shows up here without a GPU. The time of a frame is reported as well, the GL work issued, not waited for.
+//
+//   scenario_benchmarks [--out results.json] [--filter substring] [--quick] [--assets directory]
+//
+// The counts of a scenario are the same on every host, --quick only shortens the timing.
+
+namespace {
+constexpr int32_t ViewWidth = 256;
+constexpr int32_t ViewHeight = 256;
+constexpr XrDuration FramePeriod = 13888889;  // 72Hz
+constexpr uint32_t WarmUpFrames = 3;
+constexpr uint32_t CountedFrames = 4;
+
+// Forwards to the application and adds up the calls of every renderFrame, the part of an eye the application owns.
+class CountingApplication : public IApplication {
+   public:
+    explicit CountingApplication(std::shared_ptr<IApplication> application) : m_application(std::move(application)) {}
+
+    bool initialize(const XrInstance instance, const XrSession session, const std::vector<std::string>& enabledExtensions,
+                    StartupTasks& startup) override {
+        return m_application->initialize(instance, session, enabledExtensions, startup);
+    }
+    void setControllerPose(int leftright, const XrPosef& pose) override { m_application->setControllerPose(leftright, pose); }
+    void setHandJointLocation(XrHandJointLocationEXT* location) override { m_application->setHandJointLocation(location); }
+    InputEventQueue& inputQueue() override { return m_application->inputQueue(); }
+    void setTrackingSnapshot(const TrackingSnapshot& snapshot) override { m_application->setTrackingSnapshot(snapshot); }
+    void update(XrTime predictedDisplayTime, XrDuration predictedDisplayPeriod) override {
+        m_application->update(predictedDisplayTime, predictedDisplayPeriod);
+    }
+    void renderFrame(int32_t eye, const glm::vec3& viewPosition) override {
+        const GlCallSnapshot before = GlCallSnapshot::Take();
+        m_application->renderFrame(eye, viewPosition);
+        m_eyeCalls += GlCallSnapshot::Take() - before;
+        m_eyes++;
+    }
+    void appendLayers(XrSpace space, std::vector<const XrCompositionLayerBaseHeader*>& underlays,
+                      std::vector<const XrCompositionLayerBaseHeader*>& overlays) override {
+        m_application->appendLayers(space, underlays, overlays);
+    }
+    void releaseXrResources() override { m_application->releaseXrResources(); }
+
+    void ResetCounts() {
+        m_eyeCalls = GlCallSnapshot();
+        m_eyes = 0;
+    }
+    const GlCallSnapshot& EyeCalls() const { return m_eyeCalls; }
+    uint32_t Eyes() const { return m_eyes; }
+
+   private:
+    std::shared_ptr<IApplication> m_application;
+    GlCallSnapshot m_eyeCalls;
+    uint32_t m_eyes{0};
+};
+
+// Application draws neither models nor text at the moment, this draws count of them the way it would: one model placed
+// count times, or count labels of four digits each. The model is a textured quad drawn as a Mesh, which is what
+// Model::render submits for each of its meshes; importing a real one would need assimp, which the host may not have.
+class PropsApplication : public IApplication {
+   public:
+    enum class Prop { Models, Text };
+
+    PropsApplication(Prop prop, uint32_t count) : m_prop(prop), m_count(count) {}
+
+    bool initialize(const XrInstance, const XrSession, const std::vector<std::string>&, StartupTasks& startup) override {
+        if (m_prop == Prop::Models) {
+            m_ready = initializeMesh();
+        } else {
+            m_text = std::make_shared<Text>();
+            std::shared_ptr<Text> text = m_text;
+            const auto glyphs = startup.Add("font glyphs", StartupTasks::Thread::Worker, [text] { return text->load(); });
+            startup.Add("text upload", StartupTasks::Thread::Render, [this, text] {
+                m_ready = text->initialize();
+                return m_ready;
+            }, {glyphs});
+        }
+        return true;
+    }
+    void setControllerPose(int, const XrPosef&) override {}
+    void setHandJointLocation(XrHandJointLocationEXT*) override {}
+    InputEventQueue& inputQueue() override { return m_inputQueue; }
+    void setTrackingSnapshot(const TrackingSnapshot&) override {}
+    void update(XrTime, XrDuration) override {}
+    void renderFrame(int32_t, const glm::vec3& viewPosition) override {
+        m_drawList.begin(viewPosition);
+        for (uint32_t i = 0; m_ready && i < m_count; i++) {
+            // A grid in front of the viewer, eight per row.
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(-0.7f + 0.2f * (i % 8), 0.4f - 0.2f * (i / 8), -1.5f));
+            if (m_prop == Prop::Models) {
+                m_mesh->render(m_drawList, m_shader, glm::scale(model, glm::vec3(0.15f)));
+            } else {
+                wchar_t label[8];
+                swprintf(label, 8, L"%04u", i);
+                m_text->render(m_drawList, glm::scale(model, glm::vec3(0.2f, 0.2f, 1.0f)), label, 4, glm::vec3(1.0f));
+            }
+        }
+        m_drawList.execute();
+    }
+    void appendLayers(XrSpace, std::vector<const XrCompositionLayerBaseHeader*>&, std::vector<const XrCompositionLayerBaseHeader*>&) override {}
+    void releaseXrResources() override {}
+
+   private:
+    bool initializeMesh() {
+        const char* vertexShaderCode = R"_(
+            #version 320 es
+            layout(location = 0) in vec3 aPos;
+            layout(location = 2) in vec2 aTexCoords;
+            out vec2 TexCoords;
+            uniform mat4 model;
+            void main()
+            {
+                TexCoords = aTexCoords;
+                gl_Position = projection[VIEW_ID] * view[VIEW_ID] * model * vec4(aPos, 1.0);
+            }
+        )_";
+        const char* fragmentShaderCode = R"_(
+            #version 320 es
+            precision mediump float;
+            in vec2 TexCoords;
+            out vec4 FragColor;
+            uniform sampler2D texture_diffuse1;
+            void main()
+            {
+                FragColor = texture(texture_diffuse1, TexCoords);
+            }
+        )_";
+        if (!m_shader.loadShader(vertexShaderCode, fragmentShaderCode, true, "model")) {
+            return false;
+        }
+
+        m_texture = GlTexture::generate();
+        GlState::instance().bindTexture(0, GL_TEXTURE_2D, m_texture.get());
+        GpuMemory::instance().texStorage2D(GpuMemoryTag::Model, m_texture.get(), GL_TEXTURE_2D, 1, GL_RGBA8, 1, 1);
+
+        std::vector<Vertex> vertices(4);
+        for (uint32_t i = 0; i < 4; i++) {
+            vertices[i].TexCoords = glm::vec2(i & 1, i >> 1);
+            vertices[i].Position = glm::vec3(vertices[i].TexCoords - glm::vec2(0.5f), 0.0f);
+            vertices[i].Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+        }
+        m_mesh = std::make_shared<Mesh>(vertices, std::vector<unsigned int>{0, 1, 2, 2, 1, 3},
+                                        std::vector<Texture>{{m_texture.get(), "texture_diffuse", "white", true}});
+        return true;
+    }
+
+    const Prop m_prop;
+    const uint32_t m_count;
+    Shader m_shader;
+    GlTexture m_texture;
+    std::shared_ptr<Mesh> m_mesh;
+    std::shared_ptr<Text> m_text;
+    bool m_ready{false};
+    DrawList m_drawList;
+    InputEventQueue m_inputQueue;
+};
+
+// An upper (and optionally lower) limit of the calls of one kind, per eye (in renderFrame) or per frame (everything
+// between two frames, the plugin's passes included). A lower limit catches a scenario that silently draws nothing.
+// Limits by renderer only make sense per eye, see ScenarioRunner::Run.
+struct Budget {
+    enum Scope { Eye, Frame };
+    static constexpr int AllKinds = -1;
+
+    Scope scope;
+    const char* renderer;  // the program label, nullptr for the calls of all renderers
+    int kind;              // a GlCallCounts::Kind or AllKinds
+    uint64_t max;
+    uint64_t min = 0;
+};
+
+struct Scenario {
+    std::string name;
+    std::function<std::shared_ptr<IApplication>()> create;
+    bool closeDashboard;
+    uint32_t trackedJoints;  // of both hands together, hand cubes are drawn for these
+    std::vector<Budget> budgets;
+};
+
+uint64_t Count(const GlCallCounts& counts, int kind) {
+    return kind == Budget::AllKinds ? counts.Total() : counts.calls[kind];
+}
+
+// Mean calls per eye or frame, rounded up: the counts of a scenario are the same in every frame once it is warm.
+uint64_t Measure(const GlCallSnapshot& calls, uint32_t divisor, const char* renderer, int kind) {
+    if (renderer == nullptr) {
+        return (Count(calls.total, kind) + divisor - 1) / divisor;
+    }
+    const auto it = calls.renderers.find(renderer);
+    return it == calls.renderers.end() ? 0 : (Count(it->second, kind) + divisor - 1) / divisor;
+}
+
+class ScenarioRunner {
+   public:
+    ScenarioRunner(BenchmarkRunner& runner, OffscreenViews& views) : m_runner(runner), m_views(views) {
+        // Both views look at the scene from where the eyes of a head at the origin would be.
+        XrView view{};
+        view.type = XR_TYPE_VIEW;
+        m_xrViews.resize(2, view);
+        for (uint32_t i = 0; i < 2; i++) {
+            m_xrViews[i].pose = {{0.0f, 0.0f, 0.0f, 1.0f}, {i == 0 ? -0.032f : 0.032f, 0.0f, 0.0f}};
+            m_xrViews[i].fov = {-0.785f, 0.785f, 0.785f, -0.785f};
+        }
+        for (int hand = 0; hand < HAND_COUNT; hand++) {
+            for (int i = 0; i < XR_HAND_JOINT_COUNT_EXT; i++) {
+                XrHandJointLocationEXT& joint = m_joints[hand][i];
+                joint.pose = {{0.0f, 0.0f, 0.0f, 1.0f}, {hand == HAND_LEFT ? -0.2f : 0.2f, -0.2f + 0.01f * i, -0.5f}};
+                joint.radius = 0.01f;
+            }
+        }
+    }
+
+    // Returns false when the scenario could not be set up or exceeded a budget.
+    bool Run(const Scenario& scenario) {
+        if (!m_runner.Enabled(scenario.name)) {
+            return true;
+        }
+        for (int hand = 0; hand < HAND_COUNT; hand++) {
+            for (int i = 0; i < XR_HAND_JOINT_COUNT_EXT; i++) {
+                const bool tracked = static_cast<uint32_t>(hand * XR_HAND_JOINT_COUNT_EXT + i) < scenario.trackedJoints;
+                m_joints[hand][i].locationFlags = tracked ? XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_POSITION_TRACKED_BIT |
+                                                                XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT
+                                                          : 0;
+            }
+        }
+
+        auto counting = std::make_shared<CountingApplication>(scenario.create());
+        std::shared_ptr<IApplication> application = counting;
+        {
+            StartupTasks startup;
+            startup.Start();
+            if (!application->initialize(XR_NULL_HANDLE, XR_NULL_HANDLE, {}, startup)) {
+                Log::Write(Log::Level::Error, Fmt("%s: initialize failed", scenario.name.c_str()));
+                return false;
+            }
+            if (scenario.closeDashboard) {
+                InputEvent event{};
+                event.source = HAND_RIGHT;
+                event.changedBits = CONTROLLER_EVENT_BIT_click_menu;
+                event.stateBits = CONTROLLER_EVENT_BIT_click_menu;
+                application->inputQueue().Push(event);
+            }
+
+            // The frames the startup tasks come up behind, as on the device.
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+            while (!startup.RunRenderTasks(std::chrono::milliseconds(100))) {
+                if (std::chrono::steady_clock::now() > deadline) {
+                    Log::Write(Log::Level::Error, Fmt("%s: startup did not finish", scenario.name.c_str()));
+                    return false;
+                }
+                RenderFrame(application);
+            }
+        }
+
+        for (uint32_t i = 0; i < WarmUpFrames; i++) {
+            RenderFrame(application);
+        }
+        counting->ResetCounts();
+        const GlCallSnapshot before = GlCallSnapshot::Take();
+        for (uint32_t i = 0; i < CountedFrames; i++) {
+            RenderFrame(application);
+        }
+        const GlCallSnapshot frameCalls = GlCallSnapshot::Take() - before;
+        const GlCallSnapshot& eyeCalls = counting->EyeCalls();
+        const uint32_t eyes = counting->Eyes();
+        if (eyes == 0) {
+            Log::Write(Log::Level::Error, Fmt("%s: renderFrame was never called", scenario.name.c_str()));
+            return false;
+        }
+
+        std::map<std::string, double> counters;
+        for (int kind = 0; kind < GlCallCounts::KindCount; kind++) {
+            const char* name = GlCallCounts::Name(static_cast<GlCallCounts::Kind>(kind));
+            counters[Fmt("eye.%s", name)] = static_cast<double>(Measure(eyeCalls, eyes, nullptr, kind));
+            counters[Fmt("frame.%s", name)] = static_cast<double>(Measure(frameCalls, CountedFrames, nullptr, kind));
+        }
+        counters["eye.calls"] = static_cast<double>(Measure(eyeCalls, eyes, nullptr, Budget::AllKinds));
+        counters["frame.calls"] = static_cast<double>(Measure(frameCalls, CountedFrames, nullptr, Budget::AllKinds));
+        // By renderer only within renderFrame: the plugin's calls between the eyes go to whichever program was last in use.
+        for (const auto& renderer : eyeCalls.renderers) {
+            counters[Fmt("eye.%s.calls", renderer.first.c_str())] =
+                static_cast<double>(Measure(eyeCalls, eyes, renderer.first.c_str(), Budget::AllKinds));
+        }
+
+        bool withinBudget = true;
+        for (const Budget& budget : scenario.budgets) {
+            const bool perEye = budget.scope == Budget::Eye;
+            const uint64_t calls = Measure(perEye ? eyeCalls : frameCalls, perEye ? eyes : CountedFrames, budget.renderer, budget.kind);
+            if (calls > budget.max || calls < budget.min) {
+                Log::Write(Log::Level::Error, Fmt("%s: %llu %s of %s per %s, the budget is %llu to %llu", scenario.name.c_str(),
+                                                  static_cast<unsigned long long>(calls),
+                                                  budget.kind == Budget::AllKinds ? "GL calls" : GlCallCounts::Name(static_cast<GlCallCounts::Kind>(budget.kind)),
+                                                  budget.renderer != nullptr ? budget.renderer : "all renderers", perEye ? "eye" : "frame",
+                                                  static_cast<unsigned long long>(budget.min), static_cast<unsigned long long>(budget.max)));
+                withinBudget = false;
+            }
+        }
+
+        m_runner.Run(scenario.name, [&] { RenderFrame(application); }, std::move(counters));
+        glFinish();
+        return withinBudget;
+    }
+
+   private:
+    void RenderFrame(std::shared_ptr<IApplication>& application) {
+        // Controllers held low in front, pointing at the dashboard.
+        application->setControllerPose(HAND_LEFT, {{0.0f, 0.0f, 0.0f, 1.0f}, {-0.2f, -0.3f, -0.3f}});
+        application->setControllerPose(HAND_RIGHT, {{0.0f, 0.0f, 0.0f, 1.0f}, {0.2f, -0.3f, -0.3f}});
+        application->setHandJointLocation(&m_joints[0][0]);
+        m_frame++;
+        m_views.RenderFrame(application, m_xrViews, m_frame * FramePeriod, FramePeriod);
+    }
+
+    BenchmarkRunner& m_runner;
+    OffscreenViews& m_views;
+    std::vector<XrView> m_xrViews;
+    XrHandJointLocationEXT m_joints[HAND_COUNT][XR_HAND_JOINT_COUNT_EXT]{};
+    XrTime m_frame{0};
+};
+
+bool HasAsset(const std::string& assets, const char* asset) {
+    if (FILE* file = fopen((assets + "/" + asset).c_str(), "rb")) {
+        fclose(file);
+        return true;
+    }
+    return false;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    BenchmarkRunner::Options benchmarkOptions;
+    std::string assets = BENCHMARK_ASSET_DIR;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) {
+            benchmarkOptions.output = argv[++i];
+        } else if (arg == "--filter" && i + 1 < argc) {
+            benchmarkOptions.filter = argv[++i];
+        } else if (arg == "--assets" && i + 1 < argc) {
+            assets = argv[++i];
+        } else if (arg == "--quick") {
+            benchmarkOptions.minSeconds = 0.02;
+            benchmarkOptions.samples = 5;
+        } else {
+            Log::Write(Log::Level::Error, Fmt("Unknown argument %s", arg.c_str()));
+            return 2;
+        }
+    }
+    Log::SetLevel(Log::Level::Info);
+    setAssetDirectory(assets);
+
+    // Rendered per eye, so that every renderFrame is one eye; the dashboard is drawn into the eyes, there is no
+    // runtime to composite a quad layer.
+    auto options = std::make_shared<Options>();
+    options->GraphicsPlugin = "Headless";
+    options->Multiview = false;
+    options->GuiQuadLayer = false;
+    options->VideoSurfaceLayer = false;
+    options->DynamicResolution = false;
+    std::shared_ptr<IGraphicsPlugin> graphicsPlugin = CreateGraphicsPlugin(options, nullptr);
+    graphicsPlugin->InitializeDevice(XR_NULL_HANDLE, XR_NULL_SYSTEM_ID);
+    OffscreenViews views(graphicsPlugin, 2, ViewWidth, ViewHeight);
+
+    const auto application = [options, graphicsPlugin](const std::string& videoFile) {
+        return [options, graphicsPlugin, videoFile] {
+            auto scenarioOptions = std::make_shared<Options>(*options);
+            scenarioOptions->VideoFile = videoFile;
+            return createApplication(scenarioOptions, graphicsPlugin);
+        };
+    };
+    const auto props = [](PropsApplication::Prop prop, uint32_t count) {
+        return [prop, count]() -> std::shared_ptr<IApplication> { return std::make_shared<PropsApplication>(prop, count); };
+    };
+    using K = GlCallCounts;
+    const int All = Budget::AllKinds;
+
+    // The limits are what the scenarios make today, a change that needs more calls has to raise them on purpose. Every
+    // frame of the application draws the fixed cube and both controller rays; every uniform a packet sets looks up its
+    // location first, hence a glGetUniformLocation per glUniform*.
+    std::vector<Scenario> scenarios = {
+        {"app/idle", application(""), true, 0,
+         {{Budget::Eye, nullptr, All, 24}, {Budget::Eye, nullptr, K::Draw, 3, 3}, {Budget::Eye, nullptr, K::Uniform, 7},
+          {Budget::Eye, nullptr, K::Get, 7}, {Budget::Eye, nullptr, K::GetError, 0}, {Budget::Frame, nullptr, All, 59},
+          {Budget::Frame, nullptr, K::BufferUpload, 2}}},
+    };
+    for (const uint32_t joints : {1u, 26u, 52u}) {
+        // A draw per joint, each setting its model matrix.
+        scenarios.push_back({Fmt("app/hand_cubes/%u", joints), application(""), true, joints,
+                             {{Budget::Eye, nullptr, All, 24 + 3 * joints},
+                              {Budget::Eye, nullptr, K::Draw, 3 + joints, 3 + joints},
+                              {Budget::Eye, nullptr, K::Uniform, 7 + joints},
+                              {Budget::Eye, nullptr, K::Get, 7 + joints},
+                              {Budget::Eye, nullptr, K::GetError, 0},
+                              {Budget::Frame, nullptr, All, 59 + 6 * joints}}});
+    }
+    // The panel is a single textured quad in the eyes, the ImGui pass that fills its texture runs once per frame.
+    scenarios.push_back({"app/dashboard", application(""), false, 0,
+                         {{Budget::Eye, nullptr, All, 33}, {Budget::Eye, nullptr, K::Draw, 4, 4}, {Budget::Eye, "gui", K::Draw, 1, 1},
+                          {Budget::Eye, nullptr, K::GetError, 0}, {Budget::Frame, nullptr, All, 105},
+                          {Budget::Frame, nullptr, K::BufferUpload, 4}}});
+    // The host player decodes nothing, the file only has to be named: the sphere is drawn with whatever the texture
+    // holds. llvmpipe cannot compile the external texture shader, its calls are counted all the same.
+    scenarios.push_back({"app/playback_360", application("playback_360.mp4"), true, 0,
+                         {{Budget::Eye, nullptr, All, 31}, {Budget::Eye, nullptr, K::Draw, 4, 4}, {Budget::Eye, "player", K::Draw, 1, 1},
+                          {Budget::Eye, nullptr, K::GetError, 0}, {Budget::Frame, nullptr, All, 73}}});
+    for (const uint32_t count : {1u, 16u, 64u}) {
+        // A single mesh with a single texture: per placement a draw, the model matrix and the sampler, each looked up
+        // first. The program, vertex array and texture stay bound from one placement to the next.
+        scenarios.push_back({Fmt("scene/models/%u", count), props(PropsApplication::Prop::Models, count), false, 0,
+                             {{Budget::Eye, nullptr, K::Draw, count, count},
+                              {Budget::Eye, "model", All, 5 * count},
+                              {Budget::Eye, nullptr, K::GetError, 0}}});
+    }
+    if (HasAsset(assets, Text::FontAsset)) {
+        // Every glyph writes its vertices with a glBufferSubData of its own and is a draw of its own.
+        const std::pair<uint32_t, uint64_t> labels[] = {{1, 25}, {16, 419}, {64, 1688}};
+        for (const auto& label : labels) {
+            const uint32_t glyphs = 4 * label.first;
+            scenarios.push_back({Fmt("scene/text/%u", label.first), props(PropsApplication::Prop::Text, label.first), false, 0,
+                                 {{Budget::Eye, nullptr, K::Draw, glyphs, glyphs},
+                                  {Budget::Eye, "text", All, label.second},
+                                  {Budget::Eye, nullptr, K::BufferUpload, glyphs + 1},
+                                  {Budget::Eye, nullptr, K::GetError, 0}}});
+        }
+    } else {
+        Log::Write(Log::Level::Warning, Fmt("No %s under %s, skipping the text scenarios", Text::FontAsset, assets.c_str()));
+    }
+
+    BenchmarkRunner runner(benchmarkOptions);
+    ScenarioRunner scenarioRunner(runner, views);
+    bool withinBudget = true;
+    for (const Scenario& scenario : scenarios) {
+        withinBudget = scenarioRunner.Run(scenario) && withinBudget;
+    }
+
+    const bool written = runner.WriteResults();
+    return withinBudget && written ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+#include "pch.h"
+#include "common.h"
+#include "options.h"
+#include "graphicsplugin.h"
+#include "offscreenviews.h"
+#include "sessionrecording.h"
+#include "startuptasks.h"
+#include "demos/application.h"
+#include "demos/utils.h"
+
+// Plays a recording made with debug.xr.recordSession through the application on the headless plugin, as fast as the
+// frames can be issued or as far apart as they were shown. The application renders each frame into views of its own,
+// there is no runtime; logs, GL validation and the GPU memory report work as on the glasses.
+//
+//   session_replay <recording> [--realtime] [--size <width>x<height>] [--assets directory]
+
+namespace {
+constexpr int32_t DefaultViewWidth = 1920;  // the recommended view of the glasses
+constexpr int32_t DefaultViewHeight = 1080;
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string path;
+    std::string assets = BENCHMARK_ASSET_DIR;
+    SessionReplayer::Pace pace = SessionReplayer::Pace::FullSpeed;
+    int32_t width = DefaultViewWidth;
+    int32_t height = DefaultViewHeight;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--realtime") {
+            pace = SessionReplayer::Pace::RealTime;
+        } else if (arg == "--size" && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                Log::Write(Log::Level::Error, Fmt("Bad view size %s", argv[i]));
+                return 2;
+            }
+        } else if (arg == "--assets" && i + 1 < argc) {
+            assets = argv[++i];
+        } else if (path.empty() && arg[0] != '-') {
+            path = arg;
+        } else {
+            Log::Write(Log::Level::Error, Fmt("Unknown argument %s", arg.c_str()));
+            return 2;
+        }
+    }
+    if (path.empty()) {
+        Log::Write(Log::Level::Error, "Usage: session_replay <recording> [--realtime] [--size <width>x<height>] [--assets directory]");
+        return 2;
+    }
+    Log::SetLevel(Log::Level::Info);
+    setAssetDirectory(assets);
+
+    SessionReplayer replayer;
+    if (!replayer.Open(path)) {
+        return 1;
+    }
+
+    // The layers the application would submit itself are drawn into the eyes, there is no runtime to composite them.
+    auto options = std::make_shared<Options>();
+    options->GraphicsPlugin = "Headless";
+    options->GuiQuadLayer = false;
+    options->VideoSurfaceLayer = false;
+    try {
+        std::shared_ptr<IGraphicsPlugin> graphicsPlugin = CreateGraphicsPlugin(options, nullptr);
+        graphicsPlugin->InitializeDevice(XR_NULL_HANDLE, XR_NULL_SYSTEM_ID);
+        OffscreenViews views(graphicsPlugin, replayer.ViewCount(), width, height);
+
+        std::shared_ptr<IApplication> application = createApplication(options, graphicsPlugin);
+        {
+            StartupTasks startup;
+            startup.Start();
+            CHECK_MSG(application->initialize(XR_NULL_HANDLE, XR_NULL_HANDLE, {}, startup), "Application initialize failed");
+            // Replayed from its first frame on with everything loaded, so that runs of the same recording compare.
+            while (!startup.RunRenderTasks(std::chrono::milliseconds(100))) {
+            }
+        }
+
+        const uint32_t frames = replayer.Run(application, views, pace);
+        application->releaseXrResources();
+        return frames > 0 ? 0 : 1;
+    } catch (const std::exception& ex) {
+        Log::Write(Log::Level::Error, ex.what());
+        return 1;
+    }
+}
@@ -0,0 +1,232 @@
+#include "pch.h"
+#include "common.h"
+#include "sessionrecording.h"
+#include "trackingworker.h"
+#include "demos/application.h"
+
+#include <filesystem>
+#include <unistd.h>
+
+// Records synthetic frames with SessionRecorder and replays them with SessionReplayer::Next into an application that
+// keeps what it is handed: poses, joints, input events and tracking snapshots have to come back as recorded, and a
+// recording cut short has to end at its last complete frame.
+//
+//   sessionrecording_test [directory for the recordings]
+
+namespace {
+using namespace SessionRecording;
+
+// More frames than fit the recorder's window, so that it is moved at least once.
+constexpr uint32_t FrameCount = 2 * SessionRecorder::WindowSize / sizeof(Frame) + 10;
+constexpr XrTime FirstDisplayTime = 1000000000;
+constexpr XrDuration DisplayPeriod = 16666667;
+
+uint32_t g_failures = 0;
+
+void Expect(bool condition, const std::string& what) {
+    if (!condition) {
+        Log::Write(Log::Level::Error, what);
+        g_failures++;
+    }
+}
+
+bool SamePose(const XrPosef& a, const XrPosef& b) { return memcmp(&a, &b, sizeof(a)) == 0; }
+
+// What the recording of frame i holds, distinct in every field that is compared.
+Frame MakeFrame(uint32_t i) {
+    Frame frame{};
+    frame.predictedDisplayPeriod = DisplayPeriod;
+    frame.viewCount = 2;
+    frame.controllerPoseMask = i % 4;
+    for (uint32_t view = 0; view < 2; view++) {
+        frame.views[view].pose = {{0.0f, 0.0f, 0.0f, 1.0f}, {view == 0 ? -0.032f : 0.032f, 0.001f * i, 0.0f}};
+        frame.views[view].fov = {-0.4f, 0.4f, 0.3f, -0.3f};
+    }
+    for (uint32_t hand = 0; hand < 2; hand++) {
+        frame.controllerPose[hand] = {{0.0f, 0.0f, 0.0f, 1.0f}, {static_cast<float>(hand), static_cast<float>(i), -0.5f}};
+        for (uint32_t joint = 0; joint < XR_HAND_JOINT_COUNT_EXT; joint++) {
+            XrHandJointLocationEXT& location = frame.joints[hand][joint];
+            location.locationFlags = (i + joint) % 3 == 0 ? 0 : XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT;
+            location.pose = {{0.0f, 0.0f, 0.0f, 1.0f}, {0.01f * joint, 0.001f * i, static_cast<float>(hand)}};
+            location.radius = 0.005f + 0.0001f * joint;
+        }
+    }
+    return frame;
+}
+
+// Frames that are multiples of three follow an input event, of five a new tracking snapshot.
+InputEvent MakeInput(uint32_t i) {
+    InputEvent event{};
+    event.timeNs = static_cast<int64_t>(i);
+    event.source = static_cast<int32_t>(i % 3);
+    event.changedBits = 1u << (i % 8);
+    event.stateBits = i & 0xff;
+    return event;
+}
+
+TrackingSnapshot MakeTracking(uint32_t i) {
+    TrackingSnapshot snapshot;
+    snapshot.version = i / 5 + 1;
+    snapshot.timeNs = static_cast<int64_t>(i) * 1000;
+    snapshot.markers.resize(i % 3);
+    for (size_t m = 0; m < snapshot.markers.size(); m++) {
+        snapshot.markers[m].handle = static_cast<intptr_t>(100 + m);
+        snapshot.markers[m].pose[0] = static_cast<float>(i);
+        snapshot.markers[m].extent[1] = 0.1f * m;
+    }
+    snapshot.planes.resize(i % 2);
+    for (size_t p = 0; p < snapshot.planes.size(); p++) {
+        snapshot.planes[p].handle = 200 + p;
+        snapshot.planes[p].type = 1;
+        snapshot.planes[p].normal[1] = 1.0f;
+    }
+    return snapshot;
+}
+
+bool Record(const std::string& path) {
+    SessionRecorder recorder;
+    if (!recorder.Open(path, 2)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < FrameCount; i++) {
+        if (i % 3 == 0) {
+            recorder.RecordInput(MakeInput(i));
+        }
+        recorder.RecordTracking(MakeTracking(i - i % 5));
+        const Frame frame = MakeFrame(i);
+        recorder.RecordFrame(FirstDisplayTime + i * DisplayPeriod, frame);
+    }
+    recorder.Close();
+    return true;
+}
+
+// Keeps what the replayer hands it for the frame at hand.
+class CapturingApplication : public IApplication {
+   public:
+    bool initialize(const XrInstance, const XrSession, const std::vector<std::string>&, StartupTasks&) override { return true; }
+    void setControllerPose(int leftright, const XrPosef& pose) override {
+        controllerPoseMask |= 1u << leftright;
+        controllerPose[leftright] = pose;
+    }
+    void setHandJointLocation(XrHandJointLocationEXT* location) override {
+        memcpy(joints, location, sizeof(joints));
+    }
+    InputEventQueue& inputQueue() override { return m_inputQueue; }
+    void setTrackingSnapshot(const TrackingSnapshot& snapshot) override { tracking = snapshot; }
+    void update(XrTime, XrDuration) override {}
+    void renderFrame(int32_t, const glm::vec3&) override {}
+    void appendLayers(XrSpace, std::vector<const XrCompositionLayerBaseHeader*>&, std::vector<const XrCompositionLayerBaseHeader*>&) override {}
+    void releaseXrResources() override {}
+
+    void Reset() { controllerPoseMask = 0; }
+
+    uint32_t controllerPoseMask{0};
+    XrPosef controllerPose[2];
+    XrHandJointLocationEXT joints[2][XR_HAND_JOINT_COUNT_EXT];
+    TrackingSnapshot tracking;
+
+   private:
+    InputEventQueue m_inputQueue;
+};
+
+// Replays path and compares every frame with what was recorded, returns the frames replayed.
+uint32_t Replay(const std::string& path) {
+    SessionReplayer replayer;
+    if (!replayer.Open(path)) {
+        g_failures++;
+        return 0;
+    }
+    Expect(replayer.ViewCount() == 2, "view count");
+
+    CapturingApplication application;
+    uint32_t frames = 0;
+    XrTime predictedDisplayTime = 0;
+    application.Reset();
+    while (const Frame* frame = replayer.Next(application, predictedDisplayTime)) {
+        const uint32_t i = frames++;
+        const std::string at = Fmt("frame %u: ", i);
+        const Frame expected = MakeFrame(i);
+        Expect(predictedDisplayTime == FirstDisplayTime + i * DisplayPeriod, at + "predicted display time");
+        Expect(frame->predictedDisplayPeriod == DisplayPeriod && frame->viewCount == 2, at + "display period and views");
+        for (uint32_t view = 0; view < 2; view++) {
+            Expect(SamePose(frame->views[view].pose, expected.views[view].pose), at + "view pose");
+            Expect(memcmp(&frame->views[view].fov, &expected.views[view].fov, sizeof(XrFovf)) == 0, at + "view fov");
+        }
+
+        Expect(application.controllerPoseMask == expected.controllerPoseMask, at + "controller poses set");
+        for (uint32_t hand = 0; hand < 2; hand++) {
+            if ((expected.controllerPoseMask & (1u << hand)) != 0) {
+                Expect(SamePose(application.controllerPose[hand], expected.controllerPose[hand]), at + "controller pose");
+            }
+        }
+        Expect(memcmp(application.joints, expected.joints, sizeof(expected.joints)) == 0, at + "hand joints");
+
+        // Stamped anew on replay, the rest of an event is as recorded.
+        InputEvent event;
+        if (i % 3 == 0) {
+            const InputEvent recorded = MakeInput(i);
+            Expect(application.inputQueue().Pop(event) && event.source == recorded.source &&
+                       event.changedBits == recorded.changedBits && event.stateBits == recorded.stateBits,
+                   at + "input event");
+        }
+        Expect(!application.inputQueue().Pop(event), at + "no other input event");
+
+        const TrackingSnapshot recorded = MakeTracking(i - i % 5);
+        const TrackingSnapshot& replayed = application.tracking;
+        bool sameTracking = replayed.version == recorded.version && replayed.timeNs == recorded.timeNs &&
+                            replayed.markers.size() == recorded.markers.size() && replayed.planes.size() == recorded.planes.size();
+        for (size_t m = 0; sameTracking && m < recorded.markers.size(); m++) {
+            const TrackingSnapshot::Marker& a = replayed.markers[m];
+            const TrackingSnapshot::Marker& b = recorded.markers[m];
+            sameTracking = a.handle == b.handle && memcmp(a.pose, b.pose, sizeof(a.pose)) == 0 && memcmp(a.extent, b.extent, sizeof(a.extent)) == 0;
+        }
+        for (size_t p = 0; sameTracking && p < recorded.planes.size(); p++) {
+            const TrackingSnapshot::Plane& a = replayed.planes[p];
+            const TrackingSnapshot::Plane& b = recorded.planes[p];
+            sameTracking = a.handle == b.handle && a.type == b.type && memcmp(a.pose, b.pose, sizeof(a.pose)) == 0 &&
+                           memcmp(a.center, b.center, sizeof(a.center)) == 0 && memcmp(a.normal, b.normal, sizeof(a.normal)) == 0;
+        }
+        Expect(sameTracking, at + "tracking snapshot");
+        application.Reset();
+    }
+    return frames;
+}
+
+// A copy of source cut to size bytes, as a crash would leave it.
+std::string Truncated(const std::string& source, const std::string& path, size_t size) {
+    std::filesystem::copy_file(source, path, std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::resize_file(path, size);
+    return path;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    Log::SetLevel(Log::Level::Info);
+    const std::filesystem::path directory = argc > 1 ? std::filesystem::path(argv[1]) : std::filesystem::temp_directory_path();
+    const std::string path = (directory / Fmt("sessionrecording_test_%d.xrsr", getpid())).string();
+    const std::string cutPath = path + ".cut";
+
+    if (!Record(path)) {
+        return 1;
+    }
+    const uint32_t frames = Replay(path);
+    Expect(frames == FrameCount, Fmt("replayed %u of %u frames", frames, FrameCount));
+
+    // Records are padded to 8 bytes; the last one is a frame. Cut into its payload, then into its header: either way
+    // the replay ends with the frame before.
+    const size_t size = std::filesystem::file_size(path);
+    const size_t lastFrame = size - sizeof(RecordHeader) - ((sizeof(Frame) + 7) & ~size_t(7));
+    for (const size_t cut : {size - sizeof(Frame) / 2, lastFrame + sizeof(RecordHeader) / 2, lastFrame + sizeof(RecordHeader)}) {
+        const uint32_t cutFrames = Replay(Truncated(path, cutPath, cut));
+        Expect(cutFrames == FrameCount - 1, Fmt("cut at %zu of %zu bytes: replayed %u frames", cut, size, cutFrames));
+    }
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(cutPath);
+    if (g_failures > 0) {
+        Log::Write(Log::Level::Error, Fmt("%u checks failed", g_failures));
+        return 1;
+    }
+    Log::Write(Log::Level::Info, Fmt("%u frames recorded and replayed", FrameCount));
+    return 0;
+}
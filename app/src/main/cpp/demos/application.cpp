@@ -1,4 +1,5 @@
 #include <dirent.h>
+#include <chrono>
 #include "pch.h"
 #include "common.h"
 #include "options.h"
@@ -14,23 +15,40 @@
 #include "utils.h"
 #include "graphicsplugin.h"
 #include "cube.h"
+#include "drawList.h"
+#include "gpuProfiler.h"
+#include "programCache.h"
+#include "renderGraph.h"
+#include "glState.h"
+#include "gpuMemory.h"
+#include "trackingworker.h"
+#include "startuptasks.h"
 
 class Application : public IApplication {
 public:
     Application(const std::shared_ptr<struct Options>& options, const std::shared_ptr<IGraphicsPlugin>& graphicsPlugin);
     virtual ~Application() override;
     virtual void setControllerPose(int leftright, const XrPosef& pose) override;
-    virtual bool initialize(const XrInstance instance, const XrSession session) override;
+    virtual bool initialize(const XrInstance instance, const XrSession session, const std::vector<std::string>& enabledExtensions,
+                            StartupTasks& startup) override;
     virtual void setHandJointLocation(XrHandJointLocationEXT* location) override;
-    virtual void inputEvent(int leftright, const ApplicationEvent& event) override;
-    virtual void renderFrame(const XrPosef& pose, const glm::mat4& project, const glm::mat4& view, int32_t eye) override;
+    virtual InputEventQueue& inputQueue() override { return mInputQueue; }
+    virtual void setTrackingSnapshot(const TrackingSnapshot& snapshot) override { mTracking = &snapshot; }
+    virtual void update(XrTime predictedDisplayTime, XrDuration predictedDisplayPeriod) override;
+    virtual void renderFrame(int32_t eye, const glm::vec3& viewPosition) override;
+    virtual void releaseXrResources() override;
+    virtual void appendLayers(XrSpace space, std::vector<const XrCompositionLayerBaseHeader*>& underlays,
+                              std::vector<const XrCompositionLayerBaseHeader*>& overlays) override;
 private:
     void layout();//布局UI
-    void showDashboard(const glm::mat4& project, const glm::mat4& view);
+    void drainInputEvents();
+    void inputEvent(int leftright, const ApplicationEvent& event);
+    void updateDashboard();
     void showDashboardController();
-    void showDeviceInformation(const glm::mat4& project, const glm::mat4& view);
-    void renderHandTracking(const glm::mat4& project, const glm::mat4& view);
-    virtual void renderFixedCube(const glm::mat4& project, const glm::mat4& view);//4.6添加，用于渲染固定位置立方体
+    void showDeviceInformation();
+    void updateHandTracking();
+    void updateFixedCube(XrTime predictedDisplayTime);
+    virtual void renderFixedCube();//4.6添加，用于渲染固定位置立方体
     // Calculate the angle between the vector v and the plane normal vector n
     float angleBetweenVectorAndPlane(const glm::vec3& vector, const glm::vec3& normal);
 
@@ -57,8 +75,21 @@ private://私有成员变量
     std::string mDeviceOS;
 
     bool mIsShowDashboard = true;//改这里原本的文本会变成乱码
+    bool mGuiQuadLayer;
+    bool mVideoSurfaceLayer;
+    std::string mVideoFile;
+    bool mPlayerReady = false;  // the player initializes after the first frame, until then there is no video
 
-    const ApplicationEvent *mControllerEvent[HAND_COUNT];
+    InputEventQueue mInputQueue;
+    ApplicationEvent mControllerEvent[HAND_COUNT] = {};
+    int64_t mInputLatencyNs = 0;  // from the xrSyncActions that saw the last event until update() consumed it
+    const TrackingSnapshot* mTracking = nullptr;
+
+    // per-frame results of update(), shared by both eyes
+    std::vector<CubeRender::Cube> mHandCubes;
+    std::vector<CubeRender::Cube> mFixedCubes;
+
+    DrawList mDrawList;  // the packets of the view being rendered
 
 };
 
@@ -68,18 +99,24 @@ std::shared_ptr<IApplication> createApplication(const std::shared_ptr<struct Opt
 
 Application::Application(const std::shared_ptr<struct Options>& options, const std::shared_ptr<IGraphicsPlugin>& graphicsPlugin) {
     mGraphicsPlugin = graphicsPlugin;
+    mGuiQuadLayer = options->GuiQuadLayer;
+    mVideoSurfaceLayer = options->VideoSurfaceLayer;
+    mVideoFile = options->VideoFile;
     mController = std::make_shared<Controller>();
     mHandTracker = std::make_shared<Hand>();
     mPanel = std::make_shared<Gui>("dashboard");
     mTextRender = std::make_shared<Text>();
     mPlayer = std::make_shared<Player>();
     mCubeRender = std::make_shared<CubeRender>();
+    mHandCubes.reserve(HAND_COUNT * XR_HAND_JOINT_COUNT_EXT);
+    mFixedCubes.resize(1);
 }//初始化各组件（智能指针会自动管理资源）
 
 Application::~Application() {
 }
 
-bool Application::initialize(const XrInstance instance, const XrSession session) {
+bool Application::initialize(const XrInstance instance, const XrSession session, const std::vector<std::string>& enabledExtensions,
+                             StartupTasks& startup) {
     m_instance = instance;
     m_session = session;
 
@@ -90,15 +127,44 @@ bool Application::initialize(const XrInstance instance, const XrSession session)
     //__system_property_get("ro.system.build.id", buffer); // You can also call this function, the result is the same
     mDeviceOS = "It is HARD";
 
+    // Needed by the first frame: the controller ray, the dashboard and the cubes.
     mController->initialize(mDeviceModel);
-    mHandTracker->initialize(); // zhfzhf
 
     mPanel->initialize(600, 800);  //set resolution，仪表盘吧
-    mTextRender->initialize();
+    if (mGuiQuadLayer && !mPanel->initializeLayer(session)) {
+        warnf("dashboard quad layer unavailable, drawing it into the eye buffers");
+    }
     mCubeRender->initialize();
 
+    // Everything else comes up behind the first frames: parsing and rasterizing on the workers, the GL part a few
+    // tasks per frame on the render thread. Hand, text and video are simply not drawn until their upload is done.
+    std::shared_ptr<Hand> hand = mHandTracker;
+    const auto leftHand = startup.Add("hand model left", StartupTasks::Thread::Worker, [hand] { return hand->load(HAND_LEFT); });
+    const auto rightHand = startup.Add("hand model right", StartupTasks::Thread::Worker, [hand] { return hand->load(HAND_RIGHT); });
+    startup.Add("hand upload", StartupTasks::Thread::Render, [hand] { return hand->initialize(); }, {leftHand, rightHand}); // zhfzhf
+
+    std::shared_ptr<Text> text = mTextRender;
+    const auto glyphs = startup.Add("font glyphs", StartupTasks::Thread::Worker, [text] { return text->load(); });
+    startup.Add("text upload", StartupTasks::Thread::Render, [text] { return text->initialize(); }, {glyphs});
+
+#ifdef XR_USE_PLATFORM_ANDROID
     const XrGraphicsBindingOpenGLESAndroidKHR *binding = reinterpret_cast<const XrGraphicsBindingOpenGLESAndroidKHR*>(mGraphicsPlugin->GetGraphicsBinding());
-    mPlayer->initialize(binding->display);
+#else
+    const XrGraphicsBindingEGLMNDX *binding = reinterpret_cast<const XrGraphicsBindingEGLMNDX*>(mGraphicsPlugin->GetGraphicsBinding());
+#endif
+    const EGLDisplay display = binding->display;
+    const bool equirect2Enabled = std::find(enabledExtensions.begin(), enabledExtensions.end(), XR_KHR_COMPOSITION_LAYER_EQUIRECT2_EXTENSION_NAME) != enabledExtensions.end();
+    startup.Add("player", StartupTasks::Thread::Render, [this, display, instance, session, equirect2Enabled] {
+        mPlayer->initialize(display);
+        if (mVideoSurfaceLayer) {
+            mPlayer->initializeLayer(instance, session, equirect2Enabled);
+        }
+        if (!mVideoFile.empty() && !mPlayer->start(mVideoFile)) {
+            warnf("cannot play %s", mVideoFile.c_str());
+        }
+        mPlayerReady = true;
+        return true;
+    });
 
     return true;
 }
@@ -117,9 +183,23 @@ void Application::setHandJointLocation(XrHandJointLocationEXT* location) {
     memcpy(&m_jointLocations, location, sizeof(m_jointLocations));
 }
 
-void Application::inputEvent(int leftright, const ApplicationEvent& event) {
-    mControllerEvent[leftright] = &event;
+void Application::drainInputEvents() {
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    InputEvent event;
+    while (mInputQueue.Pop(event)) {
+        mInputLatencyNs = now - event.timeNs;
+        if (event.source == INPUT_SOURCE_GAMEPAD) {
+            continue;  // the gamepad buttons only drive system actions, handled in PollActions
+        }
+        ApplicationEvent& state = mControllerEvent[event.source];
+        state.controllerEventBit = event.changedBits;
+        state.click_trigger = (event.stateBits & CONTROLLER_EVENT_BIT_click_trigger) != 0;
+        state.click_menu = (event.stateBits & CONTROLLER_EVENT_BIT_click_menu) != 0;
+        inputEvent(event.source, state);
+    }
+}
 
+void Application::inputEvent(int leftright, const ApplicationEvent& event) {
     if (event.controllerEventBit & CONTROLLER_EVENT_BIT_click_menu) {
         if (event.click_menu == true) {
             mIsShowDashboard = !mIsShowDashboard;
@@ -162,27 +242,27 @@ void Application::showDashboardController() {
                                         ImGui::TableNextColumn();\
                                         ImGui::Text("%s", MEMBER_NAME(ApplicationEvent, x));\
                                         ImGui::TableNextColumn();\
-                                        ImGui::Text("%f", mControllerEvent[HAND_LEFT]->x);\
+                                        ImGui::Text("%f", mControllerEvent[HAND_LEFT].x);\
                                         ImGui::TableNextColumn();\
-                                        ImGui::Text("%f", mControllerEvent[HAND_RIGHT]->x);
+                                        ImGui::Text("%f", mControllerEvent[HAND_RIGHT].x);
 
 #define SHOW_CONTROLLER_ROW_bool(hand, x)   ImGui::TableNextRow();\
                                             ImGui::TableNextColumn();\
                                             ImGui::Text("%s", MEMBER_NAME(ApplicationEvent, x));\
                                             ImGui::TableNextColumn();\
-                                            if (hand & HAND_BIT_LEFT && mControllerEvent[HAND_LEFT]->x) {\
+                                            if (hand & HAND_BIT_LEFT && mControllerEvent[HAND_LEFT].x) {\
                                                 ImGui::Text("true");\
                                             }\
                                             ImGui::TableNextColumn();\
-                                            if (hand & HAND_BIT_RIGHT && mControllerEvent[HAND_RIGHT]->x) {\
+                                            if (hand & HAND_BIT_RIGHT && mControllerEvent[HAND_RIGHT].x) {\
                                                 ImGui::Text("true");\
                                             }
 
 }
 
-void Application::showDashboard(const glm::mat4& project, const glm::mat4& view) {
+void Application::updateDashboard() {
 
-    PlayModel playModel = mPlayer->getPlayStyle();
+    PlayModel playModel = mPlayerReady ? mPlayer->getPlayStyle() : playModel_2D_360;
 
     const XrPosef& controllerPose = mControllerPose[1];
     glm::vec3 linePoint = glm::make_vec3((float*)&controllerPose.position);
@@ -193,20 +273,63 @@ void Application::showDashboard(const glm::mat4& project, const glm::mat4& view)
     if (ImGui::CollapsingHeader("information")) {
         ImGui::BulletText("device model: %s", mDeviceModel.c_str());
         ImGui::BulletText("device OS: %s", mDeviceOS.c_str());
+        ImGui::BulletText("input latency: %.2fms, dropped: %u", mInputLatencyNs / 1000000.0f, mInputQueue.Dropped());
+        const ProgramCache::Stats& programs = ProgramCache::instance().getStats();
+        ImGui::BulletText("program cache: %u of %u hits, %.1fms saved", programs.hits, programs.hits + programs.misses, programs.savedMs);
+        const GlState::Stats& glStats = GlState::instance().getStats();
+        ImGui::BulletText("gl state: %u calls, %u avoided", glStats.issued, glStats.avoided);
+        const DrawList::Stats& drawStats = mDrawList.getStats();
+        ImGui::BulletText("draw list: %u draws, %u programs, %u vertex arrays, %u texture sets", drawStats.packets,
+                          drawStats.programChanges, drawStats.vertexArrayChanges, drawStats.textureChanges);
     }
     
+    const GpuProfiler& gpuProfiler = GpuProfiler::instance();
+    if (gpuProfiler.isEnabled() && ImGui::CollapsingHeader("gpu")) {
+        int64_t frameNs = 0;
+        if (gpuProfiler.getFrameTime(frameNs)) {
+            ImGui::BulletText("frame: %.2fms", frameNs / 1000000.0f);
+        }
+        for (const GpuProfiler::ZoneResult& zone : gpuProfiler.getZones()) {
+            ImGui::BulletText("%s: %.2fms", zone.name, zone.ms);
+        }
+    }
+
+    const GpuMemory& gpuMemory = GpuMemory::instance();
+    if (ImGui::CollapsingHeader("gpu memory")) {
+        const GpuMemory::TagStats& total = gpuMemory.getTotal();
+        if (gpuMemory.getBudget() != 0) {
+            ImGui::BulletText("total: %.1fMB of %.1fMB, peak %.1fMB", total.bytes / 1048576.0f, gpuMemory.getBudget() / 1048576.0f,
+                              total.peakBytes / 1048576.0f);
+        } else {
+            ImGui::BulletText("total: %.1fMB, peak %.1fMB", total.bytes / 1048576.0f, total.peakBytes / 1048576.0f);
+        }
+        for (uint32_t tag = 0; tag < static_cast<uint32_t>(GpuMemoryTag::Count); tag++) {
+            const GpuMemory::TagStats& stats = gpuMemory.getStats(static_cast<GpuMemoryTag>(tag));
+            ImGui::BulletText("%s: %.1fKB in %u, peak %.1fKB", GpuMemory::tagName(static_cast<GpuMemoryTag>(tag)), stats.bytes / 1024.0f,
+                              stats.objects, stats.peakBytes / 1024.0f);
+        }
+    }
+
+    if (mTracking != nullptr && mTracking->version != 0 && ImGui::CollapsingHeader("tracking")) {
+        const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        ImGui::BulletText("snapshot %llu, %.0fms old", (unsigned long long)mTracking->version, (now - mTracking->timeNs) / 1000000.0f);
+        ImGui::BulletText("markers: %zu, planes: %zu", mTracking->markers.size(), mTracking->planes.size());
+    }
+
     //test controller
     showDashboardController();
 
     ImGui::Text("Go Go Go");
 
     mPanel->end();
-    mPanel->render(project, view);
+    mPanel->renderPanel();
 
-    mPlayer->setPlayStyle(playModel);
+    if (mPlayerReady) {
+        mPlayer->setPlayStyle(playModel);
+    }
 }
 
-void Application::showDeviceInformation(const glm::mat4& project, const glm::mat4& view) {
+void Application::showDeviceInformation() {
     wchar_t text[1024] = {0};
     swprintf(text, 1024, L"model: %s, OS: %s", mDeviceModel.c_str(), mDeviceOS.c_str());
 
@@ -214,7 +337,7 @@ void Application::showDeviceInformation(const glm::mat4& project, const glm::mat
     model = glm::translate(model, glm::vec3(0.5f, -0.6f, -1.0f));
     model = glm::rotate(model, glm::radians(-30.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     model = glm::scale(model, glm::vec3(0.5, 0.5, 1.0f));
-    mTextRender->render(project, view, model, text, wcslen(text), glm::vec3(1.0, 1.0, 1.0));
+    mTextRender->render(mDrawList, model, text, wcslen(text), glm::vec3(1.0, 1.0, 1.0));
 }
 
 float Application::angleBetweenVectorAndPlane(const glm::vec3& vector, const glm::vec3& normal) {
@@ -249,42 +372,24 @@ float Application::angleBetweenVectorAndPlane(const glm::vec3& vector, const glm
 //        },
 //};
 
-void Application::renderHandTracking(const glm::mat4& project, const glm::mat4& view) {
-    std::vector<CubeRender::Cube> cubes;//立方体容器
+void Application::updateHandTracking() {
+    mHandCubes.clear();
     for (auto hand = 0; hand < HAND_COUNT; hand++) {
-        for (int i = 0; i < XR_HAND_JOINT_COUNT_EXT; i++) {
-            XrHandJointLocationEXT& jointLocation = m_jointLocations[hand][i];
-            if (jointLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT && jointLocation.locationFlags & XR_SPACE_LOCATION_POSITION_TRACKED_BIT) {
-
-                XrMatrix4x4f m{};
-                XrVector3f scale{1.0f, 1.0f, 1.0f};
-                XrMatrix4x4f_CreateTranslationRotationScale(&m, &jointLocation.pose.position, &jointLocation.pose.orientation, &scale);
-                glm::mat4 model = glm::make_mat4((float*)&m);//创建关节变换矩阵
-
-                CubeRender::Cube cube;
-                cube.model = model;
-                cube.scale = 0.01f;
-                cubes.push_back(cube);
-
-                //mHandTracker->setBoneNodeMatrices(hand, getBoneNameByIndex(hand, i), model); // zhfzhf
-            }
-        }
-        //mHandTracker->render(hand, project, view);
+        CubeRender::appendJoints(m_jointLocations[hand], XR_HAND_JOINT_COUNT_EXT, 0.01f, mHandCubes);
+        //mHandTracker->setBoneNodeMatrices(hand, getBoneNameByIndex(hand, i), model); // zhfzhf
     }
-
-    mCubeRender->render(project, view, cubes);
 }
 
-void Application::renderFixedCube(const glm::mat4& project, const glm::mat4& view) {
+void Application::updateFixedCube(XrTime predictedDisplayTime) {
     glm::mat4 model = glm::mat4(1.0f);
 
     const float distanceFromView = 1.5f;
     model = glm::translate(model, glm::vec3(0.0f, 0.0f, -distanceFromView));
 
     // 添加旋转效果（随时间旋转）
-    static float rotationAngle = 0.0f;
-    rotationAngle += 0.5f; // 每帧旋转0.5度
-    if(rotationAngle > 360.0f) rotationAngle -= 360.0f;
+    // 36 degrees per second, i.e. 0.5 degrees per frame at 72Hz, driven by the display time instead of the call count
+    const double seconds = predictedDisplayTime * 1e-9;
+    const float rotationAngle = (float)fmod(seconds * 36.0, 360.0);
 
     // 绕Y轴旋转（水平旋转）
     model = glm::rotate(model, glm::radians(rotationAngle), glm::vec3(0.0f, 1.0f, 0.0f));
@@ -292,38 +397,73 @@ void Application::renderFixedCube(const glm::mat4& project, const glm::mat4& vie
     const float cubeSize = 0.2f;
     model = glm::scale(model, glm::vec3(cubeSize));
 
-    CubeRender::Cube fixedCube;
-    fixedCube.model = model;
-    fixedCube.scale = 1.0f;
+    mFixedCubes[0].model = model;
+    mFixedCubes[0].scale = 1.0f;
+}
+
+void Application::renderFixedCube() {
+    mCubeRender->render(mDrawList, mFixedCubes);
+}
+
+//每一帧调用一次，两只眼睛共用结果
+void Application::update(XrTime predictedDisplayTime, XrDuration predictedDisplayPeriod) {
+    drainInputEvents();
+
+    layout();
+
+    // The video frame is imported into its texture in a pass of its own, ahead of the eye passes that sample it.
+    if (mPlayerReady) {
+        RenderGraph::instance().addPass("Video", RenderGraph::Kind::Offscreen, RenderGraph::Target(), [this]() { mPlayer->update(); });
+    }
+
+    if (mIsShowDashboard) {
+        mPanel->setDeltaTime(predictedDisplayPeriod * 1e-9f);
+        updateDashboard();
+    }
 
-    std::vector<CubeRender::Cube> cubes;
-    cubes.push_back(fixedCube);
+    updateHandTracking();
 
-    glDisable(GL_DEPTH_TEST); // 禁用深度测试
-    glDisable(GL_CULL_FACE);  // 禁用面剔除
+    updateFixedCube(predictedDisplayTime);
+}
 
-    mCubeRender->render(project, view, cubes);
+void Application::appendLayers(XrSpace space, std::vector<const XrCompositionLayerBaseHeader*>& underlays,
+                               std::vector<const XrCompositionLayerBaseHeader*>& overlays) {
+    if (mPlayerReady) {
+        mPlayer->appendLayers(space, underlays);
+    }
 
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_DEPTH_TEST);
+    if (mIsShowDashboard && mPanel->hasLayer()) {
+        const XrCompositionLayerBaseHeader* layer = mPanel->getLayer(space);
+        if (layer != nullptr) {
+            overlays.push_back(layer);
+        }
+    }
 }
 
-//每一帧都会渲染
-void Application::renderFrame(const XrPosef& pose, const glm::mat4& project, const glm::mat4& view, int32_t eye) {
-    layout();
-//    showDeviceInformation(project, view);
+void Application::releaseXrResources() {
+    mPanel->destroyLayer();
+    // Stopping also destroys the swapchain the video is decoded into, after the decoder is done with its surface.
+    mPlayer->stop();
+}
 
-    mPlayer->render(project, view, eye);
+//每个渲染pass调用一次：multiview时两只眼睛一次画完，否则每只眼睛一次
+void Application::renderFrame(int32_t /*eye*/, const glm::vec3& viewPosition) {
+    mDrawList.begin(viewPosition);
+//    showDeviceInformation();
 
-    if (mIsShowDashboard) {
-        showDashboard(project, view);
+    if (mPlayerReady) {
+        mPlayer->render(mDrawList);
     }
 
-    mController->render(project, view);
+    if (mIsShowDashboard && !mPanel->hasLayer()) {
+        mPanel->render(mDrawList);
+    }
 
+    mController->render(mDrawList);
 
-    renderHandTracking(project, view);
+    mCubeRender->render(mDrawList, mHandCubes);
 
-    renderFixedCube(project, view);
+    renderFixedCube();
 
+    mDrawList.execute();
 }
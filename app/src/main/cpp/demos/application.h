@@ -1,7 +1,10 @@
 #pragma once
 #include <memory>
+#include <string>
+#include <vector>
 #include "glm/glm.hpp"
 #include <openxr/openxr.h>
+#include "spscqueue.h"
 
 #define CONTROLLER_EVENT_BIT_value_trigger    0x00000001
 #define CONTROLLER_EVENT_BIT_value_squeeze    0x00000002
@@ -23,6 +26,17 @@
 #define CONTROLLER_EVENT_BIT_touch_x          0x00010000
 #define CONTROLLER_EVENT_BIT_touch_y          0x00020000
 
+// gamepad only buttons
+#define CONTROLLER_EVENT_BIT_click_o          0x00040000
+#define CONTROLLER_EVENT_BIT_click_up         0x00080000
+#define CONTROLLER_EVENT_BIT_click_down       0x00100000
+#define CONTROLLER_EVENT_BIT_click_left       0x00200000
+#define CONTROLLER_EVENT_BIT_click_right      0x00400000
+
+// input sources of an InputEvent, the hands use HAND_LEFT/HAND_RIGHT
+#define INPUT_SOURCE_GAMEPAD 2
+#define INPUT_SOURCE_COUNT   3
+
 //system and shot button cannot be use in application
 typedef struct {
     uint32_t controllerEventBit;
@@ -47,17 +61,47 @@ typedef struct {
     bool touch_y;          //true:touch false:none touch
 }ApplicationEvent;
 
+// The buttons of one input source that changed in an xrSyncActions, stamped with the steady clock time of that sync.
+typedef struct {
+    int64_t timeNs;
+    int32_t source;        // HAND_LEFT, HAND_RIGHT or INPUT_SOURCE_GAMEPAD
+    uint32_t changedBits;  // CONTROLLER_EVENT_BIT_click_* that changed
+    uint32_t stateBits;    // CONTROLLER_EVENT_BIT_click_* currently down
+}InputEvent;
+
+typedef SpscQueue<InputEvent, 64> InputEventQueue;
+
+struct TrackingSnapshot;
+class StartupTasks;
+
 #define PFN_DECLARE(pfn) PFN_##pfn pfn = nullptr
 #define PFN_INITIALIZE(pfn) CHECK_XRCMD(xrGetInstanceProcAddr(m_instance, #pfn, (PFN_xrVoidFunction*)(&pfn)))
 
 class IApplication {
 public:
     virtual ~IApplication() = default;
-    virtual bool initialize(const XrInstance instance, const XrSession session) = 0;
+    // Sets up what the first frame needs, everything else is added to startup and becomes visible once it is done.
+    virtual bool initialize(const XrInstance instance, const XrSession session, const std::vector<std::string>& enabledExtensions,
+                            StartupTasks& startup) = 0;
     virtual void setControllerPose(int leftright, const XrPosef& pose) = 0;
     virtual void setHandJointLocation(XrHandJointLocationEXT* location) = 0;
-    virtual void inputEvent(int leftright, const ApplicationEvent& event) = 0;
-    virtual void renderFrame(const XrPosef& pose, const glm::mat4& project, const glm::mat4& view, int32_t eye) = 0;
+    // Input events are pushed by PollActions and drained by the application once per frame in update().
+    virtual InputEventQueue& inputQueue() = 0;
+    // The latest marker and plane tracking results, valid until the next call. Called once per frame before update().
+    virtual void setTrackingSnapshot(const TrackingSnapshot& snapshot) = 0;
+    // Called once per displayed frame before any eye is rendered: animation, UI and other per-frame state is built here.
+    virtual void update(XrTime predictedDisplayTime, XrDuration predictedDisplayPeriod) = 0;
+    // Called once per render pass, only issues the draws for the state produced by update(). The view and projection
+    // matrices are already in the ViewBlock uniform buffer; eye is EYE_BOTH for a multiview pass, else the eye drawn.
+    // viewPosition is where the pass looks from in world space, the draws are sorted by their distance to it.
+    virtual void renderFrame(int32_t eye, const glm::vec3& viewPosition) = 0;
+    // Appends the composition layers the application submits itself, underlays are composited below the projection
+    // layer and overlays above it.
+    virtual void appendLayers(XrSpace space, std::vector<const XrCompositionLayerBaseHeader*>& underlays,
+                              std::vector<const XrCompositionLayerBaseHeader*>& overlays) = 0;
+    // Destroys the OpenXR handles the application created itself, e.g. layer swapchains. Called before the session
+    // and the instance are destroyed, nothing is rendered or submitted afterwards.
+    virtual void releaseXrResources() = 0;
 
 
 };
@@ -23,14 +23,14 @@ void ControllerBase::setModel(const glm::mat4& model) {
     mControllerModel = model;
     mRayModel = model;
 }
-bool ControllerBase::render(const glm::mat4& p, const glm::mat4& v) {
+bool ControllerBase::render(DrawList& drawList) {
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::scale(mControllerModel, glm::vec3(mControllerDefaultScale, mControllerDefaultScale, mControllerDefaultScale));
-//    mController->render(p, v, model); // zhf remove
+//    mController->render(drawList, model); // zhf remove
 
     model = glm::mat4(1.0f);
     model = glm::scale(mControllerModel, glm::vec3(mControllerRayDefaultScale, mControllerRayDefaultScale, mControllerRayDefaultScale));
-    mControllerRay->render(p, v, model);
+    mControllerRay->render(drawList, model);
     return true;
 }
 glm::vec3 ControllerBase::getRayDirection() {
@@ -124,9 +124,9 @@ void Controller::setModel(int leftright, const glm::mat4& m) {
     }
 }
 
-void Controller::render(const glm::mat4& p, const glm::mat4& v) {
-    mLeftController->render(p, v);
-    mRightController->render(p, v);
+void Controller::render(DrawList& drawList) {
+    mLeftController->render(drawList);
+    mRightController->render(drawList);
 }
 
 glm::vec3 Controller::getRayDirection(int leftright) {
@@ -11,7 +11,7 @@ public:
     void setModelFile(const std::string& modelFile);
     bool loadModelFile();
     void setModel(const glm::mat4& model);
-    bool render(const glm::mat4& p, const glm::mat4& v);
+    bool render(DrawList& drawList);
     glm::vec3 getRayDirection();
     
 private:
@@ -42,7 +42,7 @@ public:
 //	void setRightPowerValue(int power);
 //    void setLeftPowerValue(int power);
     void setModel(int leftright, const glm::mat4& m);
-    void render(const glm::mat4& p, const glm::mat4& v);
+    void render(DrawList& drawList);
     glm::vec3 getRayDirection(int leftright);
 
 private:
@@ -2,10 +2,14 @@
 #include "cube.h"
 #include "utils.h"
 #include "geometry.h"
+#include "glState.h"
+#include "gpuMemory.h"
 #include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/type_ptr.hpp"
+#include <common/xr_linear.h>
 
 Shader CubeRender::mShader;//静态着色器对象，所有实例共享
-CubeRender::CubeRender(): mFramebuffer(0), mVAO(0), mVBO(0) {
+CubeRender::CubeRender() {
 }
 CubeRender::~CubeRender() {
 }//似乎是没有用处的析构函数
@@ -23,11 +27,9 @@ bool CubeRender::initShader() {
             layout (location = 1) in vec3 color;
             out vec3 fColor;
             uniform mat4 model;
-            uniform mat4 view;
-            uniform mat4 projection;
             void main()
             {
-                gl_Position = projection * view * model* vec4(position, 1.0);
+                gl_Position = projection[VIEW_ID] * view[VIEW_ID] * model* vec4(position, 1.0);
                 fColor = color;
             }
         )_";
@@ -43,7 +45,7 @@ bool CubeRender::initShader() {
             }
         )_";
 
-        if (mShader.loadShader(vertex_shader_glsl, fragment_shader_glsl) == false) {
+        if (mShader.loadShader(vertex_shader_glsl, fragment_shader_glsl, true, "cube") == false) {
             return false;
         }
         init = true;
@@ -59,56 +61,64 @@ bool CubeRender::initialize() {
     //GL_CALL(glGenFramebuffers(1, &mFramebuffer));
     //GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer));
 
+    // The index buffer is bound before the VAO is, so no other VAO may be bound
+    GlState::instance().bindVertexArray(0);
+
     // 生成顶点缓冲对象（VBO）并绑定立方体数据
-    GL_CALL(glGenBuffers(1, &mCubeVertexBuffer));
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mCubeVertexBuffer));
-    GL_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(Geometry::c_cubeVertices), Geometry::c_cubeVertices, GL_STATIC_DRAW));
+    mCubeVertexBuffer = GlBuffer::generate();
+    GlState::instance().bindBuffer(GL_ARRAY_BUFFER, mCubeVertexBuffer.get());
+    GpuMemory::instance().bufferData(GpuMemoryTag::Geometry, mCubeVertexBuffer.get(), GL_ARRAY_BUFFER, sizeof(Geometry::c_cubeVertices),
+                                     Geometry::c_cubeVertices, GL_STATIC_DRAW);
 
     // 生成索引缓冲对象（EBO）并绑定立方体索引
-    GL_CALL(glGenBuffers(1, &mCubeIndexBuffer));
-    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mCubeIndexBuffer));
-    GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Geometry::c_cubeIndices), Geometry::c_cubeIndices, GL_STATIC_DRAW));
+    mCubeIndexBuffer = GlBuffer::generate();
+    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mCubeIndexBuffer.get()));
+    GpuMemory::instance().bufferData(GpuMemoryTag::Geometry, mCubeIndexBuffer.get(), GL_ELEMENT_ARRAY_BUFFER, sizeof(Geometry::c_cubeIndices),
+                                     Geometry::c_cubeIndices, GL_STATIC_DRAW);
 
     // 获取着色器中属性的位置
     GLint vertex_location_postion = glGetAttribLocation(mShader.id(), "position");
     GLint vertex_location_color = glGetAttribLocation(mShader.id(), "color");
 
     // 配置顶点数组对象（VAO）,绑定VBO和EBO到VAO
-    GL_CALL(glGenVertexArrays(1, &mVAO));
-    GL_CALL(glBindVertexArray(mVAO));
+    mVAO = GlVertexArray::generate();
+    GlState::instance().bindVertexArray(mVAO.get());
     GL_CALL(glEnableVertexAttribArray(vertex_location_postion));
     GL_CALL(glEnableVertexAttribArray(vertex_location_color));
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mCubeVertexBuffer));
-    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mCubeIndexBuffer));
+    GlState::instance().bindBuffer(GL_ARRAY_BUFFER, mCubeVertexBuffer.get());
+    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mCubeIndexBuffer.get()));
     GL_CALL(glVertexAttribPointer(vertex_location_postion, sizeof(XrVector3f) / sizeof(float), GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex), nullptr));
     GL_CALL(glVertexAttribPointer(vertex_location_color,   sizeof(XrVector3f) / sizeof(float), GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex), reinterpret_cast<const void*>(sizeof(XrVector3f))));
 
     return true;
 }
 
-void CubeRender::render(const glm::mat4& p, const glm::mat4& v, std::vector<Cube> &cubes) {
-    mShader.use(); 
-    mShader.setUniformMat4("projection", p);
-    mShader.setUniformMat4("view", v);
-    glEnable(GL_DEPTH_TEST);//深度测试
-    //glDisable(GL_DEPTH_TEST);
-    glFrontFace(GL_CW);//顺时针为正面
-    glCullFace(GL_BACK);//背面剔除-没看懂啥玩意
-    //glDisable(GL_CULL_FACE);//强制禁用面剔除
-    GL_CALL(glBindVertexArray(mVAO));
+void CubeRender::render(DrawList& drawList, const std::vector<Cube>& cubes) {
+    // 立方体不透明，不剔除面
+    DrawPacket packet;
+    packet.shader = &mShader;
+    packet.vertexArray = mVAO.get();
+    packet.frontFace = GL_CW;//顺时针为正面
+    packet.count = sizeof(Geometry::c_cubeIndices) / sizeof(Geometry::c_cubeIndices[0]);
+    packet.indexType = GL_UNSIGNED_SHORT;
     for (const Cube& cube : cubes) {
-        // Compute the model-view-projection transform and set it..
-        //XrMatrix4x4f model;
-        //XrMatrix4x4f_CreateTranslationRotationScale(&model, &cube.Pose.position, &cube.Pose.orientation, &cube.Scale);
-        //XrMatrix4x4f mvp;
-        //XrMatrix4x4f_Multiply(&mvp, &vp, &model);
-        //glUniformMatrix4fv(m_modelViewProjectionUniformLocation, 1, GL_FALSE, reinterpret_cast<const GLfloat*>(&mvp));
-        glm::mat4 model = glm::scale(cube.model, glm::vec3(cube.scale, cube.scale, cube.scale));
-        mShader.setUniformMat4("model", model);
-
-        // Draw the cube.
-        GL_CALL(glDrawElements(GL_TRIANGLES, sizeof(Geometry::c_cubeIndices) / sizeof(Geometry::c_cubeIndices[0]), GL_UNSIGNED_SHORT, nullptr));
+        packet.model = glm::scale(cube.model, glm::vec3(cube.scale, cube.scale, cube.scale));
+        drawList.submit(packet);
     }
+}
+
+void CubeRender::appendJoints(const XrHandJointLocationEXT* joints, uint32_t count, float scale, std::vector<Cube>& cubes) {
+    const XrVector3f unit{1.0f, 1.0f, 1.0f};
+    for (uint32_t i = 0; i < count; i++) {
+        const XrHandJointLocationEXT& jointLocation = joints[i];
+        if (jointLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT && jointLocation.locationFlags & XR_SPACE_LOCATION_POSITION_TRACKED_BIT) {
+            XrMatrix4x4f m{};
+            XrMatrix4x4f_CreateTranslationRotationScale(&m, &jointLocation.pose.position, &jointLocation.pose.orientation, &unit);
 
-    GL_CALL(glBindVertexArray(0));
+            Cube cube;
+            cube.model = glm::make_mat4((float*)&m);//创建关节变换矩阵
+            cube.scale = scale;
+            cubes.push_back(cube);
+        }
+    }
 }
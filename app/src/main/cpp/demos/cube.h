@@ -4,6 +4,8 @@
 #include <openxr/openxr.h>
 #include "common/gfxwrapper_opengl.h"
 #include "shader.h"
+#include "drawList.h"
+#include "glResource.h"
 
 class CubeRender {
 public:
@@ -14,14 +16,14 @@ public:
         glm::mat4 model;
         float scale;
     };
-    void render(const glm::mat4& p, const glm::mat4& v, std::vector<Cube> &cubes);
+    void render(DrawList& drawList, const std::vector<Cube>& cubes);
+    // Appends a cube of the given scale at every joint whose position is valid and tracked.
+    static void appendJoints(const XrHandJointLocationEXT* joints, uint32_t count, float scale, std::vector<Cube>& cubes);
 private:
     bool initShader();
 private:
     static Shader mShader;
-    GLuint mFramebuffer;
-    GLuint mCubeVertexBuffer;
-    GLuint mCubeIndexBuffer;
-    GLuint mVAO;
-    GLuint mVBO;
+    GlBuffer mCubeVertexBuffer;
+    GlBuffer mCubeIndexBuffer;
+    GlVertexArray mVAO;
 };
\ No newline at end of file
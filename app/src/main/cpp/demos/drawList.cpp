@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <string.h>
+#include "drawList.h"
+#include "glState.h"
+#include "gpuProfiler.h"
+#include "utils.h"
+
+namespace {
+constexpr uint32_t ProgramBits = 8;
+constexpr uint32_t StateBits = 4;
+constexpr uint32_t VertexArrayBits = 10;
+constexpr uint32_t TextureBits = 10;
+constexpr uint32_t DepthBits = 29;
+
+uint64_t fnv1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// The bits of a non-negative float sort like the float itself, the top DepthBits of them are plenty for ordering.
+uint64_t depthBits(float distance) {
+    uint32_t bits;
+    memcpy(&bits, &distance, sizeof(bits));
+    return bits >> (32 - DepthBits);
+}
+}  // namespace
+
+void DrawList::begin(const glm::vec3& viewPosition) {
+    mViewPosition = viewPosition;
+    mGeneration++;
+    mPackets.clear();
+    recycleSlots(mPrograms, ProgramBits);
+    recycleSlots(mVertexArrays, VertexArrayBits);
+    recycleSlots(mTextureSets, TextureBits);
+}
+
+void DrawList::submit(const DrawPacket& packet) {
+    mPackets.push_back(packet);
+}
+
+uint32_t DrawList::slot(std::unordered_map<uint64_t, uint32_t>& slots, uint64_t value, uint32_t bits) {
+    auto it = slots.find(value);
+    if (it != slots.end()) {
+        return it->second;
+    }
+    // Once the ids run out everything new shares the last one, which only costs some state changes.
+    const uint32_t last = (1u << bits) - 1;
+    const uint32_t id = std::min<uint32_t>(static_cast<uint32_t>(slots.size()), last);
+    slots.emplace(value, id);
+    return id;
+}
+
+void DrawList::recycleSlots(std::unordered_map<uint64_t, uint32_t>& slots, uint32_t bits) {
+    if (slots.size() >= (1u << bits)) {
+        slots.clear();
+    }
+}
+
+uint64_t DrawList::makeKey(const DrawPacket& packet) {
+    const uint64_t program = slot(mPrograms, packet.shader->id(), ProgramBits);
+    const uint64_t vertexArray = slot(mVertexArrays, packet.vertexArray, VertexArrayBits);
+    uint64_t textureHash = fnv1a(&packet.textureTarget, sizeof(packet.textureTarget));
+    textureHash = fnv1a(packet.textures.data(), sizeof(packet.textures), textureHash);
+    const uint64_t textures = slot(mTextureSets, textureHash, TextureBits);
+    const uint64_t state = (packet.blend ? 8 : 0) | (packet.depthTest ? 4 : 0) | (packet.cullFace ? 2 : 0) | (packet.frontFace == GL_CW ? 1 : 0);
+
+    const uint64_t depth = depthBits(glm::length(glm::vec3(packet.model[3]) - mViewPosition));
+    const uint64_t material = (((program << StateBits | state) << VertexArrayBits | vertexArray) << TextureBits) | textures;
+    constexpr uint32_t MaterialBits = ProgramBits + StateBits + VertexArrayBits + TextureBits;
+
+    uint64_t key = static_cast<uint64_t>(packet.layer) << 62;
+    if (packet.blend) {
+        const uint64_t farFirst = ~depth & ((1ull << DepthBits) - 1);
+        key |= 1ull << 61 | farFirst << MaterialBits | material;
+    } else {
+        key |= material << DepthBits | depth;
+    }
+    return key;
+}
+
+void DrawList::radixSort() {
+    // Least significant byte first, every pass is stable. Bytes that are equal in all keys are skipped, with few
+    // programs and layers that is most of the upper ones.
+    mScratch.resize(mEntries.size());
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        uint32_t counts[256] = {};
+        for (const SortEntry& entry : mEntries) {
+            counts[(entry.key >> shift) & 0xFF]++;
+        }
+        if (counts[(mEntries[0].key >> shift) & 0xFF] == mEntries.size()) {
+            continue;
+        }
+        uint32_t offset = 0;
+        for (uint32_t& count : counts) {
+            const uint32_t size = count;
+            count = offset;
+            offset += size;
+        }
+        for (const SortEntry& entry : mEntries) {
+            mScratch[counts[(entry.key >> shift) & 0xFF]++] = entry;
+        }
+        mEntries.swap(mScratch);
+    }
+}
+
+void DrawList::execute() {
+    mStats = {};
+    mStats.packets = static_cast<uint32_t>(mPackets.size());
+    if (mPackets.empty()) {
+        return;
+    }
+
+    mEntries.clear();
+    for (uint32_t i = 0; i < mPackets.size(); i++) {
+        mEntries.push_back({makeKey(mPackets[i]), i});
+    }
+    radixSort();
+
+    // GPU time per renderer, told apart by the label of its program: a zone spans each run of its packets, the profiler
+    // sums the runs of a frame by name.
+    const auto zoneName = [this](size_t entry) {
+        const char* label = mPackets[mEntries[entry].index].shader->label();
+        return label != nullptr ? label : "DrawList";
+    };
+    const DrawPacket* previous = nullptr;
+    for (size_t entry = 0; entry < mEntries.size();) {
+        const char* name = zoneName(entry);
+        GpuProfiler::Zone zone(name);
+        for (; entry < mEntries.size() && zoneName(entry) == name; entry++) {
+            const DrawPacket& packet = mPackets[mEntries[entry].index];
+            issue(packet, previous);
+            previous = &packet;
+        }
+    }
+}
+
+void DrawList::issue(const DrawPacket& packet, const DrawPacket* previous) {
+    GlState& glState = GlState::instance();
+    if (previous == nullptr || previous->shader != packet.shader) {
+        packet.shader->use();
+        mStats.programChanges++;
+    }
+    if (previous == nullptr || previous->vertexArray != packet.vertexArray) {
+        glState.bindVertexArray(packet.vertexArray);
+        mStats.vertexArrayChanges++;
+    }
+    if (previous == nullptr || previous->textureTarget != packet.textureTarget || previous->textures != packet.textures) {
+        for (uint32_t unit = 0; unit < DrawPacket::MaxTextures; unit++) {
+            if (packet.textures[unit] != 0) {
+                glState.bindTexture(unit, packet.textureTarget, packet.textures[unit]);
+            }
+        }
+        mStats.textureChanges++;
+    }
+    if (previous == nullptr || previous->blend != packet.blend || previous->depthTest != packet.depthTest ||
+        previous->cullFace != packet.cullFace || previous->frontFace != packet.frontFace) {
+        glState.setEnabled(GL_BLEND, packet.blend);
+        if (packet.blend) {
+            glState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        }
+        glState.setEnabled(GL_DEPTH_TEST, packet.depthTest);
+        glState.setEnabled(GL_CULL_FACE, packet.cullFace);
+        if (packet.cullFace) {
+            glState.cullFace(GL_BACK);
+            glState.frontFace(packet.frontFace);
+        }
+    }
+
+    if (packet.setUniforms != nullptr) {
+        packet.setUniforms(*packet.shader, packet);
+    } else {
+        packet.shader->setUniformMat4("model", packet.model);
+    }
+
+    if (packet.indexType != GL_NONE) {
+        GL_CALL(glDrawElements(packet.mode, packet.count, packet.indexType, nullptr));
+    } else {
+        GL_CALL(glDrawArrays(packet.mode, packet.first, packet.count));
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <stdint.h>
+#include <array>
+#include <unordered_map>
+#include <vector>
+#include "glm/glm.hpp"
+#include "common/gfxwrapper_opengl.h"
+#include "shader.h"
+
+// One draw recorded by a renderer: everything needed to issue it later, in whatever order the draw list picks.
+struct DrawPacket {
+    static constexpr uint32_t MaxTextures = 4;
+
+    enum class Layer : uint8_t {
+        Background,  // drawn first whatever its depth, e.g. the video sphere around the viewer
+        Scene,
+        Overlay,     // drawn last
+    };
+
+    Layer layer = Layer::Scene;
+    const Shader* shader = nullptr;
+    GLuint vertexArray = 0;
+    GLenum textureTarget = GL_TEXTURE_2D;
+    std::array<GLuint, MaxTextures> textures{};  // texture i goes to unit i, 0: unit unused
+
+    // Blended packets are transparent and drawn back to front after the opaque ones, which are drawn front to back.
+    bool blend = false;
+    bool depthTest = true;
+    bool cullFace = false;
+    GLenum frontFace = GL_CCW;
+
+    // The per-draw uniforms. setUniforms receives the packet with the shader in use; without it only "model" is set.
+    glm::mat4 model = glm::mat4(1.0f);
+    glm::vec4 params[2] = {};
+    const void* object = nullptr;  // renderer data setUniforms needs, e.g. the mesh
+    void (*setUniforms)(const Shader& shader, const DrawPacket& packet) = nullptr;
+
+    // glDrawElements when indexType is set, else glDrawArrays from first.
+    GLenum mode = GL_TRIANGLES;
+    GLsizei count = 0;
+    GLenum indexType = GL_NONE;
+    GLint first = 0;
+};
+
+// The packets of one view. Renderers submit during renderFrame(), execute() then sorts them by a 64-bit key and issues
+// them, touching programs, vertex arrays, textures and raster state only where consecutive packets differ.
+// Key layout, most significant first:
+//   opaque:      layer:2 | 0:1 | program:8 | raster state:4 | vertex array:10 | textures:10 | depth:29
+//   transparent: layer:2 | 1:1 | inverted depth:29 | program:8 | raster state:4 | vertex array:10 | textures:10
+class DrawList {
+public:
+    struct Stats {
+        uint32_t packets;
+        uint32_t programChanges;
+        uint32_t vertexArrayChanges;
+        uint32_t textureChanges;
+    };
+
+    // Drops the packets of the last view. Depth is the distance from viewPosition to the origin of a packet's model.
+    void begin(const glm::vec3& viewPosition);
+    void submit(const DrawPacket& packet);
+    void execute();
+
+    // Changes with every begin(), lets a renderer tell its first submit of a view.
+    uint32_t generation() const { return mGeneration; }
+    // Of the last execute().
+    const Stats& getStats() const { return mStats; }
+
+private:
+    struct SortEntry {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    uint64_t makeKey(const DrawPacket& packet);
+    // Small stable ids for the key fields, assigned on first sight and kept across views. The ids only have to agree
+    // within one execute(), so begin() starts a map over once its ids have run out: values that are gone, e.g. deleted
+    // vertex arrays, give their ids back and the map stays bounded.
+    static uint32_t slot(std::unordered_map<uint64_t, uint32_t>& slots, uint64_t value, uint32_t bits);
+    static void recycleSlots(std::unordered_map<uint64_t, uint32_t>& slots, uint32_t bits);
+    void radixSort();
+    void issue(const DrawPacket& packet, const DrawPacket* previous);
+
+private:
+    glm::vec3 mViewPosition = glm::vec3(0.0f);
+    uint32_t mGeneration = 0;
+    std::vector<DrawPacket> mPackets;
+    std::vector<SortEntry> mEntries;
+    std::vector<SortEntry> mScratch;
+    std::unordered_map<uint64_t, uint32_t> mPrograms;
+    std::unordered_map<uint64_t, uint32_t> mVertexArrays;
+    std::unordered_map<uint64_t, uint32_t> mTextureSets;
+    Stats mStats{};
+};
@@ -0,0 +1,87 @@
+#include "glResource.h"
+#include "glState.h"
+#include "gpuMemory.h"
+#include "renderGraph.h"
+#include "utils.h"
+
+GLuint generateGlObject(GlObject type) {
+    GLuint name = 0;
+    switch (type) {
+        case GlObject::Buffer: GL_CALL(glGenBuffers(1, &name)); break;
+        case GlObject::Texture: GL_CALL(glGenTextures(1, &name)); break;
+        case GlObject::VertexArray: GL_CALL(glGenVertexArrays(1, &name)); break;
+        case GlObject::Framebuffer: GL_CALL(glGenFramebuffers(1, &name)); break;
+        case GlObject::Program: name = glCreateProgram(); break;
+    }
+    return name;
+}
+
+GlDeletionQueue& GlDeletionQueue::instance() {
+    // Never destroyed: the renderers' static shaders retire their programs into it while the process exits, after
+    // any function-local static would be gone.
+    static GlDeletionQueue* glDeletionQueue = new GlDeletionQueue();
+    return *glDeletionQueue;
+}
+
+void GlDeletionQueue::retire(GlObject type, GLuint name) {
+    // Its storage is about to go, the budget should not have to wait for the fence.
+    GpuMemory::instance().release(type, name);
+    if (!mShutdown) {
+        mRetired.emplace_back(type, name);
+    }
+}
+
+void GlDeletionQueue::endFrame() {
+    while (!mInFlight.empty()) {
+        GLint status = GL_UNSIGNALED;
+        GL_CALL(glGetSynciv(mInFlight.front().fence, GL_SYNC_STATUS, 1, nullptr, &status));
+        if (status != GL_SIGNALED) {
+            break;
+        }
+        GL_CALL(glDeleteSync(mInFlight.front().fence));
+        destroy(mInFlight.front().objects);
+        mInFlight.pop_front();
+    }
+
+    if (!mRetired.empty()) {
+        const GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        mInFlight.push_back({fence, std::move(mRetired)});
+        mRetired.clear();
+    }
+}
+
+void GlDeletionQueue::shutdown() {
+    for (const Batch& batch : mInFlight) {
+        GL_CALL(glDeleteSync(batch.fence));
+        destroy(batch.objects);
+    }
+    mInFlight.clear();
+    destroy(mRetired);
+    mRetired.clear();
+    mShutdown = true;
+}
+
+uint32_t GlDeletionQueue::pending() const {
+    size_t count = mRetired.size();
+    for (const Batch& batch : mInFlight) {
+        count += batch.objects.size();
+    }
+    return static_cast<uint32_t>(count);
+}
+
+void GlDeletionQueue::destroy(const Objects& objects) {
+    GlState& glState = GlState::instance();
+    for (const auto& object : objects) {
+        const GLuint name = object.second;
+        switch (object.first) {
+            case GlObject::Buffer: glState.deleteBuffers(1, &name); break;
+            case GlObject::Texture: glState.deleteTextures(1, &name); break;
+            case GlObject::VertexArray: glState.deleteVertexArrays(1, &name); break;
+            case GlObject::Framebuffer:
+                RenderGraph::instance().releaseFramebuffer(name);
+                GL_CALL(glDeleteFramebuffers(1, &name));
+                break;
+            case GlObject::Program: glState.deleteProgram(name); break;
+        }
+    }
+}
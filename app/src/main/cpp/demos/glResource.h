@@ -0,0 +1,90 @@
+#pragma once
+#include <stdint.h>
+#include <deque>
+#include <utility>
+#include <vector>
+#include "common/gfxwrapper_opengl.h"
+
+enum class GlObject { Buffer, Texture, VertexArray, Framebuffer, Program };
+
+// glGen* or glCreateProgram for one object of the type.
+GLuint generateGlObject(GlObject type);
+
+// GL objects whose owner let go of them. They are deleted once the GPU is done with every frame that may have used
+// them: what is retired during a frame is fenced at its end and deleted when that fence has signaled, which is polled
+// and never waited for. Deleting an object a queued draw still reads can make the driver stall or copy it.
+class GlDeletionQueue {
+public:
+    static GlDeletionQueue& instance();
+
+    void retire(GlObject type, GLuint name);
+    // Called once per frame after its GL work is issued.
+    void endFrame();
+    // Deletes everything right away, while the context is still current. Objects retired afterwards are dropped:
+    // the context and everything in it is gone.
+    void shutdown();
+
+    // Objects retired but not deleted yet.
+    uint32_t pending() const;
+
+private:
+    using Objects = std::vector<std::pair<GlObject, GLuint>>;
+    struct Batch {
+        GLsync fence;
+        Objects objects;
+    };
+
+    GlDeletionQueue() = default;
+    static void destroy(const Objects& objects);
+
+private:
+    Objects mRetired;              // during the current frame
+    std::deque<Batch> mInFlight;   // oldest first, fences signal in order
+    bool mShutdown = false;
+};
+
+// Move-only owner of one GL object, retires it to the deletion queue when dropped or replaced.
+template <GlObject Type>
+class GlHandle {
+public:
+    GlHandle() = default;
+    explicit GlHandle(GLuint name) : mName(name) {}
+    ~GlHandle() { reset(); }
+
+    GlHandle(const GlHandle&) = delete;
+    GlHandle& operator=(const GlHandle&) = delete;
+    GlHandle(GlHandle&& other) noexcept : mName(other.release()) {}
+    GlHandle& operator=(GlHandle&& other) noexcept {
+        if (this != &other) {
+            reset(other.release());
+        }
+        return *this;
+    }
+
+    static GlHandle generate() { return GlHandle(generateGlObject(Type)); }
+
+    GLuint get() const { return mName; }
+    explicit operator bool() const { return mName != 0; }
+
+    // Gives up ownership without retiring the object.
+    GLuint release() {
+        const GLuint name = mName;
+        mName = 0;
+        return name;
+    }
+    void reset(GLuint name = 0) {
+        if (mName != 0) {
+            GlDeletionQueue::instance().retire(Type, mName);
+        }
+        mName = name;
+    }
+
+private:
+    GLuint mName = 0;
+};
+
+using GlBuffer = GlHandle<GlObject::Buffer>;
+using GlTexture = GlHandle<GlObject::Texture>;
+using GlVertexArray = GlHandle<GlObject::VertexArray>;
+using GlFramebuffer = GlHandle<GlObject::Framebuffer>;
+using GlProgram = GlHandle<GlObject::Program>;
@@ -0,0 +1,242 @@
+#include "glState.h"
+#include "utils.h"
+
+namespace {
+int32_t capabilityIndex(GLenum capability) {
+    switch (capability) {
+        case GL_BLEND: return 0;
+        case GL_CULL_FACE: return 1;
+        case GL_DEPTH_TEST: return 2;
+        case GL_SCISSOR_TEST: return 3;
+        case GL_STENCIL_TEST: return 4;
+        default: return -1;
+    }
+}
+
+int32_t textureTargetIndex(GLenum target) {
+    switch (target) {
+        case GL_TEXTURE_2D: return 0;
+        case GL_TEXTURE_2D_ARRAY: return 1;
+        case GL_TEXTURE_EXTERNAL_OES: return 2;
+        default: return -1;
+    }
+}
+}  // namespace
+
+GlState& GlState::instance() {
+    static GlState glState;
+    return glState;
+}
+
+GlState::GlState() {
+    invalidate();
+}
+
+void GlState::invalidate() {
+    mProgram = Unknown;
+    mVertexArray = Unknown;
+    mArrayBuffer = Unknown;
+    mUniformBuffer = Unknown;
+    mUniformBindings.fill(Unknown);
+    mActiveUnit = Unknown;
+    for (auto& unit : mTextures) {
+        unit.fill(Unknown);
+    }
+    mEnabled.fill(-1);
+    mBlendFunc.fill(Unknown);
+    mBlendEquation = Unknown;
+    mDepthMask = -1;
+    mCullFace = Unknown;
+    mFrontFace = Unknown;
+    mViewportKnown = false;
+    mScissorKnown = false;
+}
+
+void GlState::beginFrame() {
+    mLastFrame = mFrame;
+    mFrame = {};
+}
+
+bool GlState::changed(bool differs) {
+    if (differs) {
+        mFrame.issued++;
+    } else {
+        mFrame.avoided++;
+    }
+    return differs;
+}
+
+void GlState::useProgram(GLuint program) {
+    if (changed(mProgram != program)) {
+        GL_CALL(glUseProgram(program));
+        mProgram = program;
+    }
+}
+
+void GlState::bindVertexArray(GLuint vertexArray) {
+    if (changed(mVertexArray != vertexArray)) {
+        GL_CALL(glBindVertexArray(vertexArray));
+        mVertexArray = vertexArray;
+    }
+}
+
+void GlState::bindBuffer(GLenum target, GLuint buffer) {
+    GLuint* bound = target == GL_ARRAY_BUFFER ? &mArrayBuffer : target == GL_UNIFORM_BUFFER ? &mUniformBuffer : nullptr;
+    if (bound == nullptr) {
+        mFrame.issued++;
+        GL_CALL(glBindBuffer(target, buffer));
+    } else if (changed(*bound != buffer)) {
+        GL_CALL(glBindBuffer(target, buffer));
+        *bound = buffer;
+    }
+}
+
+void GlState::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    if (target != GL_UNIFORM_BUFFER || index >= MaxUniformBindings) {
+        mFrame.issued++;
+        GL_CALL(glBindBufferBase(target, index, buffer));
+        return;
+    }
+    if (changed(mUniformBindings[index] != buffer)) {
+        GL_CALL(glBindBufferBase(target, index, buffer));
+        mUniformBindings[index] = buffer;
+        mUniformBuffer = buffer;
+    }
+}
+
+void GlState::bindTexture(uint32_t unit, GLenum target, GLuint texture) {
+    const int32_t targetIndex = textureTargetIndex(target);
+    if (unit >= MaxTextureUnits || targetIndex < 0) {
+        mFrame.issued += 2;
+        GL_CALL(glActiveTexture(GL_TEXTURE0 + unit));
+        GL_CALL(glBindTexture(target, texture));
+        mActiveUnit = unit;
+        return;
+    }
+    if (!changed(mTextures[unit][targetIndex] != texture)) {
+        return;
+    }
+    if (changed(mActiveUnit != unit)) {
+        GL_CALL(glActiveTexture(GL_TEXTURE0 + unit));
+        mActiveUnit = unit;
+    }
+    GL_CALL(glBindTexture(target, texture));
+    mTextures[unit][targetIndex] = texture;
+}
+
+void GlState::setEnabled(GLenum capability, bool enabled) {
+    const int32_t index = capabilityIndex(capability);
+    if (index < 0) {
+        mFrame.issued++;
+    } else if (changed(mEnabled[index] != (enabled ? 1 : 0))) {
+        mEnabled[index] = enabled ? 1 : 0;
+    } else {
+        return;
+    }
+    if (enabled) {
+        GL_CALL(glEnable(capability));
+    } else {
+        GL_CALL(glDisable(capability));
+    }
+}
+
+void GlState::blendFuncSeparate(GLenum sourceRgb, GLenum destinationRgb, GLenum sourceAlpha, GLenum destinationAlpha) {
+    const std::array<GLenum, 4> blendFunc = {sourceRgb, destinationRgb, sourceAlpha, destinationAlpha};
+    if (changed(mBlendFunc != blendFunc)) {
+        GL_CALL(glBlendFuncSeparate(sourceRgb, destinationRgb, sourceAlpha, destinationAlpha));
+        mBlendFunc = blendFunc;
+    }
+}
+
+void GlState::blendEquation(GLenum mode) {
+    if (changed(mBlendEquation != mode)) {
+        GL_CALL(glBlendEquation(mode));
+        mBlendEquation = mode;
+    }
+}
+
+void GlState::depthMask(bool write) {
+    if (changed(mDepthMask != (write ? 1 : 0))) {
+        GL_CALL(glDepthMask(write ? GL_TRUE : GL_FALSE));
+        mDepthMask = write ? 1 : 0;
+    }
+}
+
+void GlState::cullFace(GLenum mode) {
+    if (changed(mCullFace != mode)) {
+        GL_CALL(glCullFace(mode));
+        mCullFace = mode;
+    }
+}
+
+void GlState::frontFace(GLenum mode) {
+    if (changed(mFrontFace != mode)) {
+        GL_CALL(glFrontFace(mode));
+        mFrontFace = mode;
+    }
+}
+
+void GlState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    const std::array<GLint, 4> viewport = {x, y, width, height};
+    if (changed(!mViewportKnown || mViewport != viewport)) {
+        GL_CALL(glViewport(x, y, width, height));
+        mViewport = viewport;
+        mViewportKnown = true;
+    }
+}
+
+void GlState::scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+    const std::array<GLint, 4> scissor = {x, y, width, height};
+    if (changed(!mScissorKnown || mScissor != scissor)) {
+        GL_CALL(glScissor(x, y, width, height));
+        mScissor = scissor;
+        mScissorKnown = true;
+    }
+}
+
+void GlState::deleteTextures(GLsizei count, const GLuint* textures) {
+    for (GLsizei i = 0; i < count; i++) {
+        for (auto& unit : mTextures) {
+            for (GLuint& texture : unit) {
+                if (texture == textures[i]) {
+                    texture = Unknown;
+                }
+            }
+        }
+    }
+    GL_CALL(glDeleteTextures(count, textures));
+}
+
+void GlState::deleteVertexArrays(GLsizei count, const GLuint* vertexArrays) {
+    for (GLsizei i = 0; i < count; i++) {
+        if (mVertexArray == vertexArrays[i]) {
+            mVertexArray = Unknown;
+        }
+    }
+    GL_CALL(glDeleteVertexArrays(count, vertexArrays));
+}
+
+void GlState::deleteBuffers(GLsizei count, const GLuint* buffers) {
+    for (GLsizei i = 0; i < count; i++) {
+        if (mArrayBuffer == buffers[i]) {
+            mArrayBuffer = Unknown;
+        }
+        if (mUniformBuffer == buffers[i]) {
+            mUniformBuffer = Unknown;
+        }
+        for (GLuint& binding : mUniformBindings) {
+            if (binding == buffers[i]) {
+                binding = Unknown;
+            }
+        }
+    }
+    GL_CALL(glDeleteBuffers(count, buffers));
+}
+
+void GlState::deleteProgram(GLuint program) {
+    // A program in use is only deleted once it is not anymore, until then it stays current.
+    if (mProgram == program) {
+        mProgram = Unknown;
+    }
+    GL_CALL(glDeleteProgram(program));
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <stdint.h>
+#include <array>
+#include "common/gfxwrapper_opengl.h"
+
+// CPU-side shadow of the GL state the demo renderers share: program, vertex array, buffers, textures per unit, blend,
+// depth, cull, scissor and viewport. Every renderer sets the state it needs through it instead of calling GL directly
+// and never restores anything; a call that would not change the shadowed value is dropped. Nothing is read back with
+// glGet: a value is unknown until the first call that sets it, and invalidate() forgets everything again.
+// GL_ELEMENT_ARRAY_BUFFER is vertex array state and stays a plain GL call, made while the owning vertex array is bound.
+class GlState {
+public:
+    static constexpr uint32_t MaxTextureUnits = 16;
+    static constexpr uint32_t MaxUniformBindings = 8;
+
+    struct Stats {
+        uint32_t issued;   // GL calls made
+        uint32_t avoided;  // calls dropped because the state was already set
+    };
+
+    static GlState& instance();
+
+    // Forgets every shadowed value, the next call of each setter reaches GL.
+    void invalidate();
+    // Closes the counters of the last frame, which getStats() then returns.
+    void beginFrame();
+    const Stats& getStats() const { return mLastFrame; }
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+    // GL_ARRAY_BUFFER or GL_UNIFORM_BUFFER.
+    void bindBuffer(GLenum target, GLuint buffer);
+    // GL_UNIFORM_BUFFER, also binds the buffer to the generic binding point like GL does.
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    // GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY or GL_TEXTURE_EXTERNAL_OES, the unit is made active when it is not.
+    void bindTexture(uint32_t unit, GLenum target, GLuint texture);
+
+    // GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_SCISSOR_TEST or GL_STENCIL_TEST.
+    void setEnabled(GLenum capability, bool enabled);
+    void blendFunc(GLenum source, GLenum destination) { blendFuncSeparate(source, destination, source, destination); }
+    void blendFuncSeparate(GLenum sourceRgb, GLenum destinationRgb, GLenum sourceAlpha, GLenum destinationAlpha);
+    void blendEquation(GLenum mode);
+    void depthMask(bool write);
+    void cullFace(GLenum mode);
+    void frontFace(GLenum mode);
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // Deletes the objects. Where they were shadowed as bound the binding becomes unknown: GL only unbinds them from the
+    // active texture unit, and a later object may reuse the name.
+    void deleteTextures(GLsizei count, const GLuint* textures);
+    void deleteVertexArrays(GLsizei count, const GLuint* vertexArrays);
+    void deleteBuffers(GLsizei count, const GLuint* buffers);
+    void deleteProgram(GLuint program);
+
+private:
+    GlState();
+    // Returns whether the call has to be made and counts it either way.
+    bool changed(bool differs);
+
+private:
+    static constexpr uint32_t Unknown = 0xFFFFFFFFu;
+    static constexpr uint32_t CapabilityCount = 5;     // the capabilities setEnabled shadows
+    static constexpr uint32_t TextureTargetCount = 3;  // the targets bindTexture shadows per unit
+
+    GLuint mProgram;
+    GLuint mVertexArray;
+    GLuint mArrayBuffer;
+    GLuint mUniformBuffer;
+    std::array<GLuint, MaxUniformBindings> mUniformBindings;
+    uint32_t mActiveUnit;
+    std::array<std::array<GLuint, TextureTargetCount>, MaxTextureUnits> mTextures;
+
+    std::array<int8_t, CapabilityCount> mEnabled;  // -1: unknown
+    std::array<GLenum, 4> mBlendFunc;
+    GLenum mBlendEquation;
+    int8_t mDepthMask;
+    GLenum mCullFace;
+    GLenum mFrontFace;
+    std::array<GLint, 4> mViewport;
+    std::array<GLint, 4> mScissor;
+    bool mViewportKnown;
+    bool mScissorKnown;
+
+    Stats mFrame{};
+    Stats mLastFrame{};
+};
@@ -0,0 +1,161 @@
+#include "glValidation.h"
+#include "utils.h"
+#include <string.h>
+#include <EGL/egl.h>
+
+namespace {
+const char* sourceName(GLenum source) {
+    switch (source) {
+        case GL_DEBUG_SOURCE_API: return "api";
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+        case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+        case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+        case GL_DEBUG_SOURCE_APPLICATION: return "application";
+        default: return "other";
+    }
+}
+
+const char* typeName(GLenum type) {
+    switch (type) {
+        case GL_DEBUG_TYPE_ERROR: return "error";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behavior";
+        case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+        case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+        default: return "other";
+    }
+}
+
+// Errors and high severity messages are errors, medium ones warnings; the rest is only of interest when looking for it.
+Log::Level logLevel(GLenum type, GLenum severity) {
+    if (type == GL_DEBUG_TYPE_ERROR || severity == GL_DEBUG_SEVERITY_HIGH) {
+        return Log::Level::Error;
+    }
+    if (severity == GL_DEBUG_SEVERITY_MEDIUM) {
+        return Log::Level::Warning;
+    }
+    return severity == GL_DEBUG_SEVERITY_LOW ? Log::Level::Info : Log::Level::Verbose;
+}
+
+// glDebugMessageCallback of the current context, nullptr without KHR_debug. The linked symbol is always there, whether
+// the driver implements it is only known from the version or the extension, and then the driver's entry point is used.
+PFNGLDEBUGMESSAGECALLBACKPROC debugMessageCallback() {
+    GLint major = 0;
+    GLint minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major > 3 || (major == 3 && minor >= 2)) {
+        return reinterpret_cast<PFNGLDEBUGMESSAGECALLBACKPROC>(eglGetProcAddress("glDebugMessageCallback"));
+    }
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        if (strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), "GL_KHR_debug") == 0) {
+            return reinterpret_cast<PFNGLDEBUGMESSAGECALLBACKPROC>(eglGetProcAddress("glDebugMessageCallbackKHR"));
+        }
+    }
+    return nullptr;
+}
+}  // namespace
+
+GlValidation& GlValidation::instance() {
+    static GlValidation glValidation;
+    return glValidation;
+}
+
+bool GlValidation::parse(const std::string& name, Level& level) {
+    for (Level candidate : {Level::Off, Level::Callback, Level::Pass, Level::Call}) {
+        if (name == GlValidation::name(candidate)) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* GlValidation::name(Level level) {
+    switch (level) {
+        case Level::Off: return "Off";
+        case Level::Callback: return "Callback";
+        case Level::Pass: return "Pass";
+        case Level::Call: return "Call";
+    }
+    return "Off";
+}
+
+void GlValidation::setLevel(Level level) {
+#if GL_VALIDATION_DEFAULT < 3
+    if (level == Level::Call) {
+        warnf("GL validation Call is not compiled into this build, using Pass");
+        level = Level::Pass;
+    }
+#endif
+    mLevel = level;
+
+    const PFNGLDEBUGMESSAGECALLBACKPROC setCallback = debugMessageCallback();
+    const bool callback = level != Level::Off && setCallback != nullptr;
+    if (callback) {
+        GL_CALL(setCallback(debugMessage, this));
+        GL_CALL(glEnable(GL_DEBUG_OUTPUT));
+    } else if (setCallback != nullptr) {
+        GL_CALL(glDisable(GL_DEBUG_OUTPUT));
+        GL_CALL(setCallback(nullptr, nullptr));
+    }
+    // Synchronous messages arrive inside the offending call, which is what a per-call check wants and costs the
+    // driver its threading.
+    if (level == Level::Call) {
+        GL_CALL(glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
+    } else if (callback) {
+        GL_CALL(glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
+    }
+    infof("GL validation: %s%s", name(level), level != Level::Off && !callback ? " (no KHR_debug)" : "");
+}
+
+void GlValidation::checkErrors(const char* where, const char* file, int line) {
+    // glGetError returns one queued error per call, a driver may have several.
+    for (uint32_t i = 0; i < MaxQueuedErrors; i++) {
+        const GLenum error = glGetError();
+        if (error == GL_NO_ERROR) {
+            break;
+        }
+        if (file != nullptr) {
+            Log::Write(Log::Level::Error, file, line, Fmt("GL error 0x%x returned from '%s'", error, where));
+        } else {
+            Log::Write(Log::Level::Error, Fmt("GL error 0x%x in %s", error, where));
+        }
+    }
+}
+
+void GlValidation::discardErrors() {
+    for (uint32_t i = 0; i < MaxQueuedErrors && glGetError() != GL_NO_ERROR; i++) {
+    }
+}
+
+void GL_APIENTRY GlValidation::debugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message,
+                                            const void* userParam) {
+    static_cast<GlValidation*>(const_cast<void*>(userParam))->onDebugMessage(source, type, id, severity, length, message);
+}
+
+void GlValidation::onDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message) {
+    // A message repeated every frame would flood the log: the first one is logged, then every tenfold repeat.
+    uint32_t count;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        const uint64_t key = (static_cast<uint64_t>(source & 0xFFFF) << 48) | (static_cast<uint64_t>(type & 0xFFFF) << 32) | id;
+        count = ++mMessageCounts[key];
+    }
+    uint32_t power = 1;
+    while (power < count && power <= UINT32_MAX / 10) {
+        power *= 10;
+    }
+    if (power != count) {
+        return;
+    }
+
+    const std::string text = length < 0 ? std::string(message) : std::string(message, length);
+    if (count == 1) {
+        Log::Write(logLevel(type, severity), Fmt("GL %s %s %u: %s", sourceName(source), typeName(type), id, text.c_str()));
+    } else {
+        Log::Write(logLevel(type, severity), Fmt("GL %s %s %u, seen %u times: %s", sourceName(source), typeName(type), id, count, text.c_str()));
+    }
+}
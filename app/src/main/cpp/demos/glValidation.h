@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "common/gfxwrapper_opengl.h"
+
+// How much GL error checking is done, from free to slow:
+//   Off       nothing
+//   Callback  KHR_debug messages are logged by severity, repeats of a message are counted instead of logged
+//   Pass      Callback, plus glGetError once after every render graph pass
+//   Call      Callback with synchronous messages, plus glGetError after every GL_CALL
+// The build picks the level the app starts with (GL_VALIDATION_DEFAULT, see CMakeLists.txt), debug.xr.glValidation
+// overrides it. The per-call checks are only compiled into builds whose default is Call, anywhere else GL_CALL is the
+// bare call and Call falls back to Pass.
+#ifndef GL_VALIDATION_DEFAULT
+#define GL_VALIDATION_DEFAULT 0
+#endif
+
+class GlValidation {
+public:
+    enum class Level : int32_t { Off = 0, Callback = 1, Pass = 2, Call = 3 };
+
+    static GlValidation& instance();
+    // "Off", "Callback", "Pass" or "Call", false for anything else.
+    static bool parse(const std::string& name, Level& level);
+    static const char* name(Level level);
+
+    // Needs a current context, (un)installs the debug callback.
+    void setLevel(Level level);
+    Level level() const { return mLevel; }
+
+    // Logs every error glGetError has queued since the last check. where names the pass or call.
+    void checkErrors(const char* where, const char* file = nullptr, int line = 0);
+    // Drops the queued errors unlogged, for calls whose failure is expected and handled.
+    static void discardErrors();
+    // The render graph calls this after each pass, it only checks at level Pass.
+    void checkPass(const char* name) {
+        if (mLevel == Level::Pass) {
+            checkErrors(name);
+        }
+    }
+    bool checksCalls() const { return mLevel == Level::Call; }
+
+private:
+    // A lost context reports GL_CONTEXT_LOST from every glGetError, a drain stops after this many.
+    static constexpr uint32_t MaxQueuedErrors = 16;
+
+    GlValidation() = default;
+    static void GL_APIENTRY debugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message,
+                                         const void* userParam);
+    void onDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message);
+
+private:
+    Level mLevel = Level::Off;
+    // Messages may arrive on a driver thread unless they are synchronous.
+    std::mutex mMutex;
+    std::unordered_map<uint64_t, uint32_t> mMessageCounts;  // by source, type and id
+};
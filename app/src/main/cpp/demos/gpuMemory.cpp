@@ -0,0 +1,179 @@
+#include <algorithm>
+#include "gpuMemory.h"
+#include "utils.h"
+
+namespace {
+// Unsized formats take their size from format and type, RGB is counted like RGBA as most drivers store it that way.
+uint32_t bytesPerPixel(GLenum internalFormat, GLenum type) {
+    switch (internalFormat) {
+        case GL_R8: return 1;
+        case GL_RG8: return 2;
+        case GL_RGB565:
+        case GL_RGBA4:
+        case GL_RGB5_A1:
+        case GL_R16F:
+        case GL_DEPTH_COMPONENT16: return 2;
+        case GL_RGB8:
+        case GL_RGBA8:
+        case GL_SRGB8:
+        case GL_SRGB8_ALPHA8:
+        case GL_RGB10_A2:
+        case GL_RG16F:
+        case GL_R32F:
+        case GL_DEPTH_COMPONENT24:
+        case GL_DEPTH_COMPONENT32F:
+        case GL_DEPTH24_STENCIL8: return 4;
+        case GL_RGBA16F:
+        case GL_DEPTH32F_STENCIL8: return 8;
+        case GL_RGBA32F: return 16;
+        default: break;
+    }
+
+    uint32_t components;
+    switch (internalFormat) {
+        case GL_RED:
+        case GL_ALPHA:
+        case GL_LUMINANCE: components = 1; break;
+        case GL_RG:
+        case GL_LUMINANCE_ALPHA: components = 2; break;
+        default: components = 4; break;
+    }
+    const uint32_t componentBytes = type == GL_FLOAT ? 4 : type == GL_HALF_FLOAT ? 2 : 1;
+    return components * componentBytes;
+}
+
+uint64_t mipChainBytes(GLsizei levels, GLsizei width, GLsizei height, GLsizei depth, uint32_t pixelBytes) {
+    uint64_t bytes = 0;
+    for (GLsizei level = 0; level < levels; level++) {
+        bytes += static_cast<uint64_t>(std::max(width >> level, 1)) * std::max(height >> level, 1) * depth * pixelBytes;
+    }
+    return bytes;
+}
+}  // namespace
+
+GpuMemory& GpuMemory::instance() {
+    // Never destroyed, like the deletion queue that releases into it.
+    static GpuMemory* gpuMemory = new GpuMemory();
+    return *gpuMemory;
+}
+
+const char* GpuMemory::tagName(GpuMemoryTag tag) {
+    switch (tag) {
+        case GpuMemoryTag::Frame: return "frame";
+        case GpuMemoryTag::Text: return "text";
+        case GpuMemoryTag::Model: return "model";
+        case GpuMemoryTag::Gui: return "gui";
+        case GpuMemoryTag::Player: return "player";
+        case GpuMemoryTag::Geometry: return "geometry";
+        case GpuMemoryTag::Count: break;
+    }
+    return "other";
+}
+
+void GpuMemory::bufferData(GpuMemoryTag tag, GLuint buffer, GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    GL_CALL(glBufferData(target, size, data, usage));
+    account(tag, GlObject::Buffer, buffer, size, size);
+}
+
+void GpuMemory::texImage2D(GpuMemoryTag tag, GLuint texture, GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+                           GLenum format, GLenum type, const void* pixels) {
+    GL_CALL(glTexImage2D(target, level, internalFormat, width, height, 0, format, type, pixels));
+    const uint64_t bytes = static_cast<uint64_t>(width) * height * bytesPerPixel(internalFormat, type);
+    if (level == 0) {
+        account(tag, GlObject::Texture, texture, bytes, bytes);
+        return;
+    }
+    // A level of its own adds to the texture.
+    auto it = mAllocations.find(key(GlObject::Texture, texture));
+    const uint64_t baseBytes = it != mAllocations.end() ? it->second.baseBytes : 0;
+    const uint64_t total = it != mAllocations.end() ? it->second.bytes : 0;
+    account(tag, GlObject::Texture, texture, baseBytes, total + bytes);
+}
+
+void GpuMemory::texStorage2D(GpuMemoryTag tag, GLuint texture, GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height) {
+    GL_CALL(glTexStorage2D(target, levels, internalFormat, width, height));
+    const uint32_t pixelBytes = bytesPerPixel(internalFormat, GL_NONE);
+    account(tag, GlObject::Texture, texture, mipChainBytes(1, width, height, 1, pixelBytes), mipChainBytes(levels, width, height, 1, pixelBytes));
+}
+
+void GpuMemory::texStorage3D(GpuMemoryTag tag, GLuint texture, GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height,
+                             GLsizei depth) {
+    GL_CALL(glTexStorage3D(target, levels, internalFormat, width, height, depth));
+    const uint32_t pixelBytes = bytesPerPixel(internalFormat, GL_NONE);
+    account(tag, GlObject::Texture, texture, mipChainBytes(1, width, height, depth, pixelBytes),
+            mipChainBytes(levels, width, height, depth, pixelBytes));
+}
+
+void GpuMemory::generateMipmap(GLuint texture, GLenum target) {
+    GL_CALL(glGenerateMipmap(target));
+    auto it = mAllocations.find(key(GlObject::Texture, texture));
+    if (it != mAllocations.end()) {
+        const Allocation allocation = it->second;
+        account(allocation.tag, GlObject::Texture, texture, allocation.baseBytes, allocation.baseBytes * 4 / 3);
+    }
+}
+
+void GpuMemory::release(GlObject type, GLuint name) {
+    auto it = mAllocations.find(key(type, name));
+    if (it == mAllocations.end()) {
+        return;
+    }
+    charge(it->second.tag, -static_cast<int64_t>(it->second.bytes), -1);
+    mAllocations.erase(it);
+}
+
+void GpuMemory::account(GpuMemoryTag tag, GlObject type, GLuint name, uint64_t baseBytes, uint64_t bytes) {
+    auto it = mAllocations.find(key(type, name));
+    if (it != mAllocations.end()) {
+        // respecified, possibly by another owner
+        charge(it->second.tag, -static_cast<int64_t>(it->second.bytes), -1);
+        it->second = {tag, baseBytes, bytes};
+    } else {
+        mAllocations.emplace(key(type, name), Allocation{tag, baseBytes, bytes});
+    }
+    charge(tag, static_cast<int64_t>(bytes), 1);
+}
+
+void GpuMemory::charge(GpuMemoryTag tag, int64_t bytes, int32_t objects) {
+    for (TagStats* stats : {&mTags[static_cast<uint32_t>(tag)], &mTotal}) {
+        stats->bytes += bytes;
+        stats->objects += objects;
+        stats->peakBytes = std::max(stats->peakBytes, stats->bytes);
+    }
+}
+
+uint32_t GpuMemory::addEvictor(GpuMemoryTag tag, Evictor evictor) {
+    const uint32_t id = mNextEvictorId++;
+    mEvictors.push_back({id, tag, std::move(evictor)});
+    return id;
+}
+
+void GpuMemory::removeEvictor(uint32_t id) {
+    mEvictors.erase(std::remove_if(mEvictors.begin(), mEvictors.end(), [id](const EvictorEntry& entry) { return entry.id == id; }),
+                    mEvictors.end());
+}
+
+void GpuMemory::endFrame() {
+    if (mBudget == 0 || mTotal.bytes <= mBudget) {
+        mOverBudget = false;
+        return;
+    }
+
+    for (const EvictorEntry& evictor : mEvictors) {
+        if (mTotal.bytes <= mBudget) {
+            break;
+        }
+        const uint64_t before = mTotal.bytes;
+        evictor.evict(mTotal.bytes - mBudget);
+        if (mTotal.bytes < before) {
+            debugf("GPU memory over budget, evicted %.1fKB of %s", (before - mTotal.bytes) / 1024.0f, tagName(evictor.tag));
+        }
+    }
+
+    // Once per excursion, it would repeat every frame otherwise.
+    if (mTotal.bytes > mBudget && !mOverBudget) {
+        warnf("GPU memory %.1fMB over the budget of %.1fMB with nothing left to evict", (mTotal.bytes - mBudget) / 1048576.0f,
+              mBudget / 1048576.0f);
+    }
+    mOverBudget = mTotal.bytes > mBudget;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <stdint.h>
+#include <array>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "common/gfxwrapper_opengl.h"
+#include "glResource.h"
+
+// Who an allocation is charged to.
+enum class GpuMemoryTag : uint32_t { Frame, Text, Model, Gui, Player, Geometry, Count };
+
+// Accounts the storage of buffers and textures by tag. Every glBufferData/glTexImage2D/glTexStorage of the demos goes
+// through it: the wrappers make the call on the object bound to target and record its size, which is replaced when
+// the object is respecified and released when its handle retires it. Sizes are estimates, drivers pad and compress.
+// With a budget set, endFrame() runs the evictors while the total is over it.
+class GpuMemory {
+public:
+    struct TagStats {
+        uint64_t bytes = 0;
+        uint64_t peakBytes = 0;
+        uint32_t objects = 0;
+    };
+    // Asked to free about bytes, e.g. by dropping cached objects that can be recreated. Frees through handles.
+    using Evictor = std::function<void(uint64_t bytes)>;
+
+    static GpuMemory& instance();
+    static const char* tagName(GpuMemoryTag tag);
+
+    void bufferData(GpuMemoryTag tag, GLuint buffer, GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+    void texImage2D(GpuMemoryTag tag, GLuint texture, GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+                    GLenum format, GLenum type, const void* pixels);
+    void texStorage2D(GpuMemoryTag tag, GLuint texture, GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height);
+    void texStorage3D(GpuMemoryTag tag, GLuint texture, GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height,
+                      GLsizei depth);
+    // The mip chain of a texture specified with texImage2D, a third on top of level 0.
+    void generateMipmap(GLuint texture, GLenum target);
+    // The object was deleted or retired, called by GlDeletionQueue.
+    void release(GlObject type, GLuint name);
+
+    // In bytes, 0 for none.
+    void setBudget(uint64_t bytes) { mBudget = bytes; }
+    uint64_t getBudget() const { return mBudget; }
+    // Evictors run in the order they were added. The id removes it again.
+    uint32_t addEvictor(GpuMemoryTag tag, Evictor evictor);
+    void removeEvictor(uint32_t id);
+    // Called once per frame, before the deletion queue fences what the evictors let go of.
+    void endFrame();
+
+    const TagStats& getStats(GpuMemoryTag tag) const { return mTags[static_cast<uint32_t>(tag)]; }
+    const TagStats& getTotal() const { return mTotal; }
+
+private:
+    struct Allocation {
+        GpuMemoryTag tag;
+        uint64_t baseBytes;  // level 0
+        uint64_t bytes;
+    };
+    struct EvictorEntry {
+        uint32_t id;
+        GpuMemoryTag tag;
+        Evictor evict;
+    };
+
+    GpuMemory() = default;
+    static uint64_t key(GlObject type, GLuint name) { return static_cast<uint64_t>(type) << 32 | name; }
+    void account(GpuMemoryTag tag, GlObject type, GLuint name, uint64_t baseBytes, uint64_t bytes);
+    void charge(GpuMemoryTag tag, int64_t bytes, int32_t objects);
+
+private:
+    std::unordered_map<uint64_t, Allocation> mAllocations;  // by object type and name
+    std::array<TagStats, static_cast<uint32_t>(GpuMemoryTag::Count)> mTags{};
+    TagStats mTotal;
+    uint64_t mBudget = 0;
+    bool mOverBudget = false;  // warned about this excursion already
+    std::vector<EvictorEntry> mEvictors;
+    uint32_t mNextEvictorId = 1;
+};
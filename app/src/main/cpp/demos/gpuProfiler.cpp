@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <string.h>
+#ifdef XR_USE_PLATFORM_ANDROID
+#include <android/trace.h>
+#endif
+#include "gpuProfiler.h"
+#include "utils.h"
+
+GpuProfiler& GpuProfiler::instance() {
+    static GpuProfiler gpuProfiler;
+    return gpuProfiler;
+}
+
+bool GpuProfiler::initialize(bool timerQuerySupported) {
+    if (mEnabled) {
+        return true;
+    }
+    if (!timerQuerySupported || glQueryCounter == nullptr || glGetQueryObjectui64v == nullptr) {
+        infof("GpuProfiler: timer queries unavailable, GPU timings disabled");
+        return false;
+    }
+    for (Frame& frame : mFrames) {
+        GL_CALL(glGenQueries(sizeof(frame.queries) / sizeof(frame.queries[0]), frame.queries));
+        frame.zoneCount = 0;
+        frame.pending = false;
+    }
+    mEnabled = true;
+    return true;
+}
+
+void GpuProfiler::shutdown() {
+    if (!mEnabled) {
+        return;
+    }
+    for (Frame& frame : mFrames) {
+        GL_CALL(glDeleteQueries(sizeof(frame.queries) / sizeof(frame.queries[0]), frame.queries));
+    }
+    mEnabled = false;
+    mZones.clear();
+}
+
+void GpuProfiler::beginFrame() {
+    if (!mEnabled) {
+        return;
+    }
+    Frame& frame = mFrames[mFrameIndex % FrameLatency];
+    mFrameFresh = readBack(frame);
+
+    frame.zoneCount = 0;
+    frame.pending = false;
+    GL_CALL(glQueryCounter(frame.queries[0], GL_TIMESTAMP));
+    mInFrame = true;
+}
+
+void GpuProfiler::endFrame() {
+    if (!mEnabled || !mInFrame) {
+        return;
+    }
+    Frame& frame = mFrames[mFrameIndex % FrameLatency];
+    GL_CALL(glQueryCounter(frame.queries[1], GL_TIMESTAMP));
+    frame.pending = true;
+    mInFrame = false;
+    mFrameIndex++;
+}
+
+bool GpuProfiler::getFrameTime(int64_t& ns) const {
+    if (!mFrameFresh) {
+        return false;
+    }
+    ns = mFrameNs;
+    return true;
+}
+
+int32_t GpuProfiler::beginZone(const char* name) {
+    if (!mEnabled || !mInFrame) {
+        return -1;
+    }
+    Frame& frame = mFrames[mFrameIndex % FrameLatency];
+    if (frame.zoneCount == MaxZones) {
+        return -1;
+    }
+    const uint32_t index = frame.zoneCount++;
+    frame.names[index] = name;
+    GL_CALL(glQueryCounter(frame.queries[2 * (index + 1)], GL_TIMESTAMP));
+    return static_cast<int32_t>(index);
+}
+
+void GpuProfiler::endZone(int32_t index) {
+    if (index < 0 || !mInFrame) {
+        return;
+    }
+    Frame& frame = mFrames[mFrameIndex % FrameLatency];
+    GL_CALL(glQueryCounter(frame.queries[2 * (index + 1) + 1], GL_TIMESTAMP));
+}
+
+bool GpuProfiler::readBack(Frame& frame) {
+    if (!frame.pending) {
+        return false;
+    }
+
+    // The frame end is the last timestamp of the slot, once it is available all the others are too.
+    GLuint available = 0;
+    GL_CALL(glGetQueryObjectuiv(frame.queries[1], GL_QUERY_RESULT_AVAILABLE, &available));
+    // A disjoint event (GPU frequency change, context loss) makes every timestamp in flight meaningless.
+    GLint disjoint = 0;
+    GL_CALL(glGetIntegerv(GL_GPU_DISJOINT, &disjoint));
+    if (available == 0 || disjoint != 0) {
+        return false;
+    }
+
+    const auto elapsed = [&frame](uint32_t pair) {
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        GL_CALL(glGetQueryObjectui64v(frame.queries[2 * pair], GL_QUERY_RESULT, &begin));
+        GL_CALL(glGetQueryObjectui64v(frame.queries[2 * pair + 1], GL_QUERY_RESULT, &end));
+        return end > begin ? static_cast<int64_t>(end - begin) : 0;
+    };
+
+    mFrameNs = elapsed(0);
+    mZones.clear();
+    for (uint32_t i = 0; i < frame.zoneCount; i++) {
+        const float ms = elapsed(i + 1) / 1000000.0f;
+        auto zone = std::find_if(mZones.begin(), mZones.end(), [&](const ZoneResult& z) { return z.name == frame.names[i] || strcmp(z.name, frame.names[i]) == 0; });
+        if (zone == mZones.end()) {
+            mZones.push_back({frame.names[i], ms});
+        } else {
+            zone->ms += ms;
+        }
+    }
+
+#ifdef XR_USE_PLATFORM_ANDROID
+    // Export to systrace/Perfetto as counters in microseconds.
+    if (ATrace_isEnabled()) {
+        ATrace_setCounter("GPU frame", mFrameNs / 1000);
+        for (const ZoneResult& zone : mZones) {
+            ATrace_setCounter(Fmt("GPU %s", zone.name).c_str(), static_cast<int64_t>(zone.ms * 1000.0f));
+        }
+    }
+#endif
+    return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+#include <array>
+#include <vector>
+#include "common/gfxwrapper_opengl.h"
+
+// GPU timings from GL_EXT_disjoint_timer_query timestamps.
+// Every frame owns a slot of query objects that is read back FrameLatency frames later, right before the slot is reused.
+// A slot whose results are not there yet is dropped rather than waited for, so the profiler never stalls the pipeline.
+class GpuProfiler {
+public:
+    static constexpr uint32_t FrameLatency = 4;  // frames in flight before a slot is read back
+    static constexpr uint32_t MaxZones = 64;     // zone instances per frame, later ones are not timed
+
+    struct ZoneResult {
+        const char* name;
+        float ms;  // summed over every instance of the zone in the frame, e.g. both eyes
+    };
+
+    // Times the GPU work issued during its lifetime. The name must be a string literal, zones are merged by name.
+    class Zone {
+    public:
+        explicit Zone(const char* name) : mIndex(GpuProfiler::instance().beginZone(name)) {}
+        ~Zone() { GpuProfiler::instance().endZone(mIndex); }
+    private:
+        int32_t mIndex;
+    };
+
+    static GpuProfiler& instance();
+    // Without timer query support the profiler stays disabled and every call is a no-op.
+    bool initialize(bool timerQuerySupported);
+    // Deletes the query objects, must be called while the GL context is still current.
+    void shutdown();
+    bool isEnabled() const { return mEnabled; }
+
+    // Reads back the oldest slot, then starts timing a new frame in it.
+    void beginFrame();
+    void endFrame();
+
+    // GPU time of the frame read back by the last beginFrame(), false when that read back had no result.
+    bool getFrameTime(int64_t& ns) const;
+    // Per-zone times of the last frame that was read back.
+    const std::vector<ZoneResult>& getZones() const { return mZones; }
+
+private:
+    struct Frame {
+        GLuint queries[2 * (MaxZones + 1)];  // begin/end timestamp pairs, pair 0 spans the whole frame
+        const char* names[MaxZones];
+        uint32_t zoneCount;
+        bool pending;
+    };
+
+    GpuProfiler() = default;
+    int32_t beginZone(const char* name);
+    void endZone(int32_t index);
+    bool readBack(Frame& frame);
+
+private:
+    std::array<Frame, FrameLatency> mFrames{};
+    uint32_t mFrameIndex = 0;
+    bool mEnabled = false;
+    bool mInFrame = false;
+    bool mFrameFresh = false;
+    int64_t mFrameNs = 0;
+    std::vector<ZoneResult> mZones;
+};
@@ -1,13 +1,31 @@
+#include "pch.h"
 #include "gui.h"
 #include "utils.h"
+#include "renderGraph.h"
+#include "glState.h"
+#include "gpuMemory.h"
 #include "glm/geometric.hpp"
 #include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/quaternion.hpp"
 
 Shader Gui::mShader;
-Gui::Gui(std::string name): mName(name), mFramebuffer(0), mTextureColorbuffer(0), mVAO(0), mVBO(0) {
+Gui::Gui(std::string name): mName(name), mDeltaTime(1.0f / 72.0f),
+    mHovered(false), mSwapchain(XR_NULL_HANDLE), mLayerImageReady(false), mQuadLayer{} {
+    mQuadLayer.type = XR_TYPE_COMPOSITION_LAYER_QUAD;
 }
 
 Gui::~Gui() {
+    destroyLayer();
+}
+
+void Gui::destroyLayer() {
+    mLayerFramebuffers.clear();
+    mSwapchainImages.clear();
+    mLayerImageReady = false;
+    if (mSwapchain != XR_NULL_HANDLE) {
+        xrDestroySwapchain(mSwapchain);
+        mSwapchain = XR_NULL_HANDLE;
+    }
 }
 
 bool Gui::initShader() {
@@ -23,14 +41,12 @@ bool Gui::initShader() {
             layout (location = 1) in vec2 aTexCoords;
             out vec2 TexCoords;
             out vec3 FragPos;
-            uniform mat4 projection;
-            uniform mat4 view;
             uniform mat4 model;
             void main()
             {
                 FragPos = vec3(model * vec4(aPos, 1.0));
                 TexCoords = aTexCoords;
-                gl_Position = projection * view * vec4(FragPos, 1.0);
+                gl_Position = projection[VIEW_ID] * view[VIEW_ID] * vec4(FragPos, 1.0);
             }
         )_";
 
@@ -53,7 +69,7 @@ bool Gui::initShader() {
             }
         )_";
 
-        if (mShader.loadShader(vertex_shader_glsl, fragment_shader_glsl) == false) {
+        if (mShader.loadShader(vertex_shader_glsl, fragment_shader_glsl, true, "gui") == false) {
             return false;
         }
         init = true;
@@ -74,22 +90,19 @@ bool Gui::initialize(int32_t width, int32_t height) {
         return true;
     }
 
-    GL_CALL(glGenFramebuffers(1, &mFramebuffer));
-    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer));
-
-    GL_CALL(glActiveTexture(GL_TEXTURE0));
-    GL_CALL(glGenTextures(1, &mTextureColorbuffer));
-    GL_CALL(glBindTexture(GL_TEXTURE_2D, mTextureColorbuffer));
-    GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mWidth, mHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+    mTextureColorbuffer = GlTexture::generate();
+    GlState::instance().bindTexture(0, GL_TEXTURE_2D, mTextureColorbuffer.get());
+    GpuMemory::instance().texImage2D(GpuMemoryTag::Gui, mTextureColorbuffer.get(), GL_TEXTURE_2D, 0, GL_RGBA, mWidth, mHeight, GL_RGBA,
+                                     GL_UNSIGNED_BYTE, nullptr);
     GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
     GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
     GL_CALL(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
     GL_CALL(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
-    GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
 
-    GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTextureColorbuffer, 0));
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-        errorf("Framebuffer is not complete!");
+    mFramebuffer = GlFramebuffer::generate();
+    RenderGraph::Attachment color;
+    color.texture = mTextureColorbuffer.get();
+    if (!RenderGraph::instance().prepareFramebuffer(mFramebuffer.get(), color, RenderGraph::Attachment())) {
         return false;
     }
 
@@ -104,11 +117,11 @@ bool Gui::initialize(int32_t width, int32_t height) {
          1.0f,  1.0f, 0.0f,  1.0f, 1.0f
     };
 
-    GL_CALL(glGenVertexArrays(1, &mVAO));
-    GL_CALL(glGenBuffers(1, &mVBO));
-    GL_CALL(glBindVertexArray(mVAO));
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mVBO));
-    GL_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW));
+    mVAO = GlVertexArray::generate();
+    mVBO = GlBuffer::generate();
+    GlState::instance().bindVertexArray(mVAO.get());
+    GlState::instance().bindBuffer(GL_ARRAY_BUFFER, mVBO.get());
+    GpuMemory::instance().bufferData(GpuMemoryTag::Gui, mVBO.get(), GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW);
     GL_CALL(glEnableVertexAttribArray(0));
     GL_CALL(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0));
     GL_CALL(glEnableVertexAttribArray(1));
@@ -117,31 +130,155 @@ bool Gui::initialize(int32_t width, int32_t height) {
     return true;
 }
 
-void Gui::render(const glm::mat4& p, const glm::mat4& v) {
+bool Gui::initializeLayer(XrSession session) {
+    if (mSwapchain != XR_NULL_HANDLE) {
+        return true;
+    }
 
-    GLenum last_framebuffer = 0; GL_CALL(glGetIntegerv(GL_FRAMEBUFFER_BINDING, (GLint*)&last_framebuffer));
-    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer));
-    GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTextureColorbuffer, 0));
-    GL_CALL(glClearColor(0.0f, 0.0f, 0.0f, 0.0f));
-    GL_CALL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+    // The panel texture's format, else sRGB: GL encodes what the panel pass writes and the compositor decodes it, so
+    // the panel looks the same.
+    constexpr int64_t SupportedFormats[] = {GL_RGBA8, GL_SRGB8_ALPHA8};
+    uint32_t formatCount = 0;
+    xrEnumerateSwapchainFormats(session, 0, &formatCount, nullptr);
+    std::vector<int64_t> formats(formatCount);
+    xrEnumerateSwapchainFormats(session, formatCount, &formatCount, formats.data());
+    formats.resize(formatCount);
+    const auto format = std::find_first_of(formats.begin(), formats.end(), std::begin(SupportedFormats), std::end(SupportedFormats));
+    if (format == formats.end()) {
+        errorf("No runtime swapchain format supported for the gui %s layer", mName.c_str());
+        return false;
+    }
 
-    active();
-    GuiBase::instance().render();
+    XrSwapchainCreateInfo swapchainCreateInfo{};
+    swapchainCreateInfo.type = XR_TYPE_SWAPCHAIN_CREATE_INFO;
+    swapchainCreateInfo.arraySize = 1;
+    swapchainCreateInfo.format = *format;
+    swapchainCreateInfo.width = mWidth;
+    swapchainCreateInfo.height = mHeight;
+    swapchainCreateInfo.mipCount = 1;
+    swapchainCreateInfo.faceCount = 1;
+    swapchainCreateInfo.sampleCount = 1;
+    swapchainCreateInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
+    XrResult result = xrCreateSwapchain(session, &swapchainCreateInfo, &mSwapchain);
+    if (XR_FAILED(result)) {
+        errorf("xrCreateSwapchain for gui %s failed: %d", mName.c_str(), result);
+        mSwapchain = XR_NULL_HANDLE;
+        return false;
+    }
+
+    uint32_t imageCount = 0;
+    xrEnumerateSwapchainImages(mSwapchain, 0, &imageCount, nullptr);
+    XrSwapchainImageOpenGLESKHR emptyImage{};
+    emptyImage.type = XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_ES_KHR;
+    std::vector<XrSwapchainImageOpenGLESKHR> images(imageCount, emptyImage);
+    xrEnumerateSwapchainImages(mSwapchain, imageCount, &imageCount, reinterpret_cast<XrSwapchainImageBaseHeader*>(images.data()));
+    // A framebuffer per image, the panel pass then only binds the one of the image it got.
+    for (const auto& image : images) {
+        GlFramebuffer framebuffer = GlFramebuffer::generate();
+        RenderGraph::Attachment color;
+        color.texture = image.image;
+        RenderGraph::instance().prepareFramebuffer(framebuffer.get(), color, RenderGraph::Attachment());
+        mSwapchainImages.push_back(image.image);
+        mLayerFramebuffers.push_back(std::move(framebuffer));
+    }
+    return true;
+}
+
+bool Gui::hasLayer() const {
+    return mSwapchain != XR_NULL_HANDLE;
+}
+
+// Acquires the next swapchain image, 0 when there is none.
+bool Gui::acquireLayerImage(uint32_t& index) {
+    XrSwapchainImageAcquireInfo acquireInfo{};
+    acquireInfo.type = XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO;
+    if (XR_FAILED(xrAcquireSwapchainImage(mSwapchain, &acquireInfo, &index))) {
+        return false;
+    }
+    XrSwapchainImageWaitInfo waitInfo{};
+    waitInfo.type = XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO;
+    waitInfo.timeout = XR_INFINITE_DURATION;
+    if (XR_FAILED(xrWaitSwapchainImage(mSwapchain, &waitInfo))) {
+        XrSwapchainImageReleaseInfo releaseInfo{};
+        releaseInfo.type = XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO;
+        xrReleaseSwapchainImage(mSwapchain, &releaseInfo);
+        return false;
+    }
+    return true;
+}
+
+// Records the pass that draws the ImGui data produced between begin() and end() into the panel texture, or the layer
+// swapchain, once per frame. It runs before the eye passes that draw the panel texture; the panel texture is
+// redrawn every frame, so once they have sampled it its contents are dropped instead of kept in memory.
+void Gui::renderPanel() {
+    RenderGraph::Target target;
+    if (hasLayer()) {
+        uint32_t index = 0;
+        if (!acquireLayerImage(index)) {
+            return;
+        }
+        target.framebuffer = mLayerFramebuffers[index].get();
+        target.color.texture = mSwapchainImages[index];
+    } else {
+        target.framebuffer = mFramebuffer.get();
+        target.color.texture = mTextureColorbuffer.get();
+        target.color.store = RenderGraph::Store::EndOfFrame;
+    }
+    target.width = mWidth;
+    target.height = mHeight;
+
+    RenderGraph::instance().addPass("GuiPanel", RenderGraph::Kind::Offscreen, target, [this]() {
+        active();
+        GuiBase::instance().render();
+
+        if (hasLayer()) {
+            XrSwapchainImageReleaseInfo releaseInfo{};
+            releaseInfo.type = XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO;
+            xrReleaseSwapchainImage(mSwapchain, &releaseInfo);
+            mLayerImageReady = true;
+        }
+    });
+}
 
-    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, last_framebuffer));
+const XrCompositionLayerBaseHeader* Gui::getLayer(XrSpace space) {
+    if (!mLayerImageReady) {
+        return nullptr;
+    }
 
-    mShader.use(); 
-    mShader.setUniformMat4("projection", p);
-    mShader.setUniformMat4("view", v);
-    mShader.setUniformMat4("model", mModel);
-    mShader.setUniformVec3("intersectionPoint", mIntersectionPoint);
+    // The quad spans [-1, 1] in model space, so the model matrix holds the pose and half the size.
+    const glm::vec3 axisX = glm::vec3(mModel[0]);
+    const glm::vec3 axisY = glm::vec3(mModel[1]);
+    const glm::vec3 axisZ = glm::vec3(mModel[2]);
+    const glm::quat orientation = glm::quat_cast(glm::mat3(glm::normalize(axisX), glm::normalize(axisY), glm::normalize(axisZ)));
+
+    // The panel is rendered with source alpha blending onto a cleared image, i.e. its alpha is premultiplied.
+    mQuadLayer.layerFlags = XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
+    mQuadLayer.space = space;
+    mQuadLayer.eyeVisibility = XR_EYE_VISIBILITY_BOTH;
+    mQuadLayer.subImage.swapchain = mSwapchain;
+    mQuadLayer.subImage.imageRect.offset = {0, 0};
+    mQuadLayer.subImage.imageRect.extent = {mWidth, mHeight};
+    mQuadLayer.subImage.imageArrayIndex = 0;
+    mQuadLayer.pose.position = {mModel[3].x, mModel[3].y, mModel[3].z};
+    mQuadLayer.pose.orientation = {orientation.x, orientation.y, orientation.z, orientation.w};
+    mQuadLayer.size = {2.0f * glm::length(axisX), 2.0f * glm::length(axisY)};
+    return reinterpret_cast<const XrCompositionLayerBaseHeader*>(&mQuadLayer);
+}
 
-    GL_CALL(glDisable(GL_CULL_FACE));
-    GL_CALL(glEnable(GL_BLEND));
-    GL_CALL(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
-    GL_CALL(glBindVertexArray(mVAO));
-    GL_CALL(glBindTexture(GL_TEXTURE_2D, mTextureColorbuffer));
-    GL_CALL(glDrawArrays(GL_TRIANGLES, 0, 6));
+void Gui::render(DrawList& drawList) {
+    DrawPacket packet;
+    packet.shader = &mShader;
+    packet.vertexArray = mVAO.get();
+    packet.textures[0] = mTextureColorbuffer.get();
+    packet.blend = true;
+    packet.model = mModel;
+    packet.params[0] = glm::vec4(mIntersectionPoint, 0.0f);
+    packet.setUniforms = [](const Shader& shader, const DrawPacket& packet) {
+        shader.setUniformMat4("model", packet.model);
+        shader.setUniformVec3("intersectionPoint", glm::vec3(packet.params[0]));
+    };
+    packet.count = 6;
+    drawList.submit(packet);
 }
 
 void Gui::setModel(const glm::mat4& m) {
@@ -189,10 +326,12 @@ bool Gui::isIntersectWithLine(const glm::vec3& linePoint, const glm::vec3& lineD
 
         updateMousePosition(posx, posy);
         mIntersectionPoint = point;
+        mHovered = true;
 
         return true;
     } else {
         mIntersectionPoint = {100.0, 0.0, 0.0};
+        mHovered = false;
         return false;
     }
 }
@@ -220,7 +359,11 @@ void Gui::active() {
     auto& io = ImGui::GetIO();
     io.DisplaySize.x = float(mWidth);
     io.DisplaySize.y = float(mHeight);
-    io.DeltaTime = 1.0f / 72.0f;
+    io.DeltaTime = mDeltaTime;
+}
+
+void Gui::setDeltaTime(float deltaTime) {
+    mDeltaTime = deltaTime;
 }
 
 void Gui::begin() {
@@ -234,5 +377,9 @@ void Gui::begin() {
 
 void Gui::end() {
     ImGui::End();
+    // The eye-buffer quad marks the ray hit in its shader, a quad layer gets the marker drawn into the panel instead.
+    if (hasLayer() && mHovered) {
+        ImGui::GetForegroundDrawList()->AddCircleFilled(ImGui::GetIO().MousePos, 4.0f, IM_COL32_WHITE);
+    }
     ImGui::Render();
 }
\ No newline at end of file
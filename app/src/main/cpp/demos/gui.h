@@ -1,12 +1,24 @@
 #pragma once
+#include <vector>
+#include <openxr/openxr.h>
 #include "guiBase.h"
+#include "drawList.h"
+#include "glResource.h"
 
 class Gui {
 public:
     Gui(std::string name);
     ~Gui();
     bool initialize(int32_t width, int32_t height);
-    void render(const glm::mat4& p, const glm::mat4& v);
+    // Gives the panel its own swapchain, it is then composited by the runtime as a quad layer instead of drawn into the eye buffers.
+    bool initializeLayer(XrSession session);
+    bool hasLayer() const;
+    // Destroys the layer swapchain while its session still exists, the panel is then drawn into the eye buffers again.
+    void destroyLayer();
+    // The quad layer showing the last panel image at the pose of the model matrix, nullptr before the first panel pass ran.
+    const XrCompositionLayerBaseHeader* getLayer(XrSpace space);
+    void renderPanel();
+    void render(DrawList& drawList);
     void setModel(const glm::mat4& m);
     void getWidthHeight(float& width, float& height);
     bool isIntersectWithLine(const glm::vec3& linePoint, const glm::vec3& lineDirection);
@@ -14,23 +26,34 @@ public:
     void begin();
     void end();
     void triggerEvent(bool down);
+    void setDeltaTime(float deltaTime);
 
 private:
     bool initShader();
     void updateMousePosition(float x, float y);
+    // Acquires and waits for the next layer swapchain image.
+    bool acquireLayerImage(uint32_t& index);
 
 private:
     static Shader mShader;
     std::string mName;
 
-    GLuint mFramebuffer;
-    GLuint mTextureColorbuffer;
-    GLuint mVAO;
-    GLuint mVBO;
+    GlFramebuffer mFramebuffer;
+    GlTexture mTextureColorbuffer;
+    GlVertexArray mVAO;
+    GlBuffer mVBO;
 
     int32_t mWidth;
     int32_t mHeight;
+    float mDeltaTime;
 
     glm::mat4 mModel;
     glm::vec3 mIntersectionPoint;
+    bool mHovered;
+
+    XrSwapchain mSwapchain;
+    std::vector<uint32_t> mSwapchainImages;
+    std::vector<GlFramebuffer> mLayerFramebuffers;  // one per swapchain image
+    bool mLayerImageReady;
+    XrCompositionLayerQuad mQuadLayer;
 };
\ No newline at end of file
@@ -1,12 +1,14 @@
 #include "guiBase.h"
 #include "utils.h"
+#include "glState.h"
+#include "gpuMemory.h"
 
 GuiBase& GuiBase::instance() {
     static GuiBase guiBase;
     return guiBase;
 }//确保全局只有一个UI渲染实例
 
-GuiBase::GuiBase() : mImguiContext(nullptr), mShaderHandle(0), mUseBufferSubData(true), mFontTexture(0) {
+GuiBase::GuiBase() : mImguiContext(nullptr), mShaderHandle(0), mUseBufferSubData(true), mFontTexture(0), mVertexArray(0) {
     mImguiContext = ImGui::CreateContext();//创建上下文
     ImGui::SetCurrentContext(mImguiContext);//设为当前上下文
 }//初始化时ImGui上下文为空，着色器程序ID归零，用glBufferSubData且使得字体纹理ID归0
@@ -53,7 +55,7 @@ void GuiBase::initShader() {
         }
     )_";
 
-    mShader->loadShader(vertex_shader_glsl, fragment_shader_glsl);
+    mShader->loadShader(vertex_shader_glsl, fragment_shader_glsl, false, "imgui");
     mShaderHandle = mShader->id();
 
     //Uniform是不变量的意思（全局变量），来源于CPU的设置，Attribute的数据则每个顶点会有所不同
@@ -79,19 +81,19 @@ bool GuiBase::initialize() {
         //生成顶点缓冲对象和元素缓冲对象
         GL_CALL(glGenBuffers(1, &mVboHandle));
         GL_CALL(glGenBuffers(1, &mElementsHandle));
+        //顶点数组对象常驻，不再每帧创建和删除
+        GL_CALL(glGenVertexArrays(1, &mVertexArray));
 
-        GL_CALL(glActiveTexture(GL_TEXTURE0));
         GL_CALL(glGenTextures(1, &mFontTexture));
         //纹理参数设置
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, mFontTexture));
+        GlState::instance().bindTexture(0, GL_TEXTURE_2D, mFontTexture);
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
         //放大/缩小的线性过滤
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
 
-        GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+        GpuMemory::instance().texImage2D(GpuMemoryTag::Gui, mFontTexture, GL_TEXTURE_2D, 0, GL_RGBA, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
     } else {
         unsigned char* pixels;
         io.Fonts->GetTexDataAsRGBA32(&pixels, nullptr, nullptr);
@@ -103,17 +105,18 @@ bool GuiBase::initialize() {
 #define IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
 #define GL_CLIP_ORIGIN
 
-void GuiBase::setupRenderState(ImDrawData* draw_data, int fb_width, int fb_height, GLuint vertex_array_object) {
+void GuiBase::setupRenderState(ImDrawData* draw_data, int fb_width, int fb_height) {
+    GlState& glState = GlState::instance();
     // Setup render state: alpha-blending enabled, no face culling, no depth testing, scissor enabled, polygon fill
     //混合配置(最终颜色 = 源颜色 × 源Alpha + 目标颜色 × (1 - 源Alpha))
-    GL_CALL(glEnable(GL_BLEND));//透明效果
-    GL_CALL(glBlendEquation(GL_FUNC_ADD));
-    GL_CALL(glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+    glState.setEnabled(GL_BLEND, true);//透明效果
+    glState.blendEquation(GL_FUNC_ADD);
+    glState.blendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
-    GL_CALL(glDisable(GL_CULL_FACE));
-    GL_CALL(glDisable(GL_DEPTH_TEST));
-    GL_CALL(glDisable(GL_STENCIL_TEST));
-    GL_CALL(glEnable(GL_SCISSOR_TEST));//启用裁剪测试，避免绘制不可见部分
+    glState.setEnabled(GL_CULL_FACE, false);
+    glState.setEnabled(GL_DEPTH_TEST, false);
+    glState.setEnabled(GL_STENCIL_TEST, false);
+    glState.setEnabled(GL_SCISSOR_TEST, true);//启用裁剪测试，避免绘制不可见部分
 
     //GL_CALL(glDisable(GL_PRIMITIVE_RESTART));
 
@@ -124,7 +127,7 @@ void GuiBase::setupRenderState(ImDrawData* draw_data, int fb_width, int fb_heigh
 
     // Setup viewport, orthographic projection matrix
     // Our visible imgui space lies from draw_data->DisplayPos (top left) to draw_data->DisplayPos+data_data->DisplaySize (bottom right). DisplayPos is (0,0) for single viewport apps.
-    GL_CALL(glViewport(0, 0, (GLsizei)fb_width, (GLsizei)fb_height));
+    glState.viewport(0, 0, (GLsizei)fb_width, (GLsizei)fb_height);
     float L = draw_data->DisplayPos.x;
     float R = draw_data->DisplayPos.x + draw_data->DisplaySize.x;
     float T = draw_data->DisplayPos.y;
@@ -140,16 +143,15 @@ void GuiBase::setupRenderState(ImDrawData* draw_data, int fb_width, int fb_heigh
         { (R+L)/(L-R),  (T+B)/(B-T),  0.0f,   1.0f },
     };//正交投影矩阵，将UI坐标映射到[-1,1]裁剪空间
 
-    GL_CALL(glUseProgram(mShaderHandle));
+    glState.useProgram(mShaderHandle);
     GL_CALL(glUniform1i(mAttribLocationTex, 0));
     GL_CALL(glUniformMatrix4fv(mAttribLocationProjMtx, 1, GL_FALSE, &ortho_projection[0][0])); 
 
-    glBindSampler(0, 0);
-    glBindVertexArray(vertex_array_object);
+    glState.bindVertexArray(mVertexArray);
 
     // Bind vertex/index buffers and setup attributes for ImDrawVert
     //绑定顶点缓冲和深度缓冲
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mVboHandle));
+    glState.bindBuffer(GL_ARRAY_BUFFER, mVboHandle);
     GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mElementsHandle));
     //启用顶点属性
     GL_CALL(glEnableVertexAttribArray(mAttribLocationVtxPos));
@@ -171,37 +173,8 @@ bool GuiBase::renderDrawData(ImDrawData* draw_data) {
     }
     draw_data->ScaleClipRects(io.DisplayFramebufferScale);
 
-
-    // Backup GL state/备份
-    GLenum last_active_texture = 0; GL_CALL(glGetIntegerv(GL_ACTIVE_TEXTURE, (GLint*)&last_active_texture));
-    glActiveTexture(GL_TEXTURE0);
-    GLuint last_program = 0; glGetIntegerv(GL_CURRENT_PROGRAM, (GLint*)&last_program);
-    GLuint last_texture = 0; glGetIntegerv(GL_TEXTURE_BINDING_2D, (GLint*)&last_texture);
-    GLuint last_sampler = 0; glGetIntegerv(GL_SAMPLER_BINDING, (GLint*)&last_sampler);
-    GLuint last_array_buffer = 0; glGetIntegerv(GL_ARRAY_BUFFER_BINDING, (GLint*)&last_array_buffer);
-    GLuint last_vertex_array_object = 0; glGetIntegerv(GL_VERTEX_ARRAY_BINDING, (GLint*)&last_vertex_array_object);
-    //GLint last_polygon_mode[2]; glGetIntegerv(GL_POLYGON_MODE, last_polygon_mode);
-    GLint last_viewport[4]; glGetIntegerv(GL_VIEWPORT, last_viewport);
-    GLint last_scissor_box[4]; glGetIntegerv(GL_SCISSOR_BOX, last_scissor_box);
-    GLenum last_blend_src_rgb; glGetIntegerv(GL_BLEND_SRC_RGB, (GLint*)&last_blend_src_rgb);
-    GLenum last_blend_dst_rgb; glGetIntegerv(GL_BLEND_DST_RGB, (GLint*)&last_blend_dst_rgb);
-    GLenum last_blend_src_alpha; glGetIntegerv(GL_BLEND_SRC_ALPHA, (GLint*)&last_blend_src_alpha);
-    GLenum last_blend_dst_alpha; glGetIntegerv(GL_BLEND_DST_ALPHA, (GLint*)&last_blend_dst_alpha);
-    GLenum last_blend_equation_rgb; glGetIntegerv(GL_BLEND_EQUATION_RGB, (GLint*)&last_blend_equation_rgb);
-    GLenum last_blend_equation_alpha; glGetIntegerv(GL_BLEND_EQUATION_ALPHA, (GLint*)&last_blend_equation_alpha);
-    GLboolean last_enable_blend = glIsEnabled(GL_BLEND);
-    GLboolean last_enable_cull_face = glIsEnabled(GL_CULL_FACE);
-    GLboolean last_enable_depth_test = glIsEnabled(GL_DEPTH_TEST);
-    GLboolean last_enable_stencil_test = glIsEnabled(GL_STENCIL_TEST);
-    GLboolean last_enable_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
-    //GLboolean last_enable_primitive_restart = glIsEnabled(GL_PRIMITIVE_RESTART);
-
-
-    //创建临时VAO
-    GLuint vertex_array_object = 0;
-    GL_CALL(glGenVertexArrays(1, &vertex_array_object));
-
-    setupRenderState(draw_data, fb_width, fb_height, vertex_array_object);
+    // Every renderer sets the state it needs through GlState, so nothing is backed up and restored here
+    setupRenderState(draw_data, fb_width, fb_height);
 
     ImVec2 clip_off = draw_data->DisplayPos;         // (0,0) unless using multi-viewports
     ImVec2 clip_scale = draw_data->FramebufferScale; // (1,1) unless using retina display which are often (2,2)
@@ -225,17 +198,19 @@ bool GuiBase::renderDrawData(ImDrawData* draw_data) {
         if (mUseBufferSubData) {
             if (mVertexBufferSize < vtx_buffer_size) {
                 mVertexBufferSize = vtx_buffer_size;
-                GL_CALL(glBufferData(GL_ARRAY_BUFFER, mVertexBufferSize, nullptr, GL_STREAM_DRAW));
+                GpuMemory::instance().bufferData(GpuMemoryTag::Gui, mVboHandle, GL_ARRAY_BUFFER, mVertexBufferSize, nullptr, GL_STREAM_DRAW);
             }
             if (mIndexBufferSize < idx_buffer_size) {
                 mIndexBufferSize = idx_buffer_size;
-                GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndexBufferSize, nullptr, GL_STREAM_DRAW));
+                GpuMemory::instance().bufferData(GpuMemoryTag::Gui, mElementsHandle, GL_ELEMENT_ARRAY_BUFFER, mIndexBufferSize, nullptr, GL_STREAM_DRAW);
             }
             GL_CALL(glBufferSubData(GL_ARRAY_BUFFER, 0, vtx_buffer_size, (const GLvoid*)cmd_list->VtxBuffer.Data));
             GL_CALL(glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, idx_buffer_size, (const GLvoid*)cmd_list->IdxBuffer.Data));
         } else {
-            GL_CALL(glBufferData(GL_ARRAY_BUFFER, vtx_buffer_size, (const GLvoid*)cmd_list->VtxBuffer.Data, GL_STREAM_DRAW));
-            GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx_buffer_size, (const GLvoid*)cmd_list->IdxBuffer.Data, GL_STREAM_DRAW));
+            GpuMemory::instance().bufferData(GpuMemoryTag::Gui, mVboHandle, GL_ARRAY_BUFFER, vtx_buffer_size, (const GLvoid*)cmd_list->VtxBuffer.Data,
+                                             GL_STREAM_DRAW);
+            GpuMemory::instance().bufferData(GpuMemoryTag::Gui, mElementsHandle, GL_ELEMENT_ARRAY_BUFFER, idx_buffer_size,
+                                             (const GLvoid*)cmd_list->IdxBuffer.Data, GL_STREAM_DRAW);
         }
         //处理每个绘制命令
         for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++) {
@@ -244,7 +219,7 @@ bool GuiBase::renderDrawData(ImDrawData* draw_data) {
                 // User callback, registered via ImDrawList::AddCallback()
                 // (ImDrawCallback_ResetRenderState is a special callback value used by the user to request the renderer to reset render state.)
                 if (pcmd->UserCallback == ImDrawCallback_ResetRenderState) {
-                    setupRenderState(draw_data, fb_width, fb_height, vertex_array_object);
+                    setupRenderState(draw_data, fb_width, fb_height);
                 }
                 else {
                     pcmd->UserCallback(cmd_list, pcmd);
@@ -257,33 +232,14 @@ bool GuiBase::renderDrawData(ImDrawData* draw_data) {
                     continue;
                 }
                 // Apply scissor/clipping rectangle (Y is inverted in OpenGL)
-                GL_CALL(glScissor((int)clip_min.x, (int)((float)fb_height - clip_max.y), (int)(clip_max.x - clip_min.x), (int)(clip_max.y - clip_min.y)));
+                GlState::instance().scissor((int)clip_min.x, (int)((float)fb_height - clip_max.y), (int)(clip_max.x - clip_min.x), (int)(clip_max.y - clip_min.y));
                 // Bind texture, Draw
-                GL_CALL(glBindTexture(GL_TEXTURE_2D, mFontTexture));
+                GlState::instance().bindTexture(0, GL_TEXTURE_2D, mFontTexture);
                 GL_CALL(glDrawElements(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(pcmd->IdxOffset * sizeof(ImDrawIdx))));
             }
         }
     }
 
-    // Destroy the temporary VAO
-    GL_CALL(glDeleteVertexArrays(1, &vertex_array_object));
-    if (last_program == 0 || glIsProgram(last_program)) glUseProgram(last_program);
-    glBindTexture(GL_TEXTURE_2D, last_texture);
-    glBindSampler(0, last_sampler);
-    glActiveTexture(last_active_texture);
-    glBindVertexArray(last_vertex_array_object);
-    glBindBuffer(GL_ARRAY_BUFFER, last_array_buffer);
-    glBlendEquationSeparate(last_blend_equation_rgb, last_blend_equation_alpha);
-    glBlendFuncSeparate(last_blend_src_rgb, last_blend_dst_rgb, last_blend_src_alpha, last_blend_dst_alpha);
-    if (last_enable_blend) glEnable(GL_BLEND); else glDisable(GL_BLEND);
-    if (last_enable_cull_face) glEnable(GL_CULL_FACE); else glDisable(GL_CULL_FACE);
-    if (last_enable_depth_test) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
-    if (last_enable_stencil_test) glEnable(GL_STENCIL_TEST); else glDisable(GL_STENCIL_TEST);
-    if (last_enable_scissor_test) glEnable(GL_SCISSOR_TEST); else glDisable(GL_SCISSOR_TEST);
-    //if (last_enable_primitive_restart) glEnable(GL_PRIMITIVE_RESTART); else glDisable(GL_PRIMITIVE_RESTART);
-    glViewport(last_viewport[0], last_viewport[1], (GLsizei)last_viewport[2], (GLsizei)last_viewport[3]);
-    glScissor(last_scissor_box[0], last_scissor_box[1], (GLsizei)last_scissor_box[2], (GLsizei)last_scissor_box[3]);
-
     return true;
 }
 
@@ -14,7 +14,7 @@ public:
 private:
     GuiBase();
     void initShader();
-    void setupRenderState(ImDrawData* draw_data, int fb_width, int fb_height, GLuint vertex_array_object);
+    void setupRenderState(ImDrawData* draw_data, int fb_width, int fb_height);
     bool renderDrawData(ImDrawData* draw_data);
 private:
     ImGuiContext* mImguiContext;
@@ -26,6 +26,7 @@ private:
     GLuint mAttribLocationVtxUV;
     GLuint mAttribLocationVtxColor;
     uint32_t mVboHandle, mElementsHandle;
+    GLuint mVertexArray;
     GLsizeiptr mVertexBufferSize;
     GLsizeiptr mIndexBufferSize;
     bool mHasClipOrigin;
@@ -6,22 +6,21 @@ HandBase::HandBase(std::string name) {
 HandBase::~HandBase() { 
 }
 bool HandBase::initialize() {
-    mHand->initialize();
-    return true;
+    return mHand->uploadModel();
 }
 void HandBase::setModelFile(const std::string& modelFile) {
     mModelFile = modelFile;
 }
 bool HandBase::loadModelFile() {
-    return mHand->loadModel(mModelFile);
+    return mHand->parseModel(mModelFile);
 }
 void HandBase::setModel(const glm::mat4& model) {
     mModel = model;
 }
-bool HandBase::render(const glm::mat4& p, const glm::mat4& v) {
+bool HandBase::render(DrawList& drawList) {
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::scale(mModel, glm::vec3(mDefaultScale, mDefaultScale, mDefaultScale));
-    mHand->render(p, v, model);
+    mHand->render(drawList, model);
     return true;
 }
 ////////////////////////////////////////////////////////////////////////////////
@@ -33,22 +32,26 @@ Hand::Hand() {
 Hand::~Hand() {
 }
 
+bool Hand::load(int leftright) {
+    if (leftright == HAND_LEFT) {
+        mLeftHand->setModelFile("hand/Hand_L.fbx");
+        mLeftHand->mHand->bindMeshTexture("l_handMesh", "hand/0.png");
+        return mLeftHand->loadModelFile();
+    } else {
+        mRightHand->setModelFile("hand/Hand_R.fbx");
+        mRightHand->mHand->bindMeshTexture("r_handMesh", "hand/0.png");
+        return mRightHand->loadModelFile();
+    }
+}
+
 bool Hand::initialize() {
     mLeftHand->initialize();
     mRightHand->initialize();
 
-    mLeftHand->setModelFile("hand/Hand_L.fbx");
-    mRightHand->setModelFile("hand/Hand_R.fbx");
-
-    mLeftHand->mHand->bindMeshTexture("l_handMesh", "hand/0.png");
-    mRightHand->mHand->bindMeshTexture("r_handMesh", "hand/0.png");
-
-    mLeftHand->loadModelFile();
-    mRightHand->loadModelFile();
-
     mLeftHand->mHand->activeMeshTexture("l_handMesh", "hand/0.png");
     mRightHand->mHand->activeMeshTexture("r_handMesh", "hand/0.png");
 
+    mReady = true;
     return true;
 }
 
@@ -62,15 +65,24 @@ void Hand::setModel(int leftright, const glm::mat4& m) {
     }
 }
 
-void Hand::render(const glm::mat4& p, const glm::mat4& v) {
-    mLeftHand->render(p, v);
-    mRightHand->render(p, v);
+void Hand::render(DrawList& drawList) {
+    if (!mReady) {
+        return;
+    }
+    mLeftHand->render(drawList);
+    mRightHand->render(drawList);
 }
 
-void Hand::render(int leftright, const glm::mat4& p, const glm::mat4& v) {
-    leftright == HAND_RIGHT ? mRightHand->render(p, v) : mLeftHand->render(p, v);
+void Hand::render(DrawList& drawList, int leftright) {
+    if (!mReady) {
+        return;
+    }
+    leftright == HAND_RIGHT ? mRightHand->render(drawList) : mLeftHand->render(drawList);
 }
 
 void Hand::setBoneNodeMatrices(int leftright, const std::string& bone, const glm::mat4& m) {
+    if (!mReady) {
+        return;
+    }
     leftright == HAND_RIGHT ? mRightHand->mHand->setBoneNodeMatrices(bone, m) : mLeftHand->mHand->setBoneNodeMatrices(bone, m);
 }
\ No newline at end of file
@@ -9,9 +9,9 @@ public:
     ~HandBase();
     bool initialize();
     void setModelFile(const std::string& modelFile);
-    bool loadModelFile();
+    bool loadModelFile();  // parses only, initialize() uploads
     void setModel(const glm::mat4& model);
-    bool render(const glm::mat4& p, const glm::mat4& v);
+    bool render(DrawList& drawList);
 private:
     friend class Hand;
     std::shared_ptr<Model> mHand;
@@ -27,13 +27,17 @@ public:
     Hand();
     ~Hand();
 
+    // Parses the FBX of one hand, touches no GL state so both hands can load on worker threads.
+    bool load(int leftright);
+    // Uploads what load() parsed, on the GL thread. Until then the hands are not drawn.
     bool initialize();
     void setModel(int leftright, const glm::mat4& m);
-    void render(const glm::mat4& p, const glm::mat4& v);
-    void render(int leftright, const glm::mat4& p, const glm::mat4& v);
+    void render(DrawList& drawList);
+    void render(DrawList& drawList, int leftright);
     void setBoneNodeMatrices(int leftright, const std::string& bone, const glm::mat4& m);
 private:    
     glm::mat4 mModel[HAND_COUNT];
     std::shared_ptr<HandBase> mRightHand;
     std::shared_ptr<HandBase> mLeftHand;
+    bool mReady = false;
 };
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include"mesh.h"
 #include <stddef.h>
 #include "common/gfxwrapper_opengl.h"
+#include "glState.h"
+#include "gpuMemory.h"
 
 Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures) 
     : mVertices(vertices), mIndices(indices), mTextures(textures) {
@@ -11,20 +13,21 @@ void Mesh::setupMesh() {
     // create buffers/arrays
     //glGenFramebuffers(1, &mFramebuffer);
     //glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
-    glGenVertexArrays(1, &mVAO);
-    glGenBuffers(1, &mVBO);
-    glGenBuffers(1, &mEBO);
+    mVAO = GlVertexArray::generate();
+    mVBO = GlBuffer::generate();
+    mEBO = GlBuffer::generate();
 
-    glBindVertexArray(mVAO);
+    GlState::instance().bindVertexArray(mVAO.get());
     // load data into vertex buffers
-    glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+    GlState::instance().bindBuffer(GL_ARRAY_BUFFER, mVBO.get());
     // A great thing about structs is that their memory layout is sequential for all its items.
     // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
     // again translates to 3/2 floats which translates to a byte array.
-    glBufferData(GL_ARRAY_BUFFER, mVertices.size() * sizeof(Vertex), &mVertices[0], GL_STATIC_DRAW);
+    GpuMemory::instance().bufferData(GpuMemoryTag::Model, mVBO.get(), GL_ARRAY_BUFFER, mVertices.size() * sizeof(Vertex), &mVertices[0], GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(unsigned int), &mIndices[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO.get());
+    GpuMemory::instance().bufferData(GpuMemoryTag::Model, mEBO.get(), GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(unsigned int), &mIndices[0],
+                                     GL_STATIC_DRAW);
 
     // set the vertex attribute pointers
     // vertex Positions
@@ -48,7 +51,6 @@ void Mesh::setupMesh() {
     // weights
     glEnableVertexAttribArray(6);
     glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Weights));
-    glBindVertexArray(0);
 }
 
 bool Mesh::activeTexture(const std::string& textureName) {
@@ -62,21 +64,40 @@ bool Mesh::activeTexture(const std::string& textureName) {
     return true;
 }
 
-void Mesh::draw(Shader& shader) {
-    // bind appropriate textures
+void Mesh::render(DrawList& drawList, const Shader& shader, const glm::mat4& m) {
+    DrawPacket packet;
+    packet.shader = &shader;
+    packet.vertexArray = mVAO.get();
+    for (unsigned int i = 0; i < mTextures.size() && i < DrawPacket::MaxTextures; i++) {
+        if (mTextures[i].active) {
+            packet.textures[i] = mTextures[i].id;
+        }
+    }
+    packet.blend = true;
+    packet.cullFace = true;
+    packet.model = m;
+    packet.object = this;
+    packet.setUniforms = setUniforms;
+    packet.count = static_cast<GLsizei>(mIndices.size());
+    packet.indexType = GL_UNSIGNED_INT;
+    drawList.submit(packet);
+}
+
+void Mesh::setUniforms(const Shader& shader, const DrawPacket& packet) {
+    const Mesh& mesh = *static_cast<const Mesh*>(packet.object);
+    // the textures are bound to the unit of their index, point the samplers at them
     unsigned int diffuseNr = 1;
     unsigned int specularNr = 1;
     unsigned int normalNr = 1;
     unsigned int heightNr = 1;
-    for (unsigned int i = 0; i < mTextures.size(); i++) {
-        if (mTextures[i].active == false) {
+    for (unsigned int i = 0; i < mesh.mTextures.size() && i < DrawPacket::MaxTextures; i++) {
+        if (mesh.mTextures[i].active == false) {
             continue;
         }
 
-        glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
         // retrieve texture number (the N in diffuse_textureN)
         std::string number;
-        std::string name = mTextures[i].type;
+        const std::string& name = mesh.mTextures[i].type;
         if (name == "texture_diffuse") {
             number = std::to_string(diffuseNr++);
         }
@@ -89,18 +110,7 @@ void Mesh::draw(Shader& shader) {
         else if (name == "texture_height") {
             number = std::to_string(heightNr++); // transfer unsigned int to string
         }
-
-        // now set the sampler to the correct texture unit
         glUniform1i(glGetUniformLocation(shader.id(), (name + number).c_str()), i);
-        // and finally bind the texture
-        glBindTexture(GL_TEXTURE_2D, mTextures[i].id);
     }
-
-    // draw mesh
-    glBindVertexArray(mVAO);
-    glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(mIndices.size()), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-
-    // always good practice to set everything back to defaults once configured.
-    glActiveTexture(GL_TEXTURE0);
+    shader.setUniformMat4("model", packet.model);
 }
\ No newline at end of file
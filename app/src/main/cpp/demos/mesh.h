@@ -5,6 +5,8 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include <glm/gtc/type_ptr.hpp>
 #include "shader.h"
+#include "drawList.h"
+#include "glResource.h"
 
 #define MAX_BONE_INFLUENCE 4
 
@@ -34,16 +36,18 @@ struct Texture {
 class Mesh {
 public:
     Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures);
-    void draw(Shader& shader);
+    // Submits the mesh with its active textures, at most DrawPacket::MaxTextures of them.
+    void render(DrawList& drawList, const Shader& shader, const glm::mat4& m);
     bool activeTexture(const std::string &textureName);
 private:
     void setupMesh();
+    static void setUniforms(const Shader& shader, const DrawPacket& packet);
 private:
     std::vector<Vertex>       mVertices;
     std::vector<unsigned int> mIndices;
     std::vector<Texture>      mTextures;
     unsigned int mFramebuffer;
-    unsigned int mVAO;
-    unsigned int mVBO;
-    unsigned int mEBO;
+    GlVertexArray mVAO;
+    GlBuffer mVBO;
+    GlBuffer mEBO;
 };
\ No newline at end of file
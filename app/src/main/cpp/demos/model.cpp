@@ -19,8 +19,6 @@ void Model::initShader() {
             layout(location = 6) in vec4 weights;
             
             uniform mat4 model;
-            uniform mat4 view;
-            uniform mat4 projection;
 
             const int MAX_BONE_NODES = 100;
             const int MAX_BONE_INFLUENCE = 4;
@@ -47,7 +45,7 @@ void Model::initShader() {
                 if (has_bone == false) {
                     total_position = vec4(aPos, 1.0f);
                 }
-                gl_Position = projection * view * model * total_position;
+                gl_Position = projection[VIEW_ID] * view[VIEW_ID] * model * total_position;
                 TexCoords = aTexCoords;
             }
         )_";
@@ -63,7 +61,7 @@ void Model::initShader() {
                 FragColor = texture(texture_diffuse1, TexCoords);
             }
         )_";
-        mShader.loadShader(vertexShaderCode, fragmentShaderCode);
+        mShader.loadShader(vertexShaderCode, fragmentShaderCode, true, "model");
         init = true;
     }
 }
@@ -115,7 +113,8 @@ std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType
         }
         if (!skip) {
             Texture texture;
-            texture.id = TextureFromFileAssets(str.C_Str(), mDirectory);
+            texture.id = TextureFromFileAssets(str.C_Str(), mDirectory, GpuMemoryTag::Model);
+            mTextureObjects.emplace_back(texture.id);
             texture.type = typeName;
             texture.path = str.C_Str();
             texture.active = false;
@@ -126,7 +125,7 @@ std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType
     return textures;
 }
 
-std::vector<Texture> Model::loadMaterialTextures_force(aiMaterial* mat, aiTextureType type, std::string typeName, std::string file) {
+std::vector<Texture> Model::loadMaterialTextures_force(const std::string& typeName, const std::string& file) {
     std::vector<Texture> textures;
     bool skip = false;
     for (uint32_t j = 0; j < mTexturesLoaded.size(); j++) {
@@ -137,7 +136,10 @@ std::vector<Texture> Model::loadMaterialTextures_force(aiMaterial* mat, aiTextur
     }
     if (!skip) {
         Texture texture;
-        texture.id = TextureFromFileAssets(file.c_str(), "");
+        auto decoded = mDecodedTextures.find(file);
+        texture.id = decoded != mDecodedTextures.end() ? TextureFromImage(decoded->second, GpuMemoryTag::Model)
+                                                       : TextureFromFileAssets(file.c_str(), "", GpuMemoryTag::Model);
+        mTextureObjects.emplace_back(texture.id);
         texture.type = typeName;
         texture.path = file.c_str();
         texture.active = false;
@@ -186,10 +188,11 @@ void Model::processMeshBone(aiMesh* mesh, std::vector<Vertex>& vertices) {
     }
 }
 
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene) {
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
-    std::vector<Texture> textures;
+Model::ParsedMesh Model::processMesh(aiMesh* mesh, const aiScene* scene) {
+    ParsedMesh parsed;
+    parsed.name = mesh->mName.C_Str();
+    std::vector<Vertex>& vertices = parsed.vertices;
+    std::vector<unsigned int>& indices = parsed.indices;
     
 //    infof("mesh vertex count: %d, face count:%d, bone:%d", mesh->mNumVertices, mesh->mNumFaces, mesh->mNumBones);
     for (uint32_t i = 0; i < mesh->mNumVertices; i++) {
@@ -240,9 +243,9 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene) {
         processMeshBone(mesh, vertices);
     }
 
+    /*
     aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
 
-    /*
     // 1. diffuse maps
     std::vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
     textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
@@ -257,35 +260,37 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene) {
     textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
     */
 
-    auto it = mMeshTexturesMap.find(mesh->mName.C_Str());
+    // the textures are decoded here, only their upload is left for uploadModel
+    auto it = mMeshTexturesMap.find(parsed.name);
     if (it != mMeshTexturesMap.end()) {
         for (auto& i : it->second) {
-            std::vector<Texture> texture = loadMaterialTextures_force(material, aiTextureType_DIFFUSE, "texture_diffuse", i);
-            textures.insert(textures.end(), texture.begin(), texture.end());
+            parsed.textureFiles.push_back(i);
+            if (mDecodedTextures.find(i) == mDecodedTextures.end()) {
+                decodeImageFromAssets(i.c_str(), "", mDecodedTextures[i]);
+            }
         }
     }
 
-    return Mesh(vertices, indices, textures);
+    return parsed;
 }
 
-void Model::processNode(aiNode* node, const aiScene* scene) {
-    static std::string indent = "";
+void Model::processNode(aiNode* node, const aiScene* scene, const std::string& indent) {
     infof("%snode:%s, children:%d", indent.c_str(), node->mName.C_Str(), node->mNumChildren);
     for (uint32_t i = 0; i < node->mNumMeshes; i++) {
         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
         infof("%smesh: %s", indent.c_str(), mesh->mName.C_Str());
-        mMeshes.insert(std::pair<std::string, Mesh>(mesh->mName.C_Str(), processMesh(mesh, scene)));
+        mParsedMeshes.push_back(processMesh(mesh, scene));
     }
     for (uint32_t i = 0; i < node->mNumChildren; i++) {
-        std::string tmp = indent;
-        indent += "  ";
-        processNode(node->mChildren[i], scene);
-        indent = tmp;
+        processNode(node->mChildren[i], scene, indent + "  ");
     }
 }
 
 bool Model::loadModel(const std::string& modelFileName) {
-    initShader();
+    return parseModel(modelFileName) && uploadModel();
+}
+
+bool Model::parseModel(const std::string& modelFileName) {
     std::vector<char> fileData = readFileFromAssets(modelFileName.c_str());
     Assimp::Importer importer;
     //const aiScene* scene = importer.ReadFile(modelFileName, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
@@ -300,29 +305,29 @@ bool Model::loadModel(const std::string& modelFileName) {
     infof("model:%s, scene:%s, mNumMeshes:%d, mNumMaterials:%d, mNumAnimations:%d, mNumTextures:%d", modelFileName.c_str(), 
         scene->mName.C_Str(), scene->mNumMeshes, scene->mNumMaterials, scene->mNumAnimations, scene->mNumTextures);
     processNode(scene->mRootNode, scene);
-    initializeBoneNode();
     return true;
 }
 
-void Model::draw() {
-    GL_CALL(glFrontFace(GL_CCW));
-    GL_CALL(glCullFace(GL_BACK));
-    GL_CALL(glEnable(GL_CULL_FACE));
-    GL_CALL(glEnable(GL_DEPTH_TEST));
-    GL_CALL(glEnable(GL_BLEND));
-    GL_CALL(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
-    for (auto &it : mMeshes) {
-        it.second.draw(mShader);
+bool Model::uploadModel() {
+    initShader();
+    for (ParsedMesh& parsed : mParsedMeshes) {
+        std::vector<Texture> textures;
+        for (const std::string& file : parsed.textureFiles) {
+            std::vector<Texture> texture = loadMaterialTextures_force("texture_diffuse", file);
+            textures.insert(textures.end(), texture.begin(), texture.end());
+        }
+        mMeshes.insert(std::pair<std::string, Mesh>(parsed.name, Mesh(parsed.vertices, parsed.indices, textures)));
     }
+    mParsedMeshes.clear();
+    mDecodedTextures.clear();
+    initializeBoneNode();
+    return true;
 }
 
-bool Model::render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m) {
-    mShader.use();
-    mShader.setUniformMat4("projection", p);
-    mShader.setUniformMat4("view", v);
-    mShader.setUniformMat4("model", m);
-    draw();
-    glUseProgram(0);
+bool Model::render(DrawList& drawList, const glm::mat4& m) {
+    for (auto &it : mMeshes) {
+        it.second.render(drawList, mShader, m);
+    }
     return true;
 }
 
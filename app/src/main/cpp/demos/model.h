@@ -5,10 +5,11 @@
 #include <memory>
 #include "mesh.h"
 #include "shader.h"
+#include "drawList.h"
 #include "assimp/Importer.hpp"
 #include "assimp/scene.h"
 #include "assimp/postprocess.h"
-#include "shader.h"
+#include "utils.h"
 
 class Model {
 public:
@@ -19,13 +20,17 @@ public:
     std::string& name();
 
     bool loadModel(const std::string& modelFileName);
+    // loadModel in two steps: parseModel only reads, parses and decodes, so it may run on a worker thread while the
+    // model is not in use yet; uploadModel then creates the GL objects on the GL thread.
+    bool parseModel(const std::string& modelFileName);
+    bool uploadModel();
 
     bool initialize() { return false; };
 
     bool bindMeshTexture(const std::string& meshName, const std::string& textureName);
     bool activeMeshTexture(const std::string& meshName, const std::string& textureName);
 
-    bool render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m);
+    bool render(DrawList& drawList, const glm::mat4& m);
 
     int getBoneNodeIndexByName(const std::string& name) const;
 
@@ -34,12 +39,17 @@ public:
 private:
     void initShader();
     std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName);
-    std::vector<Texture> loadMaterialTextures_force(aiMaterial* mat, aiTextureType type, std::string typeName, std::string file);
-    void processNode(aiNode* node, const aiScene* scene);
-    Mesh processMesh(aiMesh* mesh, const aiScene* scene);
+    std::vector<Texture> loadMaterialTextures_force(const std::string& typeName, const std::string& file);
+    struct ParsedMesh {
+        std::string name;
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<std::string> textureFiles;
+    };
+    void processNode(aiNode* node, const aiScene* scene, const std::string& indent = "");
+    ParsedMesh processMesh(aiMesh* mesh, const aiScene* scene);
     void processMeshBone(aiMesh* mesh, std::vector<Vertex>& vertices);
     void initializeBoneNode();
-    void draw();
 
 private:
     std::string mName;
@@ -55,9 +65,14 @@ private:
     bool mIsGammaCorrection;
 
     std::vector<Texture> mTexturesLoaded;
+    std::vector<GlTexture> mTextureObjects;  // owns the textures of mTexturesLoaded, which the meshes share
     std::string mDirectory;
 
     std::map<std::string, std::vector<std::string>> mMeshTexturesMap;
 
+    // results of parseModel, waiting for uploadModel
+    std::vector<ParsedMesh> mParsedMeshes;
+    std::map<std::string, DecodedImage> mDecodedTextures;
+
     static Shader mShader;
 };
\ No newline at end of file
@@ -2,32 +2,45 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <chrono>
-#include <aaudio/AAudio.h>
 #include <stddef.h>
+#include <time.h>
+#ifdef XR_USE_PLATFORM_ANDROID
+#include <aaudio/AAudio.h>
+#include <android/native_window_jni.h>
+#endif
 #include "player.h"
 #include "utils.h"
+#include "glState.h"
+#include "gpuMemory.h"
+#include "glm/gtc/constants.hpp"
+#include "glm/gtc/quaternion.hpp"
 
 Shader Player::mShader;
 Player::Player() : mExtractor(nullptr), mFd(-1), mStarted(false) {
     mVideoTrackIndex = -1;
     mAudioTrackIndex = -1;
     mDecodeRunning = mPlayAudioRunning = false;
-    mVAO = mVBO= mEBO = 0;
     mPlayModel = playModel_None;
+    mLayerMode = false;
+    mXrSession = XR_NULL_HANDLE;
+    mLayerSwapchain = XR_NULL_HANDLE;
+    mLayerSurface = nullptr;
+    mLayerWidth = mLayerHeight = 0;
+    mLayerFrameQueued = false;
 }
 
 Player::~Player() {
+#ifdef XR_USE_PLATFORM_ANDROID
     if (mExtractor) {
         AMediaExtractor_delete(mExtractor);
         mExtractor = nullptr;
     }
+#endif
     if (mFd > 0) {
         close(mFd);
         mFd = -1;
     }
-    if (mVAO != 0) {
-        glDeleteVertexArrays(1, &mVAO);
-    }
+    destroyLayerSwapchain();
 }
 
 bool Player::initShader() {
@@ -40,15 +53,15 @@ bool Player::initShader() {
             #version 320 es
             precision highp float;
             layout(location = 0) in vec3 aPosition;
-            layout(location = 1) in vec2 aTexCoord;
-            uniform mat4 projection;
-            uniform mat4 view;
+            layout(location = 1) in vec2 aTexCoord0;
+            layout(location = 2) in vec2 aTexCoord1;
             uniform mat4 model;
             out vec2 vTexCoord;
             void main()
             {
-                vTexCoord = vec2(aTexCoord.x, 1.0 - aTexCoord.y);
-                gl_Position = projection * view * model * vec4(aPosition, 1.0);
+                vec2 texCoord = VIEW_ID == 0u ? aTexCoord0 : aTexCoord1;
+                vTexCoord = vec2(texCoord.x, 1.0 - texCoord.y);
+                gl_Position = projection[VIEW_ID] * view[VIEW_ID] * model * vec4(aPosition, 1.0);
             }
         )_";
 
@@ -65,7 +78,7 @@ bool Player::initShader() {
             }
         )_";
 
-        if (mShader.loadShader(vertex_shader_glsl, fragment_shader_glsl) == false) {
+        if (mShader.loadShader(vertex_shader_glsl, fragment_shader_glsl, true, "player") == false) {
             return false;
         }
         init = true;
@@ -97,142 +110,221 @@ bool Player::initialize(EGLDisplay display) {
     InitializePfn();
     mEglDisplay = display;
 
-    GL_CALL(glGenVertexArrays(1, &mVAO));
-    GL_CALL(glGenBuffers(1, &mVBO));
-    GL_CALL(glGenBuffers(1, &mEBO));
+    mVAO = GlVertexArray::generate();
+    mVBO = GlBuffer::generate();
+    mEBO = GlBuffer::generate();
+
+    mVideoTexture = GlTexture::generate();
+    GlState::instance().bindTexture(0, GL_TEXTURE_EXTERNAL_OES, mVideoTexture.get());
+    GL_CALL(glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+    GL_CALL(glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    GL_CALL(glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GL_CALL(glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
 
     setPlayStyle(playModel_2D_360);
 
     return true;
 }
 
+bool Player::initializeLayer(XrInstance instance, XrSession session, bool equirect2Enabled) {
+    // Without equirect2 the 360 models could not be shown, so the GL path stays in charge.
+    if (!equirect2Enabled) {
+        warnf("XR_KHR_composition_layer_equirect2 not enabled, video is rendered through GL");
+        return false;
+    }
+#ifdef XR_USE_PLATFORM_ANDROID
+    if (XR_FAILED(xrGetInstanceProcAddr(instance, "xrCreateSwapchainAndroidSurfaceKHR", (PFN_xrVoidFunction*)&mPfnCreateSwapchainAndroidSurfaceKHR))) {
+        warnf("XR_KHR_android_surface_swapchain not enabled, video is rendered through GL");
+        mPfnCreateSwapchainAndroidSurfaceKHR = nullptr;
+        return false;
+    }
+#else
+    (void)instance;
+    warnf("XR_KHR_android_surface_swapchain is Android only, video is rendered through GL");
+    return false;
+#endif
+    mXrSession = session;
+    mLayerMode = true;
+    return true;
+}
+
+bool Player::hasLayer() const {
+    return mLayerMode;
+}
+
+#ifdef XR_USE_PLATFORM_ANDROID
+bool Player::createLayerSwapchain(int32_t width, int32_t height) {
+    XrSwapchainCreateInfo swapchainCreateInfo{};
+    swapchainCreateInfo.type = XR_TYPE_SWAPCHAIN_CREATE_INFO;
+    swapchainCreateInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
+    swapchainCreateInfo.format = 0;  // the producer, i.e. the codec, picks the format
+    swapchainCreateInfo.sampleCount = 0;
+    swapchainCreateInfo.width = width;
+    swapchainCreateInfo.height = height;
+    swapchainCreateInfo.faceCount = 0;
+    swapchainCreateInfo.arraySize = 0;
+    swapchainCreateInfo.mipCount = 0;
+
+    jobject surface = nullptr;
+    XrResult result = mPfnCreateSwapchainAndroidSurfaceKHR(mXrSession, &swapchainCreateInfo, &mLayerSwapchain, &surface);
+    if (XR_FAILED(result)) {
+        errorf("xrCreateSwapchainAndroidSurfaceKHR error %d", result);
+        mLayerSwapchain = XR_NULL_HANDLE;
+        return false;
+    }
+    // The window holds its own reference to the surface, the local one would otherwise live as long as the thread.
+    JNIEnv* env = getJNIEnv();
+    mLayerSurface = ANativeWindow_fromSurface(env, surface);
+    env->DeleteLocalRef(surface);
+    if (mLayerSurface == nullptr) {
+        errorf("ANativeWindow_fromSurface error");
+        destroyLayerSwapchain();
+        return false;
+    }
+    mLayerWidth = width;
+    mLayerHeight = height;
+    return true;
+}
+#endif
+
+void Player::destroyLayerSwapchain() {
+    mLayerFrameQueued = false;
+#ifdef XR_USE_PLATFORM_ANDROID
+    if (mLayerSurface != nullptr) {
+        ANativeWindow_release(mLayerSurface);
+        mLayerSurface = nullptr;
+    }
+#endif
+    if (mLayerSwapchain != XR_NULL_HANDLE) {
+        xrDestroySwapchain(mLayerSwapchain);
+        mLayerSwapchain = XR_NULL_HANDLE;
+    }
+}
+
+void Player::appendLayers(XrSpace space, std::vector<const XrCompositionLayerBaseHeader*>& layers) {
+    if (mLayerSwapchain == XR_NULL_HANDLE || !mLayerFrameQueued) {
+        return;
+    }
+
+    const bool sideBySide = mPlayModel == playModel_3D_SBS || mPlayModel == playModel_3D_SBS_360;
+    const bool overUnder = mPlayModel == playModel_3D_OU || mPlayModel == playModel_3D_OU_360;
+    const bool sphere = mPlayModel == playModel_2D_180 || mPlayModel == playModel_2D_360 ||
+                        mPlayModel == playModel_3D_SBS_360 || mPlayModel == playModel_3D_OU_360;
+    const uint32_t layerCount = (sideBySide || overUnder) ? 2 : 1;
+
+    // Same placement as the GL path: the quad spans [-0.5, 0.5] in model space, the sphere takes the model's orientation.
+    const glm::vec3 axisX = glm::vec3(mModel[0]);
+    const glm::vec3 axisY = glm::vec3(mModel[1]);
+    const glm::vec3 axisZ = glm::vec3(mModel[2]);
+    const glm::quat rotation = glm::quat_cast(glm::mat3(glm::normalize(axisX), glm::normalize(axisY), glm::normalize(axisZ)));
+    XrPosef pose;
+    pose.orientation = {rotation.x, rotation.y, rotation.z, rotation.w};
+    pose.position = {mModel[3].x, mModel[3].y, mModel[3].z};
+
+    for (uint32_t i = 0; i < layerCount; i++) {
+        // Surface images are top-left origin: the left eye gets the left or the top half.
+        XrSwapchainSubImage subImage{};
+        subImage.swapchain = mLayerSwapchain;
+        subImage.imageRect.offset = {0, 0};
+        subImage.imageRect.extent = {mLayerWidth, mLayerHeight};
+        if (sideBySide) {
+            subImage.imageRect.extent.width = mLayerWidth / 2;
+            subImage.imageRect.offset.x = i * mLayerWidth / 2;
+        } else if (overUnder) {
+            subImage.imageRect.extent.height = mLayerHeight / 2;
+            subImage.imageRect.offset.y = i * mLayerHeight / 2;
+        }
+        const XrEyeVisibility eyeVisibility = layerCount == 1 ? XR_EYE_VISIBILITY_BOTH : (i == 0 ? XR_EYE_VISIBILITY_LEFT : XR_EYE_VISIBILITY_RIGHT);
+
+        if (sphere) {
+            XrCompositionLayerEquirect2KHR& layer = mEquirectLayers[i];
+            layer = {};
+            layer.type = XR_TYPE_COMPOSITION_LAYER_EQUIRECT2_KHR;
+            layer.space = space;
+            layer.eyeVisibility = eyeVisibility;
+            layer.subImage = subImage;
+            layer.pose = {pose.orientation, {0.0f, 0.0f, 0.0f}};
+            layer.radius = 0.0f;  // infinite
+            layer.centralHorizontalAngle = mPlayModel == playModel_2D_180 ? glm::pi<float>() : glm::two_pi<float>();
+            layer.upperVerticalAngle = glm::half_pi<float>();
+            layer.lowerVerticalAngle = -glm::half_pi<float>();
+            layers.push_back(reinterpret_cast<const XrCompositionLayerBaseHeader*>(&layer));
+        } else {
+            XrCompositionLayerQuad& layer = mQuadLayers[i];
+            layer = {};
+            layer.type = XR_TYPE_COMPOSITION_LAYER_QUAD;
+            layer.space = space;
+            layer.eyeVisibility = eyeVisibility;
+            layer.subImage = subImage;
+            layer.pose = pose;
+            layer.size = {glm::length(axisX), glm::length(axisY)};
+            layers.push_back(reinterpret_cast<const XrCompositionLayerBaseHeader*>(&layer));
+        }
+    }
+}
+
 void Player::setPlayStyle(PlayModel model) {
     if (model == mPlayModel) {
         return;
     }
     mPlayModel = model;
-    createVertexAndIndiceData(mPlayModel);
+    createPlayerGeometry(mPlayModel, mVertexCoordinates2D, mVertexCoordinates3D, mIndices);
 
     GLuint aPosition = mShader.getAttribLocation("aPosition");
-    GLuint aTexCoord = mShader.getAttribLocation("aTexCoord");
+    GLuint aTexCoord0 = mShader.getAttribLocation("aTexCoord0");
+    GLuint aTexCoord1 = mShader.getAttribLocation("aTexCoord1");
 
-    GL_CALL(glBindVertexArray(mVAO));
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mVBO));
-    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO));
+    GlState::instance().bindVertexArray(mVAO.get());
+    GlState::instance().bindBuffer(GL_ARRAY_BUFFER, mVBO.get());
+    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO.get()));
 
     GL_CALL(glEnableVertexAttribArray(aPosition));
-    GL_CALL(glEnableVertexAttribArray(aTexCoord));
+    GL_CALL(glEnableVertexAttribArray(aTexCoord0));
+    GL_CALL(glEnableVertexAttribArray(aTexCoord1));
 
+    // The vertex shader picks the texture coordinates of its view, 2D sources give both eyes the same ones.
     if (mPlayModel == playModel_2D || mPlayModel == playModel_2D_180 || mPlayModel == playModel_2D_360) {
-        GL_CALL(glBufferData(GL_ARRAY_BUFFER, mVertexCoordinates2D.size() * sizeof(SampleVertex2D), mVertexCoordinates2D.data(), GL_STATIC_DRAW));
+        GpuMemory::instance().bufferData(GpuMemoryTag::Player, mVBO.get(), GL_ARRAY_BUFFER, mVertexCoordinates2D.size() * sizeof(SampleVertex2D),
+                                         mVertexCoordinates2D.data(), GL_STATIC_DRAW);
         GL_CALL(glVertexAttribPointer(aPosition, sizeof(Position) / sizeof(float),   GL_FLOAT, GL_FALSE, sizeof(SampleVertex2D), (const void*)offsetof(SampleVertex2D, position)));
-        GL_CALL(glVertexAttribPointer(aTexCoord, sizeof(Coordinate) / sizeof(float), GL_FLOAT, GL_FALSE, sizeof(SampleVertex2D), (const void*)offsetof(SampleVertex2D, texCoords)));
+        GL_CALL(glVertexAttribPointer(aTexCoord0, sizeof(Coordinate) / sizeof(float), GL_FLOAT, GL_FALSE, sizeof(SampleVertex2D), (const void*)offsetof(SampleVertex2D, texCoords)));
+        GL_CALL(glVertexAttribPointer(aTexCoord1, sizeof(Coordinate) / sizeof(float), GL_FLOAT, GL_FALSE, sizeof(SampleVertex2D), (const void*)offsetof(SampleVertex2D, texCoords)));
     } else {
-        GL_CALL(glBufferData(GL_ARRAY_BUFFER, mVertexCoordinates3D.size() * sizeof(SampleVertex3D), mVertexCoordinates3D.data(), GL_STATIC_DRAW));
+        GpuMemory::instance().bufferData(GpuMemoryTag::Player, mVBO.get(), GL_ARRAY_BUFFER, mVertexCoordinates3D.size() * sizeof(SampleVertex3D),
+                                         mVertexCoordinates3D.data(), GL_STATIC_DRAW);
         GL_CALL(glVertexAttribPointer(aPosition, sizeof(Position) / sizeof(float),   GL_FLOAT, GL_FALSE, sizeof(SampleVertex3D), (const void*)offsetof(SampleVertex3D, position)));
+        GL_CALL(glVertexAttribPointer(aTexCoord0, sizeof(Coordinate) / sizeof(float), GL_FLOAT, GL_FALSE, sizeof(SampleVertex3D), (const void*)offsetof(SampleVertex3D, texCoords0)));
+        GL_CALL(glVertexAttribPointer(aTexCoord1, sizeof(Coordinate) / sizeof(float), GL_FLOAT, GL_FALSE, sizeof(SampleVertex3D), (const void*)offsetof(SampleVertex3D, texCoords1)));
     }
-    GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(GLuint), mIndices.data(), GL_STATIC_DRAW));
-
-    GL_CALL(glBindVertexArray(GL_NONE));
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, GL_NONE));
-    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_NONE));
+    GpuMemory::instance().bufferData(GpuMemoryTag::Player, mEBO.get(), GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(GLuint), mIndices.data(),
+                                     GL_STATIC_DRAW);
 }
 
 PlayModel Player::getPlayStyle() const {
     return mPlayModel;
 }
 
-#define PI 3.1415926535
-#define RADIAN(x) ((x) * PI / 180)
-void Player::createVertexAndIndiceData(const PlayModel model) {
-    mIndices.resize(0);
-    if (model == playModel_2D) {
-        /* texture coordinate
-         0(0,1)-------1(1,1)
-            |            |
-            |            |
-         3(0,0)-------2(1,0)
-        */
-        mVertexCoordinates2D.resize(0);
-        SampleVertex2D v0{{-0.5f,  0.5f, 0.0f}, {0.0f, 1.0f}};  //left top
-        SampleVertex2D v1{{ 0.5f,  0.5f, 0.0f}, {1.0f, 1.0f}};  //right top
-        SampleVertex2D v2{{ 0.5f, -0.5f, 0.0f}, {1.0f, 0.0f}};  //right bottom
-        SampleVertex2D v3{{-0.5f, -0.5f, 0.0f}, {0.0f, 0.0f}};  //left bottom
-        mVertexCoordinates2D.push_back(v0);
-        mVertexCoordinates2D.push_back(v1);
-        mVertexCoordinates2D.push_back(v2);
-        mVertexCoordinates2D.push_back(v3);
-
-        mIndices.push_back(0); mIndices.push_back(3); mIndices.push_back(1);  //GL_CCW counterclockwise order 逆时针方向为正面
-        mIndices.push_back(1); mIndices.push_back(3); mIndices.push_back(2);
-    } else if (model == playModel_2D_360) {
-        mVertexCoordinates2D.resize(0);
-        int vertexCount = 0;
-        float angleSpan = 2.0f;
-        int32_t indexWidth = 0;
-        float radius = 50.0f;
-        for (float vAngle = 0; vAngle <= 180; vAngle += angleSpan) {      //vertical
-            for (float hAngle = 0; hAngle <= 360; hAngle += angleSpan) {
-                float x = (float) radius * sin(RADIAN(vAngle)) * sin(RADIAN(hAngle));
-                float y = (float) radius * cos(RADIAN(vAngle));
-                float z = (float) radius * sin(RADIAN(vAngle)) * cos(RADIAN(hAngle));
-
-                float textureCoords_x = 1 - hAngle / 360;
-                float textureCoords_y = 1 - vAngle / 180;
-
-                SampleVertex2D v{{x, y, z}, {textureCoords_x, textureCoords_y}};
-                mVertexCoordinates2D.push_back(v);
-                
-                if (vAngle == angleSpan && hAngle == 0) {
-                    indexWidth = vertexCount;
-                }
-                if (vAngle > 0 && hAngle > 0) {
-                    mIndices.push_back(vertexCount);
-                    mIndices.push_back(vertexCount - indexWidth - 1);
-                    mIndices.push_back(vertexCount - indexWidth);
-                    mIndices.push_back(vertexCount);
-                    mIndices.push_back(vertexCount - 1);
-                    mIndices.push_back(vertexCount - indexWidth - 1);
-                }
-                vertexCount++;
-            }
-        }
-    } else if (model == playModel_3D_SBS) {
-        mVertexCoordinates3D.resize(0);
-        SampleVertex3D v0{{-0.5f,  0.5f, 0.0f}, {0.0f, 1.0f}, {0.5f, 1.0f}};  //left top
-        SampleVertex3D v1{{ 0.5f,  0.5f, 0.0f}, {0.5f, 1.0f}, {1.0f, 1.0f}};  //right top
-        SampleVertex3D v2{{ 0.5f, -0.5f, 0.0f}, {0.5f, 0.0f}, {1.0f, 0.0f}};  //right bottom
-        SampleVertex3D v3{{-0.5f, -0.5f, 0.0f}, {0.0f, 0.0f}, {0.5f, 0.0f}};  //left bottom
-        mVertexCoordinates3D.push_back(v0);
-        mVertexCoordinates3D.push_back(v1);
-        mVertexCoordinates3D.push_back(v2);
-        mVertexCoordinates3D.push_back(v3);
-
-        mIndices.push_back(0); mIndices.push_back(3); mIndices.push_back(1);  //GL_CCW counterclockwise order 逆时针方向为正面
-        mIndices.push_back(1); mIndices.push_back(3); mIndices.push_back(2);
-    } else if (model == playModel_3D_OU) {
-        mVertexCoordinates3D.resize(0);
-        SampleVertex3D v0{{-0.5f,  0.5f, 0.0f}, {0.0f, 1.0f}, {0.0f, 0.5f}};  //left top
-        SampleVertex3D v1{{ 0.5f,  0.5f, 0.0f}, {1.0f, 1.0f}, {1.0f, 0.5f}};  //right top
-        SampleVertex3D v2{{ 0.5f, -0.5f, 0.0f}, {1.0f, 0.5f}, {1.0f, 0.0f}};  //right bottom
-        SampleVertex3D v3{{-0.5f, -0.5f, 0.0f}, {0.0f, 0.5f}, {0.0f, 0.0f}};  //left bottom
-        mVertexCoordinates3D.push_back(v0);
-        mVertexCoordinates3D.push_back(v1);
-        mVertexCoordinates3D.push_back(v2);
-        mVertexCoordinates3D.push_back(v3);
-
-        mIndices.push_back(0); mIndices.push_back(3); mIndices.push_back(1);  //GL_CCW counterclockwise order 逆时针方向为正面
-        mIndices.push_back(1); mIndices.push_back(3); mIndices.push_back(2);
+// Latches the current video frame into mVideoTexture once per displayed frame, both eyes then sample the same image.
+bool Player::update() {
+    if (mLayerMode) {
+        return mLayerFrameQueued;
     }
-}
 
-bool Player::render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m, int32_t eye) {
+    // The draws of the previous frame have been issued, so its image can go back to the reader once it is due.
+    std::shared_ptr<MediaFrame> previous = mCurrentFrame;
+    releaseVideoFrame(previous);
 
     std::shared_ptr<MediaFrame> frame = getVideoFrame();
     if (frame.get() == nullptr) {
+        mCurrentFrame.reset();
         return false;
     }
+    if (frame == previous) {
+        return true;
+    }
+    mCurrentFrame.reset();
 
+#ifdef XR_USE_PLATFORM_ANDROID
     AImage* image = reinterpret_cast<AImage*>(frame->image);
     AHardwareBuffer* hwBuff = nullptr;
     if (AImage_getHardwareBuffer(image, &hwBuff) != AMEDIA_OK) {
@@ -247,39 +339,38 @@ bool Player::render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m,
         return false;
     }
 
-    mShader.use(); 
-    mShader.setUniformMat4("projection", p);
-    mShader.setUniformMat4("view", v);
-    mShader.setUniformMat4("model", m);
-
-    GL_CALL(glFrontFace(GL_CCW));
-    GL_CALL(glCullFace(GL_BACK));
-    GL_CALL(glEnable(GL_CULL_FACE));
-    GL_CALL(glEnable(GL_BLEND));
-    GL_CALL(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
-    GL_CALL(glBindVertexArray(mVAO));
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mVBO));
-
-    if (mPlayModel >= playModel_3D_SBS) {
-        GLuint aTexCoord = mShader.getAttribLocation("aTexCoord");
-        GL_CALL(glEnableVertexAttribArray(aTexCoord));
-        if (eye == EYE_LEFT) {
-            GL_CALL(glVertexAttribPointer(aTexCoord, sizeof(Coordinate) / sizeof(float), GL_FLOAT, GL_FALSE, sizeof(SampleVertex3D), (const void*)offsetof(SampleVertex3D, texCoords0)));
-        } else {
-            GL_CALL(glVertexAttribPointer(aTexCoord, sizeof(Coordinate) / sizeof(float), GL_FLOAT, GL_FALSE, sizeof(SampleVertex3D), (const void*)offsetof(SampleVertex3D, texCoords1)));
-        }
-    }
-
+    // The texture keeps the buffer alive as an EGLImage sibling, so the image handle itself is not needed after this.
+    GlState::instance().bindTexture(0, GL_TEXTURE_EXTERNAL_OES, mVideoTexture.get());
     m_glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, imagekhr);
+    m_eglDestroyImageKHR(mEglDisplay, imagekhr);
+#endif
 
-    GL_CALL(glDrawElements(GL_TRIANGLES, mIndices.size(), GL_UNSIGNED_INT, (const void*)0));
+    mCurrentFrame = frame;
+    return true;
+}
 
-    m_eglDestroyImageKHR(mEglDisplay, imagekhr);
-    releaseVideoFrame(frame);
+bool Player::render(DrawList& drawList, const glm::mat4& m) {
+    if (mLayerMode || mCurrentFrame.get() == nullptr) {
+        return false;
+    }
 
+    // The sphere surrounds the viewer, it goes before everything else whatever its distance.
+    DrawPacket packet;
+    packet.layer = DrawPacket::Layer::Background;
+    packet.shader = &mShader;
+    packet.vertexArray = mVAO.get();
+    packet.textureTarget = GL_TEXTURE_EXTERNAL_OES;
+    packet.textures[0] = mVideoTexture.get();
+    packet.blend = true;
+    packet.cullFace = true;
+    packet.model = m;
+    packet.count = mIndices.size();
+    packet.indexType = GL_UNSIGNED_INT;
+    drawList.submit(packet);
     return true;
 }
 
+#ifdef XR_USE_PLATFORM_ANDROID
 bool Player::start(const std::string& file) {
     if (mFileName == file) {
         return true;
@@ -315,6 +406,22 @@ bool Player::start(const std::string& file) {
         return false;
     }
     mTrackCount = AMediaExtractor_getTrackCount(mExtractor);
+    if (mLayerMode) {
+        // The surface swapchain is sized for the video track before the decoder is configured with it.
+        for (auto i = 0; i < mTrackCount; i++) {
+            const char* mime = nullptr;
+            int32_t width = 0, height = 0;
+            AMediaFormat* format = AMediaExtractor_getTrackFormat(mExtractor, i);
+            AMediaFormat_getString(format, "mime", &mime);
+            if (strstr(mime, "video") && AMediaFormat_getInt32(format, "width", &width) && AMediaFormat_getInt32(format, "height", &height)) {
+                if (!createLayerSwapchain(width, height)) {
+                    warnf("video surface swapchain unavailable, falling back to GL rendering");
+                    mLayerMode = false;
+                }
+            }
+            AMediaFormat_delete(format);
+        }
+    }
     if (mTrackCount > 0) {
         mThreadDecode = std::thread(&Player::threadDecode, this);
     } else {
@@ -345,6 +452,8 @@ bool Player::stop() {
         mExtractor = nullptr;
     }
 
+    mCurrentFrame.reset();
+    destroyLayerSwapchain();
     mDecodedVideoFrameListMutex.lock();
     mDecodedVideoFrameList.clear();
     mDecodedVideoFrameListMutex.unlock();
@@ -360,11 +469,37 @@ bool Player::stop() {
     infof("stop---");
     return true;
 }
+#else
+// Nothing is decoded: one frame without an image is queued and stays current, so the video is drawn every frame as it
+// is on the device, with whatever the texture holds.
+bool Player::start(const std::string& file) {
+    if (mFileName == file) {
+        return true;
+    }
+    stop();
+
+    mFileName = file;
+    std::shared_ptr<MediaFrame> frame = std::make_shared<MediaFrame>();
+    frame->bufferIndex = -1;
+    frame->image = nullptr;
+    std::lock_guard<std::mutex> guard(mDecodedVideoFrameListMutex);
+    mDecodedVideoFrameList.push_back(frame);
+    return true;
+}
 
-bool Player::render(const glm::mat4& p, const glm::mat4& v, int32_t eye) {
-    return render(p, v, mModel, eye);
+bool Player::stop() {
+    mCurrentFrame.reset();
+    std::lock_guard<std::mutex> guard(mDecodedVideoFrameListMutex);
+    mDecodedVideoFrameList.clear();
+    return true;
 }
+#endif
 
+bool Player::render(DrawList& drawList) {
+    return render(drawList, mModel);
+}
+
+#ifdef XR_USE_PLATFORM_ANDROID
 void AImageReaderImageCallback(void* context, AImageReader* reader) {
     Player* thiz = (Player*)context;
     AImage* image = nullptr;
@@ -406,17 +541,22 @@ void Player::threadDecode() {
     imageListener.context = this;
     imageListener.onImageAvailable = &AImageReaderImageCallback;
 
-    if (AImageReader_newWithUsage(1, 1, AIMAGE_FORMAT_PRIVATE, imageReaderFlags, maxImageCount, &imageReader) != AMEDIA_OK) {
-        errorf("AImageReader_newWithUsage error");
-        return;
-    }
-    if (AImageReader_setImageListener(imageReader, &imageListener) != AMEDIA_OK) {
-        errorf("AImageReader_setImageListener error");
-        return;
-    }
-    if (AImageReader_getWindow(imageReader, &surface) != AMEDIA_OK) {
-        errorf("AImageReader_getWindow error");
-        return;
+    if (mLayerSurface != nullptr) {
+        // The compositor consumes the decoded frames directly
+        surface = mLayerSurface;
+    } else {
+        if (AImageReader_newWithUsage(1, 1, AIMAGE_FORMAT_PRIVATE, imageReaderFlags, maxImageCount, &imageReader) != AMEDIA_OK) {
+            errorf("AImageReader_newWithUsage error");
+            return;
+        }
+        if (AImageReader_setImageListener(imageReader, &imageListener) != AMEDIA_OK) {
+            errorf("AImageReader_setImageListener error");
+            return;
+        }
+        if (AImageReader_getWindow(imageReader, &surface) != AMEDIA_OK) {
+            errorf("AImageReader_getWindow error");
+            return;
+        }
     }
 
     AMediaCodec* videoCodec = nullptr;
@@ -495,6 +635,14 @@ void Player::threadDecode() {
             codec = audioCodec;
         } else if (index == mVideoTrackIndex) {
             codec = videoCodec;
+            // Nothing queues up in mDecodedVideoFrameList with the surface swapchain, so keep the decoder at most
+            // 100 ms ahead of presentation instead.
+            if (mLayerSurface != nullptr) {
+                uint64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+                if (pts / 1000 + mVideoPtsOffset > now + 100) {
+                    continue;
+                }
+            }
         }
 
         // input
@@ -518,7 +666,18 @@ void Player::threadDecode() {
             if (codec == videoCodec) {
                 if (bufferIndex != AMEDIACODEC_INFO_OUTPUT_BUFFERS_CHANGED && bufferIndex != AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED && bufferIndex != AMEDIACODEC_INFO_TRY_AGAIN_LATER) {
                     //infof("to AMediaCodec_releaseOutputBuffer");
-                    AMediaCodec_releaseOutputBuffer(codec, bufferIndex, true);
+                    if (mLayerSurface != nullptr) {
+                        // Present at the frame's due time, converted from the system clock of mVideoPtsOffset to CLOCK_MONOTONIC.
+                        uint64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+                        int64_t dueInMs = (int64_t)(outputBufferInfo.presentationTimeUs / 1000 + mVideoPtsOffset) - (int64_t)now;
+                        timespec monotonic{};
+                        clock_gettime(CLOCK_MONOTONIC, &monotonic);
+                        int64_t dueNs = monotonic.tv_sec * 1000000000LL + monotonic.tv_nsec + std::max<int64_t>(dueInMs, 0) * 1000000LL;
+                        AMediaCodec_releaseOutputBufferAtTime(codec, bufferIndex, dueNs);
+                        mLayerFrameQueued = true;
+                    } else {
+                        AMediaCodec_releaseOutputBuffer(codec, bufferIndex, true);
+                    }
                 }
             } else {
                 uint8_t *outputBuffer = AMediaCodec_getOutputBuffer(codec, bufferIndex, nullptr);
@@ -589,6 +748,7 @@ void Player::threadPlayAudio() {
     AAudioStreamBuilder_delete(builder);
     infof("threadPlayAudio---");
 }
+#endif
 
 std::shared_ptr<MediaFrame> Player::getVideoFrame() {
     std::lock_guard<std::mutex> guard(mDecodedVideoFrameListMutex);
@@ -621,9 +781,11 @@ bool Player::releaseVideoFrame(std::shared_ptr<MediaFrame> &frame) {
         return false;
     }
     auto &it = mDecodedVideoFrameList.front();
+#ifdef XR_USE_PLATFORM_ANDROID
     if (frame->image) {
         AImage_delete((AImage*)frame->image);
     }
+#endif
     mDecodedVideoFrameList.pop_front();
     //infof("pop mDecodedVideoFrameList size:%d", mDecodedVideoFrameList.size());
     return true;
@@ -631,8 +793,10 @@ bool Player::releaseVideoFrame(std::shared_ptr<MediaFrame> &frame) {
 bool Player::releaseAudioFrame(std::shared_ptr<MediaFrame> &frame) {
     std::lock_guard<std::mutex> guard(mDecodedAudioFrameListMutex);
     if (mDecodedAudioFrameList.size()) {
+#ifdef XR_USE_PLATFORM_ANDROID
         auto &it = mDecodedAudioFrameList.front();
         AMediaCodec_releaseOutputBuffer(mAudioCodec, it->bufferIndex, true);
+#endif
         mDecodedAudioFrameList.pop_front();
     }
     //infof("pop mDecodedAudioFrameList size:%d", mDecodedAudioFrameList.size());
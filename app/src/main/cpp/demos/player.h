@@ -1,50 +1,35 @@
 #pragma once
+#include <atomic>
 #include <thread>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <vector>
+#ifdef XR_USE_PLATFORM_ANDROID
+#include <android/native_window.h>
 #include <media/NdkImage.h>
 #include <media/NdkImageReader.h>
 #include <media/NdkMediaExtractor.h>
+#include <jni.h>
+#else
+// Host builds have no media framework, the player then draws the video texture without decoding into it.
+struct AMediaExtractor;
+struct AMediaCodec;
+struct AImageReader;
+struct ANativeWindow;
+#endif
 #include "shader.h"
-
-typedef struct {
-    float x;
-    float y;
-    float z;
-}Position;
-typedef struct {
-    float x;
-    float y;
-}Coordinate;
-
-typedef struct {
-    Position position;
-    Coordinate texCoords;
-}SampleVertex2D;
-
-typedef struct {
-    Position position;
-    Coordinate texCoords0;
-    Coordinate texCoords1;
-}SampleVertex3D;
+#include "drawList.h"
+#include "glResource.h"
+#include "playerGeometry.h"
+#include <openxr/openxr.h>
+#include <openxr/openxr_platform.h>
 
 typedef enum {
     mediaTypeVideo = 0,
     mediaTypeAudio
 }mediaType;
 
-typedef enum {
-    playModel_None = 0,
-    playModel_2D,
-    playModel_2D_180,
-    playModel_2D_360,
-    playModel_3D_SBS,
-    playModel_3D_SBS_360,
-    playModel_3D_OU,
-    playModel_3D_OU_360
-}PlayModel;
-
 typedef struct MediaFrame_tag {
     MediaFrame_tag() : type(mediaTypeVideo), pts(0), data(nullptr), size(0) {};
     mediaType type;
@@ -64,11 +49,17 @@ public:
     ~Player();
 
     bool initialize(EGLDisplay display);
+    // Decodes straight into an XR_KHR_android_surface_swapchain that is composited as an equirect2 or quad layer
+    // according to the play model, the decoded frames then never reach the GL thread. Call before start().
+    bool initializeLayer(XrInstance instance, XrSession session, bool equirect2Enabled);
+    bool hasLayer() const;
+    void appendLayers(XrSpace space, std::vector<const XrCompositionLayerBaseHeader*>& layers);
     bool start(const std::string& file);
     bool stop();
     void setModel(const glm::mat4& m);
-    bool render(const glm::mat4& p, const glm::mat4& v, int32_t eye);
-    bool render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m, int32_t eye);
+    bool update();
+    bool render(DrawList& drawList);
+    bool render(DrawList& drawList, const glm::mat4& m);
     void setPlayStyle(const PlayModel model);
     PlayModel getPlayStyle() const;
 
@@ -83,15 +74,18 @@ private:
     bool releaseVideoFrame(std::shared_ptr<MediaFrame> &frame);
     bool releaseAudioFrame(std::shared_ptr<MediaFrame> &frame);
 
-    void createVertexAndIndiceData(const PlayModel model);
+    bool createLayerSwapchain(int32_t width, int32_t height);
+    void destroyLayerSwapchain();
 
 private:
     friend void AImageReaderImageCallback(void* context, AImageReader* reader);
 
     static Shader mShader;
-    GLuint mVAO;
-    GLuint mVBO;
-    GLuint mEBO;
+    GlVertexArray mVAO;
+    GlBuffer mVBO;
+    GlBuffer mEBO;
+    GlTexture mVideoTexture;
+    std::shared_ptr<MediaFrame> mCurrentFrame;
 
     EGLDisplay mEglDisplay;
     PFNEGLGETNATIVECLIENTBUFFERANDROIDPROC m_eglGetNativeClientBufferANDROID = nullptr;
@@ -128,6 +122,20 @@ private:
 
     glm::mat4 mModel;
 
+    // surface swapchain output
+    bool mLayerMode;
+    XrSession mXrSession;
+#ifdef XR_USE_PLATFORM_ANDROID
+    PFN_xrCreateSwapchainAndroidSurfaceKHR mPfnCreateSwapchainAndroidSurfaceKHR = nullptr;
+#endif
+    XrSwapchain mLayerSwapchain;
+    ANativeWindow* mLayerSurface;
+    int32_t mLayerWidth;
+    int32_t mLayerHeight;
+    std::atomic<bool> mLayerFrameQueued;
+    XrCompositionLayerEquirect2KHR mEquirectLayers[2];
+    XrCompositionLayerQuad mQuadLayers[2];
+
     std::vector<SampleVertex2D> mVertexCoordinates2D;
     std::vector<SampleVertex3D> mVertexCoordinates3D;
     std::vector<GLuint>         mIndices;
@@ -0,0 +1,87 @@
+#include <math.h>
+#include "playerGeometry.h"
+
+#define PI 3.1415926535
+#define RADIAN(x) ((x) * PI / 180)
+void createPlayerGeometry(const PlayModel model, std::vector<SampleVertex2D>& vertices2D, std::vector<SampleVertex3D>& vertices3D,
+                          std::vector<GLuint>& indices) {
+    indices.resize(0);
+    if (model == playModel_2D) {
+        /* texture coordinate
+         0(0,1)-------1(1,1)
+            |            |
+            |            |
+         3(0,0)-------2(1,0)
+        */
+        vertices2D.resize(0);
+        SampleVertex2D v0{{-0.5f,  0.5f, 0.0f}, {0.0f, 1.0f}};  //left top
+        SampleVertex2D v1{{ 0.5f,  0.5f, 0.0f}, {1.0f, 1.0f}};  //right top
+        SampleVertex2D v2{{ 0.5f, -0.5f, 0.0f}, {1.0f, 0.0f}};  //right bottom
+        SampleVertex2D v3{{-0.5f, -0.5f, 0.0f}, {0.0f, 0.0f}};  //left bottom
+        vertices2D.push_back(v0);
+        vertices2D.push_back(v1);
+        vertices2D.push_back(v2);
+        vertices2D.push_back(v3);
+
+        indices.push_back(0); indices.push_back(3); indices.push_back(1);  //GL_CCW counterclockwise order 逆时针方向为正面
+        indices.push_back(1); indices.push_back(3); indices.push_back(2);
+    } else if (model == playModel_2D_360) {
+        vertices2D.resize(0);
+        int vertexCount = 0;
+        float angleSpan = 2.0f;
+        int32_t indexWidth = 0;
+        float radius = 50.0f;
+        for (float vAngle = 0; vAngle <= 180; vAngle += angleSpan) {      //vertical
+            for (float hAngle = 0; hAngle <= 360; hAngle += angleSpan) {
+                float x = (float) radius * sin(RADIAN(vAngle)) * sin(RADIAN(hAngle));
+                float y = (float) radius * cos(RADIAN(vAngle));
+                float z = (float) radius * sin(RADIAN(vAngle)) * cos(RADIAN(hAngle));
+
+                float textureCoords_x = 1 - hAngle / 360;
+                float textureCoords_y = 1 - vAngle / 180;
+
+                SampleVertex2D v{{x, y, z}, {textureCoords_x, textureCoords_y}};
+                vertices2D.push_back(v);
+                
+                if (vAngle == angleSpan && hAngle == 0) {
+                    indexWidth = vertexCount;
+                }
+                if (vAngle > 0 && hAngle > 0) {
+                    indices.push_back(vertexCount);
+                    indices.push_back(vertexCount - indexWidth - 1);
+                    indices.push_back(vertexCount - indexWidth);
+                    indices.push_back(vertexCount);
+                    indices.push_back(vertexCount - 1);
+                    indices.push_back(vertexCount - indexWidth - 1);
+                }
+                vertexCount++;
+            }
+        }
+    } else if (model == playModel_3D_SBS) {
+        vertices3D.resize(0);
+        SampleVertex3D v0{{-0.5f,  0.5f, 0.0f}, {0.0f, 1.0f}, {0.5f, 1.0f}};  //left top
+        SampleVertex3D v1{{ 0.5f,  0.5f, 0.0f}, {0.5f, 1.0f}, {1.0f, 1.0f}};  //right top
+        SampleVertex3D v2{{ 0.5f, -0.5f, 0.0f}, {0.5f, 0.0f}, {1.0f, 0.0f}};  //right bottom
+        SampleVertex3D v3{{-0.5f, -0.5f, 0.0f}, {0.0f, 0.0f}, {0.5f, 0.0f}};  //left bottom
+        vertices3D.push_back(v0);
+        vertices3D.push_back(v1);
+        vertices3D.push_back(v2);
+        vertices3D.push_back(v3);
+
+        indices.push_back(0); indices.push_back(3); indices.push_back(1);  //GL_CCW counterclockwise order 逆时针方向为正面
+        indices.push_back(1); indices.push_back(3); indices.push_back(2);
+    } else if (model == playModel_3D_OU) {
+        vertices3D.resize(0);
+        SampleVertex3D v0{{-0.5f,  0.5f, 0.0f}, {0.0f, 1.0f}, {0.0f, 0.5f}};  //left top
+        SampleVertex3D v1{{ 0.5f,  0.5f, 0.0f}, {1.0f, 1.0f}, {1.0f, 0.5f}};  //right top
+        SampleVertex3D v2{{ 0.5f, -0.5f, 0.0f}, {1.0f, 0.5f}, {1.0f, 0.0f}};  //right bottom
+        SampleVertex3D v3{{-0.5f, -0.5f, 0.0f}, {0.0f, 0.5f}, {0.0f, 0.0f}};  //left bottom
+        vertices3D.push_back(v0);
+        vertices3D.push_back(v1);
+        vertices3D.push_back(v2);
+        vertices3D.push_back(v3);
+
+        indices.push_back(0); indices.push_back(3); indices.push_back(1);  //GL_CCW counterclockwise order 逆时针方向为正面
+        indices.push_back(1); indices.push_back(3); indices.push_back(2);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include "common/gfxwrapper_opengl.h"
+
+typedef struct {
+    float x;
+    float y;
+    float z;
+}Position;
+typedef struct {
+    float x;
+    float y;
+}Coordinate;
+
+typedef struct {
+    Position position;
+    Coordinate texCoords;
+}SampleVertex2D;
+
+typedef struct {
+    Position position;
+    Coordinate texCoords0;
+    Coordinate texCoords1;
+}SampleVertex3D;
+
+typedef enum {
+    playModel_None = 0,
+    playModel_2D,
+    playModel_2D_180,
+    playModel_2D_360,
+    playModel_3D_SBS,
+    playModel_3D_SBS_360,
+    playModel_3D_OU,
+    playModel_3D_OU_360
+}PlayModel;
+
+// The video surface of a play model: a unit quad, or for 2D_360 a sphere of radius 50 around the viewer in 2 degree
+// steps. 2D models fill vertices2D, 3D models vertices3D with the texture coordinates of both eyes, the other vector is
+// left as it is. Pure CPU work, the player uploads the result.
+void createPlayerGeometry(const PlayModel model, std::vector<SampleVertex2D>& vertices2D, std::vector<SampleVertex3D>& vertices3D,
+                          std::vector<GLuint>& indices);
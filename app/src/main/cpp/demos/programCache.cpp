@@ -0,0 +1,223 @@
+#include <dirent.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef XR_USE_PLATFORM_ANDROID
+#include <sys/system_properties.h>
+#endif
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "programCache.h"
+#include "utils.h"
+
+namespace {
+constexpr char Magic[4] = {'P', 'R', 'G', 'B'};
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;     // binaryFormat of glGetProgramBinary
+    uint32_t length;
+    int64_t compileNs;   // what compiling and linking the sources took, to report the time a hit saves
+};
+
+uint64_t fnv1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string glString(GLenum name) {
+    const GLubyte* value = glGetString(name);
+    return value != nullptr ? reinterpret_cast<const char*>(value) : "";
+}
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}  // namespace
+
+ProgramCache& ProgramCache::instance() {
+    static ProgramCache programCache;
+    return programCache;
+}
+
+void ProgramCache::setDirectory(const std::string& directory) {
+    mDirectory = directory;
+    mDriverChecked = false;
+    mEnabled = false;
+}
+
+bool ProgramCache::initializeDriver() {
+    if (mDriverChecked) {
+        return mEnabled;
+    }
+    mDriverChecked = true;
+    if (mDirectory.empty()) {
+        return false;
+    }
+    GLint formats = 0;
+    GL_CALL(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+    if (formats == 0) {
+        infof("ProgramCache: no program binary formats, shaders are always compiled");
+        return false;
+    }
+
+    // GL_VERSION carries the driver build on most GPUs, the fingerprints catch system and vendor updates that do not.
+#ifdef XR_USE_PLATFORM_ANDROID
+    char fingerprint[PROP_VALUE_MAX] = {};
+    char vendorFingerprint[PROP_VALUE_MAX] = {};
+    __system_property_get("ro.build.fingerprint", fingerprint);
+    __system_property_get("ro.vendor.build.fingerprint", vendorFingerprint);
+#else
+    const char* fingerprint = "";
+    const char* vendorFingerprint = "";
+#endif
+    const std::string driver = glString(GL_RENDERER) + "\n" + glString(GL_VERSION) + "\n" + fingerprint + "\n" + vendorFingerprint + "\n";
+    mDriverHash = fnv1a(driver.data(), driver.size());
+
+    mkdir(mDirectory.c_str(), 0700);
+    const std::string driverPath = mDirectory + "/driver";
+    std::string previous;
+    if (FILE* file = fopen(driverPath.c_str(), "rb")) {
+        char buffer[1024];
+        size_t size;
+        while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            previous.append(buffer, size);
+        }
+        fclose(file);
+    }
+    if (previous != driver) {
+        // Nothing cached for another driver can ever hit again.
+        if (DIR* dir = opendir(mDirectory.c_str())) {
+            while (struct dirent* entry = readdir(dir)) {
+                const size_t length = strlen(entry->d_name);
+                if (length > 4 && strcmp(entry->d_name + length - 4, ".bin") == 0) {
+                    unlink((mDirectory + "/" + entry->d_name).c_str());
+                }
+            }
+            closedir(dir);
+        }
+        FILE* file = fopen(driverPath.c_str(), "wb");
+        if (file == nullptr) {
+            errorf("ProgramCache: cannot write %s, shaders are always compiled", driverPath.c_str());
+            return false;
+        }
+        fwrite(driver.data(), 1, driver.size(), file);
+        fclose(file);
+        infof("ProgramCache: %s for %s", previous.empty() ? "created" : "cleared", glString(GL_RENDERER).c_str());
+    }
+    mEnabled = true;
+    return true;
+}
+
+uint64_t ProgramCache::key(const char* vertexCode, const char* fragmentCode) const {
+    uint64_t hash = fnv1a(&mDriverHash, sizeof(mDriverHash));
+    hash = fnv1a(vertexCode, strlen(vertexCode) + 1, hash);
+    return fnv1a(fragmentCode, strlen(fragmentCode) + 1, hash);
+}
+
+std::string ProgramCache::path(uint64_t key) const {
+    return mDirectory + Fmt("/%016llx.bin", (unsigned long long)key);
+}
+
+bool ProgramCache::load(const char* vertexCode, const char* fragmentCode, GLuint& program) {
+    if (!initializeDriver()) {
+        return false;
+    }
+    const int64_t start = nowNs();
+    const uint64_t programKey = key(vertexCode, fragmentCode);
+    const std::string programPath = path(programKey);
+
+    FileHeader header{};
+    std::vector<uint8_t> binary;
+    FILE* file = fopen(programPath.c_str(), "rb");
+    if (file == nullptr) {
+        mStats.misses++;
+        return false;
+    }
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, Magic, sizeof(Magic)) == 0 &&
+                 header.version == Version && header.key == programKey && header.length > 0;
+    if (valid) {
+        binary.resize(header.length);
+        valid = fread(binary.data(), 1, binary.size(), file) == binary.size();
+    }
+    fclose(file);
+    if (!valid) {
+        mStats.misses++;
+        unlink(programPath.c_str());
+        return false;
+    }
+
+    // A driver may refuse a binary it wrote itself, which is not an error: the program is compiled instead.
+    // glProgramBinary is called without GL_CALL so that the refusal is not logged as one.
+    program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+    GlValidation::discardErrors();
+    GLint linked = GL_FALSE;
+    GL_CALL(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+    if (linked == GL_FALSE) {
+        GL_CALL(glDeleteProgram(program));
+        program = 0;
+        mStats.misses++;
+        mStats.rejected++;
+        unlink(programPath.c_str());
+        warnf("ProgramCache: binary %016llx rejected by the driver", (unsigned long long)programKey);
+        return false;
+    }
+
+    const int64_t loadNs = nowNs() - start;
+    mStats.hits++;
+    mStats.savedMs += std::max<int64_t>(0, header.compileNs - loadNs) / 1000000.0f;
+    infof("ProgramCache: hit %016llx in %.2fms, %u of %u hits, %.1fms saved", (unsigned long long)programKey, loadNs / 1000000.0f, mStats.hits,
+          mStats.hits + mStats.misses, mStats.savedMs);
+    return true;
+}
+
+void ProgramCache::store(const char* vertexCode, const char* fragmentCode, GLuint program, int64_t compileNs) {
+    if (!initializeDriver()) {
+        return;
+    }
+    GLint length = 0;
+    GL_CALL(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0) {
+        return;
+    }
+    std::vector<uint8_t> binary(length);
+    GLsizei written = 0;
+    GLenum format = 0;
+    GL_CALL(glGetProgramBinary(program, length, &written, &format, binary.data()));
+    if (written <= 0) {
+        return;
+    }
+
+    FileHeader header{};
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.key = key(vertexCode, fragmentCode);
+    header.format = format;
+    header.length = static_cast<uint32_t>(written);
+    header.compileNs = compileNs;
+
+    // Written next to its final name and renamed, so a crash never leaves a torn binary behind.
+    const std::string programPath = path(header.key);
+    const std::string tempPath = programPath + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        errorf("ProgramCache: cannot write %s", tempPath.c_str());
+        return;
+    }
+    bool stored = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(binary.data(), 1, header.length, file) == header.length;
+    stored = fclose(file) == 0 && stored;
+    if (!stored || rename(tempPath.c_str(), programPath.c_str()) != 0) {
+        errorf("ProgramCache: failed to write %s", programPath.c_str());
+        unlink(tempPath.c_str());
+        return;
+    }
+    infof("ProgramCache: stored %016llx, %u bytes, compiled in %.1fms", (unsigned long long)header.key, header.length, compileNs / 1000000.0f);
+}
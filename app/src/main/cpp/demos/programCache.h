@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include "common/gfxwrapper_opengl.h"
+
+// Linked GL programs kept as glGetProgramBinary blobs in app-private storage, one file per program.
+// A program is keyed by a hash of its final sources and of the driver (GL_RENDERER, GL_VERSION and the build
+// fingerprints), so a shader edit or a driver update simply misses and the program is compiled again. The cached files
+// of an older driver are deleted the first time a new one is seen.
+class ProgramCache {
+public:
+    static constexpr uint32_t Version = 1;
+
+    struct Stats {
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t rejected;  // cached binaries the driver refused to load
+        float savedMs;      // compile and link time the hits did not spend, minus their load time
+    };
+
+    static ProgramCache& instance();
+
+    // Until a directory is set every lookup misses and nothing is stored.
+    void setDirectory(const std::string& directory);
+
+    // Creates program from the cached binary of these sources. Returns false on a miss or when the driver rejects the
+    // binary, the caller then compiles the program itself and hands it to store().
+    bool load(const char* vertexCode, const char* fragmentCode, GLuint& program);
+    // program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+    void store(const char* vertexCode, const char* fragmentCode, GLuint program, int64_t compileNs);
+
+    const Stats& getStats() const { return mStats; }
+
+private:
+    ProgramCache() = default;
+    bool initializeDriver();
+    uint64_t key(const char* vertexCode, const char* fragmentCode) const;
+    std::string path(uint64_t key) const;
+
+private:
+    std::string mDirectory;
+    bool mDriverChecked = false;
+    bool mEnabled = false;
+    uint64_t mDriverHash = 0;
+    Stats mStats{};
+};
@@ -1,5 +1,7 @@
 #include "ray.h"
 #include "utils.h"
+#include "glState.h"
+#include "gpuMemory.h"
 
 Shader Ray::mShader;
 Ray::Ray() {
@@ -19,14 +21,12 @@ bool Ray::initShader() {
             #version 320 es
             precision highp float;
             layout (location = 0) in vec3 position;
-            uniform mat4 projection;
-            uniform mat4 view;
             uniform mat4 model;
             out vec3 outPosition;
             void main()
             {
                 outPosition = position;
-                gl_Position = projection * view * model * vec4(position, 1.0);
+                gl_Position = projection[VIEW_ID] * view[VIEW_ID] * model * vec4(position, 1.0);
             }
         )_";
 
@@ -47,7 +47,7 @@ bool Ray::initShader() {
             }
         )_";
 
-        if (mShader.loadShader(vertex_shader_glsl, fragment_shader_glsl) == false) {
+        if (mShader.loadShader(vertex_shader_glsl, fragment_shader_glsl, true, "ray") == false) {
             return false;
         }
         init = true;
@@ -87,15 +87,15 @@ void Ray::initialize() {
     mPoint1 = glm::vec3(0.0f, 0.0f, startz);              //start point
     mPoint2 = glm::vec3(0.0f, 0.0f, startz - mLength);    //end point        use to calculate line direction
 
-    GLuint VBO = 0, EBO = 0;
-	GL_CALL(glGenVertexArrays(1, &mVAO));
-	GL_CALL(glGenBuffers(1, &VBO));
-    GL_CALL(glGenBuffers(1, &EBO));
-	GL_CALL(glBindVertexArray(mVAO));
-	GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, VBO));
-    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO));
-	GL_CALL(glBufferData(GL_ARRAY_BUFFER, mVertices.size() * sizeof(float), mVertices.data(), GL_STATIC_DRAW));
-    GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(GLuint), mIndices.data(), GL_STATIC_DRAW));
+    mVAO = GlVertexArray::generate();
+    mVBO = GlBuffer::generate();
+    mEBO = GlBuffer::generate();
+	GlState::instance().bindVertexArray(mVAO.get());
+	GlState::instance().bindBuffer(GL_ARRAY_BUFFER, mVBO.get());
+    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO.get()));
+	GpuMemory::instance().bufferData(GpuMemoryTag::Geometry, mVBO.get(), GL_ARRAY_BUFFER, mVertices.size() * sizeof(float), mVertices.data(), GL_STATIC_DRAW);
+    GpuMemory::instance().bufferData(GpuMemoryTag::Geometry, mEBO.get(), GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(GLuint), mIndices.data(),
+                                     GL_STATIC_DRAW);
 	GL_CALL(glEnableVertexAttribArray(0));
 	GL_CALL(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0));
 }
@@ -118,21 +118,26 @@ void Ray::setColor(float x, float y, float z) {
     mColor = {x, y, z};
 }
 
-bool Ray::render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m) {
-    //GL_CALL(glDisable(GL_CULL_FACE));
-    mShader.use();
-    mShader.setUniformVec3("color", mColor);
-    mShader.setUniformMat4("projection", p);
-    mShader.setUniformMat4("view", v);
-    mShader.setUniformMat4("model", m);
-    float maxz = mVertices[mVertices.size() - 1];
-    mShader.setUniformFloat("inmaxz", maxz);
-    GL_CALL(glBindVertexArray(mVAO));
-    GL_CALL(glDrawElements(GL_TRIANGLES, mIndices.size(), GL_UNSIGNED_INT, 0));
-    GL_CALL(glBindVertexArray(0));
+bool Ray::render(DrawList& drawList, const glm::mat4& m) {
+    DrawPacket packet;
+    packet.shader = &mShader;
+    packet.vertexArray = mVAO.get();
+    packet.blend = true;
+    packet.model = m;
+    packet.params[0] = glm::vec4(mColor, mVertices[mVertices.size() - 1]);
+    packet.setUniforms = setUniforms;
+    packet.count = mIndices.size();
+    packet.indexType = GL_UNSIGNED_INT;
+    drawList.submit(packet);
     return true;
 }
 
+void Ray::setUniforms(const Shader& shader, const DrawPacket& packet) {
+    shader.setUniformVec3("color", glm::vec3(packet.params[0]));
+    shader.setUniformMat4("model", packet.model);
+    shader.setUniformFloat("inmaxz", packet.params[0].w);
+}
+
 std::vector<glm::vec3> Ray::getPoints() {
     std::vector<glm::vec3> points;
     points.push_back(mPoint1);
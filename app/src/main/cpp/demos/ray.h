@@ -1,6 +1,8 @@
 #pragma once
 #include <vector>
 #include "shader.h"
+#include "drawList.h"
+#include "glResource.h"
 #include "glm/glm.hpp"
 #include "common/gfxwrapper_opengl.h"
 
@@ -12,7 +14,7 @@ public:
     Ray();
     ~Ray();
     void initialize();
-    bool render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m);
+    bool render(DrawList& drawList, const glm::mat4& m);
     std::vector<glm::vec3> getPoints();
     glm::vec3 getForwardVector();
     glm::vec3 getDirectionVector(const glm::mat4& m);
@@ -20,6 +22,7 @@ public:
     void setColor(float x, float y, float z);
 private:
     bool initShader();
+    static void setUniforms(const Shader& shader, const DrawPacket& packet);
 private:
     static Shader mShader;
     float mRadius = 0.0015f;
@@ -29,6 +32,8 @@ private:
     glm::vec3 mPoint2;
     std::vector<float> mVertices;
     std::vector<GLuint> mIndices;
-    GLuint mVAO;
+    GlVertexArray mVAO;
+    GlBuffer mVBO;
+    GlBuffer mEBO;
     glm::vec3 mColor;
 };
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <chrono>
+#include "renderGraph.h"
+#include "gpuProfiler.h"
+#include "glState.h"
+#include "utils.h"
+
+RenderGraph& RenderGraph::instance() {
+    static RenderGraph renderGraph;
+    return renderGraph;
+}
+
+void RenderGraph::beginFrame() {
+    if (!mPasses.empty()) {
+        warnf("RenderGraph: %zu passes of the last frame were never executed", mPasses.size());
+    }
+    mPasses.clear();
+    // Framebuffers bound outside the graph in between, e.g. by initialization code, are not tracked.
+    mBindingKnown = false;
+}
+
+RenderGraph::PassId RenderGraph::addPass(const char* name, Kind kind, const Target& target, std::function<void()> execute,
+                                         std::initializer_list<PassId> dependencies) {
+    const PassId id = static_cast<PassId>(mPasses.size());
+    for (PassId dependency : dependencies) {
+        if (dependency >= id) {
+            errorf("RenderGraph: %s depends on a pass that was not added before it", name);
+        }
+    }
+    mPasses.push_back({name, kind, target, std::move(execute), std::vector<PassId>(dependencies), false});
+    return id;
+}
+
+void RenderGraph::execute() {
+    // Passes are few, so the next one is simply searched for: the first offscreen pass whose dependencies have run,
+    // else the first such eye pass. Dependencies always point backwards, so there always is one.
+    mTiming = {};
+    uint32_t eyePasses = 0;
+    for (size_t executed = 0; executed < mPasses.size(); executed++) {
+        Pass* next = nullptr;
+        for (Pass& pass : mPasses) {
+            if (pass.done) {
+                continue;
+            }
+            bool ready = true;
+            for (PassId dependency : pass.dependencies) {
+                ready = ready && (dependency >= mPasses.size() || mPasses[dependency].done);
+            }
+            if (ready && (next == nullptr || (next->kind == Kind::Eye && pass.kind == Kind::Offscreen))) {
+                next = &pass;
+                if (pass.kind == Kind::Offscreen) {
+                    break;
+                }
+            }
+        }
+        if (next == nullptr) {
+            break;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        run(*next);
+        const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        if (next->kind == Kind::Offscreen) {
+            mTiming.offscreenNs += ns;
+        } else {
+            mTiming.eyeNs[std::min(eyePasses++, 1u)] += ns;
+        }
+        next->done = true;
+    }
+
+    // Every pass that samples an end-of-frame attachment has run, its contents are not needed anymore.
+    for (const Pass& pass : mPasses) {
+        const Target& target = pass.target;
+        GLenum discard[2];
+        GLsizei discardCount = 0;
+        if (target.color.texture != 0 && target.color.store == Store::EndOfFrame) {
+            discard[discardCount++] = GL_COLOR_ATTACHMENT0;
+        }
+        if (target.depth.texture != 0 && target.depth.store == Store::EndOfFrame) {
+            discard[discardCount++] = GL_DEPTH_ATTACHMENT;
+        }
+        if (target.framebuffer != 0 && discardCount > 0) {
+            bind(target.framebuffer);
+            GL_CALL(glInvalidateFramebuffer(GL_FRAMEBUFFER, discardCount, discard));
+        }
+    }
+
+    bind(0);
+    mPasses.clear();
+}
+
+bool RenderGraph::prepareFramebuffer(GLuint framebuffer, const Attachment& color, const Attachment& depth) {
+    bind(framebuffer);
+    Attached& attached = mAttached[framebuffer];
+    attach(GL_COLOR_ATTACHMENT0, color, attached.color, attached.colorLayers);
+    attach(GL_DEPTH_ATTACHMENT, depth, attached.depth, attached.depthLayers);
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        errorf("RenderGraph: framebuffer %u is incomplete: 0x%x", framebuffer, status);
+        return false;
+    }
+    return true;
+}
+
+void RenderGraph::releaseFramebuffer(GLuint framebuffer) {
+    mAttached.erase(framebuffer);
+    if (mBoundFramebuffer == framebuffer) {
+        mBindingKnown = false;
+    }
+}
+
+void RenderGraph::bind(GLuint framebuffer) {
+    if (!mBindingKnown || mBoundFramebuffer != framebuffer) {
+        GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+        mBoundFramebuffer = framebuffer;
+        mBindingKnown = true;
+    }
+}
+
+void RenderGraph::run(Pass& pass) {
+    GpuProfiler::Zone zone(pass.name);
+    const Target& target = pass.target;
+    if (target.framebuffer == 0) {
+        pass.execute();
+        GlValidation::instance().checkPass(pass.name);
+        return;
+    }
+
+    bind(target.framebuffer);
+    Attached& attached = mAttached[target.framebuffer];
+    attach(GL_COLOR_ATTACHMENT0, target.color, attached.color, attached.colorLayers);
+    attach(GL_DEPTH_ATTACHMENT, target.depth, attached.depth, attached.depthLayers);
+    GlState::instance().viewport(target.x, target.y, target.width, target.height);
+
+    GLenum discard[2];
+    GLsizei discardCount = 0;
+    GLbitfield clear = 0;
+    if (target.color.texture != 0) {
+        if (target.color.load == Load::Clear) {
+            clear |= GL_COLOR_BUFFER_BIT;
+        } else if (target.color.load == Load::DontCare) {
+            discard[discardCount++] = GL_COLOR_ATTACHMENT0;
+        }
+    }
+    if (target.depth.texture != 0) {
+        if (target.depth.load == Load::Clear) {
+            clear |= GL_DEPTH_BUFFER_BIT;  // nothing attaches or uses stencil
+        } else if (target.depth.load == Load::DontCare) {
+            discard[discardCount++] = GL_DEPTH_ATTACHMENT;
+        }
+    }
+    if (discardCount > 0) {
+        GL_CALL(glInvalidateFramebuffer(GL_FRAMEBUFFER, discardCount, discard));
+    }
+    if (clear != 0) {
+        // Clears are cut by the scissor and depth mask, which an earlier pass may have left set.
+        GlState::instance().setEnabled(GL_SCISSOR_TEST, false);
+        if ((clear & GL_DEPTH_BUFFER_BIT) != 0) {
+            GlState::instance().depthMask(true);
+        }
+        GL_CALL(glClearColor(target.clearColor.r, target.clearColor.g, target.clearColor.b, target.clearColor.a));
+        GL_CALL(glClear(clear));
+    }
+
+    pass.execute();
+    GlValidation::instance().checkPass(pass.name);
+
+    discardCount = 0;
+    if (target.color.texture != 0 && target.color.store == Store::DontCare) {
+        discard[discardCount++] = GL_COLOR_ATTACHMENT0;
+    }
+    if (target.depth.texture != 0 && target.depth.store == Store::DontCare) {
+        discard[discardCount++] = GL_DEPTH_ATTACHMENT;
+    }
+    if (discardCount > 0) {
+        GL_CALL(glInvalidateFramebuffer(GL_FRAMEBUFFER, discardCount, discard));
+    }
+}
+
+void RenderGraph::attach(GLenum attachmentPoint, const Attachment& attachment, GLuint& texture, uint32_t& layers) {
+    if (attachment.texture == texture && attachment.layers == layers) {
+        return;
+    }
+    if (attachment.layers > 1) {
+        GL_CALL(glFramebufferTextureMultiviewOVR(GL_FRAMEBUFFER, attachmentPoint, attachment.texture, 0, 0, attachment.layers));
+    } else {
+        GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, attachmentPoint, GL_TEXTURE_2D, attachment.texture, 0));
+    }
+    texture = attachment.texture;
+    layers = attachment.layers;
+}
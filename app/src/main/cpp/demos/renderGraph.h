@@ -0,0 +1,103 @@
+#pragma once
+#include <stdint.h>
+#include <functional>
+#include <initializer_list>
+#include <map>
+#include <vector>
+#include "glm/glm.hpp"
+#include "common/gfxwrapper_opengl.h"
+
+// The GL passes of one frame. Passes are recorded during update() and the view rendering, then executed together:
+// offscreen passes (the dashboard panel, the video import) run before the eye passes that sample their results, never
+// nested inside them. The graph owns the framebuffer binds, attachments, clears and invalidations of every pass, so a
+// pass body only issues its draws. Binds and attachments that are already in place are skipped.
+class RenderGraph {
+public:
+    enum class Kind {
+        Offscreen,  // produces something the eye passes use
+        Eye,        // renders into a swapchain image of the projection layer
+    };
+    enum class Load { Clear, Keep, DontCare };  // DontCare lets a tiler skip loading the old contents
+    enum class Store {
+        Store,
+        DontCare,    // lets a tiler skip writing the contents back
+        EndOfFrame,  // stored for the passes of this frame that sample it, invalidated once they all ran
+    };
+
+    struct Attachment {
+        GLuint texture = 0;  // 0: no attachment
+        uint32_t layers = 1; // 2 for a multiview target, the texture is then a 2D array
+        Load load = Load::Clear;
+        Store store = Store::Store;
+    };
+
+    // What a pass renders into. A pass without framebuffer only issues GL commands, e.g. a texture upload.
+    struct Target {
+        GLuint framebuffer = 0;
+        Attachment color;
+        Attachment depth;
+        int32_t x = 0;
+        int32_t y = 0;
+        int32_t width = 0;
+        int32_t height = 0;
+        glm::vec4 clearColor = glm::vec4(0.0f);
+    };
+
+    using PassId = uint32_t;
+
+    static RenderGraph& instance();
+
+    // Drops whatever the last frame recorded but did not execute and starts recording a new frame.
+    void beginFrame();
+
+    // The name must be a string literal, it names the pass's GPU profiler zone. Dependencies must have been added
+    // before; a pass runs after them, and offscreen passes that are ready run before eye passes that are.
+    // The target is bound, attached and cleared when execute runs; execute must leave the framebuffer binding alone.
+    PassId addPass(const char* name, Kind kind, const Target& target, std::function<void()> execute, std::initializer_list<PassId> dependencies = {});
+
+    // Executes the recorded passes and leaves the default framebuffer bound.
+    void execute();
+
+    // CPU time the last execute() spent running passes, by kind. Eye passes count in the order they ran, which is the
+    // order they were added; a third one adds to the second.
+    struct Timing {
+        int64_t offscreenNs;
+        int64_t eyeNs[2];
+    };
+    const Timing& lastTiming() const { return mTiming; }
+
+    // Attaches the textures to a framebuffer created for one fixed target and checks that it is complete, so passes
+    // rendering to it later never touch its attachments. Returns false, after logging why, when it is not complete.
+    bool prepareFramebuffer(GLuint framebuffer, const Attachment& color, const Attachment& depth);
+    // Forgets what is attached to a framebuffer that is about to be deleted, its name may be reused.
+    void releaseFramebuffer(GLuint framebuffer);
+
+private:
+    struct Pass {
+        const char* name;
+        Kind kind;
+        Target target;
+        std::function<void()> execute;
+        std::vector<PassId> dependencies;
+        bool done;
+    };
+    // What is attached to a framebuffer, to skip re-attaching the same textures every frame.
+    struct Attached {
+        GLuint color = 0;
+        uint32_t colorLayers = 0;
+        GLuint depth = 0;
+        uint32_t depthLayers = 0;
+    };
+
+    RenderGraph() = default;
+    void run(Pass& pass);
+    void bind(GLuint framebuffer);
+    void attach(GLenum attachmentPoint, const Attachment& attachment, GLuint& texture, uint32_t& layers);
+
+private:
+    std::vector<Pass> mPasses;
+    std::map<GLuint, Attached> mAttached;
+    GLuint mBoundFramebuffer = 0;
+    bool mBindingKnown = false;
+    Timing mTiming{};
+};
@@ -1,15 +1,51 @@
+#include <chrono>
 #include <iostream>
 #include "shader.h"
+#include "programCache.h"
+#include "glState.h"
 #include "utils.h"
 
+namespace {
+const char* const MultiviewPrelude = R"_(
+#extension GL_OVR_multiview2 : require
+layout(num_views = 2) in;
+#define VIEW_ID gl_ViewID_OVR
+layout(std140, binding = 0) uniform ViewBlock { mat4 projection[2]; mat4 view[2]; uint viewIndex; };
+)_";
+
+const char* const SingleViewPrelude = R"_(
+#define VIEW_ID viewIndex
+layout(std140, binding = 0) uniform ViewBlock { mat4 projection[2]; mat4 view[2]; uint viewIndex; };
+)_";
+
+// Inserts the prelude right after the #version line, which has to stay the first statement of the source.
+std::string injectPrelude(const char* code, const char* prelude) {
+    std::string source(code);
+    size_t version = source.find("#version");
+    size_t lineEnd = version == std::string::npos ? std::string::npos : source.find('\n', version);
+    if (lineEnd == std::string::npos) {
+        return prelude + source;
+    }
+    source.insert(lineEnd + 1, prelude);
+    return source;
+}
+}  // namespace
+
+bool Shader::sMultiview = false;
+
+void Shader::setMultiview(bool multiview) {
+    sMultiview = multiview;
+}
+
+bool Shader::isMultiview() {
+    return sMultiview;
+}
+
 //构造函数和析构函数
-Shader::Shader() : mProgram(0) {
+Shader::Shader() {
 }
 
 Shader::~Shader() {
-    if (mProgram) {
-        glDeleteProgram(mProgram);
-    }
 }
 
 //检查着色器编译或程序链接错误
@@ -35,12 +71,22 @@ bool Shader::checkCompileErrors(GLuint shader, std::string type) {
 }//Q1：程序链接和着色器编译的区别是啥 Q2：GL_CALL有何用
 
 //加载并编译着色器
-bool Shader::loadShader(const char* vertexShaderCode, const char* fragmentShaderCode) {
-    //查询GPU支持的顶点着色器和片段着色器的最大Uniform变量数量
-    int maxVertexUniform, maxFragmentUniform;
-    GL_CALL(glGetIntegerv(GL_MAX_VERTEX_UNIFORM_COMPONENTS, &maxVertexUniform));
-    GL_CALL(glGetIntegerv(GL_MAX_FRAGMENT_UNIFORM_COMPONENTS, &maxFragmentUniform));
-    //infof("maxVertexUniform:%d, maxFragmentUniform:%d", maxVertexUniform, maxFragmentUniform);
+bool Shader::loadShader(const char* vertexShaderCode, const char* fragmentShaderCode, bool stereo, const char* label) {
+    std::string stereoVertexCode;
+    if (stereo) {
+        stereoVertexCode = injectPrelude(vertexShaderCode, sMultiview ? MultiviewPrelude : SingleViewPrelude);
+        vertexShaderCode = stereoVertexCode.c_str();
+    }
+
+    //先查找缓存的程序二进制，未命中时才编译
+    ProgramCache& programCache = ProgramCache::instance();
+    GLuint program = 0;
+    if (programCache.load(vertexShaderCode, fragmentShaderCode, program)) {
+        mProgram.reset(program);
+        setLabel(label);
+        return true;
+    }
+    const auto compileStart = std::chrono::steady_clock::now();
 
     GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
     //绑定GLSL源码glShaderSource，编译glCompileShader，下面的片段着色器同理
@@ -56,79 +102,91 @@ bool Shader::loadShader(const char* vertexShaderCode, const char* fragmentShader
         return false;
     }
     //创建程序后附加顶点和片段着色器，连接程序并检查错误
-    mProgram = glCreateProgram();
-    GL_CALL(glAttachShader(mProgram, vertex));
-    GL_CALL(glAttachShader(mProgram, fragment));
-    GL_CALL(glLinkProgram(mProgram));
-    if (!checkCompileErrors(mProgram, "PROGRAM")) {
+    mProgram = GlProgram::generate();
+    GL_CALL(glAttachShader(mProgram.get(), vertex));
+    GL_CALL(glAttachShader(mProgram.get(), fragment));
+    GL_CALL(glProgramParameteri(mProgram.get(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    GL_CALL(glLinkProgram(mProgram.get()));
+    if (!checkCompileErrors(mProgram.get(), "PROGRAM")) {
         return false;
     }
     //删除临时着色器对象
     GL_CALL(glDeleteShader(vertex));
     GL_CALL(glDeleteShader(fragment));
+
+    const int64_t compileNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - compileStart).count();
+    programCache.store(vertexShaderCode, fragmentShaderCode, mProgram.get(), compileNs);
+    setLabel(label);
     return true;
 }
 
+void Shader::setLabel(const char* label) {
+    mLabel = label;
+    if (label != nullptr) {
+        GL_CALL(glObjectLabel(GL_PROGRAM, mProgram.get(), -1, label));
+    }
+}
+
 //激活当前着色器程序
 void Shader::use() const {
-    GL_CALL(glUseProgram(mProgram));
+    GlState::instance().useProgram(mProgram.get());
 }
 
 //返回着色器程序ID
 GLuint Shader::id() const {
-    return mProgram;
+    return mProgram.get();
 }
 
 //Uniform 变量设置
 void Shader::setUniformBool(const std::string& name, bool value) const {
-    GL_CALL(glUniform1i(glGetUniformLocation(mProgram, name.c_str()), (int)value));
+    GL_CALL(glUniform1i(glGetUniformLocation(mProgram.get(), name.c_str()), (int)value));
 }
 
 void Shader::setUniformInt(const std::string& name, int value) const {
-    GL_CALL(glUniform1i(glGetUniformLocation(mProgram, name.c_str()), value));
+    GL_CALL(glUniform1i(glGetUniformLocation(mProgram.get(), name.c_str()), value));
 }
 
 void Shader::setUniformFloat(const std::string& name, float value) const {
-    GL_CALL(glUniform1f(glGetUniformLocation(mProgram, name.c_str()), value));
+    GL_CALL(glUniform1f(glGetUniformLocation(mProgram.get(), name.c_str()), value));
 }
 
 //Q：glm::vec2是啥玩意
 void Shader::setUniformVec2(const std::string& name, const glm::vec2& value) const {
-    GL_CALL(glUniform2fv(glGetUniformLocation(mProgram, name.c_str()), 1, &value[0]));
+    GL_CALL(glUniform2fv(glGetUniformLocation(mProgram.get(), name.c_str()), 1, &value[0]));
 }
 
 void Shader::setUniformVec2(const std::string& name, float x, float y) const {
-    GL_CALL(glUniform2f(glGetUniformLocation(mProgram, name.c_str()), x, y));
+    GL_CALL(glUniform2f(glGetUniformLocation(mProgram.get(), name.c_str()), x, y));
 }
 
 void Shader::setUniformVec3(const std::string& name, const glm::vec3& value) const {
-    GL_CALL(glUniform3fv(glGetUniformLocation(mProgram, name.c_str()), 1, &value[0]));
+    GL_CALL(glUniform3fv(glGetUniformLocation(mProgram.get(), name.c_str()), 1, &value[0]));
 }
 
 void Shader::setUniformVec3(const std::string& name, float x, float y, float z) const {
-    GL_CALL(glUniform3f(glGetUniformLocation(mProgram, name.c_str()), x, y, z));
+    GL_CALL(glUniform3f(glGetUniformLocation(mProgram.get(), name.c_str()), x, y, z));
 }
 
 void Shader::setUniformVec4(const std::string& name, const glm::vec4& value) const {
-    GL_CALL(glUniform4fv(glGetUniformLocation(mProgram, name.c_str()), 1, &value[0]));
+    GL_CALL(glUniform4fv(glGetUniformLocation(mProgram.get(), name.c_str()), 1, &value[0]));
 }
 
 void Shader::setUniformVec4(const std::string& name, float x, float y, float z, float w) const {
-    GL_CALL(glUniform4f(glGetUniformLocation(mProgram, name.c_str()), x, y, z, w));
+    GL_CALL(glUniform4f(glGetUniformLocation(mProgram.get(), name.c_str()), x, y, z, w));
 }
 
 void Shader::setUniformMat2(const std::string& name, const glm::mat2& mat) const {
-    GL_CALL(glUniformMatrix2fv(glGetUniformLocation(mProgram, name.c_str()), 1, GL_FALSE, &mat[0][0]));
+    GL_CALL(glUniformMatrix2fv(glGetUniformLocation(mProgram.get(), name.c_str()), 1, GL_FALSE, &mat[0][0]));
 }
 
 void Shader::setUniformMat3(const std::string& name, const glm::mat3& mat) const {
-    GL_CALL(glUniformMatrix3fv(glGetUniformLocation(mProgram, name.c_str()), 1, GL_FALSE, &mat[0][0]));
+    GL_CALL(glUniformMatrix3fv(glGetUniformLocation(mProgram.get(), name.c_str()), 1, GL_FALSE, &mat[0][0]));
 }
 
 void Shader::setUniformMat4(const std::string& name, const glm::mat4& mat) const {
-    GL_CALL(glUniformMatrix4fv(glGetUniformLocation(mProgram, name.c_str()), 1, GL_FALSE, &mat[0][0]));
+    GL_CALL(glUniformMatrix4fv(glGetUniformLocation(mProgram.get(), name.c_str()), 1, GL_FALSE, &mat[0][0]));
 }
 
 GLuint Shader::getAttribLocation(const std::string& name) const {
-    return glGetAttribLocation(mProgram, name.c_str());
+    return glGetAttribLocation(mProgram.get(), name.c_str());
 }
@@ -2,16 +2,36 @@
 #include <string>
 #include "glm/glm.hpp"
 #include "common/gfxwrapper_opengl.h"
+#include "glResource.h"
+
+// Per-pass camera data of the stereo shaders, uniform buffer binding VIEW_BLOCK_BINDING (std140).
+// In a multiview pass both entries are used and indexed by gl_ViewID_OVR, in a per-eye pass only [viewIndex] is.
+struct ViewBlock {
+    glm::mat4 projection[2];
+    glm::mat4 view[2];
+    uint32_t viewIndex;
+    uint32_t padding[3];
+};
+#define VIEW_BLOCK_BINDING 0
 
 class Shader {
 public:
     Shader();
     ~Shader();
 
-    bool loadShader(const char* vertexCode, const char* fragmentCode);
+    // stereo: the ViewBlock uniform buffer and VIEW_ID are injected after the #version line of the vertex shader,
+    // which then uses projection[VIEW_ID] * view[VIEW_ID] instead of its own matrices.
+    // label names the program in GPU debuggers, in the GPU profiler's per-renderer zones and in the GL call counts of the
+    // scenario benchmarks. It is kept, not copied: pass a string literal.
+    bool loadShader(const char* vertexCode, const char* fragmentCode, bool stereo = false, const char* label = nullptr);
+
+    // Selects the stereo prelude for shaders loaded afterwards: GL_OVR_multiview2 with two views, or one view per pass.
+    static void setMultiview(bool multiview);
+    static bool isMultiview();
 
     void use() const;
     GLuint id() const;
+    const char* label() const { return mLabel; }
     void setUniformBool(const std::string& name, bool value) const;
     void setUniformInt(const std::string& name, int value) const;
     void setUniformFloat(const std::string& name, float value) const;
@@ -27,7 +47,10 @@ public:
     GLuint getAttribLocation(const std::string& name) const;
 private:
     bool checkCompileErrors(GLuint shader, std::string type);
+    void setLabel(const char* label);
 
 private:
-    GLuint mProgram;
+    GlProgram mProgram;
+    const char* mLabel = nullptr;
+    static bool sMultiview;
 };
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include "text.h"
 #include "utils.h"
+#include "glState.h"
+#include "gpuMemory.h"
+#include <algorithm>
 #include <iostream>
 
 Shader Text::mShader;
@@ -13,13 +16,11 @@ void Text::initShader() {
             layout(location = 0) in vec3 aPos;
             layout(location = 1) in vec2 aTexCoords;
             out vec2 TexCoords;
-            uniform mat4 projection;
-            uniform mat4 view;
             uniform mat4 model;
             void main()
             {
                 TexCoords = aTexCoords;
-                gl_Position = projection * view * model * vec4(aPos, 1.0);
+                gl_Position = projection[VIEW_ID] * view[VIEW_ID] * model * vec4(aPos, 1.0);
             }
         )_";
 
@@ -29,14 +30,14 @@ void Text::initShader() {
             in vec2 TexCoords;
             out vec4 FragColor;
             uniform vec3 textColor;
-            uniform sampler2D texture;
+            uniform sampler2D glyph;
             void main()
             {
-                vec4 color = vec4(1.0, 1.0, 1.0, texture(texture, TexCoords).r);
+                vec4 color = vec4(1.0, 1.0, 1.0, texture(glyph, TexCoords).r);
                 FragColor = vec4(textColor, 1.0) * color;
             }
         )_";
-        mShader.loadShader(vertexShaderCode, fragmentShaderCode);
+        mShader.loadShader(vertexShaderCode, fragmentShaderCode, true, "text");
         init = true;
     }
 }
@@ -45,33 +46,65 @@ Text::Text() {
 }
 
 Text::~Text() {
+    if (mEvictor != 0) {
+        GpuMemory::instance().removeEvictor(mEvictor);
+    }
     mWordsMap.clear();
+    if (mFace != nullptr) {
+        FT_Done_Face(mFace);
+    }
+    if (mFreeType != nullptr) {
+        FT_Done_FreeType(mFreeType);
+    }
 }
 
-void Text::loadFaces(const wchar_t* text, int32_t length) {
-    FT_Library ft;
-    if (FT_Init_FreeType(&ft)) {
+bool Text::openFace() {
+    if (mFace != nullptr) {
+        return true;
+    }
+    if (mFreeType == nullptr && FT_Init_FreeType(&mFreeType)) {
         errorf("initialize freetype error");
-        return;
+        mFreeType = nullptr;
+        return false;
     }
-    FT_Face face;
-    std::string fft("font/Alibaba-PuHuiTi-Regular.ttf");
-
-    std::vector<char> fftData = readFileFromAssets(fft.c_str());
-    if (FT_New_Memory_Face(ft, (FT_Byte*)fftData.data(), fftData.size(), 0, &face)) {
+    mFontData = readFileFromAssets(FontAsset);
+    if (FT_New_Memory_Face(mFreeType, (FT_Byte*)mFontData.data(), mFontData.size(), 0, &mFace)) {
         errorf("FT_New_Memory_Face error");
-        return;
+        mFace = nullptr;
+        mFontData.clear();
+        return false;
     }
+    FT_Set_Pixel_Sizes(mFace, 96, 96);
+    FT_Select_Charmap(mFace, ft_encoding_unicode);
+    return true;
+}
 
-    FT_Set_Pixel_Sizes(face, 96, 96);
-    FT_Select_Charmap(face, ft_encoding_unicode);
+void Text::loadFaces(const wchar_t* text, int32_t length) {
+    std::wstring missing;
+    for (int32_t i = 0; i < length; ++i) {
+        if (mWordsMap.find(text[i]) == mWordsMap.end() && mUnavailable.count(text[i]) == 0) {
+            missing.push_back(text[i]);
+        }
+    }
+    uploadGlyphs(rasterizeGlyphs(missing.c_str(), (int32_t)missing.size()));
+    for (wchar_t ch : missing) {
+        if (mWordsMap.find(ch) == mWordsMap.end()) {
+            mUnavailable.insert(ch);
+        }
+    }
+}
 
-    GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+std::vector<Text::Glyph> Text::rasterizeGlyphs(const wchar_t* text, int32_t length) {
+    std::vector<Glyph> glyphs;
+    if (length == 0 || !openFace()) {
+        return glyphs;
+    }
+    FT_Face face = mFace;
 
     for (int32_t i = 0; i < length; ++i) {
         wchar_t ch = text[i];
-        auto it = mWordsMap.find(ch);
-        if (it != mWordsMap.end()) {
+        auto it = std::find_if(glyphs.begin(), glyphs.end(), [ch](const Glyph& glyph) { return glyph.ch == ch; });
+        if (it != glyphs.end()) {
             continue;
         }
 
@@ -88,61 +121,126 @@ void Text::loadFaces(const wchar_t* text, int32_t length) {
         FT_BitmapGlyph bitmap_glyph = (FT_BitmapGlyph)glyph;
         FT_Bitmap& bitmap = bitmap_glyph->bitmap;
 
-        GLuint texture;
-        GL_CALL(glGenTextures(1, &texture));
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, texture));
-        GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, bitmap.width, bitmap.rows, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, bitmap.buffer));
+        Glyph result;
+        result.ch = ch;
+        result.pixels.resize((size_t)bitmap.width * bitmap.rows);
+        for (uint32_t row = 0; row < bitmap.rows; ++row) {
+            memcpy(result.pixels.data() + row * bitmap.width, bitmap.buffer + row * bitmap.pitch, bitmap.width);
+        }
+        result.word = Word{0, face->glyph->bitmap.width, face->glyph->bitmap.rows, face->glyph->bitmap_left, face->glyph->bitmap_top, glyph->advance.x, 0};
+        glyphs.push_back(std::move(result));
+        FT_Done_Glyph(glyph);
+
+//        debugf("bitmap.width:%d, bitmap.rows:%d, bitmap_left:%d, bitmap_top:%d, advance.x:%d",
+//            face->glyph->bitmap.width, face->glyph->bitmap.rows, face->glyph->bitmap_left, face->glyph->bitmap_top, glyph->advance.x);
+    }
+    return glyphs;
+}
+
+void Text::uploadGlyphs(const std::vector<Glyph>& glyphs) {
+    GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    for (const Glyph& glyph : glyphs) {
+        if (mWordsMap.find(glyph.ch) != mWordsMap.end()) {
+            continue;
+        }
+        GlTexture& glyphTexture = mGlyphTextures[glyph.ch];
+        glyphTexture = GlTexture::generate();
+        const GLuint texture = glyphTexture.get();
+        GlState::instance().bindTexture(0, GL_TEXTURE_2D, texture);
+        GpuMemory::instance().texImage2D(GpuMemoryTag::Text, texture, GL_TEXTURE_2D, 0, GL_LUMINANCE, glyph.word.bitmap_width, glyph.word.bitmap_rows,
+                                         GL_LUMINANCE, GL_UNSIGNED_BYTE, glyph.pixels.data());
 
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
 
-        Word word{texture, face->glyph->bitmap.width, face->glyph->bitmap.rows, face->glyph->bitmap_left, face->glyph->bitmap_top, glyph->advance.x};
-        mWordsMap[ch] = word;
+        Word word = glyph.word;
+        word.textureId = texture;
+        word.lastUse = mGeneration;
+        mWordsMap[glyph.ch] = word;
+    }
+}
 
-//        debugf("bitmap.width:%d, bitmap.rows:%d, bitmap_left:%d, bitmap_top:%d, advance.x:%d",
-//            face->glyph->bitmap.width, face->glyph->bitmap.rows, face->glyph->bitmap_left, face->glyph->bitmap_top, glyph->advance.x);
+void Text::trimGlyphs(uint64_t bytes) {
+    // The glyphs of the last view are kept, the frame that drew them is still in flight.
+    std::vector<std::pair<uint32_t, int32_t>> candidates;
+    for (const auto& word : mWordsMap) {
+        if (word.second.lastUse != mGeneration) {
+            candidates.emplace_back(word.second.lastUse, word.first);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    uint64_t freed = 0;
+    for (const auto& candidate : candidates) {
+        if (freed >= bytes) {
+            break;
+        }
+        const Word& word = mWordsMap[candidate.second];
+        freed += static_cast<uint64_t>(word.bitmap_width) * word.bitmap_rows;
+        mWordsMap.erase(candidate.second);
+        mGlyphTextures.erase(candidate.second);
     }
-    GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+}
+
+bool Text::load() {
+    const wchar_t texts[] = L"-0123456789";
+    mPendingGlyphs = rasterizeGlyphs(texts, sizeof(texts) / sizeof(texts[0]) - 1);
+    return true;
 }
 
 bool Text::initialize() {
     initShader();
-    const wchar_t texts[] = L"-0123456789";
-    loadFaces(texts, sizeof(texts) / sizeof(texts[0]) - 1);
+    uploadGlyphs(mPendingGlyphs);
+    mPendingGlyphs.clear();
 
-    GL_CALL(glGenVertexArrays(1, &mVAO));
-    GL_CALL(glGenBuffers(1, &mVBO));
+    mVAO = GlVertexArray::generate();
+    mVBO = GlBuffer::generate();
 
-    GL_CALL(glBindVertexArray(mVAO));
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mVBO));
-    GL_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 5, nullptr, GL_DYNAMIC_DRAW));
+    GlState::instance().bindVertexArray(mVAO.get());
+    GlState::instance().bindBuffer(GL_ARRAY_BUFFER, mVBO.get());
+    GpuMemory::instance().bufferData(GpuMemoryTag::Text, mVBO.get(), GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 5 * MaxGlyphs, nullptr, GL_DYNAMIC_DRAW);
     GL_CALL(glEnableVertexAttribArray(0));
     GL_CALL(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), 0));
     GL_CALL(glEnableVertexAttribArray(1));
     GL_CALL(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(float))));
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, GL_NONE));
-    GL_CALL(glBindVertexArray(GL_NONE));
 
+    mEvictor = GpuMemory::instance().addEvictor(GpuMemoryTag::Text, [this](uint64_t bytes) { trimGlyphs(bytes); });
+    mReady = true;
     return true;
 }
 
-bool Text::render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m, const wchar_t* text, int32_t length, const glm::vec3& color) {
-    mShader.use();
-    mShader.setUniformMat4("projection", p);
-    mShader.setUniformMat4("view", v);
-    mShader.setUniformMat4("model", m);
-    mShader.setUniformVec3("textColor", color);
+bool Text::render(DrawList& drawList, const glm::mat4& m, const wchar_t* text, int32_t length, const glm::vec3& color) {
+    if (!mReady) {
+        return false;
+    }
+
+    GlState::instance().bindBuffer(GL_ARRAY_BUFFER, mVBO.get());
+    if (mGeneration != drawList.generation()) {
+        // The glyphs of the last view may still be read by the GPU, start on fresh storage instead of waiting for it.
+        GpuMemory::instance().bufferData(GpuMemoryTag::Text, mVBO.get(), GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 5 * MaxGlyphs, nullptr,
+                                         GL_DYNAMIC_DRAW);
+        mGeneration = drawList.generation();
+        mGlyphCount = 0;
+    }
 
-    GL_CALL(glBindVertexArray(mVAO));
+    DrawPacket packet;
+    packet.shader = &mShader;
+    packet.vertexArray = mVAO.get();
+    packet.blend = true;
+    packet.model = m;
+    packet.params[0] = glm::vec4(color, 1.0f);
+    packet.setUniforms = [](const Shader& shader, const DrawPacket& packet) {
+        shader.setUniformMat4("model", packet.model);
+        shader.setUniformVec3("textColor", glm::vec3(packet.params[0]));
+    };
+    packet.count = 6;
 
     float scale = 0.001f;
     float xpos = 0.0f;
     float ypos = 0.0f;
-    for (int32_t i = 0; i < length; ++i) {
+    for (int32_t i = 0; i < length && mGlyphCount < MaxGlyphs; ++i) {
         wchar_t ch = text[i];
         if (ch == L' ') {
             xpos += 60 * scale;
@@ -151,9 +249,12 @@ bool Text::render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m, co
         auto it = mWordsMap.find(ch);
         if (it == mWordsMap.end()) {
             loadFaces(text + i, length - i);
-            i--;
-            continue;
+            it = mWordsMap.find(ch);
+        }
+        if (it == mWordsMap.end()) {
+            continue;  // the font has no glyph for it
         } else {
+            it->second.lastUse = mGeneration;
             Word word = it->second;
 
             GLfloat w = word.bitmap_width * scale;
@@ -171,20 +272,16 @@ bool Text::render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m, co
                     { xpos + w, ypos + h, 0.0,   1.0, 0.0 }
             };
 
-            GL_CALL(glActiveTexture(GL_TEXTURE0));
-            GL_CALL(glBindTexture(GL_TEXTURE_2D, word.textureId));
-            //glUniform1i(m_SamplerLoc, 0);
-
-            GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mVBO));
-            GL_CALL(glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices));
-            GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
-            GL_CALL(glDrawArrays(GL_TRIANGLES, 0, 6));
+            // every glyph gets its own six vertices in the buffer, the draws run after all of them are written
+            GL_CALL(glBufferSubData(GL_ARRAY_BUFFER, sizeof(vertices) * mGlyphCount, sizeof(vertices), vertices));
+            packet.textures[0] = word.textureId;
+            packet.first = 6 * mGlyphCount;
+            drawList.submit(packet);
+            mGlyphCount++;
 
             xpos += w;
         }
     }
-    GL_CALL(glBindVertexArray(0));
-    GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
 
     return true;
 }
@@ -1,7 +1,10 @@
 #pragma once
 #include <vector>
 #include <map>
+#include <set>
 #include "shader.h"
+#include "drawList.h"
+#include "glResource.h"
 #include "ft2build.h"
 #include "freetype/freetype.h"
 #include "freetype/ftglyph.h"
@@ -13,20 +16,51 @@ typedef struct {
     FT_Int bitmap_left;
     FT_Int bitmap_top;
     long advance;
+    uint32_t lastUse;  // draw list generation
 }Word;
 
 class Text {
 public:
+    static constexpr const char* FontAsset = "font/Alibaba-PuHuiTi-Regular.ttf";
+
     Text();
     ~Text();
+    // Rasterizes the preloaded glyphs, touches no GL state so it can run on a worker thread.
+    bool load();
+    // Uploads what load() rasterized, on the GL thread. render() draws nothing until then.
     bool initialize();
-    bool render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m, const wchar_t* text, int32_t length, const glm::vec3& color);
+    // Submits a packet per glyph. At most MaxGlyphs glyphs per view, counted over all texts submitted to it.
+    bool render(DrawList& drawList, const glm::mat4& m, const wchar_t* text, int32_t length, const glm::vec3& color);
 private:
+    static constexpr uint32_t MaxGlyphs = 256;
+
     void initShader();
+    // Opens the font once, it stays open for the life of the Text: glyphs evicted under memory pressure come back
+    // without reading and parsing the font file again.
+    bool openFace();
     void loadFaces(const wchar_t* text, int32_t length);
+    struct Glyph {
+        wchar_t ch;
+        std::vector<uint8_t> pixels;  // bitmap_width x bitmap_rows, tightly packed
+        Word word;                    // textureId is filled in by uploadGlyphs
+    };
+    std::vector<Glyph> rasterizeGlyphs(const wchar_t* text, int32_t length);
+    void uploadGlyphs(const std::vector<Glyph>& glyphs);
+    // Evictor of the glyph cache: drops the least recently drawn glyphs, they are rasterized again when drawn next.
+    void trimGlyphs(uint64_t bytes);
 private:
     static Shader mShader;
     std::map<int32_t, Word> mWordsMap;
-    GLuint mVAO;
-    GLuint mVBO;
+    std::map<int32_t, GlTexture> mGlyphTextures;  // owns the textureId of every Word
+    std::set<wchar_t> mUnavailable;                 // characters that failed to rasterize, not tried again
+    std::vector<char> mFontData;                    // the face reads from it
+    FT_Library mFreeType = nullptr;
+    FT_Face mFace = nullptr;
+    GlVertexArray mVAO;
+    GlBuffer mVBO;
+    std::vector<Glyph> mPendingGlyphs;
+    bool mReady = false;
+    uint32_t mGeneration = 0;  // of the draw list the buffer holds the glyphs for
+    uint32_t mGlyphCount = 0;
+    uint32_t mEvictor = 0;
 };
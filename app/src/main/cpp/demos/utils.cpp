@@ -1,8 +1,10 @@
 #include "utils.h"
+#include "glState.h"
+#include "gpuMemory.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
-unsigned int TextureFromFile(const char* path, const std::string& directory, bool gamma) {
+unsigned int TextureFromFile(const char* path, const std::string& directory, GpuMemoryTag tag, bool gamma) {
     std::string filename = std::string(path);
     if (directory != "") {
         filename = directory + '/' + filename;
@@ -20,9 +22,9 @@ unsigned int TextureFromFile(const char* path, const std::string& directory, boo
         } else if (nrComponents == 4) {
             format = GL_RGBA;
         }
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        GlState::instance().bindTexture(0, GL_TEXTURE_2D, textureID);
+        GpuMemory::instance().texImage2D(tag, textureID, GL_TEXTURE_2D, 0, format, width, height, format, GL_UNSIGNED_BYTE, data);
+        GpuMemory::instance().generateMipmap(textureID, GL_TEXTURE_2D);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
@@ -56,6 +58,7 @@ bool copyFile(const char* src, const char* dst) {
     return true;
 }
 
+#ifdef XR_USE_PLATFORM_ANDROID
 #include <jni.h>
 #include <android/asset_manager_jni.h>
 #include <android/asset_manager.h>
@@ -77,47 +80,103 @@ void setJNIEnv(JNIEnv *env) {
     s_env = env;
 }
 
-unsigned int TextureFromFileAssets(const char* path, const std::string& directory, bool gamma) {
+JNIEnv* getJNIEnv() {
+    return s_env;
+}
+#else
+static std::string s_assetDirectory = ".";
+
+void setAssetDirectory(const std::string& directory) {
+    s_assetDirectory = directory;
+}
+
+static bool readAsset(const std::string& filename, std::vector<char>& buffer) {
+    FILE* file = fopen((s_assetDirectory + '/' + filename).c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    buffer.resize(ftell(file));
+    fseek(file, 0, SEEK_SET);
+    const bool complete = fread(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    fclose(file);
+    return complete;
+}
+#endif
+
+unsigned int TextureFromFileAssets(const char* path, const std::string& directory, GpuMemoryTag tag, bool gamma) {
+    DecodedImage image;
+    decodeImageFromAssets(path, directory, image);
+    return TextureFromImage(image, tag);
+}
+
+bool decodeImageFromAssets(const char* path, const std::string& directory, DecodedImage& image) {
     std::string filename = std::string(path);
     if (directory != "") {
         filename = directory + '/' + filename;
     }
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
 
     // read file from assets
+    int width, height, nrComponents;
+#ifdef XR_USE_PLATFORM_ANDROID
     AAsset *pathAsset = AAssetManager_open(s_nativeasset, filename.c_str(), AASSET_MODE_UNKNOWN);
+    if (pathAsset == nullptr) {
+        errorf("Texture failed to load at path: %s", path);
+        return false;
+    }
     off_t assetLength = AAsset_getLength(pathAsset);
     unsigned char *fileData = (unsigned char *) AAsset_getBuffer(pathAsset);
 
-    int width, height, nrComponents;
-    //unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
     unsigned char *data = stbi_load_from_memory(fileData, assetLength, &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1) {
-            format = GL_RED;
-        } else if (nrComponents == 3) {
-            format = GL_RGB;
-        } else if (nrComponents == 4) {
-            format = GL_RGBA;
-        }
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        stbi_image_free(data);
-    } else {
+    AAsset_close(pathAsset);
+#else
+    std::vector<char> fileData;
+    if (!readAsset(filename, fileData)) {
         errorf("Texture failed to load at path: %s", path);
+        return false;
     }
-    AAsset_close(pathAsset);
+    unsigned char *data = stbi_load_from_memory((unsigned char *) fileData.data(), fileData.size(), &width, &height, &nrComponents, 0);
+#endif
+    if (data == nullptr) {
+        errorf("Texture failed to load at path: %s", path);
+        return false;
+    }
+    image.pixels.assign(data, data + (size_t)width * height * nrComponents);
+    image.width = width;
+    image.height = height;
+    image.components = nrComponents;
+    stbi_image_free(data);
+    return true;
+}
+
+unsigned int TextureFromImage(const DecodedImage& image, GpuMemoryTag tag) {
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    if (image.pixels.empty()) {
+        return textureID;
+    }
+
+    GLenum format;
+    if (image.components == 1) {
+        format = GL_RED;
+    } else if (image.components == 3) {
+        format = GL_RGB;
+    } else {
+        format = GL_RGBA;
+    }
+    GlState::instance().bindTexture(0, GL_TEXTURE_2D, textureID);
+    GpuMemory::instance().texImage2D(tag, textureID, GL_TEXTURE_2D, 0, format, image.width, image.height, format, GL_UNSIGNED_BYTE,
+                                     image.pixels.data());
+    GpuMemory::instance().generateMipmap(textureID, GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     return textureID;
 }
 
 std::vector<char> readFileFromAssets(const char* filename) {
+#ifdef XR_USE_PLATFORM_ANDROID
     AAsset *pathAsset = AAssetManager_open(s_nativeasset, filename, AASSET_MODE_UNKNOWN);
     off_t assetLength = AAsset_getLength(pathAsset);
     unsigned char *fileData = (unsigned char *) AAsset_getBuffer(pathAsset);
@@ -125,4 +184,12 @@ std::vector<char> readFileFromAssets(const char* filename) {
     memcpy(buffer.data(), fileData, assetLength);
     AAsset_close(pathAsset);
     return buffer;
+#else
+    std::vector<char> buffer;
+    if (!readAsset(filename, buffer)) {
+        errorf("Asset failed to load at path: %s", filename);
+        buffer.clear();
+    }
+    return buffer;
+#endif
 }
@@ -3,12 +3,15 @@
 #include <vector>
 #include "common/gfxwrapper_opengl.h"
 #include "logger.h"
+#include "glValidation.h"
+#include "gpuMemory.h"
 
-#define OPENGL_DEBUG
-#ifdef OPENGL_DEBUG
-#define GL_CALL(_CALL)  do { _CALL; GLenum gl_err = glGetError(); if (gl_err != 0) Log::Write(Log::Level::Error,__FILE__,__LINE__,Fmt("GL error %d returned from '%s'", gl_err,#_CALL)); } while (0)
+// Checks the call with glGetError when GL validation is at level Call, see glValidation.h. Builds that do not start at
+// that level only make the call.
+#if GL_VALIDATION_DEFAULT >= 3
+#define GL_CALL(_CALL)  do { _CALL; if (GlValidation::instance().checksCalls()) GlValidation::instance().checkErrors(#_CALL, __FILE__, __LINE__); } while (0)
 #else
-#define GL_CALL(_CALL)
+#define GL_CALL(_CALL)  do { _CALL; } while (0)
 #endif
 
 #define errorf(...)   Log::Write(Log::Level::Error,   __FILE__, __LINE__, Fmt(__VA_ARGS__));
@@ -19,11 +22,27 @@
 
 
 bool copyFile(const char* src, const char* dst);
-unsigned int TextureFromFile(const char* path, const std::string& directory, bool gamma = false);
-unsigned int TextureFromFileAssets(const char* path, const std::string& directory, bool gamma = false);
+// The texture is charged to tag, see gpuMemory.h.
+unsigned int TextureFromFile(const char* path, const std::string& directory, GpuMemoryTag tag, bool gamma = false);
+unsigned int TextureFromFileAssets(const char* path, const std::string& directory, GpuMemoryTag tag, bool gamma = false);
+// Decoding touches no GL state and may run on any thread, the upload has to happen on the GL thread.
+struct DecodedImage {
+    std::vector<unsigned char> pixels;
+    int width = 0;
+    int height = 0;
+    int components = 0;
+};
+bool decodeImageFromAssets(const char* path, const std::string& directory, DecodedImage& image);
+unsigned int TextureFromImage(const DecodedImage& image, GpuMemoryTag tag);
 std::vector<char> readFileFromAssets(const char* file);
 void refreshMedia(const std::string& path);
+#ifdef XR_USE_PLATFORM_ANDROID
 void setJNIEnv(JNIEnv *env);
+JNIEnv* getJNIEnv();
+#else
+// Host builds (benchmarks/) have no asset manager, the assets are read from files under this directory.
+void setAssetDirectory(const std::string& directory);
+#endif
 
 
 #define HAND_LEFT  0
@@ -33,6 +52,7 @@ void setJNIEnv(JNIEnv *env);
 #define EYE_LEFT  0
 #define EYE_RIGHT 1
 #define EYE_COUNT 2
+#define EYE_BOTH  -1   // both eyes in one multiview pass
 
 #define GETSTR(str) #str
 
@@ -0,0 +1,66 @@
+#include "pch.h"
+#include "common.h"
+#include "frametiming.h"
+
+namespace {
+const char* const PhaseNames[FrameTiming::PhaseCount] = {"xrWaitFrame",   "xrBeginFrame",    "LocateSpaces",  "AppUpdate",
+                                                          "AcquireImages", "OffscreenPasses", "RenderView[0]", "RenderView[1]",
+                                                          "xrEndFrame",    "FrameCpu"};
+
+inline float ToMs(int64_t ns) { return ns / 1000000.0f; }
+}  // namespace
+
+void FrameTiming::BeginFrame() {
+    m_current = {};
+    m_frameStart = Clock::now();
+}
+
+void FrameTiming::Record(Phase phase, Clock::time_point start) {
+    Add(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+void FrameTiming::EndFrame(XrTime predictedDisplayTime, XrDuration predictedDisplayPeriod) {
+    // xrWaitFrame blocks for pacing by design, so it is not part of the frame's own cost.
+    const int64_t elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_frameStart).count();
+    m_current.phaseNs[FrameCpu] = elapsedNs - m_current.phaseNs[XrWaitFrame];
+
+    // A frame misses if its CPU work alone is longer than a display period, or if the runtime had to skip a refresh
+    // between the previous predicted display time and this one.
+    const bool skippedRefresh = m_lastDisplayTime != 0 && (predictedDisplayTime - m_lastDisplayTime) * 2 > predictedDisplayPeriod * 3;
+    m_current.missed = m_current.phaseNs[FrameCpu] > predictedDisplayPeriod || skippedRefresh;
+    m_lastDisplayTime = predictedDisplayTime;
+
+    m_samples[m_next] = m_current;
+    m_next = (m_next + 1) % Capacity;
+    m_count = std::min(m_count + 1, Capacity);
+
+    m_framesSinceReport++;
+    if (m_current.missed) {
+        m_missedSinceReport++;
+    }
+    if (m_framesSinceReport >= ReportInterval) {
+        Report();
+        m_framesSinceReport = 0;
+        m_missedSinceReport = 0;
+    }
+}
+
+void FrameTiming::Report() {
+    Log::Write(Log::Level::Info, Fmt("FrameTiming: %u of last %u frames missed the display period", m_missedSinceReport, m_framesSinceReport));
+
+    const auto percentile = [this](uint32_t p) {
+        int64_t* nth = m_scratch.data() + (m_count - 1) * p / 100;
+        std::nth_element(m_scratch.data(), nth, m_scratch.data() + m_count);
+        return *nth;
+    };
+
+    for (uint32_t phase = 0; phase < PhaseCount; phase++) {
+        for (uint32_t i = 0; i < m_count; i++) {
+            m_scratch[i] = m_samples[i].phaseNs[phase];
+        }
+        const int64_t p50 = percentile(50);
+        const int64_t p95 = percentile(95);
+        const int64_t p99 = percentile(99);
+        Log::Write(Log::Level::Info, Fmt("FrameTiming: %-15s p50=%6.2fms p95=%6.2fms p99=%6.2fms", PhaseNames[phase], ToMs(p50), ToMs(p95), ToMs(p99)));
+    }
+}
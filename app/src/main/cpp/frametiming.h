@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+
+// CPU timing of the OpenXR frame loop, broken down per phase.
+// Samples are kept in a fixed-size ring so recording a frame never allocates. Every ReportInterval frames the
+// p50/p95/p99 of each phase over the ring is logged, together with the number of frames that missed the display period.
+// The ring holds one interval, so every frame of an interval is in its percentiles and no frame is in two reports.
+class FrameTiming {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    enum Phase : uint32_t {
+        XrWaitFrame,
+        XrBeginFrame,
+        LocateSpaces,
+        AppUpdate,
+        AcquireImages,    // acquiring and waiting for the swapchain images
+        OffscreenPasses,  // executing the offscreen passes, e.g. the dashboard panel and the video import
+        RenderViewLeft,   // executing the eye passes; a multiview pass renders both eyes and counts as the left one
+        RenderViewRight,
+        XrEndFrame,
+        FrameCpu,  // everything but xrWaitFrame, i.e. the CPU work of the frame
+        PhaseCount
+    };
+
+    static constexpr uint32_t ReportInterval = 600;
+    static constexpr uint32_t Capacity = ReportInterval;
+
+    // Accumulates the time between construction and destruction into the given phase of the current frame.
+    class Scope {
+       public:
+        Scope(FrameTiming& timing, Phase phase) : m_timing(timing), m_phase(phase), m_start(Clock::now()) {}
+        ~Scope() { m_timing.Record(m_phase, m_start); }
+
+       private:
+        FrameTiming& m_timing;
+        Phase m_phase;
+        Clock::time_point m_start;
+    };
+
+    // Starts a new frame, must be called before xrWaitFrame.
+    void BeginFrame();
+
+    void Record(Phase phase, Clock::time_point start);
+    void Add(Phase phase, int64_t ns) { m_current.phaseNs[phase] += ns; }
+
+    // Closes the current frame after xrEndFrame and flags it if it missed the display period.
+    void EndFrame(XrTime predictedDisplayTime, XrDuration predictedDisplayPeriod);
+
+   private:
+    struct Sample {
+        std::array<int64_t, PhaseCount> phaseNs;
+        bool missed;
+    };
+
+    void Report();
+
+    std::array<Sample, Capacity> m_samples{};
+    std::array<int64_t, Capacity> m_scratch{};
+    Sample m_current{};
+    Clock::time_point m_frameStart;
+    XrTime m_lastDisplayTime{0};
+    uint32_t m_next{0};
+    uint32_t m_count{0};
+    uint32_t m_framesSinceReport{0};
+    uint32_t m_missedSinceReport{0};
+};
@@ -11,6 +11,10 @@ struct Cube {
 
 class IApplication;
 
+// Clip planes of the projection matrices, also reported to the runtime with submitted depth.
+constexpr float ProjectionNearZ = 0.05f;
+constexpr float ProjectionFarZ = 100.0f;
+
 // Wraps a graphics API so the main openxr program can be graphics API-independent.
 struct IGraphicsPlugin {
     virtual ~IGraphicsPlugin() = default;
@@ -24,6 +28,9 @@ struct IGraphicsPlugin {
     // Select the preferred swapchain format from the list of available formats.
     virtual int64_t SelectColorSwapchainFormat(const std::vector<int64_t>& runtimeFormats) const = 0;
 
+    // Select the preferred depth swapchain format from the list of available formats, -1 if none can be used.
+    virtual int64_t SelectDepthSwapchainFormat(const std::vector<int64_t>& /*runtimeFormats*/) const { return -1; }
+
     // Get the graphics binding header for session creation.
     virtual const XrBaseInStructure* GetGraphicsBinding() const = 0;
 
@@ -32,9 +39,42 @@ struct IGraphicsPlugin {
     virtual std::vector<XrSwapchainImageBaseHeader*> AllocateSwapchainImageStructs(
         uint32_t capacity, const XrSwapchainCreateInfo& swapchainCreateInfo) = 0;
 
-    // Render to a swapchain image for a projection view.
+    // Create whatever rendering to the images of a projection swapchain needs, once, right after the swapchain is
+    // created. depthImages are the images of its depth swapchain, empty when depth is not submitted.
+    virtual void CreateSwapchainTargets(const XrSwapchainCreateInfo& /*swapchainCreateInfo*/,
+                                        const std::vector<XrSwapchainImageBaseHeader*>& /*colorImages*/,
+                                        const std::vector<XrSwapchainImageBaseHeader*>& /*depthImages*/) {}
+
+    // Record the pass that renders to a swapchain image for a projection view, it runs in RenderPasses.
+    // depthSwapchainImage is the matching depth swapchain image, or nullptr when depth is not submitted and the plugin
+    // provides its own depth buffer.
     virtual void RenderView(std::shared_ptr<IApplication>& application, const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
-                            int64_t swapchainFormat, const int32_t eye) = 0;
+                            const XrSwapchainImageBaseHeader* depthSwapchainImage, int64_t swapchainFormat, const int32_t eye) = 0;
+
+    // Whether both views of a stereo pair can be rendered in a single pass into a two-layer array swapchain.
+    virtual bool SupportsMultiview() const { return false; }
+
+    // Record one pass that renders both projection views, view i goes to array layer i of the swapchain image.
+    // Only called when SupportsMultiview() returns true.
+    virtual void RenderMultiView(std::shared_ptr<IApplication>& application, const std::vector<XrCompositionLayerProjectionView>& layerViews,
+                                 const XrSwapchainImageBaseHeader* swapchainImage, const XrSwapchainImageBaseHeader* depthSwapchainImage,
+                                 int64_t swapchainFormat) = 0;
+
+    // CPU time RenderPasses spent in the passes, by kind. Eye passes count in the order they ran, i.e. left then right;
+    // a multiview pass is one pass and counts as the left eye's.
+    struct PassTimes {
+        int64_t offscreenNs = 0;
+        int64_t eyeNs[2] = {0, 0};
+    };
+
+    // Execute the passes recorded since BeginGpuFrame, while the swapchain images they render to are acquired.
+    virtual PassTimes RenderPasses() { return {}; }
+
+    // Bracket the GPU work of one frame. The measured time becomes available a few frames later through
+    // GetGpuFrameTime, which returns false while no result is ready or when the API cannot measure it.
+    virtual void BeginGpuFrame() {}
+    virtual void EndGpuFrame() {}
+    virtual bool GetGpuFrameTime(int64_t& /*gpuFrameNs*/) { return false; }
 
     // Get recommended number of sub-data element samples in view (recommendedSwapchainSampleCount)
     // if supported by the graphics plugin. A supported value otherwise.
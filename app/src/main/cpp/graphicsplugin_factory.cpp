@@ -14,6 +14,8 @@
 #ifdef XR_USE_GRAPHICS_API_OPENGL_ES
 std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin_OpenGLES(const std::shared_ptr<Options>& options,
                                                                std::shared_ptr<IPlatformPlugin> platformPlugin);
+std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin_Headless(const std::shared_ptr<Options>& options,
+                                                               std::shared_ptr<IPlatformPlugin> platformPlugin);
 #endif
 #ifdef XR_USE_GRAPHICS_API_OPENGL
 std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin_OpenGL(const std::shared_ptr<Options>& options,
@@ -45,6 +47,10 @@ std::map<std::string, GraphicsPluginFactory, IgnoreCaseStringLess> graphicsPlugi
      [](const std::shared_ptr<Options>& options, std::shared_ptr<IPlatformPlugin> platformPlugin) {
          return CreateGraphicsPlugin_OpenGLES(options, std::move(platformPlugin));
      }},
+    {"Headless",
+     [](const std::shared_ptr<Options>& options, std::shared_ptr<IPlatformPlugin> platformPlugin) {
+         return CreateGraphicsPlugin_Headless(options, std::move(platformPlugin));
+     }},
 #endif
 #ifdef XR_USE_GRAPHICS_API_OPENGL
     {"OpenGL",
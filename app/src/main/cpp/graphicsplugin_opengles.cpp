@@ -5,64 +5,93 @@
 #include "pch.h"
 #include "common.h"
 #include "geometry.h"
+#include "options.h"
 #include "graphicsplugin.h"
 
 #define XR_USE_GRAPHICS_API_OPENGL_ES 1
 #ifdef XR_USE_GRAPHICS_API_OPENGL_ES
 
 #include "common/gfxwrapper_opengl.h"
+#include <EGL/eglext.h>
 #include <common/xr_linear.h>
 #include "demos/controller.h"
 #include "demos/application.h"
+#include "demos/shader.h"
+#include "demos/gpuProfiler.h"
+#include "demos/glState.h"
+#include "demos/glResource.h"
+#include "demos/gpuMemory.h"
+#include "demos/glValidation.h"
+#include "demos/renderGraph.h"
+#include "demos/utils.h"
 
 namespace {
 
 struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
-    OpenGLESGraphicsPlugin(const std::shared_ptr<Options>& /*unused*/, const std::shared_ptr<IPlatformPlugin> /*unused*/&){};
+    OpenGLESGraphicsPlugin(const std::shared_ptr<Options>& options, const std::shared_ptr<IPlatformPlugin> /*unused*/&, bool headless)
+        : m_headless(headless), m_multiviewRequested(options->Multiview), m_depth16(options->Depth16) {
+        m_glValidation = static_cast<GlValidation::Level>(GL_VALIDATION_DEFAULT);
+        if (!options->GlValidation.empty() && !GlValidation::parse(options->GlValidation, m_glValidation)) {
+            Log::Write(Log::Level::Warning, Fmt("Unknown GL validation level %s, using %s", options->GlValidation.c_str(), GlValidation::name(m_glValidation)));
+        }
+        GpuMemory::instance().setBudget(static_cast<uint64_t>(options->GpuMemoryBudgetMB) << 20);
+    };
     OpenGLESGraphicsPlugin(const OpenGLESGraphicsPlugin&) = delete;
     OpenGLESGraphicsPlugin& operator=(const OpenGLESGraphicsPlugin&) = delete;
     OpenGLESGraphicsPlugin(OpenGLESGraphicsPlugin&&) = delete;
     OpenGLESGraphicsPlugin& operator=(OpenGLESGraphicsPlugin&&) = delete;
     ~OpenGLESGraphicsPlugin() override {
-        if (m_swapchainFramebuffer != 0) {
-            glDeleteFramebuffers(1, &m_swapchainFramebuffer);
-        }
-        for (auto& colorToDepth : m_colorToDepthMap) {
-            if (colorToDepth.second != 0) {
-                glDeleteTextures(1, &colorToDepth.second);
+        // The application, which holds on to the plugin, has retired its objects already.
+        m_swapchainTargets.clear();
+        m_viewBlockBuffer.reset();
+        GlDeletionQueue::instance().shutdown();
+        GpuProfiler::instance().shutdown();
+        if (m_eglDisplay != EGL_NO_DISPLAY) {
+            eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (m_eglSurface != EGL_NO_SURFACE) {
+                eglDestroySurface(m_eglDisplay, m_eglSurface);
+            }
+            if (m_eglContext != EGL_NO_CONTEXT) {
+                eglDestroyContext(m_eglDisplay, m_eglContext);
             }
+            eglTerminate(m_eglDisplay);
         }
     }
 
-    std::vector<std::string> GetInstanceExtensions() const override { return {XR_KHR_OPENGL_ES_ENABLE_EXTENSION_NAME}; }
+    std::vector<std::string> GetInstanceExtensions() const override {
+#if !defined(XR_USE_PLATFORM_ANDROID) && defined(XR_USE_PLATFORM_EGL)
+        if (m_headless) {
+            return {XR_KHR_OPENGL_ES_ENABLE_EXTENSION_NAME, XR_MNDX_EGL_ENABLE_EXTENSION_NAME};
+        }
+#endif
+        return {XR_KHR_OPENGL_ES_ENABLE_EXTENSION_NAME};
+    }
 
     ksGpuWindow window{};
 
-    void DebugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message) {
-        (void)source;
-        (void)type;
-        (void)id;
-        (void)severity;
-        //Log::Write(Log::Level::Info, "GLES Debug: " + std::string(message, 0, length));
-    }
-
+    // Without an instance there is no runtime to ask, the headless plugin then renders into OffscreenViews.
     void InitializeDevice(XrInstance instance, XrSystemId systemId) override {
-        // Extension function must be loaded by name
-        PFN_xrGetOpenGLESGraphicsRequirementsKHR pfnGetOpenGLESGraphicsRequirementsKHR = nullptr;
-        CHECK_XRCMD(xrGetInstanceProcAddr(instance, "xrGetOpenGLESGraphicsRequirementsKHR",
-                                          reinterpret_cast<PFN_xrVoidFunction*>(&pfnGetOpenGLESGraphicsRequirementsKHR)));
-
         XrGraphicsRequirementsOpenGLESKHR graphicsRequirements{XR_TYPE_GRAPHICS_REQUIREMENTS_OPENGL_ES_KHR};
-        CHECK_XRCMD(pfnGetOpenGLESGraphicsRequirementsKHR(instance, systemId, &graphicsRequirements));
+        if (instance != XR_NULL_HANDLE) {
+            // Extension function must be loaded by name
+            PFN_xrGetOpenGLESGraphicsRequirementsKHR pfnGetOpenGLESGraphicsRequirementsKHR = nullptr;
+            CHECK_XRCMD(xrGetInstanceProcAddr(instance, "xrGetOpenGLESGraphicsRequirementsKHR",
+                                              reinterpret_cast<PFN_xrVoidFunction*>(&pfnGetOpenGLESGraphicsRequirementsKHR)));
+            CHECK_XRCMD(pfnGetOpenGLESGraphicsRequirementsKHR(instance, systemId, &graphicsRequirements));
+        }
 
-        // Initialize the gl extensions. Note we have to open a window.
-        ksDriverInstance driverInstance{};
-        ksGpuQueueInfo queueInfo{};
-        ksGpuSurfaceColorFormat colorFormat{KS_GPU_SURFACE_COLOR_FORMAT_B8G8R8A8};
-        ksGpuSurfaceDepthFormat depthFormat{KS_GPU_SURFACE_DEPTH_FORMAT_D24};
-        ksGpuSampleCount sampleCount{KS_GPU_SAMPLE_COUNT_1};
-        if (!ksGpuWindow_Create(&window, &driverInstance, &queueInfo, 0, colorFormat, depthFormat, sampleCount, 640, 480, false)) {
-            THROW("Unable to create GL context");
+        if (m_headless) {
+            CreateHeadlessContext();
+        } else {
+            // Initialize the gl extensions. Note we have to open a window.
+            ksDriverInstance driverInstance{};
+            ksGpuQueueInfo queueInfo{};
+            ksGpuSurfaceColorFormat colorFormat{KS_GPU_SURFACE_COLOR_FORMAT_B8G8R8A8};
+            ksGpuSurfaceDepthFormat depthFormat{KS_GPU_SURFACE_DEPTH_FORMAT_D24};
+            ksGpuSampleCount sampleCount{KS_GPU_SAMPLE_COUNT_1};
+            if (!ksGpuWindow_Create(&window, &driverInstance, &queueInfo, 0, colorFormat, depthFormat, sampleCount, 640, 480, false)) {
+                THROW("Unable to create GL context");
+            }
         }
 
         GLint major = 0;
@@ -76,26 +105,140 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         }
 
 #if defined(XR_USE_PLATFORM_ANDROID)
-        m_graphicsBinding.display = window.display;
-        m_graphicsBinding.config = (EGLConfig)0;
-        m_graphicsBinding.context = window.context.context;
+        m_graphicsBinding.display = m_headless ? m_eglDisplay : window.display;
+        m_graphicsBinding.config = m_headless ? m_eglConfig : (EGLConfig)0;
+        m_graphicsBinding.context = m_headless ? m_eglContext : window.context.context;
+#elif defined(XR_USE_PLATFORM_EGL)
+        m_graphicsBinding.type = XR_TYPE_GRAPHICS_BINDING_EGL_MNDX;
+        m_graphicsBinding.getProcAddress = reinterpret_cast<PFN_xrEglGetProcAddressMNDX>(eglGetProcAddress);
+        m_graphicsBinding.display = m_eglDisplay;
+        m_graphicsBinding.config = m_eglConfig;
+        m_graphicsBinding.context = m_eglContext;
 #endif
 
-        glEnable(GL_DEBUG_OUTPUT);
-        glDebugMessageCallback(
-            [](GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message,
-               const void* userParam) {
-                ((OpenGLESGraphicsPlugin*)userParam)->DebugMessageCallback(source, type, id, severity, length, message);
-            },
-            this);
+        GlValidation::instance().setLevel(m_glValidation);
+
+        // Shaders are compiled for one stereo mode, so it has to be settled before the application initializes.
+        m_multiview = m_multiviewRequested && HasExtension("GL_OVR_multiview2") && glFramebufferTextureMultiviewOVR != nullptr;
+        Shader::setMultiview(m_multiview);
+        Log::Write(Log::Level::Info, Fmt("Stereo rendering: %s", m_multiview ? "multiview" : "per eye"));
+
+        GpuProfiler::instance().initialize(HasExtension("GL_EXT_disjoint_timer_query"));
+        // Nothing of the new context is known yet.
+        GlState::instance().invalidate();
 
         InitializeResources();
     }
 
+    // A GL ES 3.2 context without a window. It is created on Mesa's software device when there is one, which is
+    // llvmpipe: every build server then renders the same pixels, GPU or not. Otherwise it uses the surfaceless platform
+    // or the default display. A context that cannot be current without a surface gets a 16x16 pbuffer; the eye passes
+    // render into framebuffers of their own either way.
+    void CreateHeadlessContext() {
+        m_eglDisplay = GetHeadlessDisplay();
+        EGLint eglMajor = 0;
+        EGLint eglMinor = 0;
+        if (m_eglDisplay == EGL_NO_DISPLAY || !eglInitialize(m_eglDisplay, &eglMajor, &eglMinor)) {
+            THROW(Fmt("No EGL display for a headless context: 0x%x", eglGetError()));
+        }
+        eglBindAPI(EGL_OPENGL_ES_API);
+
+        const EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR, EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                                           EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8, EGL_NONE};
+        EGLint configCount = 0;
+        if (!eglChooseConfig(m_eglDisplay, configAttributes, &m_eglConfig, 1, &configCount) || configCount == 0) {
+            THROW("No EGL config for a headless GL ES 3 context");
+        }
+        const EGLint contextAttributes[] = {EGL_CONTEXT_MAJOR_VERSION_KHR, 3, EGL_CONTEXT_MINOR_VERSION_KHR, 2, EGL_NONE};
+        m_eglContext = eglCreateContext(m_eglDisplay, m_eglConfig, EGL_NO_CONTEXT, contextAttributes);
+        if (m_eglContext == EGL_NO_CONTEXT) {
+            THROW(Fmt("Unable to create a headless GL ES 3.2 context: 0x%x", eglGetError()));
+        }
+        if (!HasToken(eglQueryString(m_eglDisplay, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context")) {
+            const EGLint pbufferAttributes[] = {EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE};
+            m_eglSurface = eglCreatePbufferSurface(m_eglDisplay, m_eglConfig, pbufferAttributes);
+        }
+        if (!eglMakeCurrent(m_eglDisplay, m_eglSurface, m_eglSurface, m_eglContext)) {
+            THROW(Fmt("Unable to make the headless context current: 0x%x", eglGetError()));
+        }
+#if defined(OS_ANDROID)
+        GlInitExtensions();
+#endif
+        Log::Write(Log::Level::Info, Fmt("Headless context: EGL %d.%d, %s, %s", eglMajor, eglMinor, glGetString(GL_RENDERER),
+                                         m_eglSurface == EGL_NO_SURFACE ? "surfaceless" : "pbuffer"));
+    }
+
+    static EGLDisplay GetHeadlessDisplay() {
+        // Client extensions are only there with EGL_EXT_client_extensions, the query returns null otherwise.
+        const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        const auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (clientExtensions == nullptr || getPlatformDisplay == nullptr) {
+            return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+
+        const auto queryDevices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+        const auto queryDeviceString = reinterpret_cast<PFNEGLQUERYDEVICESTRINGEXTPROC>(eglGetProcAddress("eglQueryDeviceStringEXT"));
+        if (HasToken(clientExtensions, "EGL_EXT_platform_device") && queryDevices != nullptr && queryDeviceString != nullptr) {
+            EGLDeviceEXT devices[8];
+            EGLint deviceCount = 0;
+            if (queryDevices(8, devices, &deviceCount)) {
+                for (EGLint i = 0; i < deviceCount; i++) {
+                    if (HasToken(queryDeviceString(devices[i], EGL_EXTENSIONS), "EGL_MESA_device_software")) {
+                        return getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[i], nullptr);
+                    }
+                }
+            }
+        }
+        if (HasToken(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+            return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    // Whether the space separated list holds the token, false for a null list.
+    static bool HasToken(const char* list, const char* token) {
+        const size_t length = strlen(token);
+        for (const char* it = list; it != nullptr && (it = strstr(it, token)) != nullptr; it += length) {
+            if ((it == list || it[-1] == ' ') && (it[length] == ' ' || it[length] == '\0')) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool HasExtension(const char* extension) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++) {
+            if (strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), extension) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     void InitializeResources() {
-        glGenFramebuffers(1, &m_swapchainFramebuffer);
+        m_viewBlockBuffer = GlBuffer::generate();
+        GlState::instance().bindBuffer(GL_UNIFORM_BUFFER, m_viewBlockBuffer.get());
+        GpuMemory::instance().bufferData(GpuMemoryTag::Frame, m_viewBlockBuffer.get(), GL_UNIFORM_BUFFER, sizeof(ViewBlock), nullptr, GL_DYNAMIC_DRAW);
     }
 
+    bool SupportsMultiview() const override { return m_multiview; }
+
+    void BeginGpuFrame() override {
+        GlState::instance().beginFrame();
+        GpuProfiler::instance().beginFrame();
+        RenderGraph::instance().beginFrame();
+    }
+
+    void EndGpuFrame() override {
+        GpuProfiler::instance().endFrame();
+        GpuMemory::instance().endFrame();
+        GlDeletionQueue::instance().endFrame();
+    }
+
+    bool GetGpuFrameTime(int64_t& gpuFrameNs) override { return GpuProfiler::instance().getFrameTime(gpuFrameNs); }
+
     int64_t SelectColorSwapchainFormat(const std::vector<int64_t>& runtimeFormats) const override {
         // List of supported color swapchain formats.
         constexpr int64_t SupportedColorSwapchainFormats[] = {
@@ -112,6 +255,28 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         return *swapchainFormatIt;
     }
 
+    int64_t SelectDepthSwapchainFormat(const std::vector<int64_t>& runtimeFormats) const override {
+        // List of supported depth swapchain formats in order of preference, the same as the private depth buffer first.
+        // Stencil is never used, a format without it is preferred.
+        constexpr int64_t SupportedDepthSwapchainFormats[] = {
+            GL_DEPTH_COMPONENT24,
+            GL_DEPTH_COMPONENT16,
+            GL_DEPTH24_STENCIL8,
+            GL_DEPTH_COMPONENT32F,
+        };
+        constexpr int64_t SupportedDepth16SwapchainFormats[] = {
+            GL_DEPTH_COMPONENT16,
+            GL_DEPTH_COMPONENT24,
+            GL_DEPTH24_STENCIL8,
+            GL_DEPTH_COMPONENT32F,
+        };
+
+        const int64_t* formats = m_depth16 ? std::begin(SupportedDepth16SwapchainFormats) : std::begin(SupportedDepthSwapchainFormats);
+        const int64_t* formatsEnd = m_depth16 ? std::end(SupportedDepth16SwapchainFormats) : std::end(SupportedDepthSwapchainFormats);
+        auto swapchainFormatIt = std::find_first_of(formats, formatsEnd, runtimeFormats.begin(), runtimeFormats.end());
+        return swapchainFormatIt == formatsEnd ? -1 : *swapchainFormatIt;
+    }
+
     const XrBaseInStructure* GetGraphicsBinding() const override {
         return reinterpret_cast<const XrBaseInStructure*>(&m_graphicsBinding);
     }
@@ -130,83 +295,180 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         return swapchainImageBase;
     }
 
-    uint32_t GetDepthTexture(uint32_t colorTexture) {
-        // If a depth-stencil view has already been created for this back-buffer, use it.
-        auto depthBufferIt = m_colorToDepthMap.find(colorTexture);
-        if (depthBufferIt != m_colorToDepthMap.end()) {
-            return depthBufferIt->second;
-        }
-
-        // This back-buffer has no corresponding depth-stencil texture, so create one with matching dimensions.
-        GLint width;
-        GLint height;
-        glBindTexture(GL_TEXTURE_2D, colorTexture);
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
-
-        uint32_t depthTexture;
-        glGenTextures(1, &depthTexture);
-        glBindTexture(GL_TEXTURE_2D, depthTexture);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
-
-        m_colorToDepthMap.insert(std::make_pair(colorTexture, depthTexture));
+    // One framebuffer per swapchain image with its attachments in place, so an eye pass only binds it. Without a depth
+    // swapchain each image gets a private depth texture, D16 or D24; it is cleared and invalidated by every eye pass
+    // and never leaves the tile memory on a tiler. With one, image i is paired with depth image i: the runtime hands
+    // them out in step, and should it not, the eye pass attaches the depth image it got.
+    void CreateSwapchainTargets(const XrSwapchainCreateInfo& swapchainCreateInfo, const std::vector<XrSwapchainImageBaseHeader*>& colorImages,
+                                const std::vector<XrSwapchainImageBaseHeader*>& depthImages) override {
+        const uint32_t layers = swapchainCreateInfo.arraySize;
+        const GLenum target = layers > 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+        for (size_t i = 0; i < colorImages.size(); i++) {
+            SwapchainTarget swapchainTarget;
+            const uint32_t colorTexture = reinterpret_cast<const XrSwapchainImageOpenGLESKHR*>(colorImages[i])->image;
+            uint32_t depthTexture;
+            if (i < depthImages.size()) {
+                depthTexture = reinterpret_cast<const XrSwapchainImageOpenGLESKHR*>(depthImages[i])->image;
+            } else {
+                const GLenum depthFormat = m_depth16 ? GL_DEPTH_COMPONENT16 : GL_DEPTH_COMPONENT24;
+                swapchainTarget.depthTexture = GlTexture::generate();
+                GlState::instance().bindTexture(0, target, swapchainTarget.depthTexture.get());
+                GL_CALL(glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+                GL_CALL(glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+                GL_CALL(glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+                GL_CALL(glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+                if (layers > 1) {
+                    GpuMemory::instance().texStorage3D(GpuMemoryTag::Frame, swapchainTarget.depthTexture.get(), target, 1, depthFormat,
+                                                       swapchainCreateInfo.width, swapchainCreateInfo.height, layers);
+                } else {
+                    GpuMemory::instance().texStorage2D(GpuMemoryTag::Frame, swapchainTarget.depthTexture.get(), target, 1, depthFormat,
+                                                       swapchainCreateInfo.width, swapchainCreateInfo.height);
+                }
+                depthTexture = swapchainTarget.depthTexture.get();
+            }
 
-        return depthTexture;
+            swapchainTarget.framebuffer = GlFramebuffer::generate();
+            const RenderGraph::Attachment color{colorTexture, layers};
+            const RenderGraph::Attachment depth{depthTexture, layers};
+            if (!RenderGraph::instance().prepareFramebuffer(swapchainTarget.framebuffer.get(), color, depth)) {
+                THROW("Swapchain framebuffer is incomplete");
+            }
+            m_swapchainTargets.insert(std::make_pair(colorTexture, std::move(swapchainTarget)));
+        }
+        Log::Write(Log::Level::Info, Fmt("Created %zu swapchain framebuffers, depth: %s", colorImages.size(),
+                                         !depthImages.empty() ? "swapchain" : m_depth16 ? "private D16" : "private D24"));
     }
 
     void RenderView(std::shared_ptr<IApplication>& application, const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
-                    int64_t swapchainFormat, const int32_t eye) override {
-
+                    const XrSwapchainImageBaseHeader* depthSwapchainImage, int64_t /*swapchainFormat*/, const int32_t eye) override {
         const uint32_t colorTexture = reinterpret_cast<const XrSwapchainImageOpenGLESKHR*>(swapchainImage)->image;
+        const RenderGraph::Target target = GetSwapchainTarget(layerView.subImage.imageRect, colorTexture, depthSwapchainImage, 1);
+
+        ViewBlock viewBlock{};
+        viewBlock.viewIndex = static_cast<uint32_t>(eye);
+        GetViewMatrices(layerView, viewBlock.projection[eye], viewBlock.view[eye]);
+        const XrVector3f& position = layerView.pose.position;
+        const glm::vec3 viewPosition(position.x, position.y, position.z);
+
+        RenderGraph::instance().addPass(eye == EYE_LEFT ? "RenderView[0]" : "RenderView[1]", RenderGraph::Kind::Eye, target,
+                                        [this, application, viewBlock, eye, viewPosition]() {
+                                            UploadViewBlock(viewBlock);
+                                            application->renderFrame(eye, viewPosition);
+                                        });
+    }
 
-        glBindFramebuffer(GL_FRAMEBUFFER, m_swapchainFramebuffer);
-        
-        glViewport(static_cast<GLint>(layerView.subImage.imageRect.offset.x),
-                   static_cast<GLint>(layerView.subImage.imageRect.offset.y),
-                   static_cast<GLsizei>(layerView.subImage.imageRect.extent.width),
-                   static_cast<GLsizei>(layerView.subImage.imageRect.extent.height));
+    void RenderMultiView(std::shared_ptr<IApplication>& application, const std::vector<XrCompositionLayerProjectionView>& layerViews,
+                         const XrSwapchainImageBaseHeader* swapchainImage, const XrSwapchainImageBaseHeader* depthSwapchainImage,
+                         int64_t /*swapchainFormat*/) override {
+        CHECK(m_multiview && layerViews.size() == EYE_COUNT);
 
-        const uint32_t depthTexture = GetDepthTexture(colorTexture);
+        const uint32_t colorTexture = reinterpret_cast<const XrSwapchainImageOpenGLESKHR*>(swapchainImage)->image;
+        // Both views share the image rect, they only differ in the array layer.
+        const RenderGraph::Target target = GetSwapchainTarget(layerViews[0].subImage.imageRect, colorTexture, depthSwapchainImage, EYE_COUNT);
+
+        ViewBlock viewBlock{};
+        // One draw order serves both eyes, sorted from between them.
+        glm::vec3 viewPosition(0.0f);
+        for (int32_t eye = 0; eye < EYE_COUNT; eye++) {
+            GetViewMatrices(layerViews[eye], viewBlock.projection[eye], viewBlock.view[eye]);
+            const XrVector3f& position = layerViews[eye].pose.position;
+            viewPosition += glm::vec3(position.x, position.y, position.z) / static_cast<float>(EYE_COUNT);
+        }
 
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+        RenderGraph::instance().addPass("RenderMultiView", RenderGraph::Kind::Eye, target, [this, application, viewBlock, viewPosition]() {
+            UploadViewBlock(viewBlock);
+            application->renderFrame(EYE_BOTH, viewPosition);
+        });
+    }
 
-        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    PassTimes RenderPasses() override {
+        RenderGraph& renderGraph = RenderGraph::instance();
+        renderGraph.execute();
+        const RenderGraph::Timing& timing = renderGraph.lastTiming();
+        PassTimes passTimes;
+        passTimes.offscreenNs = timing.offscreenNs;
+        passTimes.eyeNs[0] = timing.eyeNs[0];
+        passTimes.eyeNs[1] = timing.eyeNs[1];
+        return passTimes;
+    }
+
+    // The eye passes clear everything they render into. Depth the runtime does not receive is never stored, depth it
+    // does receive is, the runtime reprojects with it.
+    RenderGraph::Target GetSwapchainTarget(const XrRect2Di& imageRect, uint32_t colorTexture, const XrSwapchainImageBaseHeader* depthSwapchainImage,
+                                           uint32_t layers) const {
+        auto swapchainTargetIt = m_swapchainTargets.find(colorTexture);
+        CHECK(swapchainTargetIt != m_swapchainTargets.end());
+        const SwapchainTarget& swapchainTarget = swapchainTargetIt->second;
+
+        RenderGraph::Target target;
+        target.framebuffer = swapchainTarget.framebuffer.get();
+        target.color = {colorTexture, layers, RenderGraph::Load::Clear, RenderGraph::Store::Store};
+        if (depthSwapchainImage != nullptr) {
+            const uint32_t depthTexture = reinterpret_cast<const XrSwapchainImageOpenGLESKHR*>(depthSwapchainImage)->image;
+            target.depth = {depthTexture, layers, RenderGraph::Load::Clear, RenderGraph::Store::Store};
+        } else {
+            target.depth = {swapchainTarget.depthTexture.get(), layers, RenderGraph::Load::Clear, RenderGraph::Store::DontCare};
+        }
+        target.x = imageRect.offset.x;
+        target.y = imageRect.offset.y;
+        target.width = imageRect.extent.width;
+        target.height = imageRect.extent.height;
+        return target;
+    }
 
+    static void GetViewMatrices(const XrCompositionLayerProjectionView& layerView, glm::mat4& p, glm::mat4& v) {
         const auto& eyePose = layerView.pose;
         XrMatrix4x4f projection{};
         XrMatrix4x4f view{};
         XrMatrix4x4f toView{};
         XrVector3f scale{1.0f, 1.0f, 1.0f};
-        XrMatrix4x4f_CreateProjectionFov(&projection, GRAPHICS_OPENGL_ES, layerView.fov, 0.05f, 100.0f);
+        XrMatrix4x4f_CreateProjectionFov(&projection, GRAPHICS_OPENGL_ES, layerView.fov, ProjectionNearZ, ProjectionFarZ);
         XrMatrix4x4f_CreateTranslationRotationScale(&toView, &eyePose.position, &eyePose.orientation, &scale);
         XrMatrix4x4f_InvertRigidBody(&view, &toView);
 
-        glm::mat4 p = glm::make_mat4((float*)&projection);
-        glm::mat4 v = glm::make_mat4((float*)&view);
-
-        application->renderFrame(eyePose, p, v, eye);
+        p = glm::make_mat4((float*)&projection);
+        v = glm::make_mat4((float*)&view);
+    }
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    void UploadViewBlock(const ViewBlock& viewBlock) {
+        GlState& glState = GlState::instance();
+        glState.bindBuffer(GL_UNIFORM_BUFFER, m_viewBlockBuffer.get());
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ViewBlock), &viewBlock);
+        glState.bindBufferBase(GL_UNIFORM_BUFFER, VIEW_BLOCK_BINDING, m_viewBlockBuffer.get());
     }
 
    private:
 #ifdef XR_USE_PLATFORM_ANDROID
     XrGraphicsBindingOpenGLESAndroidKHR m_graphicsBinding{XR_TYPE_GRAPHICS_BINDING_OPENGL_ES_ANDROID_KHR};
+#elif defined(XR_USE_PLATFORM_EGL)
+    XrGraphicsBindingEGLMNDX m_graphicsBinding{};
 #endif
+    bool m_headless{false};
+    // The context of the headless plugin, the windowed one lives in window.
+    EGLDisplay m_eglDisplay{EGL_NO_DISPLAY};
+    EGLConfig m_eglConfig{nullptr};
+    EGLContext m_eglContext{EGL_NO_CONTEXT};
+    EGLSurface m_eglSurface{EGL_NO_SURFACE};
     std::list<std::vector<XrSwapchainImageOpenGLESKHR>> m_swapchainImageBuffers;
-    GLuint m_swapchainFramebuffer{0};
-    std::map<uint32_t, uint32_t> m_colorToDepthMap;
+    struct SwapchainTarget {
+        GlFramebuffer framebuffer;
+        GlTexture depthTexture;  // the private depth texture, none with a depth swapchain
+    };
+    std::map<uint32_t, SwapchainTarget> m_swapchainTargets;  // by color swapchain image
+    GlBuffer m_viewBlockBuffer;
+    bool m_multiviewRequested{true};
+    bool m_depth16{false};
+    GlValidation::Level m_glValidation{GlValidation::Level::Off};
+    bool m_multiview{false};
 };
 }  // namespace
 
 std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin_OpenGLES(const std::shared_ptr<Options>& options, std::shared_ptr<IPlatformPlugin> platformPlugin) {
-    return std::make_shared<OpenGLESGraphicsPlugin>(options, platformPlugin);
+    return std::make_shared<OpenGLESGraphicsPlugin>(options, platformPlugin, false);
+}
+
+std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin_Headless(const std::shared_ptr<Options>& options, std::shared_ptr<IPlatformPlugin> platformPlugin) {
+    return std::make_shared<OpenGLESGraphicsPlugin>(options, platformPlugin, true);
 }
 
 #endif
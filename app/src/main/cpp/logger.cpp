@@ -7,11 +7,20 @@
 
 #include <sstream>
 
+#ifdef XR_USE_PLATFORM_ANDROID
 #define ALOGE(...) __android_log_print(ANDROID_LOG_ERROR,   "RK-Openxr-App", __VA_ARGS__)
 #define ALOGW(...) __android_log_print(ANDROID_LOG_WARN,    "RK-Openxr-App", __VA_ARGS__)
 #define ALOGI(...) __android_log_print(ANDROID_LOG_INFO,    "RK-Openxr-App", __VA_ARGS__)
 #define ALOGD(...) __android_log_print(ANDROID_LOG_DEBUG,   "RK-Openxr-App", __VA_ARGS__)
 #define ALOGV(...) __android_log_print(ANDROID_LOG_VERBOSE, "RK-Openxr-App", __VA_ARGS__)
+#else
+// host builds (benchmarks/) only have the standard streams
+#define ALOGE(...)
+#define ALOGW(...)
+#define ALOGI(...)
+#define ALOGD(...)
+#define ALOGV(...)
+#endif
 
 namespace {
     Log::Level g_minSeverity{Log::Level::Verbose};
@@ -9,16 +9,27 @@
 #include "platformplugin.h"
 #include "graphicsplugin.h"//图形API抽象层
 #include "openxr_program.h"//openxr程序主逻辑
+#include "startuptasks.h"
 #include "demos/utils.h"
+#include "demos/programCache.h"
 
 
 namespace {
 
 void ShowHelp() {
-    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.graphicsPlugin OpenGLES|Vulkan");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.graphicsPlugin OpenGLES|Headless|Vulkan");
     Log::Write(Log::Level::Info, "adb shell setprop debug.xr.formFactor Hmd|Handheld");
     Log::Write(Log::Level::Info, "adb shell setprop debug.xr.viewConfiguration Stereo|Mono");
     Log::Write(Log::Level::Info, "adb shell setprop debug.xr.blendMode Opaque|Additive|AlphaBlend");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.multiview 1|0");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.guiLayer 1|0");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.videoLayer 0|1");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.videoFile <absolute path>|\"\"");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.dynamicResolution 1|0");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.depth16 0|1");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.glValidation Off|Callback|Pass|Call");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.gpuMemoryBudget <MB>|0");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.recordSession <absolute path>|\"\"");
     Log::Write(Log::Level::Info, "adb shell setprop persist.log.tag V");
 }
 
@@ -27,6 +38,33 @@ bool UpdateOptionsFromSystemProperties(Options& options) {
     if (__system_property_get("debug.xr.graphicsPlugin", value) != 0) {
         options.GraphicsPlugin = value;
     }
+    if (__system_property_get("debug.xr.multiview", value) != 0) {
+        options.Multiview = strcmp(value, "0") != 0;
+    }
+    if (__system_property_get("debug.xr.guiLayer", value) != 0) {
+        options.GuiQuadLayer = strcmp(value, "0") != 0;
+    }
+    if (__system_property_get("debug.xr.videoLayer", value) != 0) {
+        options.VideoSurfaceLayer = strcmp(value, "1") == 0;
+    }
+    if (__system_property_get("debug.xr.videoFile", value) != 0) {
+        options.VideoFile = value;
+    }
+    if (__system_property_get("debug.xr.dynamicResolution", value) != 0) {
+        options.DynamicResolution = strcmp(value, "0") != 0;
+    }
+    if (__system_property_get("debug.xr.depth16", value) != 0) {
+        options.Depth16 = strcmp(value, "1") == 0;
+    }
+    if (__system_property_get("debug.xr.glValidation", value) != 0) {
+        options.GlValidation = value;
+    }
+    if (__system_property_get("debug.xr.gpuMemoryBudget", value) != 0) {
+        options.GpuMemoryBudgetMB = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+    }
+    if (__system_property_get("debug.xr.recordSession", value) != 0) {
+        options.RecordSession = value;
+    }
 
     // Check for required parameters.
     if (options.GraphicsPlugin.empty()) {
@@ -118,6 +156,7 @@ static void killProcess() {
  * event loop for receiving input events and doing other things.
  */
 void android_main(struct android_app* app) {
+    const auto launchTime = std::chrono::steady_clock::now();
     app_dummy();
     try {
         JNIEnv* Env;
@@ -167,16 +206,51 @@ void android_main(struct android_app* app) {
             initializeLoader((const XrLoaderInitInfoBaseHeaderKHR*)&loaderInitInfoAndroid);
         }
 
-        program->CreateInstance();//创建实例
-        program->InitializeSystem();
-        program->InitializeSession();//创建会话
-        program->CreateSwapchains();//创建交换链-Q：交换链是什么
-        program->InitializeApplication();
+        // Startup runs as a task graph: the marker images decode on a worker while the instance, session and swapchains
+        // are created, the frame loop starts as soon as the application can draw its first frame, and the trackers and
+        // the rest of the application come up between the first frames.
+        StartupTasks startup;
+        startup.Start();
+        const std::string cacheDir = app->activity->internalDataPath;
+        ProgramCache::instance().setDirectory(cacheDir + "/programs");
+        const auto markerImages = startup.Add("marker images", StartupTasks::Thread::Worker, [program, cacheDir] {
+            program->LoadMarkerImages(cacheDir);//解码标记图片
+            return true;  // without images the trackers still start, there is just nothing for the marker tracker to find
+        });
+        const auto session = startup.Add("xr session", StartupTasks::Thread::Render, [program] {
+            program->CreateInstance();//创建实例
+            program->InitializeSystem();
+            program->InitializeSession();//创建会话
+            program->CreateSwapchains();//创建交换链-Q：交换链是什么
+            return true;
+        });
+        const auto application = startup.Add("application", StartupTasks::Thread::Render, [program, &startup] {
+            program->InitializeApplication(startup);
+            return true;
+        }, {session});
         // modify by qi.cheng
         // Marker 识别功能代码调用
-        program -> InitializeMarker();//AR标记识别初始化
-        program-> AddMarkerImages();//加载标记图片
-        program-> InitializePlaneTracking();//AR平面追踪
+        const auto marker = startup.Add("marker tracker", StartupTasks::Thread::Render, [program] {
+            program->InitializeMarker();//AR标记识别初始化
+            return true;
+        }, {session});
+        const auto markerAdd = startup.Add("marker images add", StartupTasks::Thread::Render, [program] {
+            program->AddMarkerImages();//加载标记图片
+            return true;
+        }, {marker, markerImages});
+        const auto planes = startup.Add("plane tracker", StartupTasks::Thread::Render, [program] {
+            program->InitializePlaneTracking();//AR平面追踪
+            return true;
+        }, {session});
+        startup.Add("tracking", StartupTasks::Thread::Render, [program] {
+            program->StartTracking();//标记和平面数据在工作线程轮询
+            return true;
+        }, {markerAdd, planes});
+        CHECK_MSG(startup.Wait(application), "Startup failed");
+
+        // Render tasks left over from startup share the frame loop, at most this much of each iteration.
+        constexpr std::chrono::milliseconds startupTaskBudget{2};
+        bool firstFrameRendered = false;
         while (app->destroyRequested == 0) {//这里是主循环，除非执行破坏请求否则不会退出（每帧循环渲染）
             // Read all pending events.
             for (;;) {
@@ -197,6 +271,8 @@ void android_main(struct android_app* app) {
 
             program->PollEvents(&exitRenderLoop, &requestRestart);
 
+            startup.RunRenderTasks(startupTaskBudget);
+
             if (exitRenderLoop && !requestRestart) {//用户退出或故障时且不需要重启时杀死进程
                 ANativeActivity_finish(app->activity);
 
@@ -211,8 +287,12 @@ void android_main(struct android_app* app) {
 
             program->PollActions();
             program->RenderFrame();
-            program->ProcessMarkerData(); // 图像识别处理
-            //program->ProcessPlaneTracking();//平面识别处理
+
+            if (!firstFrameRendered) {
+                firstFrameRendered = true;
+                const float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - launchTime).count();
+                Log::Write(Log::Level::Info, Fmt("Time to first frame: %.1fms", ms));
+            }
         }
         app->activity->vm->DetachCurrentThread();
     }
@@ -0,0 +1,307 @@
+#include "pch.h"
+#include "common.h"
+#include "markerdatabase.h"
+#include "stb_image.h"
+
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+// Cache layout: FileHeader, FileHeader::count FileEntry records, the source paths, then the pixels of every entry at its
+// offset. A path is stored whole with its length and a terminating zero, so that it can serve as the marker id in place.
+// A source that failed to decode keeps an entry without pixels, it is not decoded again until it changes.
+constexpr char Magic[4] = {'M', 'K', 'D', 'B'};
+constexpr size_t PixelAlignment = 16;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    int32_t maxDimension;
+};
+
+struct FileEntry {
+    uint64_t pathOffset;
+    uint32_t pathLength;  // without the terminating zero
+    uint32_t reserved;
+    int64_t mtimeNs;
+    int64_t size;
+    int32_t width;
+    int32_t height;
+    uint64_t offset;
+};
+
+struct SourceStat {
+    int64_t mtimeNs;
+    int64_t size;
+};
+
+bool StatSource(const std::string& path, SourceStat& out) {
+    struct stat st {};
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    out.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    out.size = static_cast<int64_t>(st.st_size);
+    return true;
+}
+
+struct Decoded {
+    std::vector<uint8_t> pixels;
+    int32_t width{0};
+    int32_t height{0};
+};
+
+// Decodes to grey and box-filters down so that the longest side is at most MaxDimension.
+bool Decode(const std::string& path, Decoded& out) {
+    int width = 0, height = 0, channels = 0;
+    uint8_t* data = stbi_load(path.c_str(), &width, &height, &channels, STBI_grey);
+    if (data == nullptr) {
+        return false;
+    }
+
+    const float scale = std::min(1.0f, static_cast<float>(MarkerDatabase::MaxDimension) / std::max(width, height));
+    out.width = std::max(1, static_cast<int32_t>(std::lround(width * scale)));
+    out.height = std::max(1, static_cast<int32_t>(std::lround(height * scale)));
+    out.pixels.resize(static_cast<size_t>(out.width) * out.height);
+
+    if (out.width == width && out.height == height) {
+        memcpy(out.pixels.data(), data, out.pixels.size());
+    } else {
+        for (int32_t y = 0; y < out.height; y++) {
+            const int32_t y0 = y * height / out.height;
+            const int32_t y1 = std::max(y0 + 1, (y + 1) * height / out.height);
+            for (int32_t x = 0; x < out.width; x++) {
+                const int32_t x0 = x * width / out.width;
+                const int32_t x1 = std::max(x0 + 1, (x + 1) * width / out.width);
+                uint32_t sum = 0;
+                for (int32_t sy = y0; sy < y1; sy++) {
+                    for (int32_t sx = x0; sx < x1; sx++) {
+                        sum += data[sy * width + sx];
+                    }
+                }
+                out.pixels[y * out.width + x] = static_cast<uint8_t>(sum / ((y1 - y0) * (x1 - x0)));
+            }
+        }
+    }
+    stbi_image_free(data);
+    return true;
+}
+
+struct CachedEntry {
+    const FileEntry* entry;
+    std::string_view path;  // zero terminated
+};
+
+// The entries of a mapped cache, empty when it is not a valid cache of this version.
+std::vector<CachedEntry> Entries(const uint8_t* mapped, size_t size) {
+    std::vector<CachedEntry> entries;
+    if (mapped == nullptr || size < sizeof(FileHeader)) {
+        return entries;
+    }
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(mapped);
+    if (memcmp(header->magic, Magic, sizeof(Magic)) != 0 || header->version != MarkerDatabase::Version ||
+        header->maxDimension != MarkerDatabase::MaxDimension || sizeof(FileHeader) + header->count * sizeof(FileEntry) > size) {
+        return entries;
+    }
+    const FileEntry* first = reinterpret_cast<const FileEntry*>(mapped + sizeof(FileHeader));
+    for (uint32_t i = 0; i < header->count; i++) {
+        const FileEntry& entry = first[i];
+        if (entry.pathOffset + entry.pathLength >= size || mapped[entry.pathOffset + entry.pathLength] != '\0' ||
+            entry.offset + static_cast<uint64_t>(entry.width) * entry.height > size) {
+            return {};
+        }
+        entries.push_back({&entry, std::string_view(reinterpret_cast<const char*>(mapped + entry.pathOffset), entry.pathLength)});
+    }
+    return entries;
+}
+
+// Writes the entries next to the cache and renames the file over it, a crash never leaves a torn cache behind. The pixels
+// may point into the current mapping of the cache: it stays valid, the mapping keeps the replaced file alive.
+bool WriteCache(const std::string& cachePath, std::vector<FileEntry>& entries, const std::vector<const std::string*>& paths,
+                const std::vector<const uint8_t*>& pixels) {
+    uint64_t offset = sizeof(FileHeader) + entries.size() * sizeof(FileEntry);
+    for (FileEntry& entry : entries) {
+        entry.pathOffset = offset;
+        offset += entry.pathLength + 1;
+    }
+    for (FileEntry& entry : entries) {
+        offset = (offset + PixelAlignment - 1) & ~static_cast<uint64_t>(PixelAlignment - 1);
+        entry.offset = offset;
+        offset += static_cast<uint64_t>(entry.width) * entry.height;
+    }
+    const std::string tempPath = cachePath + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    FileHeader header{};
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = MarkerDatabase::Version;
+    header.count = static_cast<uint32_t>(entries.size());
+    header.maxDimension = MarkerDatabase::MaxDimension;
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    written = written && (entries.empty() || fwrite(entries.data(), sizeof(FileEntry), entries.size(), file) == entries.size());
+    for (size_t i = 0; written && i < entries.size(); i++) {
+        written = fwrite(paths[i]->c_str(), 1, paths[i]->size() + 1, file) == paths[i]->size() + 1;
+    }
+    for (size_t i = 0; written && i < entries.size(); i++) {
+        const size_t size = static_cast<size_t>(entries[i].width) * entries[i].height;
+        written = fseek(file, static_cast<long>(entries[i].offset), SEEK_SET) == 0 && (size == 0 || fwrite(pixels[i], 1, size, file) == size);
+    }
+    written = fclose(file) == 0 && written;
+    if (!written || rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+        unlink(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+}  // namespace
+
+bool MarkerDatabase::Load(const std::vector<Source>& sources, const std::string& cachePath) {
+    const auto start = std::chrono::steady_clock::now();
+    Map(cachePath);
+    const std::vector<CachedEntry> cached = Entries(m_mapped, m_mappedSize);
+
+    // Match every source against the cache, the rest is decoded in parallel.
+    struct Pending {
+        const Source* source;
+        SourceStat stat;
+        const FileEntry* cached;
+        std::future<bool> decode;
+        Decoded decoded;
+    };
+    std::vector<Pending> pending(sources.size());
+    size_t existing = 0;
+    bool upToDate = true;
+    for (size_t i = 0; i < sources.size(); i++) {
+        Pending& p = pending[i];
+        p.source = &sources[i];
+        p.cached = nullptr;
+        if (!StatSource(p.source->path, p.stat)) {
+            Log::Write(Log::Level::Error, Fmt("MarkerDatabase: missing image: %s", p.source->path.c_str()));
+            continue;
+        }
+        existing++;
+        for (const CachedEntry& entry : cached) {
+            if (entry.path == p.source->path && entry.entry->mtimeNs == p.stat.mtimeNs && entry.entry->size == p.stat.size) {
+                p.cached = entry.entry;
+                break;
+            }
+        }
+        if (p.cached == nullptr) {
+            upToDate = false;
+            p.decode = std::async(std::launch::async, Decode, p.source->path, std::ref(p.decoded));
+        } else if (p.cached->width == 0) {
+            Log::Write(Log::Level::Error, Fmt("MarkerDatabase: image failed to decode before and is unchanged: %s", p.source->path.c_str()));
+        }
+    }
+
+    // Missing sources are left out of the cache, so it is current when it holds exactly the existing ones.
+    bool cacheWritten = true;
+    if (!upToDate || cached.size() != existing) {
+        uint32_t decodedCount = 0;
+        std::vector<FileEntry> entries;
+        std::vector<const std::string*> paths;
+        std::vector<const uint8_t*> pixels;
+        for (Pending& p : pending) {
+            FileEntry entry{};
+            if (p.cached != nullptr) {
+                entry = *p.cached;
+                pixels.push_back(m_mapped + p.cached->offset);
+            } else if (p.decode.valid()) {
+                // A failure is kept as an entry without pixels.
+                entry.mtimeNs = p.stat.mtimeNs;
+                entry.size = p.stat.size;
+                if (p.decode.get()) {
+                    entry.width = p.decoded.width;
+                    entry.height = p.decoded.height;
+                    decodedCount++;
+                } else {
+                    Log::Write(Log::Level::Error, Fmt("MarkerDatabase: failed to decode image: %s", p.source->path.c_str()));
+                }
+                pixels.push_back(p.decoded.pixels.data());
+            } else {
+                continue;
+            }
+            entry.pathLength = static_cast<uint32_t>(p.source->path.size());
+            entries.push_back(entry);
+            paths.push_back(&p.source->path);
+        }
+
+        cacheWritten = WriteCache(cachePath, entries, paths, pixels);
+        if (cacheWritten) {
+            Map(cachePath);
+            Log::Write(Log::Level::Info, Fmt("MarkerDatabase: decoded %u of %zu images into %s", decodedCount, sources.size(), cachePath.c_str()));
+        } else {
+            Log::Write(Log::Level::Error, Fmt("MarkerDatabase: failed to write %s, the %u decoded images are kept in memory", cachePath.c_str(),
+                                              decodedCount));
+        }
+    }
+
+    // Resolve the images in the order of the sources: from the mapping, or without a new cache from the old mapping and
+    // what was decoded this time.
+    m_images.clear();
+    if (cacheWritten) {
+        const std::vector<CachedEntry> mapped = Entries(m_mapped, m_mappedSize);
+        for (const Source& source : sources) {
+            for (const CachedEntry& cachedEntry : mapped) {
+                if (cachedEntry.path == source.path) {
+                    const FileEntry* entry = cachedEntry.entry;
+                    if (entry->width > 0) {
+                        m_images.push_back({cachedEntry.path.data(), m_mapped + entry->offset, entry->width, entry->height,
+                                            source.widthInMeter, source.heightInMeter});
+                    }
+                    break;
+                }
+            }
+        }
+    } else {
+        m_owned.reserve(pending.size());
+        for (Pending& p : pending) {
+            if (p.cached != nullptr && p.cached->width > 0) {
+                m_images.push_back({reinterpret_cast<const char*>(m_mapped + p.cached->pathOffset), m_mapped + p.cached->offset,
+                                    p.cached->width, p.cached->height, p.source->widthInMeter, p.source->heightInMeter});
+            } else if (p.cached == nullptr && !p.decoded.pixels.empty()) {
+                m_owned.push_back({p.source->path, std::move(p.decoded.pixels)});
+                m_images.push_back({m_owned.back().path.c_str(), m_owned.back().pixels.data(), p.decoded.width, p.decoded.height,
+                                    p.source->widthInMeter, p.source->heightInMeter});
+            }
+        }
+    }
+
+    const float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    Log::Write(Log::Level::Info, Fmt("MarkerDatabase: %zu images ready in %.1fms", m_images.size(), ms));
+    return cacheWritten && m_mapped != nullptr;
+}
+
+bool MarkerDatabase::Map(const std::string& cachePath) {
+    Unmap();
+    const int fd = open(cachePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            m_mapped = static_cast<const uint8_t*>(mapped);
+            m_mappedSize = static_cast<size_t>(st.st_size);
+        }
+    }
+    close(fd);
+    return m_mapped != nullptr;
+}
+
+void MarkerDatabase::Unmap() {
+    if (m_mapped != nullptr) {
+        munmap(const_cast<uint8_t*>(m_mapped), m_mappedSize);
+        m_mapped = nullptr;
+        m_mappedSize = 0;
+    }
+    m_images.clear();
+    m_owned.clear();
+}
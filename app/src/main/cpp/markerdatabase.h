@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Grey marker images ready for xrRKMarker2AddImagePhy.
+// Decoding full resolution PNGs is what made startup slow, so the decoded, grey converted and downscaled pixels are kept
+// in a binary cache file that later launches map straight into memory. Each cached image is keyed by its source path,
+// modification time and size; only sources that are new or changed are decoded again, in parallel.
+class MarkerDatabase {
+   public:
+    struct Source {
+        std::string path;
+        float widthInMeter;
+        float heightInMeter;
+    };
+
+    struct Image {
+        const char* id;         // the source path, used as the marker id
+        const uint8_t* pixels;  // grey, width x height, tightly packed
+        int32_t width;
+        int32_t height;
+        float widthInMeter;
+        float heightInMeter;
+    };
+
+    // The camera the tracker matches against is 640x480, detail above that only costs memory and matching time.
+    static constexpr int32_t MaxDimension = 640;
+    static constexpr uint32_t Version = 2;
+
+    MarkerDatabase() = default;
+    MarkerDatabase(const MarkerDatabase&) = delete;
+    MarkerDatabase& operator=(const MarkerDatabase&) = delete;
+    ~MarkerDatabase() { Unmap(); }
+
+    // Maps cachePath, rebuilding it first when it is missing, of another version or out of date with the sources.
+    // Sources that cannot be decoded are logged and left out; the cache remembers them until they change. Returns false
+    // when no usable cache could be mapped or written, the images decoded this time are then served from memory.
+    bool Load(const std::vector<Source>& sources, const std::string& cachePath);
+
+    // Valid until the next Load or the end of the database.
+    const std::vector<Image>& Images() const { return m_images; }
+
+   private:
+    bool Map(const std::string& cachePath);
+    void Unmap();
+
+    const uint8_t* m_mapped{nullptr};
+    size_t m_mappedSize{0};
+    std::vector<Image> m_images;
+
+    // Decoded images that could not be written to the cache.
+    struct OwnedImage {
+        std::string path;
+        std::vector<uint8_t> pixels;
+    };
+    std::vector<OwnedImage> m_owned;
+};
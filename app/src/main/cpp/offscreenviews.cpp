@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "common.h"
+#include "graphicsplugin.h"
+#include "offscreenviews.h"
+#include "common/gfxwrapper_opengl.h"
+#include "demos/application.h"
+#include "demos/glState.h"
+#include "demos/gpuMemory.h"
+#include "demos/utils.h"
+
+OffscreenViews::OffscreenViews(std::shared_ptr<IGraphicsPlugin> graphicsPlugin, uint32_t viewCount, int32_t width, int32_t height)
+    : m_graphicsPlugin(std::move(graphicsPlugin)), m_viewCount(viewCount), m_width(width), m_height(height) {
+    m_multiview = m_graphicsPlugin->SupportsMultiview() && m_viewCount == 2;
+
+    XrSwapchainCreateInfo createInfo{};
+    createInfo.type = XR_TYPE_SWAPCHAIN_CREATE_INFO;
+    createInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
+    createInfo.format = GL_RGBA8;
+    createInfo.sampleCount = 1;
+    createInfo.width = m_width;
+    createInfo.height = m_height;
+    createInfo.faceCount = 1;
+    createInfo.arraySize = m_multiview ? m_viewCount : 1;
+    createInfo.mipCount = 1;
+
+    const GLenum target = m_multiview ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+    const uint32_t imageCount = m_multiview ? 1 : m_viewCount;
+    for (uint32_t i = 0; i < imageCount; i++) {
+        m_textures.push_back(GlTexture::generate());
+        GlState::instance().bindTexture(0, target, m_textures.back().get());
+        if (m_multiview) {
+            GpuMemory::instance().texStorage3D(GpuMemoryTag::Frame, m_textures.back().get(), target, 1, GL_RGBA8, m_width, m_height, m_viewCount);
+        } else {
+            GpuMemory::instance().texStorage2D(GpuMemoryTag::Frame, m_textures.back().get(), target, 1, GL_RGBA8, m_width, m_height);
+        }
+        m_images.push_back({XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_ES_KHR, nullptr, m_textures.back().get()});
+    }
+
+    // Every view gets a swapchain of a single image, the plugin sees one CreateSwapchainTargets per swapchain.
+    for (XrSwapchainImageOpenGLESKHR& image : m_images) {
+        const std::vector<XrSwapchainImageBaseHeader*> colorImages{reinterpret_cast<XrSwapchainImageBaseHeader*>(&image)};
+        m_graphicsPlugin->CreateSwapchainTargets(createInfo, colorImages, {});
+    }
+    Log::Write(Log::Level::Info, Fmt("Offscreen views: %u of %dx%d, %s", m_viewCount, m_width, m_height, m_multiview ? "multiview" : "per view"));
+}
+
+void OffscreenViews::RenderFrame(std::shared_ptr<IApplication>& application, const std::vector<XrView>& views, XrTime predictedDisplayTime,
+                                 XrDuration predictedDisplayPeriod) {
+    CHECK(views.size() == m_viewCount);
+
+    m_graphicsPlugin->BeginGpuFrame();
+    application->update(predictedDisplayTime, predictedDisplayPeriod);
+
+    XrCompositionLayerProjectionView projectionLayerView{};
+    projectionLayerView.type = XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW;
+    std::vector<XrCompositionLayerProjectionView> projectionLayerViews(m_viewCount, projectionLayerView);
+    for (uint32_t i = 0; i < m_viewCount; i++) {
+        projectionLayerViews[i].pose = views[i].pose;
+        projectionLayerViews[i].fov = views[i].fov;
+        projectionLayerViews[i].subImage.imageRect = {{0, 0}, {m_width, m_height}};
+        projectionLayerViews[i].subImage.imageArrayIndex = m_multiview ? i : 0;
+    }
+
+    if (m_multiview) {
+        const auto* image = reinterpret_cast<const XrSwapchainImageBaseHeader*>(&m_images[0]);
+        m_graphicsPlugin->RenderMultiView(application, projectionLayerViews, image, nullptr, GL_RGBA8);
+    } else {
+        for (uint32_t i = 0; i < m_viewCount; i++) {
+            const auto* image = reinterpret_cast<const XrSwapchainImageBaseHeader*>(&m_images[i]);
+            m_graphicsPlugin->RenderView(application, projectionLayerViews[i], image, nullptr, GL_RGBA8, static_cast<int32_t>(i));
+        }
+    }
+
+    m_graphicsPlugin->RenderPasses();
+    m_graphicsPlugin->EndGpuFrame();
+}
+
+bool OffscreenViews::ReadView(uint32_t view, std::vector<uint8_t>& pixels) const {
+    if (view >= m_viewCount) {
+        return false;
+    }
+
+    // A framebuffer of its own: the plugin's attaches all layers with multiview, which cannot be read from. It is bound
+    // for reading only, the draw framebuffer the render graph keeps track of stays as it is.
+    const GlFramebuffer framebuffer = GlFramebuffer::generate();
+    GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer.get()));
+    if (m_multiview) {
+        GL_CALL(glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_images[0].image, 0, static_cast<GLint>(view)));
+    } else {
+        GL_CALL(glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_images[view].image, 0));
+    }
+
+    const bool complete = glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (complete) {
+        // Tightly packed rows, the pack alignment is restored for whoever reads pixels next.
+        GLint packAlignment = 4;
+        GL_CALL(glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment));
+        GL_CALL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+        pixels.resize(static_cast<size_t>(m_width) * m_height * 4);
+        GL_CALL(glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+        GL_CALL(glPixelStorei(GL_PACK_ALIGNMENT, packAlignment));
+    }
+    GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, 0));
+    return complete;
+}
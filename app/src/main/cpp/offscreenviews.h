@@ -0,0 +1,35 @@
+#pragma once
+
+#include "demos/glResource.h"
+
+struct IGraphicsPlugin;
+class IApplication;
+
+// Plays the runtime's part for a graphics plugin that has none, e.g. the headless one on a build server: owns the
+// color images of the projection views and records and runs whole frames into them the way OpenXrProgram does, so the
+// application renders exactly as it would for a session. With multiview both views share a two-layer image.
+class OffscreenViews {
+   public:
+    // The plugin must be initialized, the views are width x height each.
+    OffscreenViews(std::shared_ptr<IGraphicsPlugin> graphicsPlugin, uint32_t viewCount, int32_t width, int32_t height);
+
+    // update() of the application, then the passes of every view. The GL work is issued, not waited for.
+    void RenderFrame(std::shared_ptr<IApplication>& application, const std::vector<XrView>& views, XrTime predictedDisplayTime,
+                     XrDuration predictedDisplayPeriod);
+
+    // The RGBA8 pixels of a view, bottom row first as GL reads them. Waits for the GPU.
+    bool ReadView(uint32_t view, std::vector<uint8_t>& pixels) const;
+
+    uint32_t ViewCount() const { return m_viewCount; }
+    int32_t Width() const { return m_width; }
+    int32_t Height() const { return m_height; }
+
+   private:
+    std::shared_ptr<IGraphicsPlugin> m_graphicsPlugin;
+    uint32_t m_viewCount;
+    int32_t m_width;
+    int32_t m_height;
+    bool m_multiview;
+    std::vector<GlTexture> m_textures;                    // one per view, or the one array of all views
+    std::vector<XrSwapchainImageOpenGLESKHR> m_images;  // of m_textures
+};
@@ -9,12 +9,16 @@
 #include "platformplugin.h"
 #include "graphicsplugin.h"
 #include "openxr_program.h"
+#include "frametiming.h"
+#include "renderscale.h"
+#include "trackingworker.h"
+#include "markerdatabase.h"
+#include "sessionrecording.h"
 #include <common/xr_linear.h>
 #include <array>
 #include <cmath>
 #include <math.h>
 #include "demos/application.h"
-#include "stb_image.h"
 
 namespace {
 
@@ -31,6 +35,29 @@ const int RIGHT = 1;
 const int COUNT = 2;
 }  // namespace Side
 
+// Boolean actions, one row each. Every sync the states of an input source are packed into its CONTROLLER_EVENT_BIT_*
+// bitfield, and only the bits that changed are queued for the application.
+struct ButtonAction {
+    const char* name;
+    bool perHand;       // one subaction per hand, otherwise the gamepad
+    const char* input;  // binding path below /user/hand/<side> or /user/gamepad
+    uint32_t eventBit;
+};
+
+constexpr ButtonAction ButtonActions[] = {
+    {"hand_pinch", true, "/input/pinch/click", CONTROLLER_EVENT_BIT_click_trigger},
+    {"hand_grip", true, "/input/squeeze/click", CONTROLLER_EVENT_BIT_click_menu},
+    {"select", false, "/input/select/click", CONTROLLER_EVENT_BIT_click_trigger},
+    {"x", false, "/input/x/click", CONTROLLER_EVENT_BIT_click_x},
+    {"o", false, "/input/o/click", CONTROLLER_EVENT_BIT_click_o},
+    {"up", false, "/input/up/click", CONTROLLER_EVENT_BIT_click_up},
+    {"down", false, "/input/down/click", CONTROLLER_EVENT_BIT_click_down},
+    {"left", false, "/input/left/click", CONTROLLER_EVENT_BIT_click_left},
+    {"right", false, "/input/right/click", CONTROLLER_EVENT_BIT_click_right},
+    {"menu", false, "/input/menu/click", CONTROLLER_EVENT_BIT_click_menu},
+};
+constexpr uint32_t ButtonActionCount = sizeof(ButtonActions) / sizeof(ButtonActions[0]);
+
 inline std::string GetXrVersionString(XrVersion ver) {
     return Fmt("%d.%d.%d", XR_VERSION_MAJOR(ver), XR_VERSION_MINOR(ver), XR_VERSION_PATCH(ver));
 }
@@ -97,11 +124,16 @@ PFN_xrGetHistoryCameraPhysicsPose pfnXrGetHistoryCameraPhysicsPose;
 struct OpenXrProgram : IOpenXrProgram {
     OpenXrProgram(const std::shared_ptr<Options>& options, const std::shared_ptr<IPlatformPlugin>& platformPlugin,
                   const std::shared_ptr<IGraphicsPlugin>& graphicsPlugin)
-        : m_options(*options), m_platformPlugin(platformPlugin), m_graphicsPlugin(graphicsPlugin) {
+        : m_options(*options), m_platformPlugin(platformPlugin), m_graphicsPlugin(graphicsPlugin), m_renderScale(options->DynamicResolution) {
             m_application = createApplication(options, graphicsPlugin);
         }
 
     ~OpenXrProgram() override {
+        // The worker calls into the runtime, it has to be gone before anything is torn down.
+        m_tracking.Stop();
+        // The application's own swapchains belong to the session, they go before it.
+        m_application->releaseXrResources();
+
         if (m_input.actionSet != XR_NULL_HANDLE) {
             for (auto hand : {Side::LEFT, Side::RIGHT}) {
                 xrDestroySpace(m_input.handSpace[hand]);
@@ -113,6 +145,9 @@ struct OpenXrProgram : IOpenXrProgram {
         for (Swapchain swapchain : m_swapchains) {
             xrDestroySwapchain(swapchain.handle);
         }
+        for (Swapchain swapchain : m_depthSwapchains) {
+            xrDestroySwapchain(swapchain.handle);
+        }
 
         if (m_appSpace != XR_NULL_HANDLE) {
             xrDestroySpace(m_appSpace);
@@ -203,6 +238,15 @@ struct OpenXrProgram : IOpenXrProgram {
                                          GetXrVersionString(instanceProperties.runtimeVersion).c_str()));
     }
 
+    static bool IsInstanceExtensionSupported(const char* extensionName) {
+        uint32_t extensionCount;
+        CHECK_XRCMD(xrEnumerateInstanceExtensionProperties(nullptr, 0, &extensionCount, nullptr));
+        std::vector<XrExtensionProperties> extensions(extensionCount, {XR_TYPE_EXTENSION_PROPERTIES});
+        CHECK_XRCMD(xrEnumerateInstanceExtensionProperties(nullptr, (uint32_t)extensions.size(), &extensionCount, extensions.data()));
+        return std::any_of(extensions.begin(), extensions.end(),
+                           [extensionName](const XrExtensionProperties& extension) { return strcmp(extension.extensionName, extensionName) == 0; });
+    }
+
     void CreateInstanceInternal() {
         CHECK(m_instance == XR_NULL_HANDLE);
 
@@ -218,6 +262,23 @@ struct OpenXrProgram : IOpenXrProgram {
 
         extensions.push_back(XR_KHR_CONVERT_TIMESPEC_TIME_EXTENSION_NAME);
 
+        // Depth submission is optional, the runtime falls back to rotation-only reprojection without it.
+        m_depthLayerSupported = IsInstanceExtensionSupported(XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME);
+        if (m_depthLayerSupported) {
+            extensions.push_back(XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME);
+        }
+
+        // Optional layer types the application can use for video, it falls back to GL rendering without them.
+        std::vector<const char*> optionalExtensions = {XR_KHR_COMPOSITION_LAYER_EQUIRECT2_EXTENSION_NAME};
+#ifdef XR_USE_PLATFORM_ANDROID
+        optionalExtensions.push_back(XR_KHR_ANDROID_SURFACE_SWAPCHAIN_EXTENSION_NAME);
+#endif
+        for (const char* optionalExtension : optionalExtensions) {
+            if (IsInstanceExtensionSupported(optionalExtension)) {
+                extensions.push_back(optionalExtension);
+            }
+        }
+
         //hand tracking
         extensions.push_back(XR_EXT_HAND_TRACKING_EXTENSION_NAME);
 
@@ -231,6 +292,7 @@ struct OpenXrProgram : IOpenXrProgram {
         Log::Write(Log::Level::Error, Fmt("====== RokidOpenXRAndroidDemo createInfo: %d", createInfo));
         Log::Write(Log::Level::Error, Fmt("====== RokidOpenXRAndroidDemo m_instance: %d", m_instance));
         CHECK_XRCMD(xrCreateInstance(&createInfo, &m_instance));
+        m_enabledExtensions.assign(extensions.begin(), extensions.end());
 
 
     }
@@ -349,18 +411,9 @@ struct OpenXrProgram : IOpenXrProgram {
         std::array<XrSpace, Side::COUNT> handSpace;
         std::array<XrSpace, Side::COUNT> aimSpace;
         XrAction handAimPoseAction{XR_NULL_HANDLE};
-        XrAction handPinchAction{XR_NULL_HANDLE};
-        XrAction handGripAction{XR_NULL_HANDLE};
 
         XrActionSet actionSet{XR_NULL_HANDLE};
-        XrAction selectAction{XR_NULL_HANDLE};
-        XrAction xAction{XR_NULL_HANDLE};
-        XrAction oAction{XR_NULL_HANDLE};
-        XrAction upAction{XR_NULL_HANDLE};
-        XrAction downAction{XR_NULL_HANDLE};
-        XrAction leftAction{XR_NULL_HANDLE};
-        XrAction rightAction{XR_NULL_HANDLE};
-        XrAction menuAction{XR_NULL_HANDLE};
+        std::array<XrAction, ButtonActionCount> buttonActions{};  // parallel to ButtonActions
         XrAction gamepadPoseAction{XR_NULL_HANDLE};
         XrPath gamepadPoseSubactionPath;
         XrSpace gamepadPoseSpace;
@@ -460,88 +513,28 @@ struct OpenXrProgram : IOpenXrProgram {
             Log::Write(Log::Level::Error, "Failed to initialize Marker recognition.");
         }
     }
-    //处理 Marker 数据
-    void ProcessMarkerData() {
-        if (!markerEnabled || pfnXrRKMarker2AcquireChanges == nullptr) {
-            Log::Write(Log::Level::Warning, "====== Marker recognition is not enabled or acquire changes function is null.");
-            return;
-        }
+    // 解码 Marker 图片，与实例和会话的创建并行
+    void LoadMarkerImages(const std::string& cacheDir) override {
+        // 图片路径及其物理尺寸（米），根据实际场景调整
+        const std::vector<MarkerDatabase::Source> sources = {
+                {"/storage/emulated/0/pictures/sunflower.png", 0.42f, 0.23f},
+                {"/storage/emulated/0/pictures/aurora.png", 0.42f, 0.23f}, // Add more images as needed
+                {"/storage/emulated/0/pictures/terrace.png", 0.42f, 0.23f}
+        };
+        // 解码后的灰度图缓存在二进制文件中，之后启动直接映射
+        m_markerDatabase.Load(sources, cacheDir + "/markers.mkdb");
+    }
 
-        XrRokidMarker2ArrayExt added{}, updated{}, removed{};
-        XrResult result = pfnXrRKMarker2AcquireChanges(&added, &updated, &removed);
-        if (XR_FAILED(result)) {
-            Log::Write(Log::Level::Error, Fmt("====== Failed to acquire marker changes. Error code: %d", result));
+    //添加 Marker 数据
+    void AddMarkerImages() override {
+        if (pfnXrRKMarker2AddImagePhy == nullptr) {
+            Log::Write(Log::Level::Error, "Marker addition interface is not initialized.");
             return;
         }
 
-        // 处理新增的 Marker
-        Log::Write(Log::Level::Info, Fmt("====== Processing added markers. Count: %d", added.size));
-        for (uint32_t i = 0; i < added.size; ++i) {
-            intptr_t marker = added.elements[i];
-            float pose[7] = {};
-            if (pfnXrRKMarker2GetCenterPose != nullptr) {
-                result = pfnXrRKMarker2GetCenterPose(marker, pose);
-                if (XR_SUCCEEDED(result)) {
-                    Log::Write(Log::Level::Info, Fmt("====== Marker added with pose: [%f, %f, %f, %f, %f, %f, %f]",
-                                                     pose[0], pose[1], pose[2], pose[3], pose[4], pose[5], pose[6]));
-                } else {
-                    Log::Write(Log::Level::Error, Fmt("====== Failed to get center pose for added marker: %ld. Error code: %d", marker, result));
-                }
-            }
-        }
-
-        // 处理更新的 Marker
-        for (uint32_t i = 0; i < updated.size; ++i) {
-            intptr_t marker = updated.elements[i];
-            Log::Write(Log::Level::Info, Fmt("====== Marker updated: %ld", marker));
-        }
-
-        // 处理移除的 Marker
-        for (uint32_t i = 0; i < removed.size; ++i) {
-            intptr_t marker = removed.elements[i];
-            Log::Write(Log::Level::Info, Fmt("====== Marker removed: %ld", marker));
-        }
-    }
-    //添加 Marker 数据
-    void AddMarkerImages() {
-        // 指定图片路径
-        // List of image paths
-        std::vector<std::string> imagePaths = {
-                "/storage/emulated/0/pictures/sunflower.png",
-                "/storage/emulated/0/pictures/aurora.png", // Add more images as needed
-                "/storage/emulated/0/pictures/terrace.png"
-        };
-        for (const auto& filePath : imagePaths) {
-            // 定义图像属性变量
-            int width, height, channels;
-
-            // 使用 stb_image 加载 PNG 图像并转换为灰度图
-            uint8_t *imageData = stbi_load(filePath.c_str(), &width, &height, &channels, STBI_grey);
-            if (!imageData) {
-                // 加载失败的日志
-                Log::Write(Log::Level::Error, Fmt("Failed to load image: %s", filePath.c_str()));
-                return;
-            }
-
-            // 检查并调用 pfnXrRKMarker2AddImagePhy 接口
-            if (pfnXrRKMarker2AddImagePhy != nullptr) {
-                // 将图像数据添加到 Marker 数据库
-                CHECK_XRCMD(pfnXrRKMarker2AddImagePhy(
-                        filePath.c_str(), // Marker ID
-                        imageData,          // 灰度图像素数据
-                        width,              // 图像宽度（像素）
-                        height,             // 图像高度（像素）
-                        width,              // 每行字节数（灰度图等于宽度）
-                        0.42f,               // 图像物理宽度（米），根据实际场景调整
-                        0.23f                // 图像物理高度（米），根据实际场景调整
-                ));
-                // 添加成功的日志
-                Log::Write(Log::Level::Info, Fmt("Marker image added: %s", filePath.c_str()));
-            } else {
-                Log::Write(Log::Level::Error, "Marker addition interface is not initialized.");
-            }
-            // 释放加载的图片数据
-            stbi_image_free(imageData);
+        for (const MarkerDatabase::Image& image : m_markerDatabase.Images()) {
+            CHECK_XRCMD(pfnXrRKMarker2AddImagePhy(image.id, image.pixels, image.width, image.height, image.width, image.widthInMeter, image.heightInMeter));
+            Log::Write(Log::Level::Info, Fmt("Marker image added: %s (%dx%d)", image.id, image.width, image.height));
         }
     }
 
@@ -627,42 +620,19 @@ struct OpenXrProgram : IOpenXrProgram {
         }
     }
 
-    //处理平面识别数据
-    void ProcessPlaneTracking() {
-        if (!planeTrackingEnabled || pfnXrRKGetUpdatePlanes == nullptr) {
-            return;
+    void StartTracking() override {
+        TrackingWorker::Api api;
+        if (markerEnabled) {
+            api.markerAcquireChanges = pfnXrRKMarker2AcquireChanges;
+            api.markerGetCenterPose = pfnXrRKMarker2GetCenterPose;
+            api.markerGetExtent = pfnXrRKMarker2GetExtent;
         }
-        void *nochangePlanes = nullptr, *changePlanes = nullptr, *newPlanes = nullptr, *removePlanes = nullptr;
-        uint32_t nochangePlaneSize = 0, changePlaneSize = 0, newPlaneSize = 0, removePlaneSize = 0;
-
-
-        // 获取平面更新数据
-        CHECK_XRCMD(
-                pfnXrRKGetUpdatePlanes(0, &nochangePlanes, &changePlanes, &newPlanes, &removePlanes,
-                                       &nochangePlaneSize, &changePlaneSize, &newPlaneSize,
-                                       &removePlaneSize));
-
-        Log::Write(Log::Level::Info,
-                   Fmt("Plane Tracking Data: NoChange: %d, Changed: %d, New: %d, Removed: %d",
-                       nochangePlaneSize, changePlaneSize, newPlaneSize, removePlaneSize));
-
-        // 处理新增的平面
-        for (int i = 0; i < newPlaneSize; ++i) {
-            long plane = ((long *) newPlanes)[i];
-            uint32_t type = 0;
-            CHECK_XRCMD(pfnXrRKGetPlaneType(plane, &type));
-
-            Log::Write(Log::Level::Info,
-                       Fmt("New plane detected. Type: %d, Handle: %ld", type, plane));
-
-            // 获取平面中心点和法线
-            void *pose = nullptr, *center = nullptr, *normalVector = nullptr;
-            CHECK_XRCMD(pfnXrRKGetPlaneCenterPose(plane, &pose, &center, &normalVector));
-
-            Log::Write(Log::Level::Info,
-                       Fmt("Plane center and normal vector acquired for plane: %ld", plane));
-
+        if (planeTrackingEnabled) {
+            api.getUpdatePlanes = pfnXrRKGetUpdatePlanes;
+            api.getPlaneType = pfnXrRKGetPlaneType;
+            api.getPlaneCenterPose = pfnXrRKGetPlaneCenterPose;
         }
+        m_tracking.Start(api);
     }
 
     void InitializeActions() {
@@ -692,20 +662,6 @@ struct OpenXrProgram : IOpenXrProgram {
             actionInfo.subactionPaths = m_input.handSubactionPath.data();
             CHECK_XRCMD(xrCreateAction(m_input.actionSet, &actionInfo, &m_input.handAimPoseAction));
 
-            actionInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
-            strcpy_s(actionInfo.actionName, "hand_pinch");
-            strcpy_s(actionInfo.localizedActionName, "hand_pinch");
-            actionInfo.countSubactionPaths = uint32_t(m_input.handSubactionPath.size());
-            actionInfo.subactionPaths = m_input.handSubactionPath.data();
-            CHECK_XRCMD(xrCreateAction(m_input.actionSet, &actionInfo, &m_input.handPinchAction));
-
-            actionInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
-            strcpy_s(actionInfo.actionName, "hand_grip");
-            strcpy_s(actionInfo.localizedActionName, "hand_grip");
-            actionInfo.countSubactionPaths = uint32_t(m_input.handSubactionPath.size());
-            actionInfo.subactionPaths = m_input.handSubactionPath.data();
-            CHECK_XRCMD(xrCreateAction(m_input.actionSet, &actionInfo, &m_input.handGripAction));
-
             actionInfo.actionType = XR_ACTION_TYPE_POSE_INPUT;
             strcpy_s(actionInfo.actionName, "gamepadpose");
             strcpy_s(actionInfo.localizedActionName, "gamepadpose");
@@ -713,91 +669,23 @@ struct OpenXrProgram : IOpenXrProgram {
             actionInfo.subactionPaths = &m_input.gamepadPoseSubactionPath;
             CHECK_XRCMD(xrCreateAction(m_input.actionSet, &actionInfo, &m_input.gamepadPoseAction));
 
-            actionInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
-            strcpy_s(actionInfo.actionName, "select");
-            strcpy_s(actionInfo.localizedActionName, "select");
-            actionInfo.countSubactionPaths = 1;
-            actionInfo.subactionPaths = &m_input.gamepadPoseSubactionPath;
-            CHECK_XRCMD(xrCreateAction(m_input.actionSet, &actionInfo, &m_input.selectAction));
-
-            actionInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
-            strcpy_s(actionInfo.actionName, "x");
-            strcpy_s(actionInfo.localizedActionName, "x");
-            actionInfo.countSubactionPaths = 1;
-            actionInfo.subactionPaths = &m_input.gamepadPoseSubactionPath;
-            CHECK_XRCMD(xrCreateAction(m_input.actionSet, &actionInfo, &m_input.xAction));
-
-            actionInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
-            strcpy_s(actionInfo.actionName, "o");
-            strcpy_s(actionInfo.localizedActionName, "o");
-            actionInfo.countSubactionPaths = 1;
-            actionInfo.subactionPaths = &m_input.gamepadPoseSubactionPath;
-            CHECK_XRCMD(xrCreateAction(m_input.actionSet, &actionInfo, &m_input.oAction));
-
-            actionInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
-            strcpy_s(actionInfo.actionName, "up");
-            strcpy_s(actionInfo.localizedActionName, "up");
-            actionInfo.countSubactionPaths = 1;
-            actionInfo.subactionPaths = &m_input.gamepadPoseSubactionPath;
-            CHECK_XRCMD(xrCreateAction(m_input.actionSet, &actionInfo, &m_input.upAction));
-
-            actionInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
-            strcpy_s(actionInfo.actionName, "down");
-            strcpy_s(actionInfo.localizedActionName, "down");
-            actionInfo.countSubactionPaths = 1;
-            actionInfo.subactionPaths = &m_input.gamepadPoseSubactionPath;
-            CHECK_XRCMD(xrCreateAction(m_input.actionSet, &actionInfo, &m_input.downAction));
-
-            actionInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
-            strcpy_s(actionInfo.actionName, "left");
-            strcpy_s(actionInfo.localizedActionName, "left");
-            actionInfo.countSubactionPaths = 1;
-            actionInfo.subactionPaths = &m_input.gamepadPoseSubactionPath;
-            CHECK_XRCMD(xrCreateAction(m_input.actionSet, &actionInfo, &m_input.leftAction));
-
-            actionInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
-            strcpy_s(actionInfo.actionName, "right");
-            strcpy_s(actionInfo.localizedActionName, "right");
-            actionInfo.countSubactionPaths = 1;
-            actionInfo.subactionPaths = &m_input.gamepadPoseSubactionPath;
-            CHECK_XRCMD(xrCreateAction(m_input.actionSet, &actionInfo, &m_input.rightAction));
-
-            actionInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
-            strcpy_s(actionInfo.actionName, "menu");
-            strcpy_s(actionInfo.localizedActionName, "menu");
-            actionInfo.countSubactionPaths = 1;
-            actionInfo.subactionPaths = &m_input.gamepadPoseSubactionPath;
-            CHECK_XRCMD(xrCreateAction(m_input.actionSet, &actionInfo, &m_input.menuAction));
+            for (uint32_t i = 0; i < ButtonActionCount; i++) {
+                const ButtonAction& button = ButtonActions[i];
+                actionInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
+                strcpy_s(actionInfo.actionName, button.name);
+                strcpy_s(actionInfo.localizedActionName, button.name);
+                actionInfo.countSubactionPaths = button.perHand ? uint32_t(m_input.handSubactionPath.size()) : 1;
+                actionInfo.subactionPaths = button.perHand ? m_input.handSubactionPath.data() : &m_input.gamepadPoseSubactionPath;
+                CHECK_XRCMD(xrCreateAction(m_input.actionSet, &actionInfo, &m_input.buttonActions[i]));
+            }
         }
 
-        XrPath  selectClickPath;
-        XrPath  xClickPath;
-        XrPath  oClickPath;
-        XrPath  upClickPath;
-        XrPath  downClickPath;
-        XrPath  leftClickPath;
-        XrPath  rightClickPath;
-        XrPath  menuClickPath;
         XrPath  gamepadePosePath;
         std::array<XrPath, Side::COUNT>  aimPosePath;
-        std::array<XrPath, Side::COUNT>  handPinchPath;
-        std::array<XrPath, Side::COUNT>  handGripPath;
-        CHECK_XRCMD(xrStringToPath(m_instance, "/user/gamepad/input/select/click", &selectClickPath));
-        CHECK_XRCMD(xrStringToPath(m_instance, "/user/gamepad/input/x/click", &xClickPath));
-        CHECK_XRCMD(xrStringToPath(m_instance, "/user/gamepad/input/o/click", &oClickPath));
-        CHECK_XRCMD(xrStringToPath(m_instance, "/user/gamepad/input/up/click", &upClickPath));
-        CHECK_XRCMD(xrStringToPath(m_instance, "/user/gamepad/input/down/click", &downClickPath));
-        CHECK_XRCMD(xrStringToPath(m_instance, "/user/gamepad/input/left/click", &leftClickPath));
-        CHECK_XRCMD(xrStringToPath(m_instance, "/user/gamepad/input/right/click", &rightClickPath));
-        CHECK_XRCMD(xrStringToPath(m_instance, "/user/gamepad/input/menu/click", &menuClickPath));
         CHECK_XRCMD(xrStringToPath(m_instance, "/user/gamepad/input/aim/pose", &gamepadePosePath));
 
         CHECK_XRCMD(xrStringToPath(m_instance, "/user/hand/left/input/aim/pose", &aimPosePath[Side::LEFT]));
         CHECK_XRCMD(xrStringToPath(m_instance, "/user/hand/right/input/aim/pose", &aimPosePath[Side::RIGHT]));
-        CHECK_XRCMD(xrStringToPath(m_instance, "/user/hand/left/input/pinch/click", &handPinchPath[Side::LEFT]));
-        CHECK_XRCMD(xrStringToPath(m_instance, "/user/hand/right/input/pinch/click", &handPinchPath[Side::RIGHT]));
-        CHECK_XRCMD(xrStringToPath(m_instance, "/user/hand/left/input/squeeze/click", &handGripPath[Side::LEFT]));
-        CHECK_XRCMD(xrStringToPath(m_instance, "/user/hand/right/input/squeeze/click", &handGripPath[Side::RIGHT]));
 
 
         // Suggest bindings for the Rokid Station Controller.
@@ -809,24 +697,24 @@ struct OpenXrProgram : IOpenXrProgram {
             CHECK_XRCMD(xrStringToPath(m_instance, gamepadProfilePath, &gamepadInteractionProfilePath));
             CHECK_XRCMD(xrStringToPath(m_instance, handProfilePath, &handInteractionProfilePath));
 
-            std::vector<XrActionSuggestedBinding> gamepadbindings{{// Fall back to a click input for the grab action.
-                                                                   {m_input.gamepadPoseAction, gamepadePosePath},
-                                                                   {m_input.selectAction, selectClickPath},
-                                                                   {m_input.xAction, xClickPath},
-                                                                   {m_input.oAction, oClickPath},
-                                                                   {m_input.upAction, upClickPath},
-                                                                   {m_input.downAction, downClickPath},
-                                                                   {m_input.leftAction, leftClickPath},
-                                                                   {m_input.rightAction, rightClickPath},
-                                                                   {m_input.menuAction, menuClickPath}}};
-
-            std::vector<XrActionSuggestedBinding> handbindings{{// Fall back to a click input for the grab action.
-                                                                   {m_input.handPinchAction, handPinchPath[Side::LEFT]},
-                                                                   {m_input.handPinchAction, handPinchPath[Side::RIGHT]},
-                                                                   {m_input.handGripAction, handGripPath[Side::LEFT]},
-                                                                   {m_input.handGripAction, handGripPath[Side::RIGHT]},
-                                                                   {m_input.handAimPoseAction, aimPosePath[Side::LEFT]},
-                                                                   {m_input.handAimPoseAction, aimPosePath[Side::RIGHT]}}};
+            std::vector<XrActionSuggestedBinding> gamepadbindings{{m_input.gamepadPoseAction, gamepadePosePath}};
+            std::vector<XrActionSuggestedBinding> handbindings{{m_input.handAimPoseAction, aimPosePath[Side::LEFT]},
+                                                               {m_input.handAimPoseAction, aimPosePath[Side::RIGHT]}};
+
+            const auto bindingPath = [this](const char* subactionPath, const char* input) {
+                XrPath path;
+                CHECK_XRCMD(xrStringToPath(m_instance, (std::string(subactionPath) + input).c_str(), &path));
+                return path;
+            };
+            for (uint32_t i = 0; i < ButtonActionCount; i++) {
+                const ButtonAction& button = ButtonActions[i];
+                if (button.perHand) {
+                    handbindings.push_back({m_input.buttonActions[i], bindingPath("/user/hand/left", button.input)});
+                    handbindings.push_back({m_input.buttonActions[i], bindingPath("/user/hand/right", button.input)});
+                } else {
+                    gamepadbindings.push_back({m_input.buttonActions[i], bindingPath("/user/gamepad", button.input)});
+                }
+            }
 
 
             XrInteractionProfileSuggestedBinding suggestedGamepadBindings{XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING};
@@ -946,8 +834,11 @@ struct OpenXrProgram : IOpenXrProgram {
         }
     }
 
-    void InitializeApplication() override {
-        m_application->initialize(m_instance, m_session);
+    void InitializeApplication(StartupTasks& startup) override {
+        m_application->initialize(m_instance, m_session, m_enabledExtensions, startup);
+        if (!m_options.RecordSession.empty()) {
+            m_recorder.Open(m_options.RecordSession, static_cast<uint32_t>(m_views.size()));
+        }
     }
 
     void CreateSwapchains() override {
@@ -978,6 +869,12 @@ struct OpenXrProgram : IOpenXrProgram {
             CHECK_XRCMD(xrEnumerateSwapchainFormats(m_session, (uint32_t)swapchainFormats.size(), &swapchainFormatCount, swapchainFormats.data()));
             CHECK(swapchainFormatCount == swapchainFormats.size());
             m_colorSwapchainFormat = m_graphicsPlugin->SelectColorSwapchainFormat(swapchainFormats);
+            if (m_depthLayerSupported) {
+                m_depthSwapchainFormat = m_graphicsPlugin->SelectDepthSwapchainFormat(swapchainFormats);
+                if (m_depthSwapchainFormat == -1) {
+                    Log::Write(Log::Level::Warning, "No runtime swapchain format supported for depth swapchain, depth is not submitted");
+                }
+            }
 
             // Print swapchain formats and the selected one.
             {
@@ -996,15 +893,23 @@ struct OpenXrProgram : IOpenXrProgram {
                 Log::Write(Log::Level::Verbose, Fmt("Swapchain Formats: %s", swapchainFormatsString.c_str()));
             }
 
-            // Create a swapchain for each view.
-            for (uint32_t i = 0; i < viewCount; i++) {
-                const XrViewConfigurationView& vp = m_configViews[i];
-                Log::Write(Log::Level::Info, Fmt("Creating swapchain for view %d with dimensions Width=%d Height=%d SampleCount=%d, maxSampleCount=%d", i,
-                                                    vp.recommendedImageRectWidth, vp.recommendedImageRectHeight, vp.recommendedSwapchainSampleCount, vp.maxSwapchainSampleCount));
+            // Create a swapchain for each view, or with multiview a single array swapchain with one layer per view,
+            // sized for the larger of the views.
+            m_multiview = m_graphicsPlugin->SupportsMultiview() && viewCount == 2;
+            const uint32_t swapchainCount = m_multiview ? 1 : viewCount;
+            for (uint32_t i = 0; i < swapchainCount; i++) {
+                XrViewConfigurationView vp = m_configViews[i];
+                if (m_multiview) {
+                    vp.recommendedImageRectWidth = std::max(m_configViews[0].recommendedImageRectWidth, m_configViews[1].recommendedImageRectWidth);
+                    vp.recommendedImageRectHeight = std::max(m_configViews[0].recommendedImageRectHeight, m_configViews[1].recommendedImageRectHeight);
+                }
+                Log::Write(Log::Level::Info, Fmt("Creating swapchain for view %d with dimensions Width=%d Height=%d ArraySize=%d SampleCount=%d, maxSampleCount=%d", i,
+                                                    vp.recommendedImageRectWidth, vp.recommendedImageRectHeight, m_multiview ? viewCount : 1,
+                                                    vp.recommendedSwapchainSampleCount, vp.maxSwapchainSampleCount));
 
                 // Create the swapchain.
                 XrSwapchainCreateInfo swapchainCreateInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
-                swapchainCreateInfo.arraySize = 1;
+                swapchainCreateInfo.arraySize = m_multiview ? viewCount : 1;
                 swapchainCreateInfo.format = m_colorSwapchainFormat;
                 swapchainCreateInfo.width = vp.recommendedImageRectWidth;
                 swapchainCreateInfo.height = vp.recommendedImageRectHeight;
@@ -1018,18 +923,52 @@ struct OpenXrProgram : IOpenXrProgram {
                 CHECK_XRCMD(xrCreateSwapchain(m_session, &swapchainCreateInfo, &swapchain.handle));
 
                 m_swapchains.push_back(swapchain);
+                EnumerateSwapchainImages(swapchain.handle, swapchainCreateInfo);
+
+                // A depth swapchain with the same layout, submitted with the color one so the runtime can reproject positionally.
+                if (m_depthSwapchainFormat != -1) {
+                    XrSwapchainCreateInfo depthCreateInfo = swapchainCreateInfo;
+                    depthCreateInfo.format = m_depthSwapchainFormat;
+                    depthCreateInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+                    Swapchain depthSwapchain;
+                    depthSwapchain.width = depthCreateInfo.width;
+                    depthSwapchain.height = depthCreateInfo.height;
+                    CHECK_XRCMD(xrCreateSwapchain(m_session, &depthCreateInfo, &depthSwapchain.handle));
+
+                    m_depthSwapchains.push_back(depthSwapchain);
+                    EnumerateSwapchainImages(depthSwapchain.handle, depthCreateInfo);
+                }
 
-                uint32_t imageCount;
-                CHECK_XRCMD(xrEnumerateSwapchainImages(swapchain.handle, 0, &imageCount, nullptr));
-                // XXX This should really just return XrSwapchainImageBaseHeader*
-                std::vector<XrSwapchainImageBaseHeader*> swapchainImages = m_graphicsPlugin->AllocateSwapchainImageStructs(imageCount, swapchainCreateInfo);
-                CHECK_XRCMD(xrEnumerateSwapchainImages(swapchain.handle, imageCount, &imageCount, swapchainImages[0]));
-
-                m_swapchainImages.insert(std::make_pair(swapchain.handle, std::move(swapchainImages)));
+                const bool hasDepth = m_depthSwapchainFormat != -1;
+                m_graphicsPlugin->CreateSwapchainTargets(swapchainCreateInfo, m_swapchainImages[swapchain.handle],
+                                                         hasDepth ? m_swapchainImages[m_depthSwapchains.back().handle]
+                                                                  : std::vector<XrSwapchainImageBaseHeader*>());
             }
+            m_depthInfos.resize(viewCount, {XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR});
         }
     }
 
+    void EnumerateSwapchainImages(XrSwapchain handle, const XrSwapchainCreateInfo& swapchainCreateInfo) {
+        uint32_t imageCount;
+        CHECK_XRCMD(xrEnumerateSwapchainImages(handle, 0, &imageCount, nullptr));
+        // XXX This should really just return XrSwapchainImageBaseHeader*
+        std::vector<XrSwapchainImageBaseHeader*> swapchainImages = m_graphicsPlugin->AllocateSwapchainImageStructs(imageCount, swapchainCreateInfo);
+        CHECK_XRCMD(xrEnumerateSwapchainImages(handle, imageCount, &imageCount, swapchainImages[0]));
+
+        m_swapchainImages.insert(std::make_pair(handle, std::move(swapchainImages)));
+    }
+
+    uint32_t AcquireSwapchainImage(XrSwapchain handle) {
+        XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+        uint32_t swapchainImageIndex;
+        CHECK_XRCMD(xrAcquireSwapchainImage(handle, &acquireInfo, &swapchainImageIndex));
+
+        XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
+        waitInfo.timeout = XR_INFINITE_DURATION;
+        CHECK_XRCMD(xrWaitSwapchainImage(handle, &waitInfo));
+        return swapchainImageIndex;
+    }
+
     // Return event if one is available, otherwise return null.
     const XrEventDataBaseHeader* TryReadNextEvent() {
         // It is sufficient to clear the just the XrEventDataBuffer header to
@@ -1140,97 +1079,54 @@ struct OpenXrProgram : IOpenXrProgram {
         syncInfo.activeActionSets = &activeActionSet;
         CHECK_XRCMD(xrSyncActions(m_session, &syncInfo));
 
-        static float joystick_x[Side::COUNT] = {0};
-        static float joystick_y[Side::COUNT] = {0};
-        static float trigger[Side::COUNT] = {0};
-        static float squeeze[Side::COUNT] = {0};
-
-        // Get pose and grab action state and start haptic vibrate when hand is 90% squeezed.
-        for (auto hand : {Side::LEFT, Side::RIGHT}) {
-            ApplicationEvent &applicationEvent = m_applicationEvent[hand];
-            applicationEvent.controllerEventBit = 0x00;
-            // 获取手部pinch状态
-            XrActionStateGetInfo getPinchInfo{XR_TYPE_ACTION_STATE_GET_INFO, nullptr, m_input.handPinchAction, m_input.handSubactionPath[hand]};
-            XrActionStateBoolean pinchValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-            CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getPinchInfo, &pinchValue));
-            if (pinchValue.isActive == XR_TRUE) {
-                if (pinchValue.changedSinceLastSync == XR_TRUE) {
-                    applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_click_trigger;
-                    if (pinchValue.currentState == XR_TRUE) {
-                        Log::Write(Log::Level::Info, Fmt("RK-Openxr-hand-App:  hand pinch pressed !!!!!!!!!!!!!!!!!!!!"));
-                        applicationEvent.click_trigger = true;
-                    } else {
-                        applicationEvent.click_trigger = false;
-                    }
-                }
-            }
-            // 获取手部grip状态
-            XrActionStateGetInfo getGripInfo{XR_TYPE_ACTION_STATE_GET_INFO, nullptr, m_input.handGripAction, m_input.handSubactionPath[hand]};
-            XrActionStateBoolean gripValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-            CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getGripInfo, &gripValue));
-            if (gripValue.isActive == XR_TRUE) {
-                if(gripValue.changedSinceLastSync == XR_TRUE) {
-                    applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_click_menu;
-                    if(gripValue.currentState == XR_TRUE) {
-                        Log::Write(Log::Level::Info, Fmt("RK-Openxr-hand-App:  hand grip pressed !!!!!!!!!!!!!!!!!!!!"));
-                        applicationEvent.click_menu = true;
-                    } else{
-                        applicationEvent.click_menu = false;
-                    }
+        const int64_t syncTimeNs =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        // Pack the state of every button into the bitfield of its source.
+        std::array<uint32_t, INPUT_SOURCE_COUNT> buttonState{};
+        for (uint32_t i = 0; i < ButtonActionCount; i++) {
+            const ButtonAction& button = ButtonActions[i];
+            const uint32_t subactionCount = button.perHand ? Side::COUNT : 1;
+            for (uint32_t subaction = 0; subaction < subactionCount; subaction++) {
+                XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO, nullptr, m_input.buttonActions[i],
+                                             button.perHand ? m_input.handSubactionPath[subaction] : XR_NULL_PATH};
+                XrActionStateBoolean value{XR_TYPE_ACTION_STATE_BOOLEAN};
+                CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &value));
+                if (value.isActive == XR_TRUE && value.currentState == XR_TRUE) {
+                    buttonState[button.perHand ? subaction : INPUT_SOURCE_GAMEPAD] |= button.eventBit;
                 }
             }
-
-            m_application->inputEvent(hand, applicationEvent);
         }
 
-        // 控制器中间确认键
-        XrActionStateGetInfo getSelectInfo{XR_TYPE_ACTION_STATE_GET_INFO, nullptr, m_input.selectAction, XR_NULL_PATH};
-        XrActionStateBoolean selectValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-        CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getSelectInfo, &selectValue));
-        if ((selectValue.changedSinceLastSync == XR_TRUE) || (selectValue.currentState == XR_TRUE)) {
-            Log::Write(Log::Level::Info, Fmt("RK-Openxr-hand-App: The gamepad select key is pressed !!!!!!!!!!!!!!!!!!!!!"));
+        // Only sources whose bits changed since the last sync produce an event.
+        InputEventQueue& inputQueue = m_application->inputQueue();
+        for (int32_t source = 0; source < INPUT_SOURCE_COUNT; source++) {
+            const uint32_t changedBits = buttonState[source] ^ m_buttonState[source];
+            if (changedBits != 0) {
+                const InputEvent event{syncTimeNs, source, changedBits, buttonState[source]};
+                inputQueue.Push(event);
+                if (m_recorder.IsOpen()) {
+                    m_recorder.RecordInput(event);
+                }
+            }
         }
 
-        // 控制器侧边MENU键
-        XrActionStateGetInfo getMenuInfo{XR_TYPE_ACTION_STATE_GET_INFO, nullptr, m_input.menuAction, XR_NULL_PATH};
-        XrActionStateBoolean menuValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-        CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getMenuInfo, &menuValue));
-        if ((menuValue.changedSinceLastSync == XR_TRUE) || (menuValue.currentState == XR_TRUE)) {
-            Log::Write(Log::Level::Info, Fmt("RK-Openxr-hand-App: The gamepad menuValue key is pressed !!!!!!!!!!!!!!!!!!!!!"));
-        }
+        // System keys of the gamepad: O recenters the 3DoF ray when pressed, holding X exits the app and holding up
+        // recenters the head tracker.
+        const uint32_t gamepadPressed = buttonState[INPUT_SOURCE_GAMEPAD] & ~m_buttonState[INPUT_SOURCE_GAMEPAD];
+        const uint32_t gamepadHeld = buttonState[INPUT_SOURCE_GAMEPAD] & m_buttonState[INPUT_SOURCE_GAMEPAD];
+        m_buttonState = buttonState;
 
-        // 控制器O键--重置3Dof射线
-        XrActionStateGetInfo getOInfo{XR_TYPE_ACTION_STATE_GET_INFO, nullptr, m_input.oAction, XR_NULL_PATH};
-        XrActionStateBoolean oValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-        CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getOInfo, &oValue));
-        if ((oValue.changedSinceLastSync == XR_TRUE) || (oValue.currentState == XR_TRUE)) {
-            if (pfnXrRecenterPhonePose != nullptr) {
-                Log::Write(Log::Level::Info, Fmt("RK-Openxr-hand-App: pfnXrRecenterPhonePose................"));
-                CHECK_XRCMD(pfnXrRecenterPhonePose());
-            }
+        if ((gamepadPressed & CONTROLLER_EVENT_BIT_click_o) != 0 && pfnXrRecenterPhonePose != nullptr) {
+            Log::Write(Log::Level::Info, Fmt("RK-Openxr-hand-App: pfnXrRecenterPhonePose................"));
+            CHECK_XRCMD(pfnXrRecenterPhonePose());
         }
-
-        // 控制器X键 -- 退出应用
-        XrActionStateGetInfo getXInfo{XR_TYPE_ACTION_STATE_GET_INFO, nullptr, m_input.xAction, XR_NULL_PATH};
-        XrActionStateBoolean xValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-        CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getXInfo, &xValue));
-        if ((xValue.isActive == XR_TRUE) && (xValue.changedSinceLastSync == XR_FALSE) && (xValue.currentState == XR_TRUE)) {
-            if (pfnXrOpenCameraPreview != nullptr) {
-                Log::Write(Log::Level::Info, Fmt("RK-Openxr-hand-App: Byebye................"));
-                ExitAppByKey = true;
-//                CHECK_XRCMD(pfnXrOpenCameraPreview(reinterpret_cast<PFN_xrCameraUpdateCallback*>(OnCameraUpdate)));
-            }
+        if ((gamepadHeld & CONTROLLER_EVENT_BIT_click_x) != 0 && pfnXrOpenCameraPreview != nullptr && !ExitAppByKey) {
+            Log::Write(Log::Level::Info, Fmt("RK-Openxr-hand-App: Byebye................"));
+            ExitAppByKey = true;
         }
-
-        // 控制器上键
-        XrActionStateGetInfo getUpInfo{XR_TYPE_ACTION_STATE_GET_INFO, nullptr, m_input.upAction, XR_NULL_PATH};
-        XrActionStateBoolean upValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-        CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getUpInfo, &upValue));
-        if ((upValue.isActive == XR_TRUE) && (upValue.changedSinceLastSync == XR_FALSE) && (upValue.currentState == XR_TRUE)) {
-            if (pfnXrRecenterHeadTracker != nullptr) {
-                Log::Write(Log::Level::Info, Fmt("RK-Openxr-hand-App: pfnXrRecenterHeadTracker................"));
-                CHECK_XRCMD(pfnXrRecenterHeadTracker());
-            }
+        if ((gamepadHeld & CONTROLLER_EVENT_BIT_click_up) != 0 && pfnXrRecenterHeadTracker != nullptr) {
+            CHECK_XRCMD(pfnXrRecenterHeadTracker());
         }
 
         // 获取camera位姿
@@ -1266,19 +1162,35 @@ struct OpenXrProgram : IOpenXrProgram {
 
     void RenderFrame() override {
         CHECK(m_session != XR_NULL_HANDLE);
+        m_frameTiming.BeginFrame();
+
         XrFrameWaitInfo frameWaitInfo{XR_TYPE_FRAME_WAIT_INFO};
         XrFrameState frameState{XR_TYPE_FRAME_STATE};
-        CHECK_XRCMD(xrWaitFrame(m_session, &frameWaitInfo, &frameState));
+        {
+            FrameTiming::Scope timing(m_frameTiming, FrameTiming::XrWaitFrame);
+            CHECK_XRCMD(xrWaitFrame(m_session, &frameWaitInfo, &frameState));
+        }
 
         XrFrameBeginInfo frameBeginInfo{XR_TYPE_FRAME_BEGIN_INFO};
-        CHECK_XRCMD(xrBeginFrame(m_session, &frameBeginInfo));
+        {
+            FrameTiming::Scope timing(m_frameTiming, FrameTiming::XrBeginFrame);
+            CHECK_XRCMD(xrBeginFrame(m_session, &frameBeginInfo));
+        }
 
-        std::vector<XrCompositionLayerBaseHeader*> layers;
+        std::vector<const XrCompositionLayerBaseHeader*> layers;
         XrCompositionLayerProjection layer{XR_TYPE_COMPOSITION_LAYER_PROJECTION};
         std::vector<XrCompositionLayerProjectionView> projectionLayerViews;
         if (frameState.shouldRender == XR_TRUE) {
-            if (RenderLayer(frameState.predictedDisplayTime, projectionLayerViews, layer)) {
+            if (RenderLayer(frameState.predictedDisplayTime, frameState.predictedDisplayPeriod, projectionLayerViews, layer)) {
+                // Layers the application submits itself: underlays such as the video go below the projection layer,
+                // which then has to be blended by its alpha, overlays such as the dashboard quad go on top.
+                std::vector<const XrCompositionLayerBaseHeader*> overlays;
+                m_application->appendLayers(m_appSpace, layers, overlays);
+                if (!layers.empty()) {
+                    layer.layerFlags |= XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
+                }
                 layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&layer));
+                layers.insert(layers.end(), overlays.begin(), overlays.end());
             }
         }
 
@@ -1287,10 +1199,16 @@ struct OpenXrProgram : IOpenXrProgram {
         frameEndInfo.environmentBlendMode = m_options.Parsed.EnvironmentBlendMode;
         frameEndInfo.layerCount = (uint32_t)layers.size();
         frameEndInfo.layers = layers.data();
-        CHECK_XRCMD(xrEndFrame(m_session, &frameEndInfo));
+        {
+            FrameTiming::Scope timing(m_frameTiming, FrameTiming::XrEndFrame);
+            CHECK_XRCMD(xrEndFrame(m_session, &frameEndInfo));
+        }
+
+        m_frameTiming.EndFrame(frameState.predictedDisplayTime, frameState.predictedDisplayPeriod);
     }
 
-    bool RenderLayer(XrTime predictedDisplayTime, std::vector<XrCompositionLayerProjectionView>& projectionLayerViews, XrCompositionLayerProjection& layer) {
+    bool RenderLayer(XrTime predictedDisplayTime, XrDuration predictedDisplayPeriod, std::vector<XrCompositionLayerProjectionView>& projectionLayerViews, XrCompositionLayerProjection& layer) {
+        const FrameTiming::Clock::time_point locateStart = FrameTiming::Clock::now();
         XrResult res;
         XrViewState viewState{XR_TYPE_VIEW_STATE};
         uint32_t viewCapacityInput = (uint32_t)m_views.size();
@@ -1308,16 +1226,21 @@ struct OpenXrProgram : IOpenXrProgram {
 
         CHECK(viewCountOutput == viewCapacityInput);
         CHECK(viewCountOutput == m_configViews.size());
-        CHECK(viewCountOutput == m_swapchains.size());
+        CHECK(m_swapchains.size() == (m_multiview ? 1 : viewCountOutput));
 
         projectionLayerViews.resize(viewCountOutput);
 
+        // What the application is handed below, kept for the recording when there is one.
+        SessionRecording::Frame recorded{};
+
         // Hand Aim 手部射线方向
         for (auto hand : {Side::LEFT, Side::RIGHT}) {
             XrSpaceLocation spaceLocation{XR_TYPE_SPACE_LOCATION};
             res = xrLocateSpace(m_input.aimSpace[hand], m_appSpace, predictedDisplayTime, &spaceLocation);
             CHECK_XRRESULT(res, "xrLocateSpace");
             if (XR_UNQUALIFIED_SUCCESS(res)) {
+                recorded.aimFlags[hand] = spaceLocation.locationFlags;
+                recorded.aimPose[hand] = spaceLocation.pose;
                 if ((spaceLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0 &&
                     (spaceLocation.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0) {
 //                    Log::Write(Log::Level::Info, Fmt("RK-Openxr-hand-app: handtype=%d, hand aimSpace : pose(%f %f %f)  orientation(%f %f %f %f)", int(hand),
@@ -1325,6 +1248,8 @@ struct OpenXrProgram : IOpenXrProgram {
 //                                                     spaceLocation.pose.orientation.x, spaceLocation.pose.orientation.y, spaceLocation.pose.orientation.z, spaceLocation.pose.orientation.w));
 #ifdef USE_HAND_AIM
                     m_application->setControllerPose(int(hand), spaceLocation.pose);
+                    recorded.controllerPoseMask |= 1u << hand;
+                    recorded.controllerPose[hand] = spaceLocation.pose;
 #endif
                 }
             }
@@ -1336,6 +1261,8 @@ struct OpenXrProgram : IOpenXrProgram {
             res = xrLocateSpace(m_input.gamepadPoseSpace, m_appSpace, predictedDisplayTime, &spaceLocation);
             CHECK_XRRESULT(res, "xrLocateSpace");
             if (XR_UNQUALIFIED_SUCCESS(res)) {
+                recorded.gamepadFlags = spaceLocation.locationFlags;
+                recorded.gamepadPose = spaceLocation.pose;
                 if ((spaceLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0 ||
                     (spaceLocation.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0) {
 //                    Log::Write(Log::Level::Info, Fmt("RK-Openxr-hand-app: gamepad pose(%f %f %f)  orientation(%f %f %f %f)",
@@ -1343,6 +1270,8 @@ struct OpenXrProgram : IOpenXrProgram {
 //                                                     spaceLocation.pose.orientation.x, spaceLocation.pose.orientation.y, spaceLocation.pose.orientation.z, spaceLocation.pose.orientation.w));
 #ifndef USE_HAND_AIM
                     m_application->setControllerPose(int(0), spaceLocation.pose);
+                    recorded.controllerPoseMask |= 1u;
+                    recorded.controllerPose[0] = spaceLocation.pose;
 #endif
                 }
             }
@@ -1373,38 +1302,104 @@ struct OpenXrProgram : IOpenXrProgram {
         XrSpaceLocation spaceLocation{XR_TYPE_SPACE_LOCATION, &velocity};
         res = xrLocateSpace(m_ViewSpace, m_appSpace, predictedDisplayTime, &spaceLocation);
         CHECK_XRRESULT(res, "xrLocateSpace");
+        m_frameTiming.Record(FrameTiming::LocateSpaces, locateStart);
+
+        const TrackingSnapshot& trackingSnapshot = m_tracking.Acquire();
+        m_application->setTrackingSnapshot(trackingSnapshot);
+
+        if (m_recorder.IsOpen()) {
+            recorded.predictedDisplayPeriod = predictedDisplayPeriod;
+            recorded.viewCount = std::min<uint32_t>(viewCountOutput, SessionRecording::MaxViews);
+            for (uint32_t i = 0; i < recorded.viewCount; i++) {
+                recorded.views[i] = {m_views[i].pose, m_views[i].fov};
+            }
+            memcpy(recorded.joints, jointLocations, sizeof(recorded.joints));
+            m_recorder.RecordTracking(trackingSnapshot);
+            m_recorder.RecordFrame(predictedDisplayTime, recorded);
+        }
+
+        // The GPU frame starts before update(), which records offscreen passes such as the dashboard panel.
+        m_graphicsPlugin->BeginGpuFrame();
+        {
+            FrameTiming::Scope timing(m_frameTiming, FrameTiming::AppUpdate);
+            m_application->update(predictedDisplayTime, predictedDisplayPeriod);
+        }
+
+        // Pick this frame's render scale from the latest completed GPU frame, the views then cover only that part of
+        // the swapchain image and the compositor upsamples it.
+        int64_t gpuFrameNs = 0;
+        if (m_graphicsPlugin->GetGpuFrameTime(gpuFrameNs)) {
+            m_renderScale.Update(gpuFrameNs, predictedDisplayPeriod);
+        }
 
         XrPosef pose[Side::COUNT];
         for (uint32_t i = 0; i < viewCountOutput; i++) {
             pose[i] = m_views[i].pose;
         }
 
-        // Render view to the appropriate part of the swapchain image.
-        for (uint32_t i = 0; i < viewCountOutput; i++) {
-            // Each view has a separate swapchain which is acquired, rendered to, and released.
-            const Swapchain viewSwapchain = m_swapchains[i];
-            XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
-            uint32_t swapchainImageIndex;
-            CHECK_XRCMD(xrAcquireSwapchainImage(viewSwapchain.handle, &acquireInfo, &swapchainImageIndex));
-
-            XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
-            waitInfo.timeout = XR_INFINITE_DURATION;
-            CHECK_XRCMD(xrWaitSwapchainImage(viewSwapchain.handle, &waitInfo));
-
-            projectionLayerViews[i] = {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW};
-            projectionLayerViews[i].pose = pose[i];
-            projectionLayerViews[i].fov = m_views[i].fov;
-            projectionLayerViews[i].subImage.swapchain = viewSwapchain.handle;
-            projectionLayerViews[i].subImage.imageRect.offset = {0, 0};
-            projectionLayerViews[i].subImage.imageRect.extent = {viewSwapchain.width, viewSwapchain.height};
+        // Record the passes that render each view to the appropriate part of its swapchain image. Each view has a
+        // separate swapchain, with multiview the only swapchain holds all views, one per array layer, and they are
+        // rendered in a single pass. All images stay acquired until the recorded passes have run.
+        const bool submitDepth = !m_depthSwapchains.empty();
+        for (uint32_t s = 0; s < m_swapchains.size(); s++) {
+            const Swapchain viewSwapchain = m_swapchains[s];
+            const FrameTiming::Clock::time_point acquireStart = FrameTiming::Clock::now();
+            const uint32_t swapchainImageIndex = AcquireSwapchainImage(viewSwapchain.handle);
+
+            // The depth swapchain mirrors the color one, without it the plugin renders into a private depth buffer.
+            const XrSwapchainImageBaseHeader* depthImage = nullptr;
+            if (submitDepth) {
+                depthImage = m_swapchainImages[m_depthSwapchains[s].handle][AcquireSwapchainImage(m_depthSwapchains[s].handle)];
+            }
+            m_frameTiming.Record(FrameTiming::AcquireImages, acquireStart);
+
+            const uint32_t firstView = m_multiview ? 0 : s;
+            const uint32_t endView = m_multiview ? viewCountOutput : s + 1;
+            for (uint32_t i = firstView; i < endView; i++) {
+                projectionLayerViews[i] = {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW};
+                projectionLayerViews[i].pose = pose[i];
+                projectionLayerViews[i].fov = m_views[i].fov;
+                projectionLayerViews[i].subImage.swapchain = viewSwapchain.handle;
+                projectionLayerViews[i].subImage.imageRect.offset = {0, 0};
+                projectionLayerViews[i].subImage.imageRect.extent = m_renderScale.Apply(viewSwapchain.width, viewSwapchain.height);
+                projectionLayerViews[i].subImage.imageArrayIndex = m_multiview ? i : 0;
+
+                if (submitDepth) {
+                    XrCompositionLayerDepthInfoKHR& depthInfo = m_depthInfos[i];
+                    depthInfo = {XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR};
+                    depthInfo.subImage = projectionLayerViews[i].subImage;
+                    depthInfo.subImage.swapchain = m_depthSwapchains[s].handle;
+                    depthInfo.minDepth = 0.0f;
+                    depthInfo.maxDepth = 1.0f;
+                    depthInfo.nearZ = ProjectionNearZ;
+                    depthInfo.farZ = ProjectionFarZ;
+                    projectionLayerViews[i].next = &depthInfo;
+                }
+            }
 
             const XrSwapchainImageBaseHeader* const swapchainImage = m_swapchainImages[viewSwapchain.handle][swapchainImageIndex];
 
-            m_graphicsPlugin->RenderView(m_application, projectionLayerViews[i], swapchainImage, m_colorSwapchainFormat, i);
+            if (m_multiview) {
+                m_graphicsPlugin->RenderMultiView(m_application, projectionLayerViews, swapchainImage, depthImage, m_colorSwapchainFormat);
+            } else {
+                m_graphicsPlugin->RenderView(m_application, projectionLayerViews[s], swapchainImage, depthImage, m_colorSwapchainFormat, s);
+            }
+        }
+
+        // Timed where the render graph runs each pass, the offscreen passes apart from each eye's.
+        const IGraphicsPlugin::PassTimes passTimes = m_graphicsPlugin->RenderPasses();
+        m_frameTiming.Add(FrameTiming::OffscreenPasses, passTimes.offscreenNs);
+        m_frameTiming.Add(FrameTiming::RenderViewLeft, passTimes.eyeNs[0]);
+        m_frameTiming.Add(FrameTiming::RenderViewRight, passTimes.eyeNs[1]);
 
-            XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
-            CHECK_XRCMD(xrReleaseSwapchainImage(viewSwapchain.handle, &releaseInfo));
+        XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+        for (uint32_t s = 0; s < m_swapchains.size(); s++) {
+            CHECK_XRCMD(xrReleaseSwapchainImage(m_swapchains[s].handle, &releaseInfo));
+            if (submitDepth) {
+                CHECK_XRCMD(xrReleaseSwapchainImage(m_depthSwapchains[s].handle, &releaseInfo));
+            }
         }
+        m_graphicsPlugin->EndGpuFrame();
 
         layer.space = m_appSpace;
         layer.viewCount = (uint32_t)projectionLayerViews.size();
@@ -1418,6 +1413,7 @@ struct OpenXrProgram : IOpenXrProgram {
         std::shared_ptr<IPlatformPlugin> m_platformPlugin;
         std::shared_ptr<IGraphicsPlugin> m_graphicsPlugin;
         XrInstance m_instance{XR_NULL_HANDLE};
+        std::vector<std::string> m_enabledExtensions;
         XrSession m_session{XR_NULL_HANDLE};
         XrSpace m_appSpace{XR_NULL_HANDLE};
         XrSystemId m_systemId{XR_NULL_SYSTEM_ID};
@@ -1427,6 +1423,11 @@ struct OpenXrProgram : IOpenXrProgram {
         std::map<XrSwapchain, std::vector<XrSwapchainImageBaseHeader*>> m_swapchainImages;
         std::vector<XrView> m_views;
         int64_t m_colorSwapchainFormat{-1};
+        bool m_depthLayerSupported{false};
+        int64_t m_depthSwapchainFormat{-1};
+        std::vector<Swapchain> m_depthSwapchains;  // parallel to m_swapchains, empty when depth is not submitted
+        std::vector<XrCompositionLayerDepthInfoKHR> m_depthInfos;  // chained to the projection views until xrEndFrame
+        bool m_multiview{false};  // one array swapchain for both views, rendered in a single pass
 
         // Application's current lifecycle state according to the runtime
         XrSessionState m_sessionState{XR_SESSION_STATE_UNKNOWN};
@@ -1439,13 +1440,19 @@ struct OpenXrProgram : IOpenXrProgram {
 
         std::shared_ptr<IApplication> m_application;
 
+        FrameTiming m_frameTiming;
+        RenderScale m_renderScale;
+        TrackingWorker m_tracking;
+        MarkerDatabase m_markerDatabase;
+        SessionRecorder m_recorder;  // open while debug.xr.recordSession names a file
+
         //hand tracking
         PFN_DECLARE(xrCreateHandTrackerEXT);
         PFN_DECLARE(xrDestroyHandTrackerEXT);
         PFN_DECLARE(xrLocateHandJointsEXT);
         XrHandTrackerEXT m_handTracker[Side::COUNT] = {0};
 
-        ApplicationEvent m_applicationEvent[Side::COUNT] = {0};
+        std::array<uint32_t, INPUT_SOURCE_COUNT> m_buttonState{};  // button bitfields of the previous sync
 
         bool ExitAppByKey = false;
     };
@@ -4,6 +4,8 @@
 
 #pragma once
 
+class StartupTasks;
+
 struct IOpenXrProgram {
     virtual ~IOpenXrProgram() = default;
 
@@ -21,7 +23,8 @@ struct IOpenXrProgram {
     // properties, getting the view configuration and grabbing the resulting swapchain images.
     virtual void CreateSwapchains() = 0;
 
-    virtual void InitializeApplication() = 0;
+    // Initializes what the application needs for its first frame, the rest is added to startup.
+    virtual void InitializeApplication(StartupTasks& startup) = 0;
 
     // Process any events in the event queue.
     virtual void PollEvents(bool* exitRenderLoop, bool* requestRestart) = 0;
@@ -44,24 +47,23 @@ struct IOpenXrProgram {
     // and enable Marker recognition features.
     virtual void InitializeMarker() = 0;
 
+    // Decodes the Marker images, or maps them from the cache under cacheDir that earlier launches left behind.
+    // Touches neither the instance nor the session, so it runs on a worker thread while those are created.
+    virtual void LoadMarkerImages(const std::string& cacheDir) = 0;
+
     // Virtual function for adding images to the Marker database.
     // This function should be implemented to add specific image data to the Marker system for recognition.
+    // Adds the images prepared by LoadMarkerImages.
     virtual void AddMarkerImages() = 0;
 
-    // Virtual function for processing Marker data.
-    // This function should be implemented to handle events related to Marker additions, updates,
-    // and removals, and to update the corresponding application logic.
-    virtual void ProcessMarkerData() = 0;
-
     // Virtual function for initializing the Plane Tracking functionality.
     // This function should be implemented to load plane tracking-related extension interfaces
     // and enable plane detection features.
     virtual void InitializePlaneTracking() = 0;
 
-    // Virtual function for processing plane tracking data.
-    // This function should be implemented to handle events related to plane additions, updates,
-    // and removals, and to update the corresponding application logic.
-    virtual void ProcessPlaneTracking() = 0;
+    // Starts polling the Marker and Plane trackers that were initialized on a worker thread. Their results reach the
+    // application through a snapshot read once per frame, so tracking never blocks the frame loop.
+    virtual void StartTracking() = 0;
 
 
 };
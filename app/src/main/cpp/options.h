@@ -15,6 +15,24 @@ struct Options {
 
     std::string AppSpace{"Local"};
 
+    bool Multiview{true};//单pass双眼渲染（GL_OVR_multiview2），不支持时自动回退到逐眼渲染
+
+    bool GuiQuadLayer{true};//仪表盘作为XrCompositionLayerQuad提交，而不是画进眼缓冲
+
+    bool VideoSurfaceLayer{false};//视频解码到Android surface交换链，按播放模式提交equirect2或quad层
+
+    std::string VideoFile;//启动后播放的视频文件（绝对路径），空则不播放
+
+    bool DynamicResolution{true};//按GPU帧耗时缩放投影层的imageRect，超预算时降低渲染分辨率
+
+    std::string GlValidation;//GL校验级别：Off|Callback|Pass|Call，空则用编译时的默认级别（GL_VALIDATION）
+
+    bool Depth16{false};//眼缓冲深度用16位（私有深度纹理和深度交换链都优先D16），深度带宽减半，远处精度降低
+
+    uint32_t GpuMemoryBudgetMB{0};//纹理和缓冲的显存预算（MB），超出时驱逐可重建的缓存（如字形），0为不限制
+
+    std::string RecordSession;//把每帧交给应用的位姿、手部关节、输入和跟踪结果录到这个文件（绝对路径），空则不录制
+
     struct {
         XrFormFactor FormFactor{XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY};
 
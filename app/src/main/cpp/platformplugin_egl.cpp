@@ -0,0 +1,27 @@
+// Copyright (c) 2017-2020 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "pch.h"
+#include "common.h"
+#include "platformdata.h"
+#include "platformplugin.h"
+
+#ifdef XR_USE_PLATFORM_EGL
+
+namespace {
+// Linux without a window system, e.g. the headless graphics plugin against the stand-in runtime: the instance needs
+// nothing from the platform, the graphics plugin asks for XR_MNDX_egl_enable itself.
+struct EglPlatformPlugin : public IPlatformPlugin {
+    EglPlatformPlugin(const std::shared_ptr<Options>& /*unused*/) {}
+
+    std::vector<std::string> GetInstanceExtensions() const override { return {}; }
+
+    XrBaseInStructure* GetInstanceCreateExtension() const override { return nullptr; }
+};
+}  // namespace
+
+std::shared_ptr<IPlatformPlugin> CreatePlatformPlugin_Egl(const std::shared_ptr<Options>& options) {
+    return std::make_shared<EglPlatformPlugin>(options);
+}
+#endif
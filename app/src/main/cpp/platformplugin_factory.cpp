@@ -28,6 +28,8 @@ std::shared_ptr<IPlatformPlugin> CreatePlatformPlugin_Xcb(const std::shared_ptr<
 std::shared_ptr<IPlatformPlugin> CreatePlatformPlugin_Android(const std::shared_ptr<Options>& /*unused*/,
                                                               const std::shared_ptr<PlatformData>& /*unused*/);
 
+std::shared_ptr<IPlatformPlugin> CreatePlatformPlugin_Egl(const std::shared_ptr<Options>& options);
+
 std::shared_ptr<IPlatformPlugin> CreatePlatformPlugin(const std::shared_ptr<Options>& options,
                                                       const std::shared_ptr<PlatformData>& data) {
 #if !defined(XR_USE_PLATFORM_ANDROID)
@@ -44,6 +46,8 @@ std::shared_ptr<IPlatformPlugin> CreatePlatformPlugin(const std::shared_ptr<Opti
     return CreatePlatformPlugin_Xcb(options);
 #elif defined(XR_USE_PLATFORM_WAYLAND)
     return CreatePlatformPlugin_Wayland(options);
+#elif defined(XR_USE_PLATFORM_EGL)
+    return CreatePlatformPlugin_Egl(options);
 #else
 #error Unsupported platform or no XR platform defined!
 #endif
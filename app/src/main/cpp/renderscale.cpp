@@ -0,0 +1,40 @@
+#include "pch.h"
+#include "common.h"
+#include "renderscale.h"
+
+bool RenderScale::Update(int64_t gpuFrameNs, XrDuration predictedDisplayPeriod) {
+    if (!m_enabled || predictedDisplayPeriod <= 0) {
+        return false;
+    }
+    if (m_settle > 0) {
+        m_settle--;
+        return false;
+    }
+
+    const float budget = static_cast<float>(gpuFrameNs) / static_cast<float>(predictedDisplayPeriod);
+    m_overBudget = budget > HighWatermark ? m_overBudget + 1 : 0;
+    m_underBudget = budget < LowWatermark ? m_underBudget + 1 : 0;
+
+    float scale = m_scale;
+    if (m_overBudget >= FramesToShrink) {
+        scale = std::max(MinScale, m_scale - Step);
+    } else if (m_underBudget >= FramesToGrow) {
+        scale = std::min(MaxScale, m_scale + Step);
+    }
+    if (scale == m_scale) {
+        return false;
+    }
+
+    Log::Write(Log::Level::Info, Fmt("RenderScale: %.2f -> %.2f, GPU frame %.2fms of %.2fms", m_scale, scale, gpuFrameNs / 1000000.0f,
+                                     predictedDisplayPeriod / 1000000.0f));
+    m_scale = scale;
+    m_overBudget = 0;
+    m_underBudget = 0;
+    m_settle = SettleFrames;
+    return true;
+}
+
+XrExtent2Di RenderScale::Apply(int32_t width, int32_t height) const {
+    const auto scaled = [this](int32_t size) { return std::min(size, std::max(1, static_cast<int32_t>(size * m_scale) & ~1)); };
+    return {scaled(width), scaled(height)};
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+// Picks the fraction of the swapchain extent that is rendered each frame from the measured GPU frame time.
+// The scale drops a step as soon as a few consecutive frames go over budget, and only climbs back after a long run of
+// frames with clear headroom, so it settles instead of oscillating around the budget. After every change the controller
+// waits for frames rendered at the new scale before judging again, the GPU timings arrive a few frames late.
+class RenderScale {
+   public:
+    static constexpr float MinScale = 0.6f;
+    static constexpr float MaxScale = 1.0f;
+    static constexpr float Step = 0.05f;
+
+    // Budget fractions of the display period: above High the scale shrinks, below Low it may grow.
+    static constexpr float HighWatermark = 0.9f;
+    static constexpr float LowWatermark = 0.7f;
+
+    static constexpr uint32_t FramesToShrink = 3;
+    static constexpr uint32_t FramesToGrow = 90;
+    static constexpr uint32_t SettleFrames = 8;
+
+    explicit RenderScale(bool enabled) : m_enabled(enabled) {}
+
+    // Feeds the GPU time of a completed frame, returns true when the scale changed.
+    bool Update(int64_t gpuFrameNs, XrDuration predictedDisplayPeriod);
+
+    float Scale() const { return m_scale; }
+
+    // The rendered extent of a width x height swapchain image at the current scale, kept even and at least 1x1.
+    XrExtent2Di Apply(int32_t width, int32_t height) const;
+
+   private:
+    bool m_enabled;
+    float m_scale{MaxScale};
+    uint32_t m_overBudget{0};
+    uint32_t m_underBudget{0};
+    uint32_t m_settle{0};
+};
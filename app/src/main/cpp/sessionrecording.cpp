@@ -0,0 +1,320 @@
+#include "pch.h"
+#include "common.h"
+#include "sessionrecording.h"
+#include "offscreenviews.h"
+
+#include <chrono>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace SessionRecording;
+
+namespace {
+constexpr size_t RecordAlignment = 8;
+
+// The layout is the file format, it must not depend on the ABI.
+static_assert(sizeof(FileHeader) == 16, "FileHeader layout");
+static_assert(sizeof(RecordHeader) == 16, "RecordHeader layout");
+static_assert(sizeof(InputEvent) == 24, "InputEvent layout");
+static_assert(sizeof(Tracking) == 24, "Tracking layout");
+static_assert(sizeof(Marker) == 48, "Marker layout");
+static_assert(sizeof(Plane) == 64, "Plane layout");
+static_assert(sizeof(XrHandJointLocationEXT) == 40, "XrHandJointLocationEXT layout");
+
+size_t Padded(size_t size) { return (size + RecordAlignment - 1) & ~(RecordAlignment - 1); }
+
+size_t PageSize() {
+    static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return pageSize;
+}
+
+int64_t SteadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}  // namespace
+
+bool SessionRecorder::Open(const std::string& path, uint32_t viewCount) {
+    Close();
+    m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        Log::Write(Log::Level::Error, Fmt("SessionRecorder: cannot create %s: %s", path.c_str(), strerror(errno)));
+        return false;
+    }
+    m_offset = 0;
+    m_trackingVersion = 0;
+    m_frames = 0;
+    m_failed = false;
+
+    uint8_t* header = Reserve(sizeof(FileHeader));
+    if (header == nullptr) {
+        Close();
+        return false;
+    }
+    FileHeader fileHeader{};
+    memcpy(fileHeader.magic, Magic, sizeof(Magic));
+    fileHeader.version = Version;
+    fileHeader.viewCount = viewCount;
+    memcpy(header, &fileHeader, sizeof(fileHeader));
+    m_offset += sizeof(FileHeader);
+    Log::Write(Log::Level::Info, Fmt("SessionRecorder: recording to %s", path.c_str()));
+    return true;
+}
+
+void SessionRecorder::Close() {
+    if (m_window != nullptr) {
+        munmap(m_window, m_windowSize);
+        m_window = nullptr;
+    }
+    if (m_fd >= 0) {
+        if (ftruncate(m_fd, static_cast<off_t>(m_offset)) != 0) {
+            Log::Write(Log::Level::Warning, Fmt("SessionRecorder: cannot trim the recording: %s", strerror(errno)));
+        }
+        close(m_fd);
+        m_fd = -1;
+        Log::Write(Log::Level::Info, Fmt("SessionRecorder: %u frames, %zu bytes", m_frames, m_offset));
+    }
+}
+
+uint8_t* SessionRecorder::Reserve(size_t size) {
+    if (m_fd < 0 || m_failed) {
+        return nullptr;
+    }
+    if (m_window != nullptr && m_offset + size <= m_windowOffset + m_windowSize) {
+        return m_window + (m_offset - m_windowOffset);
+    }
+
+    // Move the window to the page of m_offset and grow the file under it, the new tail reads as zeros.
+    if (m_window != nullptr) {
+        munmap(m_window, m_windowSize);
+        m_window = nullptr;
+    }
+    m_windowOffset = m_offset & ~(PageSize() - 1);
+    m_windowSize = std::max(WindowSize, (m_offset - m_windowOffset + size + PageSize() - 1) & ~(PageSize() - 1));
+    void* window = MAP_FAILED;
+    if (ftruncate(m_fd, static_cast<off_t>(m_windowOffset + m_windowSize)) == 0) {
+        window = mmap(nullptr, m_windowSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, static_cast<off_t>(m_windowOffset));
+    }
+    if (window == MAP_FAILED) {
+        Log::Write(Log::Level::Error, Fmt("SessionRecorder: cannot grow the recording, stopped: %s", strerror(errno)));
+        m_failed = true;
+        return nullptr;
+    }
+    m_window = static_cast<uint8_t*>(window);
+    return m_window + (m_offset - m_windowOffset);
+}
+
+void SessionRecorder::Commit(uint8_t* record, RecordType type, uint32_t size, int64_t time) {
+    RecordHeader header{RecordType::End, size, time};
+    memcpy(record, &header, sizeof(header));
+    memcpy(record + offsetof(RecordHeader, type), &type, sizeof(type));
+    m_offset += sizeof(RecordHeader) + Padded(size);
+}
+
+void SessionRecorder::RecordInput(const InputEvent& event) {
+    uint8_t* record = Reserve(sizeof(RecordHeader) + Padded(sizeof(event)));
+    if (record != nullptr) {
+        memcpy(record + sizeof(RecordHeader), &event, sizeof(event));
+        Commit(record, RecordType::Input, sizeof(event), event.timeNs);
+    }
+}
+
+void SessionRecorder::RecordTracking(const TrackingSnapshot& snapshot) {
+    if (snapshot.version == m_trackingVersion) {
+        return;
+    }
+    const size_t size = sizeof(Tracking) + snapshot.markers.size() * sizeof(Marker) + snapshot.planes.size() * sizeof(Plane);
+    uint8_t* record = Reserve(sizeof(RecordHeader) + Padded(size));
+    if (record == nullptr) {
+        return;
+    }
+    m_trackingVersion = snapshot.version;
+
+    uint8_t* out = record + sizeof(RecordHeader);
+    const Tracking tracking{snapshot.version, snapshot.timeNs, static_cast<uint32_t>(snapshot.markers.size()),
+                            static_cast<uint32_t>(snapshot.planes.size())};
+    memcpy(out, &tracking, sizeof(tracking));
+    out += sizeof(tracking);
+    for (const TrackingSnapshot::Marker& marker : snapshot.markers) {
+        Marker recorded{static_cast<int64_t>(marker.handle), {}, {}, 0};
+        memcpy(recorded.pose, marker.pose, sizeof(recorded.pose));
+        memcpy(recorded.extent, marker.extent, sizeof(recorded.extent));
+        memcpy(out, &recorded, sizeof(recorded));
+        out += sizeof(recorded);
+    }
+    for (const TrackingSnapshot::Plane& plane : snapshot.planes) {
+        Plane recorded{plane.handle, plane.type, {}, {}, {}};
+        memcpy(recorded.pose, plane.pose, sizeof(recorded.pose));
+        memcpy(recorded.center, plane.center, sizeof(recorded.center));
+        memcpy(recorded.normal, plane.normal, sizeof(recorded.normal));
+        memcpy(out, &recorded, sizeof(recorded));
+        out += sizeof(recorded);
+    }
+    Commit(record, RecordType::Tracking, static_cast<uint32_t>(size), snapshot.timeNs);
+}
+
+void SessionRecorder::RecordFrame(XrTime predictedDisplayTime, const Frame& frame) {
+    uint8_t* record = Reserve(sizeof(RecordHeader) + Padded(sizeof(frame)));
+    if (record != nullptr) {
+        memcpy(record + sizeof(RecordHeader), &frame, sizeof(frame));
+        Commit(record, RecordType::Frame, sizeof(frame), predictedDisplayTime);
+        m_frames++;
+    }
+}
+
+bool SessionReplayer::Open(const std::string& path) {
+    Unmap();
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        Log::Write(Log::Level::Error, Fmt("SessionReplayer: cannot open %s: %s", path.c_str(), strerror(errno)));
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(FileHeader)) {
+        void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            m_mapped = static_cast<const uint8_t*>(mapped);
+            m_mappedSize = static_cast<size_t>(st.st_size);
+            madvise(mapped, m_mappedSize, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+    if (m_mapped == nullptr) {
+        Log::Write(Log::Level::Error, Fmt("SessionReplayer: cannot map %s", path.c_str()));
+        return false;
+    }
+
+    FileHeader header;
+    memcpy(&header, m_mapped, sizeof(header));
+    if (memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version || header.viewCount == 0 ||
+        header.viewCount > MaxViews) {
+        Log::Write(Log::Level::Error, Fmt("SessionReplayer: %s is not a version %u recording", path.c_str(), Version));
+        Unmap();
+        return false;
+    }
+    m_viewCount = header.viewCount;
+    m_offset = sizeof(FileHeader);
+    m_released = 0;
+    m_tracking = {};
+    Log::Write(Log::Level::Info, Fmt("SessionReplayer: %s, %zu bytes", path.c_str(), m_mappedSize));
+    return true;
+}
+
+void SessionReplayer::Unmap() {
+    if (m_mapped != nullptr) {
+        munmap(const_cast<uint8_t*>(m_mapped), m_mappedSize);
+        m_mapped = nullptr;
+        m_mappedSize = 0;
+    }
+}
+
+const Frame* SessionReplayer::Next(IApplication& application, XrTime& predictedDisplayTime) {
+    while (m_mapped != nullptr && m_offset + sizeof(RecordHeader) <= m_mappedSize) {
+        RecordHeader header;
+        memcpy(&header, m_mapped + m_offset, sizeof(header));
+        const uint8_t* payload = m_mapped + m_offset + sizeof(RecordHeader);
+        if (header.type == RecordType::End || m_offset + sizeof(RecordHeader) + header.size > m_mappedSize) {
+            break;
+        }
+        m_offset += sizeof(RecordHeader) + Padded(header.size);
+
+        switch (header.type) {
+            case RecordType::Input: {
+                // Stamped when it is handed over, the application's input latency is then that of the replay.
+                InputEvent event;
+                memcpy(&event, payload, sizeof(event));
+                event.timeNs = SteadyNowNs();
+                application.inputQueue().Push(event);
+                break;
+            }
+            case RecordType::Tracking: {
+                Tracking tracking;
+                memcpy(&tracking, payload, sizeof(tracking));
+                m_tracking.version = tracking.version;
+                m_tracking.timeNs = tracking.timeNs;
+                m_tracking.markers.resize(tracking.markerCount);
+                m_tracking.planes.resize(tracking.planeCount);
+                const uint8_t* in = payload + sizeof(tracking);
+                for (TrackingSnapshot::Marker& marker : m_tracking.markers) {
+                    Marker recorded;
+                    memcpy(&recorded, in, sizeof(recorded));
+                    in += sizeof(recorded);
+                    marker.handle = static_cast<intptr_t>(recorded.handle);
+                    memcpy(marker.pose, recorded.pose, sizeof(marker.pose));
+                    memcpy(marker.extent, recorded.extent, sizeof(marker.extent));
+                }
+                for (TrackingSnapshot::Plane& plane : m_tracking.planes) {
+                    Plane recorded;
+                    memcpy(&recorded, in, sizeof(recorded));
+                    in += sizeof(recorded);
+                    plane.handle = recorded.handle;
+                    plane.type = recorded.type;
+                    memcpy(plane.pose, recorded.pose, sizeof(plane.pose));
+                    memcpy(plane.center, recorded.center, sizeof(plane.center));
+                    memcpy(plane.normal, recorded.normal, sizeof(plane.normal));
+                }
+                break;
+            }
+            case RecordType::Frame: {
+                // Records are 8 byte aligned in a page aligned mapping, the frame can be used in place.
+                const Frame* frame = reinterpret_cast<const Frame*>(payload);
+                for (uint32_t i = 0; i < 2; i++) {
+                    if ((frame->controllerPoseMask & (1u << i)) != 0) {
+                        application.setControllerPose(static_cast<int>(i), frame->controllerPose[i]);
+                    }
+                }
+                memcpy(m_joints, frame->joints, sizeof(m_joints));
+                application.setHandJointLocation(&m_joints[0][0]);
+                application.setTrackingSnapshot(m_tracking);
+
+                // What was played is not needed again, give its pages back every few windows.
+                const size_t played = m_offset & ~(PageSize() - 1);
+                if (played - m_released >= 4 * SessionRecorder::WindowSize) {
+                    madvise(const_cast<uint8_t*>(m_mapped) + m_released, played - m_released, MADV_DONTNEED);
+                    m_released = played;
+                }
+
+                predictedDisplayTime = header.time;
+                return frame;
+            }
+            default:
+                break;  // of a later version, skipped
+        }
+    }
+    return nullptr;
+}
+
+uint32_t SessionReplayer::Run(std::shared_ptr<IApplication>& application, OffscreenViews& views, Pace pace) {
+    CHECK(views.ViewCount() == m_viewCount);
+    XrView view{};
+    view.type = XR_TYPE_VIEW;
+    std::vector<XrView> xrViews(m_viewCount, view);
+    uint32_t frames = 0;
+    XrTime firstDisplayTime = 0;
+    std::chrono::steady_clock::time_point start;
+
+    XrTime predictedDisplayTime = 0;
+    while (const Frame* frame = Next(*application, predictedDisplayTime)) {
+        if (frame->viewCount != m_viewCount) {
+            continue;  // a frame without valid views, the application was not rendered either
+        }
+        if (frames == 0) {
+            firstDisplayTime = predictedDisplayTime;
+            start = std::chrono::steady_clock::now();
+        } else if (pace == Pace::RealTime) {
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds(predictedDisplayTime - firstDisplayTime));
+        }
+
+        for (uint32_t i = 0; i < m_viewCount; i++) {
+            xrViews[i].pose = frame->views[i].pose;
+            xrViews[i].fov = frame->views[i].fov;
+        }
+        views.RenderFrame(application, xrViews, predictedDisplayTime, frame->predictedDisplayPeriod);
+        frames++;
+    }
+
+    const float seconds = frames > 0 ? std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count() : 0.0f;
+    Log::Write(Log::Level::Info, Fmt("SessionReplayer: %u frames in %.2fs", frames, seconds));
+    return frames;
+}
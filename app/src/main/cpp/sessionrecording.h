@@ -0,0 +1,158 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "trackingworker.h"
+#include "demos/application.h"
+
+class OffscreenViews;
+
+// What OpenXrProgram fed the application, recorded to reproduce field problems away from the glasses.
+//
+// A recording is append-only: a FileHeader, then records of a RecordHeader and a payload padded to 8 bytes. Input
+// events and tracking snapshots are recorded when they reach the application, each frame record closes the frame they
+// belong to. The recorder writes through a window mapped over the end of the file, so a frame costs a memcpy and no
+// system call, and a record only becomes visible once complete: a recording cut short by a crash ends at the zeros of
+// its unwritten tail. The replayer maps the whole file and walks it in order, long sessions are paged in as they play.
+namespace SessionRecording {
+
+constexpr char Magic[4] = {'X', 'R', 'S', 'R'};
+constexpr uint32_t Version = 1;
+constexpr uint32_t MaxViews = 2;
+
+enum class RecordType : uint32_t {
+    End = 0,  // the zeros past the last record
+    Frame = 1,
+    Input = 2,
+    Tracking = 3,
+};
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t viewCount;
+    uint32_t reserved;
+};
+
+struct RecordHeader {
+    RecordType type;
+    uint32_t size;  // of the payload, without the padding
+    int64_t time;   // XrTime of a frame, steady clock time of the rest
+};
+
+// The poses of one frame in the application space, as located for its predicted display time.
+struct Frame {
+    struct View {
+        XrPosef pose;
+        XrFovf fov;
+    };
+
+    XrDuration predictedDisplayPeriod;
+    uint32_t viewCount;
+    uint32_t controllerPoseMask;  // bit i: setControllerPose(i, controllerPose[i]) was called
+    View views[MaxViews];
+    XrPosef controllerPose[2];
+    XrSpaceLocationFlags aimFlags[2];  // the hand aim spaces, whether or not the application got them
+    XrPosef aimPose[2];
+    XrSpaceLocationFlags gamepadFlags;
+    XrPosef gamepadPose;
+    XrHandJointLocationEXT joints[2][XR_HAND_JOINT_COUNT_EXT];  // left, right
+};
+
+// A TrackingSnapshot: this header, markerCount Marker and planeCount Plane records.
+struct Tracking {
+    uint64_t version;
+    int64_t timeNs;
+    uint32_t markerCount;
+    uint32_t planeCount;
+};
+
+struct Marker {
+    int64_t handle;
+    float pose[7];
+    float extent[2];
+    uint32_t reserved;
+};
+
+struct Plane {
+    int64_t handle;
+    uint32_t type;
+    float pose[7];
+    float center[3];
+    float normal[3];
+};
+
+}  // namespace SessionRecording
+
+class SessionRecorder {
+   public:
+    // The window over the end of the file, the file grows by as much whenever the window is moved.
+    static constexpr size_t WindowSize = 4 << 20;
+
+    SessionRecorder() = default;
+    SessionRecorder(const SessionRecorder&) = delete;
+    SessionRecorder& operator=(const SessionRecorder&) = delete;
+    ~SessionRecorder() { Close(); }
+
+    // Starts a new recording at path, replacing any file there.
+    bool Open(const std::string& path, uint32_t viewCount);
+    // Cuts the file down to the records written.
+    void Close();
+    bool IsOpen() const { return m_fd >= 0; }
+
+    void RecordInput(const InputEvent& event);
+    // Only records snapshots newer than the last one recorded.
+    void RecordTracking(const TrackingSnapshot& snapshot);
+    void RecordFrame(XrTime predictedDisplayTime, const SessionRecording::Frame& frame);
+
+   private:
+    // Room for size bytes at m_offset, nullptr when the file cannot grow.
+    uint8_t* Reserve(size_t size);
+    // Fills in the header of the record reserved at record, last so that a torn record reads as the end.
+    void Commit(uint8_t* record, SessionRecording::RecordType type, uint32_t size, int64_t time);
+
+    int m_fd{-1};
+    uint8_t* m_window{nullptr};
+    size_t m_windowOffset{0};  // of m_window in the file, page aligned
+    size_t m_windowSize{0};
+    size_t m_offset{0};  // where the next record goes
+    uint64_t m_trackingVersion{0};
+    uint32_t m_frames{0};
+    bool m_failed{false};
+};
+
+class SessionReplayer {
+   public:
+    enum class Pace {
+        FullSpeed,  // every frame as soon as the previous one is issued
+        RealTime,   // frames as far apart as their predicted display times were
+    };
+
+    SessionReplayer() = default;
+    SessionReplayer(const SessionReplayer&) = delete;
+    SessionReplayer& operator=(const SessionReplayer&) = delete;
+    ~SessionReplayer() { Unmap(); }
+
+    bool Open(const std::string& path);
+    uint32_t ViewCount() const { return m_viewCount; }
+
+    // Hands the application the input, tracking snapshot, controller poses and hand joints of the next frame, the way
+    // OpenXrProgram does before update(). Returns nullptr at the end of the recording. The frame stays valid until
+    // the replayer is destroyed.
+    const SessionRecording::Frame* Next(IApplication& application, XrTime& predictedDisplayTime);
+
+    // Plays the rest of the recording through views, which must have ViewCount() views. Returns the frames played.
+    uint32_t Run(std::shared_ptr<IApplication>& application, OffscreenViews& views, Pace pace);
+
+   private:
+    void Unmap();
+
+    const uint8_t* m_mapped{nullptr};
+    size_t m_mappedSize{0};
+    size_t m_offset{0};
+    size_t m_released{0};  // pages before this were played and handed back to the system
+    uint32_t m_viewCount{0};
+    TrackingSnapshot m_tracking;  // the application keeps a reference until the next snapshot
+    XrHandJointLocationEXT m_joints[2][XR_HAND_JOINT_COUNT_EXT];
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+// Fixed-capacity lock-free queue for exactly one producer thread and one consumer thread.
+// Capacity must be a power of two; one slot is never filled so that full and empty can be told apart.
+template <typename T, uint32_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+   public:
+    // Producer side, returns false and drops the item when the queue is full.
+    bool Push(const T& item) {
+        const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        const uint32_t next = (tail + 1) & (Capacity - 1);
+        if (next == m_head.load(std::memory_order_acquire)) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_items[tail] = item;
+        m_tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, returns false when the queue is empty.
+    bool Pop(T& item) {
+        const uint32_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = m_items[head];
+        m_head.store((head + 1) & (Capacity - 1), std::memory_order_release);
+        return true;
+    }
+
+    // Number of items lost to a full queue so far.
+    uint32_t Dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+   private:
+    std::array<T, Capacity> m_items{};
+    alignas(64) std::atomic<uint32_t> m_head{0};
+    alignas(64) std::atomic<uint32_t> m_tail{0};
+    std::atomic<uint32_t> m_dropped{0};
+};
@@ -0,0 +1,1563 @@
+#include "standin_runtime.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <time.h>
+
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+
+#ifdef XR_USE_PLATFORM_ANDROID
+#include <android/log.h>
+#include <jni.h>
+#include <sys/system_properties.h>
+#endif
+
+#include <openxr/openxr.h>
+#include <openxr/openxr_platform.h>
+
+namespace {
+
+constexpr const char* RuntimeName = "Standin";
+constexpr XrSystemId SystemId = 1;
+constexpr uint32_t ViewCount = 2;
+constexpr uint32_t SwapchainImageCount = 3;
+constexpr float FloorHeight = 1.6f;  // of the LOCAL origin above the STAGE one
+constexpr float Pi = 3.14159265f;
+
+void Logf(const char* format, ...) {
+    char message[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+#ifdef XR_USE_PLATFORM_ANDROID
+    __android_log_print(ANDROID_LOG_INFO, "StandinRuntime", "%s", message);
+#else
+    fprintf(stderr, "[StandinRuntime] %s\n", message);
+#endif
+}
+
+// debug.xr.standin.<name> on Android, XR_STANDIN_<NAME> elsewhere.
+std::string Setting(const char* name) {
+#ifdef XR_USE_PLATFORM_ANDROID
+    char value[PROP_VALUE_MAX] = {};
+    __system_property_get((std::string("debug.xr.standin.") + name).c_str(), value);
+    return value;
+#else
+    std::string variable = "XR_STANDIN_";
+    for (const char* c = name; *c != '\0'; c++) {
+        if (c != name && isupper(*c)) {
+            variable += '_';
+        }
+        variable += static_cast<char>(toupper(*c));
+    }
+    const char* value = getenv(variable.c_str());
+    return value != nullptr ? value : "";
+#endif
+}
+
+float Setting(const char* name, float defaultValue) {
+    const std::string value = Setting(name);
+    return value.empty() ? defaultValue : strtof(value.c_str(), nullptr);
+}
+
+XrTime Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+namespace Pose {
+XrPosef Identity() { return {{0, 0, 0, 1}, {0, 0, 0}}; }
+
+XrQuaternionf AxisAngle(XrVector3f axis, float angle) {
+    const float s = sinf(angle / 2);
+    return {axis.x * s, axis.y * s, axis.z * s, cosf(angle / 2)};
+}
+
+XrQuaternionf Multiply(const XrQuaternionf& a, const XrQuaternionf& b) {
+    return {a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y, a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+            a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w, a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z};
+}
+
+XrVector3f Rotate(const XrQuaternionf& q, const XrVector3f& v) {
+    // v + 2w(q x v) + 2q x (q x v)
+    const XrVector3f t{2 * (q.y * v.z - q.z * v.y), 2 * (q.z * v.x - q.x * v.z), 2 * (q.x * v.y - q.y * v.x)};
+    return {v.x + q.w * t.x + (q.y * t.z - q.z * t.y), v.y + q.w * t.y + (q.z * t.x - q.x * t.z), v.z + q.w * t.z + (q.x * t.y - q.y * t.x)};
+}
+
+// b in the space of a.
+XrPosef Multiply(const XrPosef& a, const XrPosef& b) {
+    const XrVector3f p = Rotate(a.orientation, b.position);
+    return {Multiply(a.orientation, b.orientation), {a.position.x + p.x, a.position.y + p.y, a.position.z + p.z}};
+}
+
+XrPosef Invert(const XrPosef& a) {
+    const XrQuaternionf q{-a.orientation.x, -a.orientation.y, -a.orientation.z, a.orientation.w};
+    const XrVector3f p = Rotate(q, a.position);
+    return {q, {-p.x, -p.y, -p.z}};
+}
+}  // namespace Pose
+
+using JointArray = std::array<XrHandJointLocationEXT, XR_HAND_JOINT_COUNT_EXT>;
+
+// The recorded hand track of the handTrack setting, frames sorted by time.
+class HandTrack {
+   public:
+    bool Load(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) {
+            Logf("Cannot open hand track %s", path.c_str());
+            return false;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            line = line.substr(0, line.find('#'));
+            std::istringstream fields(line);
+            double seconds;
+            int hand, joint;
+            XrPosef pose;
+            if (!(fields >> seconds >> hand >> joint >> pose.position.x >> pose.position.y >> pose.position.z >> pose.orientation.x >>
+                  pose.orientation.y >> pose.orientation.z >> pose.orientation.w)) {
+                continue;
+            }
+            float radius = 0.01f;
+            fields >> radius;
+            if (hand < 0 || hand > 1 || joint < 0 || joint >= XR_HAND_JOINT_COUNT_EXT) {
+                continue;
+            }
+            const XrTime time = static_cast<XrTime>(seconds * 1e9);
+            if (m_frames.empty() || m_frames.back().time != time) {
+                m_frames.push_back({time, {}});
+            }
+            m_frames.back().joints[hand][joint] = {XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT |
+                                                       XR_SPACE_LOCATION_POSITION_TRACKED_BIT | XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT,
+                                                   pose, radius};
+        }
+        std::stable_sort(m_frames.begin(), m_frames.end(), [](const Frame& a, const Frame& b) { return a.time < b.time; });
+        Logf("Hand track %s: %zu frames", path.c_str(), m_frames.size());
+        return !m_frames.empty();
+    }
+
+    bool Empty() const { return m_frames.empty(); }
+
+    // The frame at time since the session began, looping.
+    const JointArray& Joints(int hand, XrDuration time) const {
+        const XrDuration duration = m_frames.back().time - m_frames.front().time;
+        const XrTime t = m_frames.front().time + (duration > 0 ? time % duration : 0);
+        auto it = std::upper_bound(m_frames.begin(), m_frames.end(), t, [](XrTime t, const Frame& frame) { return t < frame.time; });
+        return (it == m_frames.begin() ? it : it - 1)->joints[hand];
+    }
+
+   private:
+    struct Frame {
+        XrTime time;
+        JointArray joints[2];
+    };
+    std::vector<Frame> m_frames;
+};
+
+struct Settings {
+    XrDuration period;
+    uint32_t viewWidth;
+    uint32_t viewHeight;
+    float tanHalfFov;
+    float ipd;
+    float headYaw;
+    uint32_t frames;
+    HandTrack handTrack;
+
+    Settings() {
+        period = static_cast<XrDuration>(1e9 / std::max(Setting("refreshRate", 60.0f), 1.0f));
+        viewWidth = static_cast<uint32_t>(Setting("viewWidth", 1920));
+        viewHeight = static_cast<uint32_t>(Setting("viewHeight", 1080));
+        tanHalfFov = tanf(Setting("fov", 44.0f) * Pi / 360);
+        ipd = Setting("ipd", 0.063f);
+        headYaw = Setting("headYaw", 10.0f) * Pi / 180;
+        frames = static_cast<uint32_t>(Setting("frames", 0));
+        const std::string track = Setting("handTrack");
+        if (!track.empty()) {
+            handTrack.Load(track);
+        }
+    }
+};
+
+struct Instance;
+struct Session;
+
+struct Instance {
+    std::vector<std::string> extensions;
+    std::deque<XrEventDataBuffer> events;
+    std::vector<std::string> paths;  // XrPath i + 1
+    Settings settings;
+
+    bool HasExtension(const char* name) const { return std::find(extensions.begin(), extensions.end(), name) != extensions.end(); }
+};
+
+struct Session {
+    Instance* instance;
+    XrSessionState state{XR_SESSION_STATE_UNKNOWN};
+    bool exitRequested{false};
+    XrTime beginTime{0};
+
+    // Frame pacing, vsyncs are beginTime + k * period.
+    XrTime nextWake{0};          // the earliest vsync the next xrWaitFrame returns at
+    XrTime waitedLatch{0};       // when the compositor latches the frame of the last xrWaitFrame
+    XrTime waitedDisplayTime{0};
+    bool frameWaited{false};
+    bool frameBegun{false};
+    GLsync endedFence{nullptr};  // of the last xrEndFrame, waited for by the next xrWaitFrame
+    XrTime endedTime{0};
+    XrTime endedLatch{0};
+    StandinFrameStats stats;
+};
+
+enum class SpaceKind { Reference, HandAim, Gamepad };
+
+struct Space {
+    Session* session;
+    SpaceKind kind;
+    XrReferenceSpaceType referenceType;
+    int hand;  // of HandAim
+    XrPosef offset;
+};
+
+struct Swapchain {
+    Session* session;
+    std::vector<GLuint> images;
+    uint32_t nextImage{0};
+    uint32_t acquired{0};
+};
+
+struct ActionSet {
+    Instance* instance;
+    bool attached{false};
+};
+
+struct Action {
+    ActionSet* actionSet;
+    XrActionType type;
+    std::vector<XrPath> subactionPaths;
+};
+
+struct HandTracker {
+    Session* session;
+    int hand;
+};
+
+// Live objects of a type, handles are their addresses.
+template <typename T>
+class Objects {
+   public:
+    template <typename Handle>
+    Handle Add(std::unique_ptr<T> object) {
+        T* pointer = object.get();
+        m_objects[pointer] = std::move(object);
+        return (Handle)(uintptr_t)pointer;
+    }
+
+    template <typename Handle>
+    T* Get(Handle handle) const {
+        auto it = m_objects.find((T*)(uintptr_t)handle);
+        return it != m_objects.end() ? it->second.get() : nullptr;
+    }
+
+    template <typename Handle>
+    bool Remove(Handle handle) {
+        return m_objects.erase((T*)(uintptr_t)handle) > 0;
+    }
+
+    // Of objects owned by another one that is being destroyed.
+    template <typename Predicate>
+    void RemoveIf(Predicate predicate) {
+        for (auto it = m_objects.begin(); it != m_objects.end();) {
+            it = predicate(*it->second) ? m_objects.erase(it) : std::next(it);
+        }
+    }
+
+   private:
+    std::map<T*, std::unique_ptr<T>> m_objects;
+};
+
+// Everything but the sleep of xrWaitFrame is under the lock, the tracking worker calls in from its own thread.
+std::mutex g_mutex;
+Objects<Instance> g_instances;
+Objects<Session> g_sessions;
+Objects<Space> g_spaces;
+Objects<Swapchain> g_swapchains;
+Objects<ActionSet> g_actionSets;
+Objects<Action> g_actions;
+Objects<HandTracker> g_handTrackers;
+StandinFrameStats g_lastStats;
+
+const char* const SupportedExtensions[] = {
+    XR_KHR_OPENGL_ES_ENABLE_EXTENSION_NAME,
+#ifdef XR_USE_PLATFORM_ANDROID
+    XR_KHR_ANDROID_CREATE_INSTANCE_EXTENSION_NAME,
+#else
+    XR_MNDX_EGL_ENABLE_EXTENSION_NAME,
+#endif
+    XR_KHR_CONVERT_TIMESPEC_TIME_EXTENSION_NAME,
+    XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME,
+    XR_EXT_HAND_TRACKING_EXTENSION_NAME,
+};
+
+const int64_t SwapchainFormats[] = {GL_RGBA8, GL_SRGB8_ALPHA8, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT16, GL_DEPTH24_STENCIL8, GL_DEPTH_COMPONENT32F};
+
+// The two-call idiom, fill(i, output) writes element i.
+template <typename T, typename Fill>
+XrResult Enumerate(uint32_t count, uint32_t capacity, uint32_t* countOutput, T* output, Fill fill) {
+    if (countOutput == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    *countOutput = count;
+    if (capacity == 0) {
+        return XR_SUCCESS;
+    }
+    if (capacity < count || output == nullptr) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        fill(i, output[i]);
+    }
+    return XR_SUCCESS;
+}
+
+void PushEvent(Instance& instance, const XrEventDataBaseHeader& event, size_t size) {
+    XrEventDataBuffer buffer{};
+    memcpy(&buffer, &event, std::min(size, sizeof(buffer)));
+    instance.events.push_back(buffer);
+}
+
+void SetSessionState(Session& session, XrSessionState state) {
+    session.state = state;
+    XrEventDataSessionStateChanged event{};
+    event.type = XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED;
+    event.session = (XrSession)(uintptr_t)&session;
+    event.state = state;
+    event.time = Now();
+    PushEvent(*session.instance, reinterpret_cast<const XrEventDataBaseHeader&>(event), sizeof(event));
+}
+
+bool IsSessionRunning(const Session& session) {
+    return session.state == XR_SESSION_STATE_SYNCHRONIZED || session.state == XR_SESSION_STATE_VISIBLE ||
+           session.state == XR_SESSION_STATE_FOCUSED || session.state == XR_SESSION_STATE_STOPPING;
+}
+
+void RequestExit(Session& session) {
+    if (!session.exitRequested && IsSessionRunning(session)) {
+        session.exitRequested = true;
+        SetSessionState(session, XR_SESSION_STATE_STOPPING);
+    }
+}
+
+XrDuration SessionTime(const Session& session, XrTime time) {
+    return std::max<XrDuration>(time - session.beginTime, 0);
+}
+
+// The scripted head sways about the vertical axis at the LOCAL origin.
+XrPosef HeadPose(const Session& session, XrTime time) {
+    const float seconds = SessionTime(session, time) * 1e-9f;
+    XrPosef head = Pose::Identity();
+    head.orientation = Pose::AxisAngle({0, 1, 0}, session.instance->settings.headYaw * sinf(2 * Pi * seconds / 8));
+    return head;
+}
+
+// A hand in front of the user, palm down, curling and stretching its fingers every two seconds.
+void ScriptedJoints(int hand, float seconds, JointArray& joints) {
+    const float side = hand == 0 ? -1.0f : 1.0f;  // x of the little finger side
+    XrPosef palm = Pose::Identity();
+    palm.position = {side * (0.15f + 0.02f * sinf(seconds * 0.7f)), -0.25f + 0.02f * sinf(seconds * 1.1f), -0.4f};
+    const float curl = 0.5f - 0.5f * cosf(2 * Pi * seconds / 2);
+
+    const auto set = [&joints](XrHandJointEXT joint, const XrPosef& pose, float radius) {
+        joints[joint] = {XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_TRACKED_BIT |
+                             XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT,
+                         pose, radius};
+    };
+    set(XR_HAND_JOINT_PALM_EXT, palm, 0.02f);
+    set(XR_HAND_JOINT_WRIST_EXT, Pose::Multiply(palm, {{0, 0, 0, 1}, {0, 0, 0.06f}}), 0.02f);
+
+    // The joints of a finger from its metacarpal, every one bends the rest of the finger by the same angle.
+    const auto finger = [&](XrHandJointEXT metacarpal, XrVector3f base, XrQuaternionf direction, const float (&lengths)[4], XrVector3f axis,
+                            float bend) {
+        XrPosef pose = Pose::Multiply(palm, {direction, base});
+        for (uint32_t i = 0; i < 5; i++) {
+            set(static_cast<XrHandJointEXT>(metacarpal + i), pose, i == 0 ? 0.012f : 0.008f);
+            if (i < 4) {
+                const XrPosef segment{i == 0 ? XrQuaternionf{0, 0, 0, 1} : Pose::AxisAngle(axis, bend), {0, 0, -lengths[i]}};
+                pose = Pose::Multiply(pose, segment);
+            }
+        }
+    };
+    const float fingerLengths[4] = {0.075f, 0.04f, 0.025f, 0.02f};
+    const float littleLengths[4] = {0.065f, 0.032f, 0.02f, 0.018f};
+    const float thumbLengths[4] = {0.04f, 0.035f, 0.03f, 0.0f};
+    finger(XR_HAND_JOINT_INDEX_METACARPAL_EXT, {-side * 0.025f, 0, 0.045f}, {0, 0, 0, 1}, fingerLengths, {1, 0, 0}, -1.2f * curl);
+    finger(XR_HAND_JOINT_MIDDLE_METACARPAL_EXT, {-side * 0.005f, 0, 0.045f}, {0, 0, 0, 1}, fingerLengths, {1, 0, 0}, -1.2f * curl);
+    finger(XR_HAND_JOINT_RING_METACARPAL_EXT, {side * 0.015f, 0, 0.045f}, {0, 0, 0, 1}, fingerLengths, {1, 0, 0}, -1.2f * curl);
+    finger(XR_HAND_JOINT_LITTLE_METACARPAL_EXT, {side * 0.032f, 0, 0.045f}, {0, 0, 0, 1}, littleLengths, {1, 0, 0}, -1.2f * curl);
+
+    // The thumb has no intermediate joint, its chain stops at the tip.
+    XrPosef thumb = Pose::Multiply(palm, {Pose::AxisAngle({0, 1, 0}, side * 0.6f), {-side * 0.03f, -0.01f, 0.03f}});
+    for (uint32_t i = 0; i < 4; i++) {
+        set(static_cast<XrHandJointEXT>(XR_HAND_JOINT_THUMB_METACARPAL_EXT + i), thumb, 0.01f);
+        thumb = Pose::Multiply(thumb, {Pose::AxisAngle({0, 1, 0}, -side * 0.5f * curl), {0, 0, -thumbLengths[i]}});
+    }
+}
+
+// In the LOCAL space.
+void HandJoints(const Session& session, int hand, XrTime time, JointArray& joints) {
+    const HandTrack& track = session.instance->settings.handTrack;
+    if (!track.Empty()) {
+        joints = track.Joints(hand, SessionTime(session, time));
+        return;
+    }
+    ScriptedJoints(hand, SessionTime(session, time) * 1e-9f, joints);
+}
+
+// Of a space in the LOCAL one, false when it is not tracked.
+bool SpacePose(const Space& space, XrTime time, XrPosef& pose, XrSpaceLocationFlags& flags) {
+    constexpr XrSpaceLocationFlags Tracked = XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT |
+                                             XR_SPACE_LOCATION_POSITION_TRACKED_BIT | XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT;
+    flags = Tracked;
+    XrPosef origin = Pose::Identity();
+    switch (space.kind) {
+        case SpaceKind::Reference:
+            if (space.referenceType == XR_REFERENCE_SPACE_TYPE_VIEW) {
+                origin = HeadPose(*space.session, time);
+            } else if (space.referenceType == XR_REFERENCE_SPACE_TYPE_STAGE) {
+                origin.position.y = -FloorHeight;
+            }
+            break;
+        case SpaceKind::HandAim: {
+            JointArray joints;
+            HandJoints(*space.session, space.hand, time, joints);
+            flags = joints[XR_HAND_JOINT_PALM_EXT].locationFlags;
+            origin = joints[XR_HAND_JOINT_PALM_EXT].pose;
+            break;
+        }
+        case SpaceKind::Gamepad: {
+            // 3DoF: held at the waist, pointing half way to where the head looks.
+            const XrPosef head = HeadPose(*space.session, time);
+            origin.orientation = {0.5f * head.orientation.x, 0.5f * head.orientation.y, 0.5f * head.orientation.z, head.orientation.w};
+            const float length = sqrtf(origin.orientation.x * origin.orientation.x + origin.orientation.y * origin.orientation.y +
+                                       origin.orientation.z * origin.orientation.z + origin.orientation.w * origin.orientation.w);
+            origin.orientation = {origin.orientation.x / length, origin.orientation.y / length, origin.orientation.z / length,
+                                  origin.orientation.w / length};
+            origin.position = {0.1f, -0.4f, -0.3f};
+            flags = XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT;
+            break;
+        }
+    }
+    pose = Pose::Multiply(origin, space.offset);
+    return (flags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0;
+}
+
+XrResult CheckStructure(const void* structure, XrStructureType type) {
+    if (structure == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    return static_cast<const XrBaseInStructure*>(structure)->type == type ? XR_SUCCESS : XR_ERROR_VALIDATION_FAILURE;
+}
+
+const XrBaseInStructure* FindNext(const void* next, XrStructureType type) {
+    for (auto* structure = static_cast<const XrBaseInStructure*>(next); structure != nullptr; structure = structure->next) {
+        if (structure->type == type) {
+            return structure;
+        }
+    }
+    return nullptr;
+}
+
+// Binds the new texture on the current unit and puts the previous one back, the application caches its bindings.
+GLuint CreateImage(const XrSwapchainCreateInfo& createInfo) {
+    const GLenum target = createInfo.arraySize > 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+    GLint previous = 0;
+    glGetIntegerv(target == GL_TEXTURE_2D_ARRAY ? GL_TEXTURE_BINDING_2D_ARRAY : GL_TEXTURE_BINDING_2D, &previous);
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(target, texture);
+    const GLenum format = static_cast<GLenum>(createInfo.format);
+    if (target == GL_TEXTURE_2D_ARRAY) {
+        glTexStorage3D(target, createInfo.mipCount, format, createInfo.width, createInfo.height, createInfo.arraySize);
+    } else {
+        glTexStorage2D(target, createInfo.mipCount, format, createInfo.width, createInfo.height);
+    }
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(target, static_cast<GLuint>(previous));
+    return texture;
+}
+
+void DestroySession(Session* session) {
+    g_spaces.RemoveIf([session](const Space& space) { return space.session == session; });
+    g_swapchains.RemoveIf([session](const Swapchain& swapchain) {
+        if (swapchain.session == session) {
+            glDeleteTextures(static_cast<GLsizei>(swapchain.images.size()), swapchain.images.data());
+        }
+        return swapchain.session == session;
+    });
+    g_handTrackers.RemoveIf([session](const HandTracker& tracker) { return tracker.session == session; });
+    if (session->endedFence != nullptr) {
+        glDeleteSync(session->endedFence);
+    }
+    g_sessions.Remove(session);
+}
+
+#define INSTANCE_OR_RETURN(name, handle)         \
+    Instance* name = g_instances.Get(handle);    \
+    if (name == nullptr) {                       \
+        return XR_ERROR_HANDLE_INVALID;          \
+    }
+#define SESSION_OR_RETURN(name, handle)          \
+    Session* name = g_sessions.Get(handle);      \
+    if (name == nullptr) {                       \
+        return XR_ERROR_HANDLE_INVALID;          \
+    }
+
+// Extensions, only reachable through xrGetInstanceProcAddr.
+
+XRAPI_ATTR XrResult XRAPI_CALL xrInitializeLoaderKHR(const XrLoaderInitInfoBaseHeaderKHR* /*loaderInitInfo*/) { return XR_SUCCESS; }
+
+XRAPI_ATTR XrResult XRAPI_CALL xrGetOpenGLESGraphicsRequirementsKHR(XrInstance instance, XrSystemId systemId,
+                                                                     XrGraphicsRequirementsOpenGLESKHR* graphicsRequirements) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    INSTANCE_OR_RETURN(instanceObject, instance);
+    if (systemId != SystemId) {
+        return XR_ERROR_SYSTEM_INVALID;
+    }
+    if (CheckStructure(graphicsRequirements, XR_TYPE_GRAPHICS_REQUIREMENTS_OPENGL_ES_KHR) != XR_SUCCESS) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    graphicsRequirements->minApiVersionSupported = XR_MAKE_VERSION(3, 0, 0);
+    graphicsRequirements->maxApiVersionSupported = XR_MAKE_VERSION(3, 2, 0);
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrConvertTimespecTimeToTimeKHR(XrInstance instance, const struct timespec* timespecTime, XrTime* time) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    INSTANCE_OR_RETURN(instanceObject, instance);
+    // XrTime is CLOCK_MONOTONIC, which steady_clock is as well.
+    *time = static_cast<XrTime>(timespecTime->tv_sec) * 1000000000 + timespecTime->tv_nsec;
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrConvertTimeToTimespecTimeKHR(XrInstance instance, XrTime time, struct timespec* timespecTime) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    INSTANCE_OR_RETURN(instanceObject, instance);
+    timespecTime->tv_sec = static_cast<time_t>(time / 1000000000);
+    timespecTime->tv_nsec = static_cast<long>(time % 1000000000);
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrCreateHandTrackerEXT(XrSession session, const XrHandTrackerCreateInfoEXT* createInfo,
+                                                      XrHandTrackerEXT* handTracker) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    if (CheckStructure(createInfo, XR_TYPE_HAND_TRACKER_CREATE_INFO_EXT) != XR_SUCCESS || handTracker == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (!sessionObject->instance->HasExtension(XR_EXT_HAND_TRACKING_EXTENSION_NAME)) {
+        return XR_ERROR_FUNCTION_UNSUPPORTED;
+    }
+    const int hand = createInfo->hand == XR_HAND_LEFT_EXT ? 0 : 1;
+    *handTracker = g_handTrackers.Add<XrHandTrackerEXT>(std::unique_ptr<HandTracker>(new HandTracker{sessionObject, hand}));
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrDestroyHandTrackerEXT(XrHandTrackerEXT handTracker) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_handTrackers.Remove(handTracker) ? XR_SUCCESS : XR_ERROR_HANDLE_INVALID;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrLocateHandJointsEXT(XrHandTrackerEXT handTracker, const XrHandJointsLocateInfoEXT* locateInfo,
+                                                     XrHandJointLocationsEXT* locations) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    HandTracker* tracker = g_handTrackers.Get(handTracker);
+    if (tracker == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    if (CheckStructure(locateInfo, XR_TYPE_HAND_JOINTS_LOCATE_INFO_EXT) != XR_SUCCESS ||
+        CheckStructure(locations, XR_TYPE_HAND_JOINT_LOCATIONS_EXT) != XR_SUCCESS || locations->jointCount != XR_HAND_JOINT_COUNT_EXT) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    const Space* base = g_spaces.Get(locateInfo->baseSpace);
+    if (base == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    JointArray joints;
+    HandJoints(*tracker->session, tracker->hand, locateInfo->time, joints);
+    XrPosef basePose;
+    XrSpaceLocationFlags baseFlags;
+    SpacePose(*base, locateInfo->time, basePose, baseFlags);
+    const XrPosef toBase = Pose::Invert(basePose);
+    locations->isActive = XR_FALSE;
+    for (uint32_t i = 0; i < XR_HAND_JOINT_COUNT_EXT; i++) {
+        locations->jointLocations[i] = joints[i];
+        locations->jointLocations[i].pose = Pose::Multiply(toBase, joints[i].pose);
+        locations->isActive |= joints[i].locationFlags != 0 ? XR_TRUE : XR_FALSE;
+    }
+    return XR_SUCCESS;
+}
+
+// The Rokid extensions do nothing: no markers, planes or camera frames ever arrive, recentering has no effect.
+
+XRAPI_ATTR XrResult XRAPI_CALL xrRecenterHeadTracker() { return XR_SUCCESS; }
+XRAPI_ATTR XrResult XRAPI_CALL xrRecenterPhonePose() { return XR_SUCCESS; }
+
+XRAPI_ATTR XrResult XRAPI_CALL xrGetHeadTrackingStatus(uint32_t* state) {
+    *state = 0;
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrGetCameraPhysicsPose(uint64_t* timeStamp, float* position, float* orientation) {
+    *timeStamp = static_cast<uint64_t>(Now());
+    std::fill(position, position + 3, 0.0f);
+    std::fill(orientation, orientation + 4, 0.0f);
+    orientation[3] = 1.0f;
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrGetHistoryCameraPhysicsPose(uint64_t /*timeStamp*/, float* position, float* orientation) {
+    uint64_t now;
+    return xrGetCameraPhysicsPose(&now, position, orientation);
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrOpenCameraPreview(PFN_xrCameraUpdateCallback /*function*/) { return XR_SUCCESS; }
+XRAPI_ATTR XrResult XRAPI_CALL xrCloseCameraPreview() { return XR_SUCCESS; }
+
+XRAPI_ATTR XrResult XRAPI_CALL xrRKOpenMarker2(const void* /*database*/, uint32_t /*size*/) { return XR_SUCCESS; }
+XRAPI_ATTR XrResult XRAPI_CALL xrRKCloseMarker2() { return XR_SUCCESS; }
+
+XRAPI_ATTR XrResult XRAPI_CALL xrRKMarker2AddImagePhy(const char* /*id*/, const uint8_t* /*imageData*/, int32_t /*width*/, int32_t /*height*/,
+                                                      int32_t /*stride*/, float /*widthInMeter*/, float /*heightInMeter*/) {
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrRKMarker2AcquireChanges(XrRokidMarker2ArrayExt* added, XrRokidMarker2ArrayExt* updated,
+                                                         XrRokidMarker2ArrayExt* removed) {
+    for (XrRokidMarker2ArrayExt* changes : {added, updated, removed}) {
+        *changes = {nullptr, 0};
+    }
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrRKMarker2GetCenterPose(intptr_t /*marker*/, float* /*out*/) { return XR_ERROR_HANDLE_INVALID; }
+XRAPI_ATTR XrResult XRAPI_CALL xrRKMarker2GetExtent(intptr_t /*marker*/, float* /*outX*/, float* /*outZ*/) { return XR_ERROR_HANDLE_INVALID; }
+XRAPI_ATTR XrResult XRAPI_CALL xrRKMarker2GetId(intptr_t /*marker*/, char* /*id*/, int /*idSize*/) { return XR_ERROR_HANDLE_INVALID; }
+XRAPI_ATTR XrResult XRAPI_CALL xrRKMarker2GetAlgoId(intptr_t /*marker*/, intptr_t* /*id*/) { return XR_ERROR_HANDLE_INVALID; }
+
+XRAPI_ATTR XrResult XRAPI_CALL xrRKOpenPlaneTracker(uint32_t /*mode*/) { return XR_SUCCESS; }
+XRAPI_ATTR XrResult XRAPI_CALL xrRKClosePlaneTracker() { return XR_SUCCESS; }
+
+XRAPI_ATTR XrResult XRAPI_CALL xrRKGetPlaneDetectMode(uint32_t* mode) {
+    *mode = 0;
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrRKSetPlaneDetectMode(uint32_t /*mode*/) { return XR_SUCCESS; }
+
+XRAPI_ATTR XrResult XRAPI_CALL xrRKGetUpdatePlanes(uint32_t /*type*/, void** nochangePlanes, void** changePlanes, void** newPlanes,
+                                                   void** removePlanes, uint32_t* nochangePlanesSize, uint32_t* changePlanesSize,
+                                                   uint32_t* newPlanesSize, uint32_t* removePlanesSize) {
+    for (void** planes : {nochangePlanes, changePlanes, newPlanes, removePlanes}) {
+        *planes = nullptr;
+    }
+    for (uint32_t* size : {nochangePlanesSize, changePlanesSize, newPlanesSize, removePlanesSize}) {
+        *size = 0;
+    }
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrRKGetPlanePolygon(int64_t /*plane*/, void** /*polygon*/, uint32_t* /*polygonSize*/) { return XR_ERROR_HANDLE_INVALID; }
+XRAPI_ATTR XrResult XRAPI_CALL xrRKGetPlaneType(int64_t /*plane*/, uint32_t* /*type*/) { return XR_ERROR_HANDLE_INVALID; }
+
+XRAPI_ATTR XrResult XRAPI_CALL xrRKGetPlaneCenterPose(int64_t /*plane*/, void** /*pose*/, void** /*center*/, void** /*normalVector*/) {
+    return XR_ERROR_HANDLE_INVALID;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrRKGetPlaneRectangle(int64_t /*plane*/, void** /*rectangle*/) { return XR_ERROR_HANDLE_INVALID; }
+XRAPI_ATTR XrResult XRAPI_CALL xrRKReleasePlane(int64_t /*plane*/) { return XR_ERROR_HANDLE_INVALID; }
+
+XRAPI_ATTR XrResult XRAPI_CALL xrRKCreateArtificialPlane(float* /*points*/, uint32_t /*numPoints*/, float /*width*/, float /*height*/) {
+    return XR_SUCCESS;
+}
+
+}  // namespace
+
+extern "C" void StandinGetFrameStats(StandinFrameStats* stats) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    *stats = g_lastStats;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrEnumerateApiLayerProperties(uint32_t propertyCapacityInput, uint32_t* propertyCountOutput,
+                                                             XrApiLayerProperties* /*properties*/) {
+    if (propertyCountOutput == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    (void)propertyCapacityInput;
+    *propertyCountOutput = 0;
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrEnumerateInstanceExtensionProperties(const char* layerName, uint32_t propertyCapacityInput,
+                                                                      uint32_t* propertyCountOutput, XrExtensionProperties* properties) {
+    if (layerName != nullptr) {
+        return XR_ERROR_API_LAYER_NOT_PRESENT;
+    }
+    const uint32_t count = sizeof(SupportedExtensions) / sizeof(SupportedExtensions[0]);
+    return Enumerate(count, propertyCapacityInput, propertyCountOutput, properties, [](uint32_t i, XrExtensionProperties& property) {
+        strncpy(property.extensionName, SupportedExtensions[i], XR_MAX_EXTENSION_NAME_SIZE - 1);
+        property.extensionVersion = 1;
+    });
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrCreateInstance(const XrInstanceCreateInfo* createInfo, XrInstance* instance) {
+    if (CheckStructure(createInfo, XR_TYPE_INSTANCE_CREATE_INFO) != XR_SUCCESS || instance == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (createInfo->enabledApiLayerCount > 0) {
+        return XR_ERROR_API_LAYER_NOT_PRESENT;
+    }
+    std::unique_ptr<Instance> instanceObject(new Instance);
+    for (uint32_t i = 0; i < createInfo->enabledExtensionCount; i++) {
+        const char* name = createInfo->enabledExtensionNames[i];
+        if (std::none_of(std::begin(SupportedExtensions), std::end(SupportedExtensions),
+                         [name](const char* supported) { return strcmp(supported, name) == 0; })) {
+            Logf("Extension %s is not supported", name);
+            return XR_ERROR_EXTENSION_NOT_PRESENT;
+        }
+        instanceObject->extensions.push_back(name);
+    }
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    Logf("Instance for %s, %.0fHz, views of %ux%u, %s hands", createInfo->applicationInfo.applicationName,
+         1e9 / instanceObject->settings.period, instanceObject->settings.viewWidth, instanceObject->settings.viewHeight,
+         instanceObject->settings.handTrack.Empty() ? "scripted" : "recorded");
+    *instance = g_instances.Add<XrInstance>(std::move(instanceObject));
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrDestroyInstance(XrInstance instance) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    INSTANCE_OR_RETURN(instanceObject, instance);
+    g_actionSets.RemoveIf([instanceObject](const ActionSet& actionSet) { return actionSet.instance == instanceObject; });
+    g_actions.RemoveIf([](const Action& action) { return g_actionSets.Get(action.actionSet) == nullptr; });
+    std::vector<Session*> sessions;
+    g_sessions.RemoveIf([instanceObject, &sessions](Session& session) {
+        if (session.instance == instanceObject) {
+            sessions.push_back(&session);
+        }
+        return false;
+    });
+    for (Session* session : sessions) {
+        DestroySession(session);
+    }
+    g_instances.Remove(instance);
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrGetInstanceProperties(XrInstance instance, XrInstanceProperties* instanceProperties) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    INSTANCE_OR_RETURN(instanceObject, instance);
+    if (CheckStructure(instanceProperties, XR_TYPE_INSTANCE_PROPERTIES) != XR_SUCCESS) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    instanceProperties->runtimeVersion = XR_MAKE_VERSION(1, 0, 0);
+    strncpy(instanceProperties->runtimeName, RuntimeName, XR_MAX_RUNTIME_NAME_SIZE - 1);
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrPollEvent(XrInstance instance, XrEventDataBuffer* eventData) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    INSTANCE_OR_RETURN(instanceObject, instance);
+    if (instanceObject->events.empty()) {
+        return XR_EVENT_UNAVAILABLE;
+    }
+    *eventData = instanceObject->events.front();
+    instanceObject->events.pop_front();
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrGetSystem(XrInstance instance, const XrSystemGetInfo* getInfo, XrSystemId* systemId) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    INSTANCE_OR_RETURN(instanceObject, instance);
+    if (CheckStructure(getInfo, XR_TYPE_SYSTEM_GET_INFO) != XR_SUCCESS) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (getInfo->formFactor != XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY) {
+        return XR_ERROR_FORM_FACTOR_UNSUPPORTED;
+    }
+    *systemId = SystemId;
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrGetSystemProperties(XrInstance instance, XrSystemId systemId, XrSystemProperties* properties) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    INSTANCE_OR_RETURN(instanceObject, instance);
+    if (systemId != SystemId) {
+        return XR_ERROR_SYSTEM_INVALID;
+    }
+    if (CheckStructure(properties, XR_TYPE_SYSTEM_PROPERTIES) != XR_SUCCESS) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    properties->systemId = SystemId;
+    properties->vendorId = 0;
+    strncpy(properties->systemName, RuntimeName, XR_MAX_SYSTEM_NAME_SIZE - 1);
+    properties->graphicsProperties.maxSwapchainImageWidth = 4096;
+    properties->graphicsProperties.maxSwapchainImageHeight = 4096;
+    properties->graphicsProperties.maxLayerCount = 16;
+    properties->trackingProperties.orientationTracking = XR_TRUE;
+    properties->trackingProperties.positionTracking = XR_TRUE;
+    auto* handTracking = const_cast<XrSystemHandTrackingPropertiesEXT*>(
+        reinterpret_cast<const XrSystemHandTrackingPropertiesEXT*>(FindNext(properties->next, XR_TYPE_SYSTEM_HAND_TRACKING_PROPERTIES_EXT)));
+    if (handTracking != nullptr) {
+        handTracking->supportsHandTracking = XR_TRUE;
+    }
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrEnumerateViewConfigurations(XrInstance instance, XrSystemId systemId, uint32_t viewConfigurationTypeCapacityInput,
+                                                             uint32_t* viewConfigurationTypeCountOutput, XrViewConfigurationType* viewConfigurationTypes) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    INSTANCE_OR_RETURN(instanceObject, instance);
+    if (systemId != SystemId) {
+        return XR_ERROR_SYSTEM_INVALID;
+    }
+    return Enumerate(1, viewConfigurationTypeCapacityInput, viewConfigurationTypeCountOutput, viewConfigurationTypes,
+                     [](uint32_t, XrViewConfigurationType& type) { type = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO; });
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrGetViewConfigurationProperties(XrInstance instance, XrSystemId systemId, XrViewConfigurationType viewConfigurationType,
+                                                                XrViewConfigurationProperties* configurationProperties) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    INSTANCE_OR_RETURN(instanceObject, instance);
+    if (systemId != SystemId) {
+        return XR_ERROR_SYSTEM_INVALID;
+    }
+    if (viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+        return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+    }
+    configurationProperties->viewConfigurationType = viewConfigurationType;
+    configurationProperties->fovMutable = XR_FALSE;
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrEnumerateViewConfigurationViews(XrInstance instance, XrSystemId systemId, XrViewConfigurationType viewConfigurationType,
+                                                                 uint32_t viewCapacityInput, uint32_t* viewCountOutput, XrViewConfigurationView* views) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    INSTANCE_OR_RETURN(instanceObject, instance);
+    if (systemId != SystemId) {
+        return XR_ERROR_SYSTEM_INVALID;
+    }
+    if (viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+        return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+    }
+    const Settings& settings = instanceObject->settings;
+    return Enumerate(ViewCount, viewCapacityInput, viewCountOutput, views, [&settings](uint32_t, XrViewConfigurationView& view) {
+        view.recommendedImageRectWidth = settings.viewWidth;
+        view.recommendedImageRectHeight = settings.viewHeight;
+        view.maxImageRectWidth = 4096;
+        view.maxImageRectHeight = 4096;
+        view.recommendedSwapchainSampleCount = 1;
+        view.maxSwapchainSampleCount = 1;
+    });
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrEnumerateEnvironmentBlendModes(XrInstance instance, XrSystemId systemId, XrViewConfigurationType viewConfigurationType,
+                                                                uint32_t environmentBlendModeCapacityInput, uint32_t* environmentBlendModeCountOutput,
+                                                                XrEnvironmentBlendMode* environmentBlendModes) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    INSTANCE_OR_RETURN(instanceObject, instance);
+    if (systemId != SystemId) {
+        return XR_ERROR_SYSTEM_INVALID;
+    }
+    if (viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+        return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+    }
+    // Nothing is composited, every mode looks the same.
+    constexpr XrEnvironmentBlendMode Modes[] = {XR_ENVIRONMENT_BLEND_MODE_OPAQUE, XR_ENVIRONMENT_BLEND_MODE_ADDITIVE, XR_ENVIRONMENT_BLEND_MODE_ALPHA_BLEND};
+    return Enumerate(3, environmentBlendModeCapacityInput, environmentBlendModeCountOutput, environmentBlendModes,
+                     [&Modes](uint32_t i, XrEnvironmentBlendMode& mode) { mode = Modes[i]; });
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrCreateSession(XrInstance instance, const XrSessionCreateInfo* createInfo, XrSession* session) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    INSTANCE_OR_RETURN(instanceObject, instance);
+    if (CheckStructure(createInfo, XR_TYPE_SESSION_CREATE_INFO) != XR_SUCCESS || session == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (createInfo->systemId != SystemId) {
+        return XR_ERROR_SYSTEM_INVALID;
+    }
+    // The binding only has to be there: swapchain images are created in whatever context is current when they are.
+#ifdef XR_USE_PLATFORM_ANDROID
+    const XrStructureType bindingType = XR_TYPE_GRAPHICS_BINDING_OPENGL_ES_ANDROID_KHR;
+#else
+    const XrStructureType bindingType = XR_TYPE_GRAPHICS_BINDING_EGL_MNDX;
+#endif
+    if (!instanceObject->HasExtension(XR_KHR_OPENGL_ES_ENABLE_EXTENSION_NAME) || FindNext(createInfo->next, bindingType) == nullptr) {
+        return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+    }
+
+    std::unique_ptr<Session> sessionObject(new Session);
+    sessionObject->instance = instanceObject;
+    Session& created = *sessionObject;
+    *session = g_sessions.Add<XrSession>(std::move(sessionObject));
+    SetSessionState(created, XR_SESSION_STATE_IDLE);
+    SetSessionState(created, XR_SESSION_STATE_READY);
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrDestroySession(XrSession session) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    DestroySession(sessionObject);
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrBeginSession(XrSession session, const XrSessionBeginInfo* beginInfo) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    if (CheckStructure(beginInfo, XR_TYPE_SESSION_BEGIN_INFO) != XR_SUCCESS) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (beginInfo->primaryViewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+        return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+    }
+    if (sessionObject->state != XR_SESSION_STATE_READY) {
+        return XR_ERROR_SESSION_NOT_READY;
+    }
+    sessionObject->beginTime = Now();
+    sessionObject->nextWake = sessionObject->beginTime;
+    sessionObject->stats = {};
+    SetSessionState(*sessionObject, XR_SESSION_STATE_SYNCHRONIZED);
+    SetSessionState(*sessionObject, XR_SESSION_STATE_VISIBLE);
+    SetSessionState(*sessionObject, XR_SESSION_STATE_FOCUSED);
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrEndSession(XrSession session) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    if (sessionObject->state != XR_SESSION_STATE_STOPPING) {
+        return XR_ERROR_SESSION_NOT_STOPPING;
+    }
+    const StandinFrameStats& stats = sessionObject->stats;
+    Logf("Session ended after %u frames: %u late, %u refreshes skipped, %.2fms per xrWaitFrame", stats.frames, stats.lateFrames,
+         stats.skippedVsyncs, stats.frames > 0 ? stats.waitNs * 1e-6 / stats.frames : 0.0);
+    g_lastStats = stats;
+    sessionObject->frameWaited = sessionObject->frameBegun = false;
+    SetSessionState(*sessionObject, XR_SESSION_STATE_IDLE);
+    if (sessionObject->exitRequested) {
+        SetSessionState(*sessionObject, XR_SESSION_STATE_EXITING);
+    }
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrRequestExitSession(XrSession session) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    if (!IsSessionRunning(*sessionObject)) {
+        return XR_ERROR_SESSION_NOT_RUNNING;
+    }
+    RequestExit(*sessionObject);
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrEnumerateReferenceSpaces(XrSession session, uint32_t spaceCapacityInput, uint32_t* spaceCountOutput,
+                                                          XrReferenceSpaceType* spaces) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    constexpr XrReferenceSpaceType Types[] = {XR_REFERENCE_SPACE_TYPE_VIEW, XR_REFERENCE_SPACE_TYPE_LOCAL, XR_REFERENCE_SPACE_TYPE_STAGE};
+    return Enumerate(3, spaceCapacityInput, spaceCountOutput, spaces, [&Types](uint32_t i, XrReferenceSpaceType& type) { type = Types[i]; });
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrCreateReferenceSpace(XrSession session, const XrReferenceSpaceCreateInfo* createInfo, XrSpace* space) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    if (CheckStructure(createInfo, XR_TYPE_REFERENCE_SPACE_CREATE_INFO) != XR_SUCCESS || space == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    const XrReferenceSpaceType type = createInfo->referenceSpaceType;
+    if (type != XR_REFERENCE_SPACE_TYPE_VIEW && type != XR_REFERENCE_SPACE_TYPE_LOCAL && type != XR_REFERENCE_SPACE_TYPE_STAGE) {
+        return XR_ERROR_REFERENCE_SPACE_UNSUPPORTED;
+    }
+    *space = g_spaces.Add<XrSpace>(
+        std::unique_ptr<Space>(new Space{sessionObject, SpaceKind::Reference, type, 0, createInfo->poseInReferenceSpace}));
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrCreateActionSpace(XrSession session, const XrActionSpaceCreateInfo* createInfo, XrSpace* space) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    if (CheckStructure(createInfo, XR_TYPE_ACTION_SPACE_CREATE_INFO) != XR_SUCCESS || space == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    const Action* action = g_actions.Get(createInfo->action);
+    if (action == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    if (action->type != XR_ACTION_TYPE_POSE_INPUT) {
+        return XR_ERROR_ACTION_TYPE_MISMATCH;
+    }
+
+    // The subaction path picks the device: a hand aims from its palm, anything else is the gamepad.
+    SpaceKind kind = SpaceKind::Gamepad;
+    int hand = 0;
+    const std::vector<std::string>& paths = sessionObject->instance->paths;
+    if (createInfo->subactionPath != XR_NULL_PATH && createInfo->subactionPath <= paths.size()) {
+        const std::string& path = paths[createInfo->subactionPath - 1];
+        if (path == "/user/hand/left" || path == "/user/hand/right") {
+            kind = SpaceKind::HandAim;
+            hand = path == "/user/hand/left" ? 0 : 1;
+        }
+    }
+    *space = g_spaces.Add<XrSpace>(
+        std::unique_ptr<Space>(new Space{sessionObject, kind, XR_REFERENCE_SPACE_TYPE_LOCAL, hand, createInfo->poseInActionSpace}));
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrDestroySpace(XrSpace space) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_spaces.Remove(space) ? XR_SUCCESS : XR_ERROR_HANDLE_INVALID;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation* location) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    const Space* spaceObject = g_spaces.Get(space);
+    const Space* baseObject = g_spaces.Get(baseSpace);
+    if (spaceObject == nullptr || baseObject == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    if (CheckStructure(location, XR_TYPE_SPACE_LOCATION) != XR_SUCCESS) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    XrPosef pose, basePose;
+    XrSpaceLocationFlags flags, baseFlags;
+    if (!SpacePose(*spaceObject, time, pose, flags) || !SpacePose(*baseObject, time, basePose, baseFlags)) {
+        location->locationFlags = 0;
+        return XR_SUCCESS;
+    }
+    location->pose = Pose::Multiply(Pose::Invert(basePose), pose);
+    location->locationFlags = flags & baseFlags;
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrEnumerateSwapchainFormats(XrSession session, uint32_t formatCapacityInput, uint32_t* formatCountOutput,
+                                                           int64_t* formats) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    const uint32_t count = sizeof(SwapchainFormats) / sizeof(SwapchainFormats[0]);
+    return Enumerate(count, formatCapacityInput, formatCountOutput, formats, [](uint32_t i, int64_t& format) { format = SwapchainFormats[i]; });
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrCreateSwapchain(XrSession session, const XrSwapchainCreateInfo* createInfo, XrSwapchain* swapchain) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    if (CheckStructure(createInfo, XR_TYPE_SWAPCHAIN_CREATE_INFO) != XR_SUCCESS || swapchain == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (std::find(std::begin(SwapchainFormats), std::end(SwapchainFormats), createInfo->format) == std::end(SwapchainFormats)) {
+        return XR_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED;
+    }
+    if (createInfo->sampleCount != 1 || createInfo->faceCount != 1 || createInfo->mipCount < 1 || createInfo->arraySize < 1) {
+        return XR_ERROR_FEATURE_UNSUPPORTED;
+    }
+    if (eglGetCurrentContext() == EGL_NO_CONTEXT) {
+        return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+    }
+
+    std::unique_ptr<Swapchain> swapchainObject(new Swapchain{sessionObject, {}});
+    for (uint32_t i = 0; i < SwapchainImageCount; i++) {
+        swapchainObject->images.push_back(CreateImage(*createInfo));
+    }
+    *swapchain = g_swapchains.Add<XrSwapchain>(std::move(swapchainObject));
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrDestroySwapchain(XrSwapchain swapchain) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    Swapchain* swapchainObject = g_swapchains.Get(swapchain);
+    if (swapchainObject == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    glDeleteTextures(static_cast<GLsizei>(swapchainObject->images.size()), swapchainObject->images.data());
+    g_swapchains.Remove(swapchain);
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrEnumerateSwapchainImages(XrSwapchain swapchain, uint32_t imageCapacityInput, uint32_t* imageCountOutput,
+                                                          XrSwapchainImageBaseHeader* images) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    const Swapchain* swapchainObject = g_swapchains.Get(swapchain);
+    if (swapchainObject == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    auto* glesImages = reinterpret_cast<XrSwapchainImageOpenGLESKHR*>(images);
+    return Enumerate(static_cast<uint32_t>(swapchainObject->images.size()), imageCapacityInput, imageCountOutput, glesImages,
+                     [swapchainObject](uint32_t i, XrSwapchainImageOpenGLESKHR& image) { image.image = swapchainObject->images[i]; });
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrAcquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* /*acquireInfo*/, uint32_t* index) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    Swapchain* swapchainObject = g_swapchains.Get(swapchain);
+    if (swapchainObject == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    if (swapchainObject->acquired == swapchainObject->images.size()) {
+        return XR_ERROR_CALL_ORDER_INVALID;
+    }
+    *index = swapchainObject->nextImage;
+    swapchainObject->nextImage = (swapchainObject->nextImage + 1) % swapchainObject->images.size();
+    swapchainObject->acquired++;
+    return XR_SUCCESS;
+}
+
+// The compositor is done with an image once it is acquired again, three images later.
+XRAPI_ATTR XrResult XRAPI_CALL xrWaitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo* /*waitInfo*/) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_swapchains.Get(swapchain) != nullptr ? XR_SUCCESS : XR_ERROR_HANDLE_INVALID;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrReleaseSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageReleaseInfo* /*releaseInfo*/) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    Swapchain* swapchainObject = g_swapchains.Get(swapchain);
+    if (swapchainObject == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    if (swapchainObject->acquired == 0) {
+        return XR_ERROR_CALL_ORDER_INVALID;
+    }
+    swapchainObject->acquired--;
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrWaitFrame(XrSession session, const XrFrameWaitInfo* /*frameWaitInfo*/, XrFrameState* frameState) {
+    std::unique_lock<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    if (CheckStructure(frameState, XR_TYPE_FRAME_STATE) != XR_SUCCESS) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (!IsSessionRunning(*sessionObject)) {
+        return XR_ERROR_SESSION_NOT_RUNNING;
+    }
+    const XrTime waitStart = Now();
+
+    // The compositor needs the previous frame before it takes another: this is where a GPU bound application blocks.
+    // The fence is taken off the session and waited for without the lock, like the sleep below.
+    if (sessionObject->endedFence != nullptr) {
+        const GLsync fence = sessionObject->endedFence;
+        sessionObject->endedFence = nullptr;
+        lock.unlock();
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        glDeleteSync(fence);
+        const XrTime signalled = Now();
+        lock.lock();
+
+        sessionObject = g_sessions.Get(session);
+        if (sessionObject == nullptr) {
+            return XR_ERROR_HANDLE_INVALID;
+        }
+        if (std::max(sessionObject->endedTime, signalled) > sessionObject->endedLatch) {
+            sessionObject->stats.lateFrames++;
+        }
+    }
+    Session& s = *sessionObject;
+    const XrDuration period = s.instance->settings.period;
+
+    // Wake at the first refresh not already taken by the previous frame, the ones in between are skipped.
+    const XrTime now = Now();
+    XrTime wake = s.nextWake;
+    if (wake < now) {
+        const XrDuration behind = (now - wake + period - 1) / period;
+        s.stats.skippedVsyncs += static_cast<uint32_t>(s.stats.frames > 0 ? behind : 0);
+        wake += behind * period;
+    }
+    s.nextWake = wake + period;
+    s.waitedLatch = wake + period;
+    s.waitedDisplayTime = wake + 2 * period;
+    s.frameWaited = true;
+    const bool shouldRender = s.state == XR_SESSION_STATE_VISIBLE || s.state == XR_SESSION_STATE_FOCUSED;
+    const XrTime displayTime = s.waitedDisplayTime;
+
+    lock.unlock();
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(wake)));
+    lock.lock();
+
+    // The session may have gone while this thread slept.
+    sessionObject = g_sessions.Get(session);
+    if (sessionObject == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    sessionObject->stats.waitNs += Now() - waitStart;
+    frameState->predictedDisplayTime = displayTime;
+    frameState->predictedDisplayPeriod = period;
+    frameState->shouldRender = shouldRender ? XR_TRUE : XR_FALSE;
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrBeginFrame(XrSession session, const XrFrameBeginInfo* /*frameBeginInfo*/) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    if (!IsSessionRunning(*sessionObject)) {
+        return XR_ERROR_SESSION_NOT_RUNNING;
+    }
+    if (!sessionObject->frameWaited) {
+        return XR_ERROR_CALL_ORDER_INVALID;
+    }
+    // A frame begun twice discards the first one.
+    const bool discarded = sessionObject->frameBegun;
+    sessionObject->frameWaited = false;
+    sessionObject->frameBegun = true;
+    return discarded ? XR_FRAME_DISCARDED : XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrEndFrame(XrSession session, const XrFrameEndInfo* frameEndInfo) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    if (CheckStructure(frameEndInfo, XR_TYPE_FRAME_END_INFO) != XR_SUCCESS) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (!IsSessionRunning(*sessionObject)) {
+        return XR_ERROR_SESSION_NOT_RUNNING;
+    }
+    if (!sessionObject->frameBegun) {
+        return XR_ERROR_CALL_ORDER_INVALID;
+    }
+    if (frameEndInfo->displayTime <= 0) {
+        return XR_ERROR_TIME_INVALID;
+    }
+    if (frameEndInfo->layerCount > 0 && frameEndInfo->layers == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (frameEndInfo->layerCount > 16) {
+        return XR_ERROR_LAYER_LIMIT_EXCEEDED;
+    }
+
+    // Nothing is shown, but the frame is only done when the GPU is.
+    Session& s = *sessionObject;
+    s.frameBegun = false;
+    s.endedFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+    s.endedTime = Now();
+    s.endedLatch = s.waitedLatch;
+    s.stats.frames++;
+    g_lastStats = s.stats;
+
+    const uint32_t frameLimit = s.instance->settings.frames;
+    if (frameLimit > 0 && s.stats.frames >= frameLimit) {
+        RequestExit(s);
+    }
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrLocateViews(XrSession session, const XrViewLocateInfo* viewLocateInfo, XrViewState* viewState, uint32_t viewCapacityInput,
+                                             uint32_t* viewCountOutput, XrView* views) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    if (CheckStructure(viewLocateInfo, XR_TYPE_VIEW_LOCATE_INFO) != XR_SUCCESS || CheckStructure(viewState, XR_TYPE_VIEW_STATE) != XR_SUCCESS) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (viewLocateInfo->viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+        return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+    }
+    const Space* base = g_spaces.Get(viewLocateInfo->space);
+    if (base == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    XrPosef basePose;
+    XrSpaceLocationFlags baseFlags;
+    SpacePose(*base, viewLocateInfo->displayTime, basePose, baseFlags);
+    const XrPosef head = Pose::Multiply(Pose::Invert(basePose), HeadPose(*sessionObject, viewLocateInfo->displayTime));
+    viewState->viewStateFlags = XR_VIEW_STATE_POSITION_VALID_BIT | XR_VIEW_STATE_ORIENTATION_VALID_BIT | XR_VIEW_STATE_POSITION_TRACKED_BIT |
+                                XR_VIEW_STATE_ORIENTATION_TRACKED_BIT;
+
+    const Settings& settings = sessionObject->instance->settings;
+    const float horizontal = atanf(settings.tanHalfFov);
+    const float vertical = atanf(settings.tanHalfFov * settings.viewHeight / settings.viewWidth);
+    return Enumerate(ViewCount, viewCapacityInput, viewCountOutput, views, [&](uint32_t i, XrView& view) {
+        const float side = i == 0 ? -0.5f : 0.5f;
+        view.pose = Pose::Multiply(head, {{0, 0, 0, 1}, {side * settings.ipd, 0, 0}});
+        view.fov = {-horizontal, horizontal, vertical, -vertical};
+    });
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrStringToPath(XrInstance instance, const char* pathString, XrPath* path) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    INSTANCE_OR_RETURN(instanceObject, instance);
+    if (pathString == nullptr || pathString[0] != '/') {
+        return XR_ERROR_PATH_FORMAT_INVALID;
+    }
+    std::vector<std::string>& paths = instanceObject->paths;
+    auto it = std::find(paths.begin(), paths.end(), pathString);
+    if (it == paths.end()) {
+        it = paths.insert(paths.end(), pathString);
+    }
+    *path = static_cast<XrPath>(it - paths.begin()) + 1;
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrPathToString(XrInstance instance, XrPath path, uint32_t bufferCapacityInput, uint32_t* bufferCountOutput,
+                                              char* buffer) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    INSTANCE_OR_RETURN(instanceObject, instance);
+    if (path == XR_NULL_PATH || path > instanceObject->paths.size()) {
+        return XR_ERROR_PATH_INVALID;
+    }
+    const std::string& string = instanceObject->paths[path - 1];
+    return Enumerate(static_cast<uint32_t>(string.size() + 1), bufferCapacityInput, bufferCountOutput, buffer,
+                     [&string](uint32_t i, char& c) { c = string.c_str()[i]; });
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrCreateActionSet(XrInstance instance, const XrActionSetCreateInfo* createInfo, XrActionSet* actionSet) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    INSTANCE_OR_RETURN(instanceObject, instance);
+    if (CheckStructure(createInfo, XR_TYPE_ACTION_SET_CREATE_INFO) != XR_SUCCESS || actionSet == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    *actionSet = g_actionSets.Add<XrActionSet>(std::unique_ptr<ActionSet>(new ActionSet{instanceObject}));
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrDestroyActionSet(XrActionSet actionSet) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    ActionSet* actionSetObject = g_actionSets.Get(actionSet);
+    if (actionSetObject == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    g_actions.RemoveIf([actionSetObject](const Action& action) { return action.actionSet == actionSetObject; });
+    g_actionSets.Remove(actionSet);
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrCreateAction(XrActionSet actionSet, const XrActionCreateInfo* createInfo, XrAction* action) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    ActionSet* actionSetObject = g_actionSets.Get(actionSet);
+    if (actionSetObject == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    if (CheckStructure(createInfo, XR_TYPE_ACTION_CREATE_INFO) != XR_SUCCESS || action == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (actionSetObject->attached) {
+        return XR_ERROR_ACTIONSETS_ALREADY_ATTACHED;
+    }
+    std::vector<XrPath> subactionPaths(createInfo->subactionPaths, createInfo->subactionPaths + createInfo->countSubactionPaths);
+    *action = g_actions.Add<XrAction>(std::unique_ptr<Action>(new Action{actionSetObject, createInfo->actionType, std::move(subactionPaths)}));
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrDestroyAction(XrAction action) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_actions.Remove(action) ? XR_SUCCESS : XR_ERROR_HANDLE_INVALID;
+}
+
+// Any binding is accepted, none of them is ever driven.
+XRAPI_ATTR XrResult XRAPI_CALL xrSuggestInteractionProfileBindings(XrInstance instance, const XrInteractionProfileSuggestedBinding* suggestedBindings) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    INSTANCE_OR_RETURN(instanceObject, instance);
+    if (CheckStructure(suggestedBindings, XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING) != XR_SUCCESS) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    for (uint32_t i = 0; i < suggestedBindings->countSuggestedBindings; i++) {
+        if (g_actions.Get(suggestedBindings->suggestedBindings[i].action) == nullptr) {
+            return XR_ERROR_HANDLE_INVALID;
+        }
+    }
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrAttachSessionActionSets(XrSession session, const XrSessionActionSetsAttachInfo* attachInfo) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    if (CheckStructure(attachInfo, XR_TYPE_SESSION_ACTION_SETS_ATTACH_INFO) != XR_SUCCESS) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    for (uint32_t i = 0; i < attachInfo->countActionSets; i++) {
+        ActionSet* actionSet = g_actionSets.Get(attachInfo->actionSets[i]);
+        if (actionSet == nullptr) {
+            return XR_ERROR_HANDLE_INVALID;
+        }
+        actionSet->attached = true;
+    }
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrSyncActions(XrSession session, const XrActionsSyncInfo* syncInfo) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    if (CheckStructure(syncInfo, XR_TYPE_ACTIONS_SYNC_INFO) != XR_SUCCESS) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    return sessionObject->state == XR_SESSION_STATE_FOCUSED ? XR_SUCCESS : XR_SESSION_NOT_FOCUSED;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrGetActionStateBoolean(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStateBoolean* state) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    const Action* action = getInfo != nullptr ? g_actions.Get(getInfo->action) : nullptr;
+    if (action == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    if (action->type != XR_ACTION_TYPE_BOOLEAN_INPUT) {
+        return XR_ERROR_ACTION_TYPE_MISMATCH;
+    }
+    state->currentState = XR_FALSE;
+    state->changedSinceLastSync = XR_FALSE;
+    state->lastChangeTime = 0;
+    state->isActive = XR_FALSE;
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrGetActionStateFloat(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStateFloat* state) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    const Action* action = getInfo != nullptr ? g_actions.Get(getInfo->action) : nullptr;
+    if (action == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    if (action->type != XR_ACTION_TYPE_FLOAT_INPUT) {
+        return XR_ERROR_ACTION_TYPE_MISMATCH;
+    }
+    state->currentState = 0;
+    state->changedSinceLastSync = XR_FALSE;
+    state->lastChangeTime = 0;
+    state->isActive = XR_FALSE;
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrGetActionStatePose(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStatePose* state) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    SESSION_OR_RETURN(sessionObject, session);
+    const Action* action = getInfo != nullptr ? g_actions.Get(getInfo->action) : nullptr;
+    if (action == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    if (action->type != XR_ACTION_TYPE_POSE_INPUT) {
+        return XR_ERROR_ACTION_TYPE_MISMATCH;
+    }
+    state->isActive = XR_TRUE;
+    return XR_SUCCESS;
+}
+
+#define STANDIN_FUNCTION(name) {#name, reinterpret_cast<PFN_xrVoidFunction>(name)}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function) {
+    static const std::map<std::string, PFN_xrVoidFunction> Functions = {
+        STANDIN_FUNCTION(xrGetInstanceProcAddr),
+        STANDIN_FUNCTION(xrInitializeLoaderKHR),
+        STANDIN_FUNCTION(xrEnumerateApiLayerProperties),
+        STANDIN_FUNCTION(xrEnumerateInstanceExtensionProperties),
+        STANDIN_FUNCTION(xrCreateInstance),
+        STANDIN_FUNCTION(xrDestroyInstance),
+        STANDIN_FUNCTION(xrGetInstanceProperties),
+        STANDIN_FUNCTION(xrPollEvent),
+        STANDIN_FUNCTION(xrGetSystem),
+        STANDIN_FUNCTION(xrGetSystemProperties),
+        STANDIN_FUNCTION(xrEnumerateViewConfigurations),
+        STANDIN_FUNCTION(xrGetViewConfigurationProperties),
+        STANDIN_FUNCTION(xrEnumerateViewConfigurationViews),
+        STANDIN_FUNCTION(xrEnumerateEnvironmentBlendModes),
+        STANDIN_FUNCTION(xrCreateSession),
+        STANDIN_FUNCTION(xrDestroySession),
+        STANDIN_FUNCTION(xrBeginSession),
+        STANDIN_FUNCTION(xrEndSession),
+        STANDIN_FUNCTION(xrRequestExitSession),
+        STANDIN_FUNCTION(xrEnumerateReferenceSpaces),
+        STANDIN_FUNCTION(xrCreateReferenceSpace),
+        STANDIN_FUNCTION(xrCreateActionSpace),
+        STANDIN_FUNCTION(xrDestroySpace),
+        STANDIN_FUNCTION(xrLocateSpace),
+        STANDIN_FUNCTION(xrEnumerateSwapchainFormats),
+        STANDIN_FUNCTION(xrCreateSwapchain),
+        STANDIN_FUNCTION(xrDestroySwapchain),
+        STANDIN_FUNCTION(xrEnumerateSwapchainImages),
+        STANDIN_FUNCTION(xrAcquireSwapchainImage),
+        STANDIN_FUNCTION(xrWaitSwapchainImage),
+        STANDIN_FUNCTION(xrReleaseSwapchainImage),
+        STANDIN_FUNCTION(xrWaitFrame),
+        STANDIN_FUNCTION(xrBeginFrame),
+        STANDIN_FUNCTION(xrEndFrame),
+        STANDIN_FUNCTION(xrLocateViews),
+        STANDIN_FUNCTION(xrStringToPath),
+        STANDIN_FUNCTION(xrPathToString),
+        STANDIN_FUNCTION(xrCreateActionSet),
+        STANDIN_FUNCTION(xrDestroyActionSet),
+        STANDIN_FUNCTION(xrCreateAction),
+        STANDIN_FUNCTION(xrDestroyAction),
+        STANDIN_FUNCTION(xrSuggestInteractionProfileBindings),
+        STANDIN_FUNCTION(xrAttachSessionActionSets),
+        STANDIN_FUNCTION(xrSyncActions),
+        STANDIN_FUNCTION(xrGetActionStateBoolean),
+        STANDIN_FUNCTION(xrGetActionStateFloat),
+        STANDIN_FUNCTION(xrGetActionStatePose),
+        STANDIN_FUNCTION(xrGetOpenGLESGraphicsRequirementsKHR),
+        STANDIN_FUNCTION(xrConvertTimespecTimeToTimeKHR),
+        STANDIN_FUNCTION(xrConvertTimeToTimespecTimeKHR),
+        STANDIN_FUNCTION(xrCreateHandTrackerEXT),
+        STANDIN_FUNCTION(xrDestroyHandTrackerEXT),
+        STANDIN_FUNCTION(xrLocateHandJointsEXT),
+        STANDIN_FUNCTION(xrRecenterHeadTracker),
+        STANDIN_FUNCTION(xrRecenterPhonePose),
+        STANDIN_FUNCTION(xrGetHeadTrackingStatus),
+        STANDIN_FUNCTION(xrGetCameraPhysicsPose),
+        STANDIN_FUNCTION(xrGetHistoryCameraPhysicsPose),
+        STANDIN_FUNCTION(xrOpenCameraPreview),
+        STANDIN_FUNCTION(xrCloseCameraPreview),
+        STANDIN_FUNCTION(xrRKOpenMarker2),
+        STANDIN_FUNCTION(xrRKCloseMarker2),
+        STANDIN_FUNCTION(xrRKMarker2AddImagePhy),
+        STANDIN_FUNCTION(xrRKMarker2AcquireChanges),
+        STANDIN_FUNCTION(xrRKMarker2GetCenterPose),
+        STANDIN_FUNCTION(xrRKMarker2GetExtent),
+        STANDIN_FUNCTION(xrRKMarker2GetId),
+        STANDIN_FUNCTION(xrRKMarker2GetAlgoId),
+        STANDIN_FUNCTION(xrRKOpenPlaneTracker),
+        STANDIN_FUNCTION(xrRKClosePlaneTracker),
+        STANDIN_FUNCTION(xrRKGetPlaneDetectMode),
+        STANDIN_FUNCTION(xrRKSetPlaneDetectMode),
+        STANDIN_FUNCTION(xrRKGetUpdatePlanes),
+        STANDIN_FUNCTION(xrRKGetPlanePolygon),
+        STANDIN_FUNCTION(xrRKGetPlaneType),
+        STANDIN_FUNCTION(xrRKGetPlaneCenterPose),
+        STANDIN_FUNCTION(xrRKGetPlaneRectangle),
+        STANDIN_FUNCTION(xrRKReleasePlane),
+        STANDIN_FUNCTION(xrRKCreateArtificialPlane),
+    };
+
+    if (name == nullptr || function == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    *function = nullptr;
+    if (instance != XR_NULL_HANDLE) {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        if (g_instances.Get(instance) == nullptr) {
+            return XR_ERROR_HANDLE_INVALID;
+        }
+    }
+    auto it = Functions.find(name);
+    if (it == Functions.end()) {
+        return XR_ERROR_FUNCTION_UNSUPPORTED;
+    }
+    *function = it->second;
+    return XR_SUCCESS;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+
+// A stand-in for the Rokid runtime, built as a libopenxr_loader.so of its own (XR_RUNTIME=Standin in CMakeLists.txt)
+// so OpenXrProgram runs unchanged without glasses, on a phone or on Linux with the headless graphics plugin.
+//
+// It implements the core functions the application calls, XR_KHR_opengl_es_enable swapchains as GL textures of the
+// application's context, XR_EXT_hand_tracking and no-op stubs of the Rokid marker, plane, camera and recenter
+// extensions. The head sways about the vertical axis, the views are a stereo pair around it, the gamepad points where
+// the head does and the hands either curl their fingers in front of the user or play a recorded track.
+//
+// xrWaitFrame paces the frame loop like a compositor: it waits for the GPU to finish the previous frame, then for the
+// next refresh, and predicts the frame to be shown two refreshes later. A frame not finished by the refresh after it
+// was waited for is late, the compositor shows the previous one again; refreshes nobody waited for are skipped.
+//
+// Settings come from environment variables on Linux and from the same names as system properties on Android:
+//   XR_STANDIN_REFRESH_RATE  / debug.xr.standin.refreshRate   refresh rate in Hz, 60
+//   XR_STANDIN_VIEW_WIDTH    / debug.xr.standin.viewWidth     recommended width of a view, 1920
+//   XR_STANDIN_VIEW_HEIGHT   / debug.xr.standin.viewHeight    recommended height of a view, 1080
+//   XR_STANDIN_FOV           / debug.xr.standin.fov           horizontal field of view in degrees, 44
+//   XR_STANDIN_IPD           / debug.xr.standin.ipd           distance between the views in meters, 0.063
+//   XR_STANDIN_HEAD_YAW      / debug.xr.standin.headYaw       amplitude of the head sway in degrees, 10
+//   XR_STANDIN_HAND_TRACK    / debug.xr.standin.handTrack     recorded hand track to play instead of the scripted one
+//   XR_STANDIN_FRAMES        / debug.xr.standin.frames        frames after which the session exits, 0 for never
+//
+// A hand track is text, one joint per line, lines of the same time make a frame and the track loops:
+//   <seconds> <hand 0 left, 1 right> <XrHandJointEXT> <px> <py> <pz> <qx> <qy> <qz> <qw> [radius]
+// Poses are in the LOCAL reference space. Joints a frame leaves out are not tracked in it, '#' starts a comment.
+
+// Frame pacing since xrBeginSession.
+struct StandinFrameStats {
+    uint32_t frames = 0;         // xrEndFrame calls
+    uint32_t lateFrames = 0;     // finished after the compositor latched them
+    uint32_t skippedVsyncs = 0;  // refreshes xrWaitFrame was not called for in time
+    int64_t waitNs = 0;          // time spent blocked in xrWaitFrame
+};
+
+// Of the running session, or of the last one once it ended. For benchmarks linking the runtime directly.
+extern "C" void StandinGetFrameStats(StandinFrameStats* stats);
@@ -0,0 +1,148 @@
+#include "pch.h"
+#include "common.h"
+#include "startuptasks.h"
+
+namespace {
+float MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+}  // namespace
+
+StartupTasks::StartupTasks() : m_created(std::chrono::steady_clock::now()) {}
+
+StartupTasks::~StartupTasks() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_changed.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+StartupTasks::TaskId StartupTasks::Add(const char* name, Thread thread, std::function<bool()> work, std::initializer_list<TaskId> dependencies) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const TaskId id = static_cast<TaskId>(m_tasks.size());
+    m_tasks.push_back({name, thread, std::move(work), State::Blocked, 0, {}});
+    m_unfinished++;
+
+    bool skipped = false;
+    for (TaskId dependency : dependencies) {
+        CHECK_MSG(dependency < id, "StartupTasks: dependencies must be added first");
+        Task& task = m_tasks[dependency];
+        if (task.state == State::Failed || task.state == State::Skipped) {
+            skipped = true;
+        } else if (task.state != State::Succeeded) {
+            task.dependents.push_back(id);
+            m_tasks[id].blockers++;
+        }
+    }
+    if (skipped) {
+        Finish(id, State::Skipped);
+    } else if (m_tasks[id].blockers == 0) {
+        MakeReady(id);
+    }
+    return id;
+}
+
+void StartupTasks::Start() {
+    if (!m_workers.empty()) {
+        return;
+    }
+    for (uint32_t i = 0; i < WorkerCount; i++) {
+        m_workers.emplace_back(&StartupTasks::WorkerLoop, this);
+    }
+}
+
+bool StartupTasks::Wait(TaskId task) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!IsFinished(m_tasks[task].state)) {
+        if (!m_renderQueue.empty()) {
+            const TaskId id = m_renderQueue.front();
+            m_renderQueue.pop_front();
+            Execute(id, lock);
+        } else {
+            m_changed.wait(lock);
+        }
+    }
+    return m_tasks[task].state == State::Succeeded;
+}
+
+bool StartupTasks::RunRenderTasks(std::chrono::microseconds budget) {
+    const auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_renderQueue.empty() && std::chrono::steady_clock::now() - start < budget) {
+        const TaskId id = m_renderQueue.front();
+        m_renderQueue.pop_front();
+        Execute(id, lock);
+    }
+    return m_unfinished == 0;
+}
+
+void StartupTasks::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_changed.wait(lock, [this] { return m_stopping || !m_workerQueue.empty(); });
+        if (m_stopping) {
+            return;
+        }
+        const TaskId id = m_workerQueue.front();
+        m_workerQueue.pop_front();
+        Execute(id, lock);
+    }
+}
+
+void StartupTasks::Execute(TaskId id, std::unique_lock<std::mutex>& lock) {
+    m_tasks[id].state = State::Running;
+    const std::function<bool()> work = std::move(m_tasks[id].work);
+    const char* name = m_tasks[id].name;
+    lock.unlock();
+
+    const auto start = std::chrono::steady_clock::now();
+    bool succeeded = false;
+    try {
+        succeeded = work();
+    } catch (const std::exception& ex) {
+        Log::Write(Log::Level::Error, Fmt("StartupTasks: %s: %s", name, ex.what()));
+    } catch (...) {
+        Log::Write(Log::Level::Error, Fmt("StartupTasks: %s: unknown error", name));
+    }
+    Log::Write(Log::Level::Info, Fmt("StartupTasks: %s %s in %.1fms, %.1fms after start", name, succeeded ? "done" : "failed",
+                                     MillisecondsSince(start), MillisecondsSince(m_created)));
+
+    lock.lock();
+    Finish(id, succeeded ? State::Succeeded : State::Failed);
+}
+
+void StartupTasks::MakeReady(TaskId id) {
+    Task& task = m_tasks[id];
+    task.state = State::Ready;
+    (task.thread == Thread::Worker ? m_workerQueue : m_renderQueue).push_back(id);
+    m_changed.notify_all();
+}
+
+void StartupTasks::Finish(TaskId id, State state) {
+    m_tasks[id].state = state;
+    m_unfinished--;
+    if (state == State::Skipped) {
+        Log::Write(Log::Level::Warning, Fmt("StartupTasks: %s skipped, a dependency failed", m_tasks[id].name));
+    }
+
+    const std::vector<TaskId> dependents = std::move(m_tasks[id].dependents);
+    for (TaskId dependent : dependents) {
+        if (m_tasks[dependent].state != State::Blocked) {
+            continue;  // already skipped through another dependency
+        }
+        if (state != State::Succeeded) {
+            Finish(dependent, State::Skipped);
+        } else if (--m_tasks[dependent].blockers == 0) {
+            MakeReady(dependent);
+        }
+    }
+
+    if (m_unfinished == 0) {
+        Log::Write(Log::Level::Info, Fmt("StartupTasks: all %zu tasks finished %.1fms after start", m_tasks.size(), MillisecondsSince(m_created)));
+    }
+    m_changed.notify_all();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The work between launch and the first frames, as a graph of named tasks with declared dependencies.
+// Worker tasks only touch the CPU (asset reads, model parsing, font rasterization, image decoding) and run on a small
+// pool. Render tasks need the GL context or the OpenXR session; they are queued for the render thread, which runs them
+// while it waits for a task it cannot start the frame loop without, and a few per frame once the loop is running.
+// A task whose dependency failed is skipped, and so is everything that depends on it.
+class StartupTasks {
+   public:
+    enum class Thread { Worker, Render };
+    using TaskId = uint32_t;
+
+    static constexpr uint32_t WorkerCount = 2;
+
+    StartupTasks();
+    StartupTasks(const StartupTasks&) = delete;
+    StartupTasks& operator=(const StartupTasks&) = delete;
+    // Waits for the running worker tasks, the ones that have not started yet are dropped.
+    ~StartupTasks();
+
+    // Dependencies must have been added before. Tasks can be added at any time, from any thread, also from within
+    // another task. Render tasks run in the order they became ready.
+    TaskId Add(const char* name, Thread thread, std::function<bool()> work, std::initializer_list<TaskId> dependencies = {});
+
+    void Start();
+
+    // Render thread only. Runs render tasks until the task has finished, returns whether it succeeded.
+    bool Wait(TaskId task);
+
+    // Render thread only. Runs the ready render tasks, but starts no new one once the budget is spent.
+    // Returns true when every task added so far has finished.
+    bool RunRenderTasks(std::chrono::microseconds budget);
+
+   private:
+    enum class State { Blocked, Ready, Running, Succeeded, Failed, Skipped };
+    struct Task {
+        const char* name;
+        Thread thread;
+        std::function<bool()> work;
+        State state;
+        uint32_t blockers;  // dependencies that have not finished yet
+        std::vector<TaskId> dependents;
+    };
+
+    static bool IsFinished(State state) { return state == State::Succeeded || state == State::Failed || state == State::Skipped; }
+
+    void WorkerLoop();
+    // Called and returns with the lock held, releases it while the task runs.
+    void Execute(TaskId id, std::unique_lock<std::mutex>& lock);
+    void MakeReady(TaskId id);
+    void Finish(TaskId id, State state);
+
+    const std::chrono::steady_clock::time_point m_created;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::deque<Task> m_tasks;  // indexed by TaskId
+    std::deque<TaskId> m_workerQueue;
+    std::deque<TaskId> m_renderQueue;
+    std::vector<std::thread> m_workers;
+    uint32_t m_unfinished{0};
+    bool m_stopping{false};
+};
@@ -0,0 +1,142 @@
+#include "pch.h"
+#include "common.h"
+#include "trackingworker.h"
+
+void TrackingWorker::Start(const Api& api) {
+    if (m_running.load()) {
+        return;
+    }
+    m_api = api;
+    const bool markers = m_api.markerAcquireChanges != nullptr;
+    const bool planes = m_api.getUpdatePlanes != nullptr;
+    if (!markers && !planes) {
+        Log::Write(Log::Level::Info, "TrackingWorker: no marker or plane tracker, not started");
+        return;
+    }
+    Log::Write(Log::Level::Info, Fmt("TrackingWorker: polling%s%s every %lldms", markers ? " markers" : "", planes ? " planes" : "",
+                                     static_cast<long long>(PollInterval.count())));
+    m_running.store(true);
+    m_thread = std::thread(&TrackingWorker::Run, this);
+}
+
+void TrackingWorker::Stop() {
+    m_running.store(false);
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+const TrackingSnapshot& TrackingWorker::Acquire() {
+    if ((m_middle.load(std::memory_order_relaxed) & FreshBit) != 0) {
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & ~FreshBit;
+    }
+    return m_buffers[m_front];
+}
+
+void TrackingWorker::Run() {
+    auto next = std::chrono::steady_clock::now();
+    while (m_running.load()) {
+        bool changed = false;
+        if (m_api.markerAcquireChanges != nullptr) {
+            changed |= PollMarkers();
+        }
+        if (m_api.getUpdatePlanes != nullptr) {
+            changed |= PollPlanes();
+        }
+        if (changed) {
+            Publish();
+        }
+
+        // Keep the cadence, but never try to catch up after a slow poll.
+        next = std::max(next + PollInterval, std::chrono::steady_clock::now());
+        std::this_thread::sleep_until(next);
+    }
+}
+
+bool TrackingWorker::PollMarkers() {
+    XrRokidMarker2ArrayExt added{}, updated{}, removed{};
+    XrResult result = m_api.markerAcquireChanges(&added, &updated, &removed);
+    if (XR_FAILED(result)) {
+        Log::Write(Log::Level::Warning, Fmt("TrackingWorker: xrRKMarker2AcquireChanges failed: %d", result));
+        return false;
+    }
+
+    const auto refresh = [this](intptr_t handle) {
+        TrackingSnapshot::Marker& marker = m_markers[handle];
+        marker.handle = handle;
+        if (m_api.markerGetCenterPose != nullptr) {
+            m_api.markerGetCenterPose(handle, marker.pose);
+        }
+        if (m_api.markerGetExtent != nullptr) {
+            m_api.markerGetExtent(handle, &marker.extent[0], &marker.extent[1]);
+        }
+    };
+    for (uint32_t i = 0; i < added.size; ++i) {
+        refresh(added.elements[i]);
+        Log::Write(Log::Level::Info, Fmt("TrackingWorker: marker added: %ld", static_cast<long>(added.elements[i])));
+    }
+    for (uint32_t i = 0; i < updated.size; ++i) {
+        refresh(updated.elements[i]);
+    }
+    for (uint32_t i = 0; i < removed.size; ++i) {
+        m_markers.erase(removed.elements[i]);
+        Log::Write(Log::Level::Info, Fmt("TrackingWorker: marker removed: %ld", static_cast<long>(removed.elements[i])));
+    }
+    return added.size + updated.size + removed.size > 0;
+}
+
+bool TrackingWorker::PollPlanes() {
+    void *nochangePlanes = nullptr, *changePlanes = nullptr, *newPlanes = nullptr, *removePlanes = nullptr;
+    uint32_t nochangePlaneSize = 0, changePlaneSize = 0, newPlaneSize = 0, removePlaneSize = 0;
+    XrResult result = m_api.getUpdatePlanes(0, &nochangePlanes, &changePlanes, &newPlanes, &removePlanes, &nochangePlaneSize, &changePlaneSize,
+                                            &newPlaneSize, &removePlaneSize);
+    if (XR_FAILED(result)) {
+        Log::Write(Log::Level::Warning, Fmt("TrackingWorker: xrRKGetUpdatePlanes failed: %d", result));
+        return false;
+    }
+
+    const auto refresh = [this](int64_t handle) {
+        TrackingSnapshot::Plane& plane = m_planes[handle];
+        plane.handle = handle;
+        if (m_api.getPlaneType != nullptr) {
+            m_api.getPlaneType(handle, &plane.type);
+        }
+        void *pose = nullptr, *center = nullptr, *normalVector = nullptr;
+        if (m_api.getPlaneCenterPose != nullptr && XR_SUCCEEDED(m_api.getPlaneCenterPose(handle, &pose, &center, &normalVector))) {
+            if (pose != nullptr) {
+                memcpy(plane.pose, pose, sizeof(plane.pose));
+            }
+            if (center != nullptr) {
+                memcpy(plane.center, center, sizeof(plane.center));
+            }
+            if (normalVector != nullptr) {
+                memcpy(plane.normal, normalVector, sizeof(plane.normal));
+            }
+        }
+    };
+    for (uint32_t i = 0; i < newPlaneSize; ++i) {
+        refresh(static_cast<const int64_t*>(newPlanes)[i]);
+    }
+    for (uint32_t i = 0; i < changePlaneSize; ++i) {
+        refresh(static_cast<const int64_t*>(changePlanes)[i]);
+    }
+    for (uint32_t i = 0; i < removePlaneSize; ++i) {
+        m_planes.erase(static_cast<const int64_t*>(removePlanes)[i]);
+    }
+    return newPlaneSize + changePlaneSize + removePlaneSize > 0;
+}
+
+void TrackingWorker::Publish() {
+    TrackingSnapshot& snapshot = m_buffers[m_back];
+    snapshot.version = ++m_version;
+    snapshot.timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    snapshot.markers.clear();
+    for (const auto& marker : m_markers) {
+        snapshot.markers.push_back(marker.second);
+    }
+    snapshot.planes.clear();
+    for (const auto& plane : m_planes) {
+        snapshot.planes.push_back(plane.second);
+    }
+    m_back = m_middle.exchange(m_back | FreshBit, std::memory_order_acq_rel) & ~FreshBit;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
+
+// Everything the tracking worker knows at one point in time. Snapshots are published whole, a reader never sees a
+// partially updated one.
+struct TrackingSnapshot {
+    struct Marker {
+        intptr_t handle;
+        float pose[7];    // position xyz, orientation xyzw, as returned by xrRKMarker2GetCenterPose
+        float extent[2];  // physical size in meters along x and z
+    };
+    struct Plane {
+        int64_t handle;
+        uint32_t type;
+        float pose[7];   // as returned by xrRKGetPlaneCenterPose, laid out like the marker pose
+        float center[3];
+        float normal[3];
+    };
+
+    uint64_t version{0};  // 0 until the first publish, then incremented on every change
+    int64_t timeNs{0};    // steady clock time of the poll that produced it
+    std::vector<Marker> markers;
+    std::vector<Plane> planes;
+};
+
+// Polls the xrRK* marker and plane trackers on its own thread, so slow tracking calls never hold up xrWaitFrame.
+// The results are handed to the render thread through a triple buffer: the worker fills its back buffer and swaps it
+// with the shared middle one, the reader swaps the middle one with its front buffer when it holds a newer snapshot.
+// Neither side ever waits for the other.
+class TrackingWorker {
+   public:
+    // Entry points of the runtime's tracking extensions, a null marker or plane query disables that tracker.
+    struct Api {
+        PFN_xrRKMarker2AcquireChanges markerAcquireChanges{nullptr};
+        PFN_xrRKMarker2GetCenterPose markerGetCenterPose{nullptr};
+        PFN_xrRKMarker2GetExtent markerGetExtent{nullptr};
+        PFN_xrRKGetUpdatePlanes getUpdatePlanes{nullptr};
+        PFN_xrRKGetPlaneType getPlaneType{nullptr};
+        PFN_xrRKGetPlaneCenterPose getPlaneCenterPose{nullptr};
+    };
+
+    static constexpr std::chrono::milliseconds PollInterval{33};
+
+    TrackingWorker() = default;
+    TrackingWorker(const TrackingWorker&) = delete;
+    TrackingWorker& operator=(const TrackingWorker&) = delete;
+    ~TrackingWorker() { Stop(); }
+
+    void Start(const Api& api);
+    // Joins the worker, must be called before the tracking extensions are closed.
+    void Stop();
+
+    // The latest published snapshot, only to be called from one reader thread. The reference stays valid until the
+    // reader's next call.
+    const TrackingSnapshot& Acquire();
+
+   private:
+    static constexpr uint32_t FreshBit = 4;  // set on m_middle while the reader has not taken it
+
+    void Run();
+    bool PollMarkers();
+    bool PollPlanes();
+    void Publish();
+
+    Api m_api;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+
+    std::array<TrackingSnapshot, 3> m_buffers;
+    std::atomic<uint32_t> m_middle{1};
+    uint32_t m_back{0};   // worker thread only
+    uint32_t m_front{2};  // reader thread only
+
+    // Tracked state of the worker, copied into the back buffer on every publish.
+    std::map<intptr_t, TrackingSnapshot::Marker> m_markers;
+    std::map<int64_t, TrackingSnapshot::Plane> m_planes;
+    uint64_t m_version{0};
+};